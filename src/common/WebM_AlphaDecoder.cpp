@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_AlphaDecoder.h"
+
+#include "WebM_FramePool.h"
+
+extern "C" {
+#include "vpx/vp8dx.h"
+}
+
+
+WebM_AlphaDecoder::WebM_AlphaDecoder() :
+	_decoder_open(false),
+	_pooled(false),
+	_have_frame(false),
+	_quit(false),
+	_img(NULL)
+{
+
+}
+
+
+WebM_AlphaDecoder::~WebM_AlphaDecoder()
+{
+	{
+		WebM_Lock lock(_mutex);
+		
+		_quit = true;
+		
+		_cond.Signal();
+	}
+	
+	Join();
+	
+	if(_decoder_open)
+		vpx_codec_destroy(&_decoder);
+	
+	if(_pooled)
+		WebM_DoneWithFramePool();
+}
+
+
+bool
+WebM_AlphaDecoder::Begin(vpx_codec_iface_t *iface, int width, int height, int threads)
+{
+	vpx_codec_dec_cfg_t config;
+	config.threads = threads;
+	config.w = width;
+	config.h = height;
+	
+	vpx_codec_err_t codec_err = vpx_codec_dec_init(&_decoder, iface, &config, 0);
+	
+	if(codec_err != VPX_CODEC_OK)
+		return false;
+	
+	_decoder_open = true;
+	
+	// VP9 buffers from the same pool as the color decoder
+	if(iface == vpx_codec_vp9_dx())
+		_pooled = WebM_UseFramePool(&_decoder);
+	
+	return Start();
+}
+
+
+void
+WebM_AlphaDecoder::Submit(const unsigned char *data, size_t size)
+{
+	WebM_Lock lock(_mutex);
+	
+	while(_have_frame)
+		_cond.Wait(_mutex);
+	
+	_data.assign(data, data + size);
+	_img = NULL;
+	
+	_have_frame = true;
+	
+	_cond.Signal();
+}
+
+
+const vpx_image_t *
+WebM_AlphaDecoder::Wait()
+{
+	WebM_Lock lock(_mutex);
+	
+	while(_have_frame)
+		_cond.Wait(_mutex);
+	
+	return _img;
+}
+
+
+void
+WebM_AlphaDecoder::Run()
+{
+	bool quit = false;
+	
+	while(!quit)
+	{
+		{
+			WebM_Lock lock(_mutex);
+			
+			while(!_have_frame && !_quit)
+				_cond.Wait(_mutex);
+			
+			quit = !_have_frame;
+		}
+		
+		if(!quit)
+		{
+			// _data stays put while _have_frame is set
+			const vpx_image_t *img = NULL;
+			
+			if(_data.size() > 0)
+			{
+				vpx_codec_err_t decode_err = vpx_codec_decode(&_decoder, &_data[0], _data.size(), NULL, 0);
+				
+				if(decode_err == VPX_CODEC_OK)
+				{
+					vpx_codec_iter_t iter = NULL;
+					
+					img = vpx_codec_get_frame(&_decoder, &iter);
+				}
+			}
+			
+			WebM_Lock lock(_mutex);
+			
+			_img = img;
+			_have_frame = false;
+			
+			_cond.Signal();
+		}
+	}
+}
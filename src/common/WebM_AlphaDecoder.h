@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#ifndef WEBM_ALPHADECODER_H
+#define WEBM_ALPHADECODER_H
+
+// WebM keeps alpha as a second VP8/VP9 stream, one frame in the BlockAdditional
+// of each video Block, with the alpha in its Y plane.  It needs its own decoder,
+// and since it doesn't depend on the color frame at all, that decoder gets
+// its own thread.  Decoding the alpha alongside the color frame means it costs
+// about nothing in wall-clock time.  No host SDK in here.
+
+#include "WebM_Thread.h"
+
+extern "C" {
+#include "vpx/vpx_decoder.h"
+}
+
+#include <vector>
+
+
+class WebM_AlphaDecoder : public WebM_Thread
+{
+  public:
+	WebM_AlphaDecoder();
+	virtual ~WebM_AlphaDecoder();
+	
+	// same codec as the color stream
+	bool Begin(vpx_codec_iface_t *iface, int width, int height, int threads);
+	
+	// Starts decoding one alpha frame (copied, so data can go away).
+	// Pass size 0 for a frame without alpha, then Wait() returns NULL.
+	void Submit(const unsigned char *data, size_t size);
+	
+	// The decoded alpha frame, good until the next Submit()
+	const vpx_image_t * Wait();
+	
+  protected:
+	virtual void Run();
+	
+  private:
+	vpx_codec_ctx_t _decoder;
+	bool _decoder_open;
+	bool _pooled;
+	
+	WebM_Mutex _mutex;
+	WebM_Condition _cond;
+	bool _have_frame;
+	bool _quit;
+	
+	std::vector<unsigned char> _data;
+	const vpx_image_t *_img;
+};
+
+
+#endif // WEBM_ALPHADECODER_H
@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_AlphaEncoder.h"
+
+#include "WebM_EncoderConfig.h"
+
+extern "C" {
+#include "vpx/vp8cx.h"
+}
+
+
+WebM_AlphaEncoder::WebM_AlphaEncoder() :
+	_encoder_open(false),
+	_have_frame(false),
+	_quit(false),
+	_result(WEBM_OK),
+	_src(NULL),
+	_pts(0),
+	_duration(0),
+	_flags(0),
+	_deadline(0),
+	_have_packet(false)
+{
+
+}
+
+
+WebM_AlphaEncoder::~WebM_AlphaEncoder()
+{
+	{
+		WebM_Lock lock(_mutex);
+		
+		_quit = true;
+		
+		_cond.Signal();
+	}
+	
+	Join();
+	
+	if(_encoder_open)
+		vpx_codec_destroy(&_encoder);
+}
+
+
+bool
+WebM_AlphaEncoder::Begin(vpx_codec_iface_t *iface, const vpx_codec_enc_cfg_t &main_config,
+							int cq_level, const char *custom_args)
+{
+	vpx_codec_enc_cfg_t config = main_config;
+	
+	// We only come along for the final pass, and we don't have stats of our own
+	if(config.g_pass != VPX_RC_ONE_PASS)
+	{
+		config.g_pass = VPX_RC_ONE_PASS;
+		config.rc_twopass_stats_in.buf = NULL;
+		config.rc_twopass_stats_in.sz = 0;
+	}
+	
+	const bool vp9 = (iface == vpx_codec_vp9_cx());
+	
+	vpx_codec_err_t codec_err = vpx_codec_enc_init(&_encoder, iface, &config, 0);
+	
+	if(codec_err != VPX_CODEC_OK)
+		return false;
+	
+	_encoder_open = true;
+	
+	if(cq_level >= 0)
+		vpx_codec_control(&_encoder, VP8E_SET_CQ_LEVEL, cq_level);
+	
+	ConfigureEncoderThreadsPost(&_encoder, config, vp9);
+	
+	ConfigureEncoderPost(&_encoder, custom_args);
+	
+	return Start();
+}
+
+
+void
+WebM_AlphaEncoder::Submit(const vpx_image_t *img, vpx_codec_pts_t pts, unsigned long duration,
+							vpx_enc_frame_flags_t flags, unsigned long deadline)
+{
+	WebM_Lock lock(_mutex);
+	
+	while(_have_frame)
+		_cond.Wait(_mutex);
+	
+	_src = img;
+	_pts = pts;
+	_duration = duration;
+	_flags = flags;
+	_deadline = deadline;
+	
+	_have_frame = true;
+	
+	_cond.Signal();
+}
+
+
+WebM_Result
+WebM_AlphaEncoder::Wait()
+{
+	WebM_Lock lock(_mutex);
+	
+	while(_have_frame)
+		_cond.Wait(_mutex);
+	
+	return _result;
+}
+
+
+bool
+WebM_AlphaEncoder::TakePacket(std::vector<unsigned char> &packet)
+{
+	WebM_Lock lock(_mutex);
+	
+	if(!_have_packet)
+		return false;
+	
+	packet.swap(_packet);
+	
+	_have_packet = false;
+	
+	return true;
+}
+
+
+void
+WebM_AlphaEncoder::SetCpuUsed(int cpu_used)
+{
+	if(_encoder_open)
+		vpx_codec_control(&_encoder, VP8E_SET_CPUUSED, cpu_used);
+}
+
+
+void
+WebM_AlphaEncoder::Run()
+{
+	bool quit = false;
+	
+	while(!quit)
+	{
+		WebM_Result result = WEBM_OK;
+		
+		{
+			WebM_Lock lock(_mutex);
+			
+			while(!_have_frame && !_quit)
+				_cond.Wait(_mutex);
+			
+			quit = !_have_frame;
+			
+			result = _result;
+		}
+		
+		if(!quit)
+		{
+			// once something's gone wrong, we just keep saying so
+			if(result == WEBM_OK)
+				result = EncodeFrame();
+			
+			WebM_Lock lock(_mutex);
+			
+			_result = result;
+			_have_frame = false;
+			
+			_cond.Signal();
+		}
+	}
+}
+
+
+WebM_Result
+WebM_AlphaEncoder::EncodeFrame()
+{
+	vpx_codec_err_t encode_err = vpx_codec_encode(&_encoder, _src, _pts, _duration, _flags, _deadline);
+	
+	if(encode_err != VPX_CODEC_OK)
+		return WEBM_ERR_INTERNAL;
+	
+	// No lag, so it's one frame in, one frame out
+	const vpx_codec_cx_pkt_t *pkt = NULL;
+	vpx_codec_iter_t iter = NULL;
+	
+	while( (pkt = vpx_codec_get_cx_data(&_encoder, &iter)) )
+	{
+		if(pkt->kind == VPX_CODEC_CX_FRAME_PKT)
+		{
+			const unsigned char *buf = (const unsigned char *)pkt->data.frame.buf;
+			
+			WebM_Lock lock(_mutex);
+			
+			_packet.assign(buf, buf + pkt->data.frame.sz);
+			_have_packet = true;
+		}
+	}
+	
+	return WEBM_OK;
+}
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#ifndef WEBM_ALPHAENCODER_H
+#define WEBM_ALPHAENCODER_H
+
+#include "WebM_Result.h"
+
+#include "WebM_Thread.h"
+
+extern "C" {
+#include "vpx/vpx_encoder.h"
+}
+
+#include <vector>
+
+
+// BlockAddID of the alpha frames, as the WebM alpha spec says
+#define WEBM_ALPHA_ADD_ID	1
+
+
+// The alpha channel goes in the movie as a second VP8/VP9 stream, with the
+// alpha in the Y plane, each frame stored in the BlockAdditional of the
+// color frame it goes with.  It gets its own encoder on its own thread,
+// working on the alpha while the main encoder works on the color, so alpha
+// doesn't double the time an export takes.
+//
+// Both encoders have to make one frame for every frame they're given and put
+// keyframes in the same places, so the caller turns off lag and frame dropping
+// and forces all the keyframes itself, passing the same flags to both.
+
+class WebM_AlphaEncoder : public WebM_Thread
+{
+  public:
+	WebM_AlphaEncoder();
+	virtual ~WebM_AlphaEncoder();
+	
+	// main_config is what the color encoder got.  Pass cq_level < 0 if not in quality mode.
+	bool Begin(vpx_codec_iface_t *iface, const vpx_codec_enc_cfg_t &main_config,
+				int cq_level, const char *custom_args);
+	
+	// Starts encoding img, which has to stay put until Wait() returns
+	void Submit(const vpx_image_t *img, vpx_codec_pts_t pts, unsigned long duration,
+				vpx_enc_frame_flags_t flags, unsigned long deadline);
+	
+	WebM_Result Wait();
+	
+	// The frame that came out, after Wait().  Returns false if there wasn't one.
+	bool TakePacket(std::vector<unsigned char> &packet);
+	
+	// Only while we're not working on a frame, i.e. after Wait()
+	void SetCpuUsed(int cpu_used);
+	
+  protected:
+	virtual void Run();
+	
+  private:
+	WebM_Result EncodeFrame();
+	
+	vpx_codec_ctx_t _encoder;
+	bool _encoder_open;
+	
+	WebM_Mutex _mutex;
+	WebM_Condition _cond;
+	bool _have_frame;
+	bool _quit;
+	WebM_Result _result;
+	
+	// the frame we're working on
+	const vpx_image_t *_src;
+	vpx_codec_pts_t _pts;
+	unsigned long _duration;
+	vpx_enc_frame_flags_t _flags;
+	unsigned long _deadline;
+	
+	std::vector<unsigned char> _packet;
+	bool _have_packet;
+};
+
+
+#endif // WEBM_ALPHAENCODER_H
@@ -0,0 +1,442 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_AudioEncoder.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+WebM_AudioEncoder::WebM_AudioEncoder(WebM_AudioSource *source,
+										int maxBlip, long long endSample) :
+	_maxBlip(maxBlip),
+	_source(source),
+	_endSample(endSample),
+	_done(false),
+	_stop(false),
+	_result(WEBM_OK)
+{
+
+}
+
+
+WebM_AudioEncoder::~WebM_AudioEncoder()
+{
+	Stop();
+	Join();
+	
+	while(!_queue.empty())
+	{
+		delete _queue.front();
+		
+		_queue.pop_front();
+	}
+}
+
+
+WebM_AudioPacket *
+WebM_AudioEncoder::NextPacket(long long granule_limit)
+{
+	WebM_Lock lock(_mutex);
+	
+	// If the queue is empty we don't know yet if the next packet
+	// will come before the limit, so we wait to find out.
+	while(_queue.empty() && !_done)
+		_cond.Wait(_mutex);
+	
+	if(!_queue.empty() && (granule_limit < 0 || _queue.front()->start_granule < granule_limit))
+	{
+		WebM_AudioPacket *packet = _queue.front();
+		
+		_queue.pop_front();
+		
+		_cond.Signal(); // encoder might be waiting for room
+		
+		return packet;
+	}
+	
+	return NULL;
+}
+
+
+WebM_Result
+WebM_AudioEncoder::Result()
+{
+	WebM_Lock lock(_mutex);
+	
+	return _result;
+}
+
+
+void
+WebM_AudioEncoder::Stop()
+{
+	WebM_Lock lock(_mutex);
+	
+	_stop = true;
+	
+	_cond.Signal();
+}
+
+
+bool
+WebM_AudioEncoder::QueuePacket(const unsigned char *data, size_t size, long long start_granule, long long granulepos)
+{
+	WebM_AudioPacket *packet = new WebM_AudioPacket;
+	
+	packet->data.assign(data, data + size);
+	packet->start_granule = start_granule;
+	packet->granulepos = granulepos;
+	
+	WebM_Lock lock(_mutex);
+	
+	while(_queue.size() >= MaxQueuedPackets && !_stop)
+		_cond.Wait(_mutex);
+	
+	if(_stop)
+	{
+		delete packet;
+		
+		return false;
+	}
+	
+	_queue.push_back(packet);
+	
+	_cond.Signal();
+	
+	return true;
+}
+
+
+void
+WebM_AudioEncoder::Run()
+{
+	WebM_Result result = WEBM_OK;
+	
+	long long currentSample = 0;
+	
+	bool stopped = false;
+	
+	while(currentSample < _endSample && result == WEBM_OK && !stopped)
+	{
+		int samples = _maxBlip;
+		
+		if(samples > (_endSample - currentSample))
+			samples = (_endSample - currentSample);
+		
+		float **buffer = Buffer(samples);
+		
+		result = _source->GetAudio(samples, buffer);
+		
+		currentSample += samples;
+		
+		if(result == WEBM_OK)
+			result = Encode(samples);
+		
+		WebM_Lock lock(_mutex);
+		
+		stopped = _stop;
+	}
+	
+	if(result == WEBM_OK && !stopped)
+		result = Encode(0); // means there will be no more data
+	
+	
+	WebM_Lock lock(_mutex);
+	
+	_result = result;
+	_done = true;
+	
+	_cond.Signal();
+}
+
+
+
+
+WebM_VorbisEncoder::WebM_VorbisEncoder(WebM_AudioSource *source,
+											vorbis_dsp_state *vd, vorbis_block *vb,
+											int maxBlip, long long endSample) :
+	WebM_AudioEncoder(source, maxBlip, endSample),
+	_vd(vd),
+	_vb(vb),
+	_last_granulepos(0)
+{
+
+}
+
+
+WebM_VorbisEncoder::~WebM_VorbisEncoder()
+{
+	// have to be done with Encode() before we go away
+	Stop();
+	Join();
+}
+
+
+float **
+WebM_VorbisEncoder::Buffer(int samples)
+{
+	return vorbis_analysis_buffer(_vd, samples);
+}
+
+
+WebM_Result
+WebM_VorbisEncoder::Encode(int samples)
+{
+	vorbis_analysis_wrote(_vd, samples);
+	
+	while(vorbis_analysis_blockout(_vd, _vb) == 1)
+	{
+		vorbis_analysis(_vb, NULL);
+		vorbis_bitrate_addblock(_vb);
+		
+		ogg_packet op;
+		
+		while( vorbis_bitrate_flushpacket(_vd, &op) )
+		{
+			if(op.packet != NULL && op.bytes > 0)
+			{
+				if( !QueuePacket(op.packet, op.bytes, _last_granulepos, op.granulepos) )
+					return WEBM_OK;
+				
+				_last_granulepos = op.granulepos;
+			}
+		}
+	}
+	
+	return WEBM_OK;
+}
+
+
+WebM_OpusEncoder::WebM_OpusEncoder(WebM_AudioSource *source,
+										OpusMSEncoder *encoder, int channels, int preSkip,
+										int maxBlip, long long endSample) :
+	WebM_AudioEncoder(source, maxBlip, endSample),
+	_encoder(encoder),
+	_channels(channels),
+	_preSkip(preSkip),
+	_planar(channels * maxBlip),
+	_buffers(channels),
+	_packet(4000 * channels), // 4000 bytes is plenty for one stream
+	_granulepos(0)
+{
+	for(int c=0; c < _channels; c++)
+		_buffers[c] = &_planar[c * _maxBlip];
+}
+
+
+WebM_OpusEncoder::~WebM_OpusEncoder()
+{
+	Stop();
+	Join();
+}
+
+
+float **
+WebM_OpusEncoder::Buffer(int samples)
+{
+	assert(samples <= _maxBlip);
+	
+	return &_buffers[0];
+}
+
+
+WebM_Result
+WebM_OpusEncoder::Encode(int samples)
+{
+	if(samples > 0)
+	{
+		const size_t start = _interleaved.size();
+		
+		_interleaved.resize(start + (samples * _channels));
+		
+		float *out = &_interleaved[start];
+		
+		for(int i=0; i < samples; i++)
+			for(int c=0; c < _channels; c++)
+				*out++ = _buffers[c][i];
+	}
+	else
+	{
+		// The encoder is still holding on to pre-skip's worth of audio,
+		// so push it through with silence and fill out the last frame.
+		const size_t frame_floats = FrameSize * _channels;
+		
+		size_t total = _interleaved.size() + (_preSkip * _channels);
+		
+		total = ((total + frame_floats - 1) / frame_floats) * frame_floats;
+		
+		_interleaved.resize(total, 0.f);
+	}
+	
+	
+	const size_t frame_floats = FrameSize * _channels;
+	
+	size_t offset = 0;
+	
+	while(_interleaved.size() - offset >= frame_floats)
+	{
+		const int len = opus_multistream_encode_float(_encoder, &_interleaved[offset], FrameSize,
+														&_packet[0], _packet.size());
+		
+		if(len < 0)
+			return WEBM_ERR_INTERNAL;
+		
+		offset += frame_floats;
+		
+		// a packet of 1 or 2 bytes doesn't need to be transmitted, but it's harmless
+		if(len > 0)
+		{
+			if( !QueuePacket(&_packet[0], len, _granulepos, _granulepos + FrameSize) )
+				return WEBM_OK;
+		}
+		
+		_granulepos += FrameSize;
+	}
+	
+	_interleaved.erase(_interleaved.begin(), _interleaved.begin() + offset);
+	
+	return WEBM_OK;
+}
+
+
+#pragma mark-
+
+
+static int
+xiph_len(int l)
+{
+    return 1 + l / 255 + l;
+}
+
+static void
+xiph_lace(unsigned char **np, unsigned long long val)
+{
+	unsigned char *p = *np;
+
+	while(val >= 255)
+	{
+		*p++ = 255;
+		val -= 255;
+	}
+	
+	*p++ = val;
+	
+	*np = p;
+}
+
+void *
+WebM_VorbisPrivateData(ogg_packet &header, ogg_packet &header_comm, ogg_packet &header_code, size_t &size)
+{
+	size = 1 + xiph_len(header.bytes) + xiph_len(header_comm.bytes) + header_code.bytes;
+	
+	void *buf = malloc(size);
+	
+	if(buf)
+	{
+		unsigned char *p = (unsigned char *)buf;
+		
+		*p++ = 2;
+		
+		xiph_lace(&p, header.bytes);
+		xiph_lace(&p, header_comm.bytes);
+		
+		memcpy(p, header.packet, header.bytes);
+		p += header.bytes;
+		memcpy(p, header_comm.packet, header_comm.bytes);
+		p += header_comm.bytes;
+		memcpy(p, header_code.packet, header_code.bytes);
+	}
+	
+	return buf;
+}
+
+
+void *
+WebM_OpusPrivateData(int channels, int pre_skip, int mapping_family,
+					int streams, int coupled_streams, const unsigned char *mapping, size_t &size)
+{
+	// the OpusHead packet, all little-endian
+	size = 19 + (mapping_family == 0 ? 0 : 2 + channels);
+	
+	void *buf = malloc(size);
+	
+	if(buf)
+	{
+		unsigned char *p = (unsigned char *)buf;
+		
+		const unsigned int input_rate = 48000;
+		
+		memcpy(p, "OpusHead", 8);
+		p += 8;
+		
+		*p++ = 1; // version
+		*p++ = channels;
+		*p++ = pre_skip & 0xff;
+		*p++ = (pre_skip >> 8) & 0xff;
+		*p++ = input_rate & 0xff;
+		*p++ = (input_rate >> 8) & 0xff;
+		*p++ = (input_rate >> 16) & 0xff;
+		*p++ = (input_rate >> 24) & 0xff;
+		*p++ = 0; // output gain
+		*p++ = 0;
+		*p++ = mapping_family;
+		
+		if(mapping_family != 0)
+		{
+			*p++ = streams;
+			*p++ = coupled_streams;
+			
+			memcpy(p, mapping, channels);
+		}
+	}
+	
+	return buf;
+}
+
+
+
+unsigned long long
+WebM_AudioTimeStamp(long long granule, long long sampleRate, long long timeCodeScale)
+{
+	const long long timeCode = ((granule * (1000000000UL / timeCodeScale)) + (sampleRate / 2)) / sampleRate;
+	
+	return timeCode * timeCodeScale;
+}
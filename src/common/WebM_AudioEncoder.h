@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_AUDIOENCODER_H
+#define WEBM_AUDIOENCODER_H
+
+#include "WebM_Result.h"
+#include "WebM_Thread.h"
+
+extern "C" {
+#include <vorbis/codec.h>
+#include <opus_multistream.h>
+}
+
+#include <vector>
+#include <deque>
+
+
+// Wherever the audio comes from.  Fills one buffer per channel, in order,
+// starting from the beginning of the export.  Called on the encoder's thread.
+class WebM_AudioSource
+{
+  public:
+	virtual ~WebM_AudioSource() {}
+	
+	virtual WebM_Result GetAudio(int samples, float **buffers) = 0;
+};
+
+
+// Audio gets its own thread, so the video encoder doesn't have to sit
+// around waiting for it.  The thread pulls audio from the host and encodes
+// as fast as it can, and the packets wait in a queue until the muxer
+// on the main thread is ready to interleave them.  Subclasses do the
+// codec-specific part.
+
+typedef struct {
+	std::vector<unsigned char>	data;
+	long long					start_granule;	// first sample this packet produces
+	long long					granulepos;		// one past the last
+} WebM_AudioPacket;
+
+
+
+
+class WebM_AudioEncoder : public WebM_Thread
+{
+  public:
+	WebM_AudioEncoder(WebM_AudioSource *source, int maxBlip, long long endSample);
+	virtual ~WebM_AudioEncoder();
+	
+	// Hands over the next packet if it starts before granule_limit (or any packet
+	// if granule_limit is negative), waiting for the encoder if necessary.
+	// Returns NULL when there isn't one.  Caller deletes the packet.
+	WebM_AudioPacket * NextPacket(long long granule_limit);
+	
+	WebM_Result Result();
+	
+	void Stop();
+	
+  protected:
+	virtual void Run();
+	
+	// Somewhere for the source to put the next samples, one buffer per channel
+	virtual float ** Buffer(int samples) = 0;
+	
+	// Encode the samples now in the buffer.  Zero samples means that's the end.
+	virtual WebM_Result Encode(int samples) = 0;
+	
+	// For Encode() to hand over a finished packet.  Returns false if we've
+	// been told to stop, in which case the packet was thrown away.
+	bool QueuePacket(const unsigned char *data, size_t size, long long start_granule, long long granulepos);
+	
+	const int _maxBlip;
+	
+  private:
+	WebM_AudioSource * const _source;
+	const long long _endSample;
+	
+	WebM_Mutex _mutex;
+	WebM_Condition _cond;
+	std::deque<WebM_AudioPacket *> _queue;
+	bool _done;
+	bool _stop;
+	WebM_Result _result;
+	
+	// about 20 seconds of stereo 48k Vorbis, don't want to run too far ahead
+	enum { MaxQueuedPackets = 2048 };
+};
+
+
+class WebM_VorbisEncoder : public WebM_AudioEncoder
+{
+  public:
+	WebM_VorbisEncoder(WebM_AudioSource *source,
+						vorbis_dsp_state *vd, vorbis_block *vb,
+						int maxBlip, long long endSample);
+	virtual ~WebM_VorbisEncoder();
+	
+  protected:
+	virtual float ** Buffer(int samples);
+	virtual WebM_Result Encode(int samples);
+	
+  private:
+	vorbis_dsp_state * const _vd;
+	vorbis_block * const _vb;
+	
+	long long _last_granulepos;
+};
+
+
+// Opus takes interleaved samples in fixed-size frames, so we collect
+// the host's audio until there's enough for a frame.  Timestamps count from
+// the very first sample out of the encoder, pre-skip and all, which is
+// how WebM wants them.
+
+
+
+class WebM_OpusEncoder : public WebM_AudioEncoder
+{
+  public:
+	WebM_OpusEncoder(WebM_AudioSource *source,
+						OpusMSEncoder *encoder, int channels, int preSkip,
+						int maxBlip, long long endSample);
+	virtual ~WebM_OpusEncoder();
+	
+  protected:
+	virtual float ** Buffer(int samples);
+	virtual WebM_Result Encode(int samples);
+	
+  private:
+	OpusMSEncoder * const _encoder;
+	const int _channels;
+	const int _preSkip;
+	
+	std::vector<float> _planar;
+	std::vector<float *> _buffers;
+	std::vector<float> _interleaved;
+	std::vector<unsigned char> _packet;
+	
+	long long _granulepos;
+	
+	enum { FrameSize = 960 }; // 20 ms at 48k
+};
+
+
+// CodecPrivate for the track, malloc'ed
+void * WebM_VorbisPrivateData(ogg_packet &header, ogg_packet &header_comm, ogg_packet &header_code, size_t &size);
+
+void * WebM_OpusPrivateData(int channels, int pre_skip, int mapping_family,
+							int streams, int coupled_streams, const unsigned char *mapping, size_t &size);
+
+// An audio block gets the time of its own first sample, quantized like the video
+unsigned long long WebM_AudioTimeStamp(long long granule, long long sampleRate, long long timeCodeScale);
+
+
+#endif // WEBM_AUDIOENCODER_H
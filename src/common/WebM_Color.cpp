@@ -0,0 +1,436 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_Color.h"
+
+#include <string.h>
+
+#include <vector>
+
+
+void
+WebM_CopyYUV420ToImage(vpx_image_t *img,
+						const unsigned char *Y, long Y_rowbytes,
+						const unsigned char *U, long U_rowbytes,
+						const unsigned char *V, long V_rowbytes)
+{
+	for(int y = 0; y < img->d_h; y++)
+	{
+		unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
+		
+		const unsigned char *prY = Y + (Y_rowbytes * y);
+		
+		memcpy(imgY, prY, img->d_w * sizeof(unsigned char));
+	}
+	
+	for(int y = 0; y < img->d_h / 2; y++)
+	{
+		unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * y);
+		unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * y);
+		
+		const unsigned char *prU = U + (U_rowbytes * y);
+		const unsigned char *prV = V + (V_rowbytes * y);
+		
+		memcpy(imgU, prU, (img->d_w / 2) * sizeof(unsigned char));
+		memcpy(imgV, prV, (img->d_w / 2) * sizeof(unsigned char));
+	}
+	
+	// The host's chroma planes stop at half the size, rounded down.  With odd
+	// dimensions the image has one more column or row, which we fill from
+	// its neighbour so the encoder doesn't see whatever the last frame left.
+	const int chroma_w = (img->d_w + 1) / 2;
+	const int chroma_h = (img->d_h + 1) / 2;
+	
+	if(img->d_w & 1)
+	{
+		for(int y = 0; y < img->d_h / 2; y++)
+		{
+			unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * y);
+			unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * y);
+			
+			imgU[chroma_w - 1] = (chroma_w > 1 ? imgU[chroma_w - 2] : 128);
+			imgV[chroma_w - 1] = (chroma_w > 1 ? imgV[chroma_w - 2] : 128);
+		}
+	}
+	
+	if(img->d_h & 1)
+	{
+		unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * (chroma_h - 1));
+		unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * (chroma_h - 1));
+		
+		if(chroma_h > 1)
+		{
+			memcpy(imgU, imgU - img->stride[VPX_PLANE_U], chroma_w * sizeof(unsigned char));
+			memcpy(imgV, imgV - img->stride[VPX_PLANE_V], chroma_w * sizeof(unsigned char));
+		}
+		else
+		{
+			memset(imgU, 128, chroma_w);
+			memset(imgV, 128, chroma_w);
+		}
+	}
+}
+
+
+void
+WebM_CopyImageToYUV420(const vpx_image_t *img,
+						unsigned char *Y, long Y_rowbytes,
+						unsigned char *U, long U_rowbytes,
+						unsigned char *V, long V_rowbytes)
+{
+	for(int y = 0; y < img->d_h; y++)
+	{
+		const unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
+		
+		unsigned char *prY = Y + (Y_rowbytes * y);
+		
+		memcpy(prY, imgY, img->d_w * sizeof(unsigned char));
+	}
+	
+	for(int y = 0; y < img->d_h / 2; y++)
+	{
+		const unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * y);
+		const unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * y);
+		
+		unsigned char *prU = U + (U_rowbytes * y);
+		unsigned char *prV = V + (V_rowbytes * y);
+		
+		memcpy(prU, imgU, (img->d_w / 2) * sizeof(unsigned char));
+		memcpy(prV, imgV, (img->d_w / 2) * sizeof(unsigned char));
+	}
+}
+
+
+void
+WebM_BGRA8ToImage(vpx_image_t *img, const unsigned char *bgra, long rowbytes, bool flipped)
+{
+	// so here's our dumb RGB to YUV conversion
+
+	for(int y = 0; y < img->d_h; y++)
+	{
+		// using the conversion found here: http://www.fourcc.org/fccyvrgb.php
+		
+		unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
+		unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * (y / 2));
+		unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * (y / 2));
+		
+		const unsigned char *prBGRA = bgra + (rowbytes * (flipped ? (img->d_h - 1 - y) : y));
+		
+		const unsigned char *prB = prBGRA + 0;
+		const unsigned char *prG = prBGRA + 1;
+		const unsigned char *prR = prBGRA + 2;
+		
+		for(int x=0; x < img->d_w; x++)
+		{
+			// like the clever integer (fixed point) math?
+			*imgY++ = ((257 * (int)*prR) + (504 * (int)*prG) + ( 98 * (int)*prB) + 16500) / 1000;
+			
+			if( (y % 2 == 0) && (x % 2 == 0) )
+			{
+				*imgV++ = ((439 * (int)*prR) - (368 * (int)*prG) - ( 71 * (int)*prB) + 128500) / 1000;
+				*imgU++ = (-(148 * (int)*prR) - (291 * (int)*prG) + (439 * (int)*prB) + 128500) / 1000;
+			}
+			
+			prR += 4;
+			prG += 4;
+			prB += 4;
+		}
+	}
+}
+
+
+// converting from the Adobe 16-bit, i.e. max_val is 0x8000
+static inline unsigned char
+Convert16to8(const unsigned short &v)
+{
+	return ( (((long)(v) * 255) + 16384) / 32768);
+}
+
+
+void
+WebM_BGRA16ToImage(vpx_image_t *img, const unsigned short *bgra, long rowbytes, bool flipped)
+{
+	// since we're doing an RGB to YUV conversion, it wouldn't hurt to have some extra bits
+	
+	for(int y = 0; y < img->d_h; y++)
+	{
+		unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
+		unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * (y / 2));
+		unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * (y / 2));
+		
+		const unsigned short *prBGRA = (const unsigned short *)((const unsigned char *)bgra + (rowbytes * (flipped ? (img->d_h - 1 - y) : y)));
+		
+		const unsigned short *prB = prBGRA + 0;
+		const unsigned short *prG = prBGRA + 1;
+		const unsigned short *prR = prBGRA + 2;
+		
+		for(int x=0; x < img->d_w; x++)
+		{
+			*imgY++ = Convert16to8( ((257 * (int)*prR) + (504 * (int)*prG) + ( 98 * (int)*prB) + 2056500) / 1000 );
+			
+			if( (y % 2 == 0) && (x % 2 == 0) )
+			{
+				*imgV++ = Convert16to8( ((439 * (int)*prR) - (368 * (int)*prG) - ( 71 * (int)*prB) + 16449500) / 1000 );
+				*imgU++ = Convert16to8( (-(148 * (int)*prR) - (291 * (int)*prG) + (439 * (int)*prB) + 16449500) / 1000 );
+			}
+			
+			prR += 4;
+			prG += 4;
+			prB += 4;
+		}
+	}
+}
+
+
+static void
+NeutralChroma(vpx_image_t *img)
+{
+	for(int y = 0; y < (img->d_h + 1) / 2; y++)
+	{
+		memset(img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * y), 128, (img->d_w + 1) / 2);
+		memset(img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * y), 128, (img->d_w + 1) / 2);
+	}
+}
+
+
+void
+WebM_BGRA8AlphaToImage(vpx_image_t *img, const unsigned char *bgra, long rowbytes, bool flipped)
+{
+	// alpha goes in as is, full range, no 16-235 business
+	for(int y = 0; y < img->d_h; y++)
+	{
+		unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
+		
+		const unsigned char *prA = bgra + (rowbytes * (flipped ? (img->d_h - 1 - y) : y)) + 3;
+		
+		for(int x=0; x < img->d_w; x++)
+		{
+			*imgY++ = *prA;
+			
+			prA += 4;
+		}
+	}
+	
+	NeutralChroma(img);
+}
+
+
+void
+WebM_BGRA16AlphaToImage(vpx_image_t *img, const unsigned short *bgra, long rowbytes, bool flipped)
+{
+	for(int y = 0; y < img->d_h; y++)
+	{
+		unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
+		
+		const unsigned short *prA = (const unsigned short *)((const unsigned char *)bgra + (rowbytes * (flipped ? (img->d_h - 1 - y) : y))) + 3;
+		
+		for(int x=0; x < img->d_w; x++)
+		{
+			*imgY++ = Convert16to8(*prA);
+			
+			prA += 4;
+		}
+	}
+	
+	NeutralChroma(img);
+}
+
+
+static inline unsigned char
+Clamp8(int v)
+{
+	return (v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+
+void
+WebM_CopyImageToBGRA8(const vpx_image_t *img, const vpx_image_t *alpha,
+						unsigned char *bgra, long rowbytes, bool flipped)
+{
+	// the same fourcc.org numbers as going the other way, turned around
+	for(int y = 0; y < img->d_h; y++)
+	{
+		const unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
+		const unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * (y / 2));
+		const unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * (y / 2));
+		
+		const unsigned char *imgA = (alpha != NULL ? alpha->planes[VPX_PLANE_Y] + (alpha->stride[VPX_PLANE_Y] * y) : NULL);
+		
+		unsigned char *prBGRA = bgra + (rowbytes * (flipped ? (img->d_h - 1 - y) : y));
+		
+		for(int x=0; x < img->d_w; x++)
+		{
+			const int Y = 1164 * ((int)imgY[x] - 16);
+			const int U = (int)imgU[x / 2] - 128;
+			const int V = (int)imgV[x / 2] - 128;
+			
+			*prBGRA++ = Clamp8((Y + (2018 * U) + 500) / 1000);
+			*prBGRA++ = Clamp8((Y - (813 * V) - (391 * U) + 500) / 1000);
+			*prBGRA++ = Clamp8((Y + (1596 * V) + 500) / 1000);
+			*prBGRA++ = (imgA != NULL ? imgA[x] : 255);
+		}
+	}
+}
+
+
+static void
+ScalePlane(const unsigned char *src, int src_stride, int src_w, int src_h,
+			unsigned char *dst, int dst_stride, int dst_w, int dst_h)
+{
+	// A box filter.  Going down a ladder we're only ever shrinking, and then
+	// this is cheap and doesn't alias.  Going up it turns into nearest neighbor.
+	// The column spans are the same for every row, so we work them out once.
+	std::vector<int> x_start(dst_w + 1);
+	
+	for(int x = 0; x <= dst_w; x++)
+		x_start[x] = (long long)x * src_w / dst_w;
+	
+	for(int y = 0; y < dst_h; y++)
+	{
+		const int y0 = (long long)y * src_h / dst_h;
+		int y1 = (long long)(y + 1) * src_h / dst_h;
+		
+		if(y1 <= y0)
+			y1 = y0 + 1;
+		
+		unsigned char *out = dst + (dst_stride * y);
+		
+		for(int x = 0; x < dst_w; x++)
+		{
+			const int x0 = x_start[x];
+			int x1 = x_start[x + 1];
+			
+			if(x1 <= x0)
+				x1 = x0 + 1;
+			
+			unsigned int sum = 0;
+			
+			for(int sy = y0; sy < y1; sy++)
+			{
+				const unsigned char *in = src + (src_stride * sy);
+				
+				for(int sx = x0; sx < x1; sx++)
+					sum += in[sx];
+			}
+			
+			const unsigned int count = (y1 - y0) * (x1 - x0);
+			
+			*out++ = (sum + (count / 2)) / count;
+		}
+	}
+}
+
+
+void
+WebM_ScaleImage(const vpx_image_t *src, vpx_image_t *dst)
+{
+	ScalePlane(src->planes[VPX_PLANE_Y], src->stride[VPX_PLANE_Y], src->d_w, src->d_h,
+				dst->planes[VPX_PLANE_Y], dst->stride[VPX_PLANE_Y], dst->d_w, dst->d_h);
+	
+	const int src_chroma_w = (src->d_w + 1) / 2;
+	const int src_chroma_h = (src->d_h + 1) / 2;
+	const int dst_chroma_w = (dst->d_w + 1) / 2;
+	const int dst_chroma_h = (dst->d_h + 1) / 2;
+	
+	ScalePlane(src->planes[VPX_PLANE_U], src->stride[VPX_PLANE_U], src_chroma_w, src_chroma_h,
+				dst->planes[VPX_PLANE_U], dst->stride[VPX_PLANE_U], dst_chroma_w, dst_chroma_h);
+	
+	ScalePlane(src->planes[VPX_PLANE_V], src->stride[VPX_PLANE_V], src_chroma_w, src_chroma_h,
+				dst->planes[VPX_PLANE_V], dst->stride[VPX_PLANE_V], dst_chroma_w, dst_chroma_h);
+}
+
+
+static inline unsigned long long
+HashMix(unsigned long long h, unsigned long long v)
+{
+	h ^= v * 0x9e3779b97f4a7c15ULL;
+	h = (h << 31) | (h >> 33);
+	
+	return h * 0xc2b2ae3d27d4eb4fULL;
+}
+
+
+static unsigned long long
+HashPlane(unsigned long long h, const unsigned char *plane, int stride, int width, int height)
+{
+	for(int y = 0; y < height; y++)
+	{
+		const unsigned char *row = plane + (stride * y);
+		
+		// eight bytes at a time, then whatever's left
+		int x = 0;
+		
+		for(; x + 8 <= width; x += 8)
+		{
+			unsigned long long v;
+			memcpy(&v, row + x, 8);
+			
+			h = HashMix(h, v);
+		}
+		
+		if(x < width)
+		{
+			unsigned long long v = 0;
+			memcpy(&v, row + x, width - x);
+			
+			h = HashMix(h, v);
+		}
+	}
+	
+	return h;
+}
+
+
+unsigned long long
+WebM_HashImage(const vpx_image_t *img)
+{
+	// With odd dimensions, the last chroma column and row don't make it
+	// through the host's buffers (see WebM_CopyYUV420ToImage), so they
+	// can't be part of a hash the importer and exporter have to agree on.
+	const int chroma_w = img->d_w / 2;
+	const int chroma_h = img->d_h / 2;
+	
+	unsigned long long h = HashMix(img->d_w, img->d_h);
+	
+	h = HashPlane(h, img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y], img->d_w, img->d_h);
+	h = HashPlane(h, img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U], chroma_w, chroma_h);
+	h = HashPlane(h, img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V], chroma_w, chroma_h);
+	
+	return h;
+}
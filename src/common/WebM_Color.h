@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_COLOR_H
+#define WEBM_COLOR_H
+
+// Pixel shuffling between host buffers and libvpx images.
+// No host SDK in here, just pointers and rowbytes.
+
+extern "C" {
+#include "vpx/vpx_image.h"
+}
+
+
+// Planar 8-bit 4:2:0 buffers (Premiere's YUV_420_MPEG2 format) to and from an I420 image
+void WebM_CopyYUV420ToImage(vpx_image_t *img,
+							const unsigned char *Y, long Y_rowbytes,
+							const unsigned char *U, long U_rowbytes,
+							const unsigned char *V, long V_rowbytes);
+
+void WebM_CopyImageToYUV420(const vpx_image_t *img,
+							unsigned char *Y, long Y_rowbytes,
+							unsigned char *U, long U_rowbytes,
+							unsigned char *V, long V_rowbytes);
+
+
+// Interleaved BGRA to an I420 image.  If flipped is true, the first row
+// in the buffer is the bottom of the picture, which is how Premiere does it.
+void WebM_BGRA8ToImage(vpx_image_t *img, const unsigned char *bgra, long rowbytes, bool flipped);
+
+void WebM_BGRA16ToImage(vpx_image_t *img, const unsigned short *bgra, long rowbytes, bool flipped);
+
+// Just the A of BGRA, into the Y plane of an I420 image, with neutral U and V.
+// That's how the alpha stream in a WebM BlockAdditional is coded.
+void WebM_BGRA8AlphaToImage(vpx_image_t *img, const unsigned char *bgra, long rowbytes, bool flipped);
+
+void WebM_BGRA16AlphaToImage(vpx_image_t *img, const unsigned short *bgra, long rowbytes, bool flipped);
+
+
+// I420 back to BGRA, taking A from the Y plane of alpha (or opaque if it's NULL)
+void WebM_CopyImageToBGRA8(const vpx_image_t *img, const vpx_image_t *alpha,
+							unsigned char *bgra, long rowbytes, bool flipped);
+
+
+// Resize one I420 image into another, using whatever sizes they already have.
+// Each destination pixel is the average of the source pixels under it.
+void WebM_ScaleImage(const vpx_image_t *src, vpx_image_t *dst);
+
+
+// A 64-bit hash of the visible pixels in an I420 image, for spotting
+// frames that are exactly the same as the last one.
+unsigned long long WebM_HashImage(const vpx_image_t *img);
+
+
+#endif // WEBM_COLOR_H
@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_DASH.h"
+
+#include "webmids.hpp"
+
+#include <stdio.h>
+
+#include <sstream>
+
+
+void
+WebM_NoteElement(WebM_MkvLayout &layout, unsigned long long element_id, long long position)
+{
+	if(element_id == mkvmuxer::kMkvCluster)
+	{
+		// we get notified again when the muxer goes back to fix things up
+		if(layout.first_cluster < 0 || position < layout.first_cluster)
+			layout.first_cluster = position;
+	}
+	else if(element_id == mkvmuxer::kMkvCues)
+	{
+		layout.cues = position;
+	}
+}
+
+
+static std::string
+XMLEscape(const std::string &str)
+{
+	std::string out;
+	
+	for(int i=0; i < str.size(); i++)
+	{
+		const char c = str[i];
+		
+		if(c == '&')
+			out += "&amp;";
+		else if(c == '<')
+			out += "&lt;";
+		else if(c == '>')
+			out += "&gt;";
+		else if(c == '\"')
+			out += "&quot;";
+		else
+			out += c;
+	}
+	
+	return out;
+}
+
+
+static std::string
+Duration(double seconds)
+{
+	char str[64];
+	
+	sprintf(str, "PT%.3fS", seconds);
+	
+	return str;
+}
+
+
+static void
+WriteRepresentations(std::stringstream &mpd, const std::vector<WebM_DASHRepresentation> &reps,
+						int &id, double duration)
+{
+	for(int i=0; i < reps.size(); i++)
+	{
+		const WebM_DASHRepresentation &rep = reps[i];
+		
+		const long long bandwidth = (duration > 0.0 ? (double)rep.layout.size * 8.0 / duration : 0.0);
+		
+		mpd << "      <Representation id=\"" << id++ << "\" bandwidth=\"" << bandwidth << "\"";
+		
+		if(rep.width > 0)
+			mpd << " width=\"" << rep.width << "\" height=\"" << rep.height << "\"";
+		
+		if(rep.sample_rate > 0)
+			mpd << " audioSamplingRate=\"" << rep.sample_rate << "\"";
+		
+		mpd << ">\n";
+		
+		if(rep.channels > 0)
+		{
+			mpd << "        <AudioChannelConfiguration schemeIdUri=\"urn:mpeg:dash:23003:3:audio_channel_configuration:2011\""
+				<< " value=\"" << rep.channels << "\"/>\n";
+		}
+		
+		mpd << "        <BaseURL>" << XMLEscape(rep.url) << "</BaseURL>\n";
+		
+		// The Cues are the index and they're the last thing in the file.
+		// Everything before the first Cluster is what a player needs to get started.
+		if(rep.layout.cues > 0 && rep.layout.first_cluster > 0 && rep.layout.size > rep.layout.cues)
+		{
+			mpd << "        <SegmentBase indexRange=\"" << rep.layout.cues << "-" << (rep.layout.size - 1) << "\">\n";
+			mpd << "          <Initialization range=\"0-" << (rep.layout.first_cluster - 1) << "\"/>\n";
+			mpd << "        </SegmentBase>\n";
+		}
+		
+		mpd << "      </Representation>\n";
+	}
+}
+
+
+std::string
+WebM_DASHManifest(const std::vector<WebM_DASHRepresentation> &video,
+					const std::vector<WebM_DASHRepresentation> &audio,
+					double duration, double min_buffer_time)
+{
+	std::stringstream mpd;
+	
+	mpd << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	mpd << "<MPD xmlns=\"urn:mpeg:DASH:schema:MPD:2011\""
+		<< " type=\"static\""
+		<< " mediaPresentationDuration=\"" << Duration(duration) << "\""
+		<< " minBufferTime=\"" << Duration(min_buffer_time) << "\""
+		<< " profiles=\"urn:mpeg:dash:profile:isoff-on-demand:2011\">\n";
+	
+	mpd << "  <Period id=\"0\" start=\"PT0S\" duration=\"" << Duration(duration) << "\">\n";
+	
+	int set_id = 0;
+	int rep_id = 0;
+	
+	if(video.size() > 0)
+	{
+		// all the renditions have keyframes in the same places, so players can switch
+		mpd << "    <AdaptationSet id=\"" << set_id++ << "\" mimeType=\"video/webm\""
+			<< " codecs=\"" << video[0].codecs << "\""
+			<< " subsegmentAlignment=\"true\" subsegmentStartsWithSAP=\"1\" bitstreamSwitching=\"true\">\n";
+		
+		WriteRepresentations(mpd, video, rep_id, duration);
+		
+		mpd << "    </AdaptationSet>\n";
+	}
+	
+	if(audio.size() > 0)
+	{
+		mpd << "    <AdaptationSet id=\"" << set_id++ << "\" mimeType=\"audio/webm\""
+			<< " codecs=\"" << audio[0].codecs << "\""
+			<< " subsegmentAlignment=\"true\" subsegmentStartsWithSAP=\"1\">\n";
+		
+		WriteRepresentations(mpd, audio, rep_id, duration);
+		
+		mpd << "    </AdaptationSet>\n";
+	}
+	
+	mpd << "  </Period>\n";
+	mpd << "</MPD>\n";
+	
+	return mpd.str();
+}
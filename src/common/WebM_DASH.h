@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_DASH_H
+#define WEBM_DASH_H
+
+// Bits for writing a DASH manifest (MPD) to go along with WebM files.
+// No host SDK in here either.
+
+#include <string>
+#include <vector>
+
+
+// Where things ended up in a finished WebM file.  The writer fills
+// this in as the muxer tells it about elements.  Positions are -1 until we've seen them.
+typedef struct WebM_MkvLayout {
+	long long	first_cluster;	// everything before this is the header
+	long long	cues;
+	long long	size;
+	
+	WebM_MkvLayout() : first_cluster(-1), cues(-1), size(0) {}
+} WebM_MkvLayout;
+
+// call from IMkvWriter::ElementStartNotify()
+void WebM_NoteElement(WebM_MkvLayout &layout, unsigned long long element_id, long long position);
+
+
+typedef struct WebM_DASHRepresentation {
+	std::string		url;		// UTF-8, relative to the manifest
+	std::string		codecs;		// "vp8", "vp9", "vorbis", "opus"
+	int				width;		// video
+	int				height;
+	int				sample_rate;	// audio
+	int				channels;
+	WebM_MkvLayout	layout;
+	
+	WebM_DASHRepresentation() : width(0), height(0), sample_rate(0), channels(0) {}
+} WebM_DASHRepresentation;
+
+
+// An on-demand profile MPD with one adaptation set for the video files and
+// one for the audio, if there is any.  The files have to be finished,
+// with Cues, and the video ones need their keyframes lined up.
+std::string WebM_DASHManifest(const std::vector<WebM_DASHRepresentation> &video,
+								const std::vector<WebM_DASHRepresentation> &audio,
+								double duration, double min_buffer_time);
+
+
+#endif // WEBM_DASH_H
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_DecoderThreads.h"
+
+#include "WebM_Thread.h"
+#include "WebM_Speed.h"
+
+#include <map>
+
+
+typedef struct {
+	double		pixels;
+	double		last_used;	// WebM_Seconds()
+	int			decoding;	// how many decoders it has right now
+} ClipUse;
+
+
+static WebM_Mutex gClipsMutex;
+
+static std::map<int, ClipUse> gClips;
+
+// how long a clip still counts after it stops decoding
+static const double kActiveSeconds = 1.0;
+
+
+WebM_DecoderThreads::WebM_DecoderThreads(int clip, int width, int height, int num_cpus) :
+	_clip(clip),
+	_threads(1)
+{
+	WebM_Lock lock(gClipsMutex);
+	
+	const double now = WebM_Seconds();
+	
+	ClipUse &use = gClips[clip];
+	
+	use.pixels = (double)width * (double)height;
+	use.last_used = now;
+	use.decoding++; // map initializes it to 0
+	
+	// forget the clips that have stopped playing, add up the rest
+	double active_pixels = 0.0;
+	
+	std::map<int, ClipUse>::iterator i = gClips.begin();
+	
+	while(i != gClips.end())
+	{
+		if(i->second.decoding == 0 && (now - i->second.last_used) > kActiveSeconds)
+		{
+			gClips.erase(i++);
+		}
+		else
+		{
+			active_pixels += i->second.pixels;
+			++i;
+		}
+	}
+	
+	if(active_pixels > 0.0 && num_cpus > 1)
+	{
+		_threads = ((double)num_cpus * use.pixels / active_pixels) + 0.5;
+		
+		if(_threads < 1)
+			_threads = 1;
+		else if(_threads > num_cpus)
+			_threads = num_cpus;
+	}
+}
+
+
+WebM_DecoderThreads::~WebM_DecoderThreads()
+{
+	WebM_Lock lock(gClipsMutex);
+	
+	std::map<int, ClipUse>::iterator use = gClips.find(_clip);
+	
+	if(use != gClips.end())
+	{
+		use->second.decoding--;
+		use->second.last_used = WebM_Seconds();
+	}
+}
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#ifndef WEBM_DECODERTHREADS_H
+#define WEBM_DECODERTHREADS_H
+
+// One thread budget for every decoder in the process.  Each clip used to
+// ask for a thread per CPU, so nine multicam angles meant nine times as
+// many threads as cores, all fighting.  Now the cores get split among the
+// clips that are being played, bigger frames getting a bigger share.
+// A clip counts as being played if it's decoding right now, or did within
+// the last second (multicam asks for the angles one after another).
+//
+// libvpx makes its own threads, so we can't hand it a shared pool.  Giving
+// each decoder its share of the budget is the next best thing.
+
+class WebM_DecoderThreads
+{
+  public:
+	// Hold on to this while the decoder exists.  clip is anything that tells
+	// clips apart, like the importer ID.
+	WebM_DecoderThreads(int clip, int width, int height, int num_cpus);
+	~WebM_DecoderThreads();
+	
+	int Threads() const { return _threads; }
+	
+  private:
+	const int _clip;
+	int _threads;
+};
+
+
+#endif // WEBM_DECODERTHREADS_H
@@ -0,0 +1,380 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_EncoderConfig.h"
+
+extern "C" {
+
+#include "vpx/vp8cx.h"
+
+}
+
+
+#include <sstream>
+#include <vector>
+
+using std::string;
+
+
+static bool
+quotedTokenize(const string& str,
+				  std::vector<string>& tokens,
+				  const string& delimiters = " ")
+{
+	// this function will respect quoted strings when tokenizing
+	// the quotes will be included in the returned strings
+	
+	int i = 0;
+	bool in_quotes = false;
+	
+	// if there are un-quoted delimiters in the beginning, skip them
+	while(i < str.size() && str[i] != '\"' && string::npos != delimiters.find(str[i]) )
+		i++;
+	
+	string::size_type lastPos = i;
+	
+	while(i < str.size())
+	{
+		if(str[i] == '\"' && (i == 0 || str[i-1] != '\\'))
+			in_quotes = !in_quotes;
+		else if(!in_quotes)
+		{
+			if( string::npos != delimiters.find(str[i]) )
+			{
+				tokens.push_back(str.substr(lastPos, i - lastPos));
+				
+				lastPos = i + 1;
+				
+				// if there are more delimiters ahead, push forward
+				while(lastPos < str.size() && (str[lastPos] != '\"' || str[lastPos-1] != '\\') && string::npos != delimiters.find(str[lastPos]) )
+					lastPos++;
+					
+				i = lastPos;
+				continue;
+			}
+		}
+		
+		i++;
+	}
+	
+	if(in_quotes)
+		return false;
+	
+	// we're at the end, was there anything left?
+	if(str.size() - lastPos > 0)
+		tokens.push_back( str.substr(lastPos) );
+	
+	return true;
+}
+
+
+template <typename T>
+static void SetValue(T &v, string s)
+{
+	std::stringstream ss;
+	
+	ss << s;
+	
+	ss >> v;
+}
+
+
+bool
+ConfigureEncoderPre(vpx_codec_enc_cfg_t &config, const char *txt)
+{
+	std::vector<string> args;
+	
+	if(quotedTokenize(txt, args, " =\t\r\n") && args.size() > 0)
+	{
+		args.push_back(""); // so there's always an i+1
+		
+		int i = 0;
+		
+		while(i < args.size())
+		{
+			const string &arg = args[i];
+			
+			if(arg == "-t" || arg == "--threads")
+			{	SetValue(config.g_threads, args[i + 1]); i++;	}
+			
+			else if(arg == "--lag-in-frames")
+			{	SetValue(config.g_lag_in_frames, args[i + 1]); i++;	}
+			
+			else if(arg == "--drop-frame")
+			{	SetValue(config.rc_dropframe_thresh, args[i + 1]); i++;	}
+			
+			else if(arg == "--resize-allowed")
+			{	SetValue(config.rc_resize_allowed, args[i + 1]); i++;	}
+			
+			else if(arg == "--resize-up")
+			{	SetValue(config.rc_resize_up_thresh, args[i + 1]); i++;	}
+			
+			else if(arg == "--resize-down")
+			{	SetValue(config.rc_resize_down_thresh, args[i + 1]); i++;	}
+			
+			else if(arg == "--target-bitrate")
+			{	SetValue(config.rc_target_bitrate, args[i + 1]); i++;	}
+			
+			else if(arg == "--min-q")
+			{	SetValue(config.rc_min_quantizer, args[i + 1]); i++;	}
+			
+			else if(arg == "--max-q")
+			{	SetValue(config.rc_max_quantizer, args[i + 1]); i++;	}
+			
+			else if(arg == "--undershoot-pct")
+			{	SetValue(config.rc_undershoot_pct, args[i + 1]); i++;	}
+			
+			else if(arg == "--overshoot-pct")
+			{	SetValue(config.rc_overshoot_pct, args[i + 1]); i++;	}
+
+			else if(arg == "--buf-sz")
+			{	SetValue(config.rc_buf_sz, args[i + 1]); i++;	}
+
+			else if(arg == "--buf-initial-sz")
+			{	SetValue(config.rc_buf_initial_sz, args[i + 1]); i++;	}
+
+			else if(arg == "--buf-optimal-sz")
+			{	SetValue(config.rc_buf_optimal_sz, args[i + 1]); i++;	}
+
+			else if(arg == "--bias-pct")
+			{	SetValue(config.rc_2pass_vbr_bias_pct, args[i + 1]); i++;	}
+
+			else if(arg == "--minsection-pct")
+			{	SetValue(config.rc_2pass_vbr_minsection_pct, args[i + 1]); i++;	}
+
+			else if(arg == "--maxsection-pct")
+			{	SetValue(config.rc_2pass_vbr_maxsection_pct, args[i + 1]); i++;	}
+
+			else if(arg == "--kf-min-dist")
+			{	SetValue(config.kf_min_dist, args[i + 1]); i++;	}
+
+			else if(arg == "--kf-max-dist")
+			{	SetValue(config.kf_max_dist, args[i + 1]); i++;	}
+
+			else if(arg == "--disable-kf")
+			{	config.kf_mode = VPX_KF_DISABLED;	}
+
+			else if(arg == "--periodicity")
+			{	SetValue(config.ts_periodicity, args[i + 1]); i++;	}
+
+			
+			i++;
+		}
+	
+		return true;
+	}
+	else
+		return false;
+}
+
+
+#define ConfigureValue(encoder, ctrl_id, s) \
+	do{							\
+		std::stringstream ss;	\
+		ss << s;				\
+		unsigned int v = 0;		\
+		ss >> v;				\
+		config_err = vpx_codec_control(encoder, ctrl_id, v); \
+	}while(0)
+
+bool
+ConfigureEncoderPost(vpx_codec_ctx_t *encoder, const char *txt)
+{
+	std::vector<string> args;
+	
+	vpx_codec_err_t config_err = VPX_CODEC_OK;
+	
+	if(quotedTokenize(txt, args, " =\t\r\n") && args.size() > 0)
+	{
+		args.push_back(""); // so there's always an i+1
+		
+		int i = 0;
+		
+		while(i < args.size())
+		{
+			const string &arg = args[i];
+		
+			if(arg == "--noise-sensitivity")
+			{	ConfigureValue(encoder, VP8E_SET_NOISE_SENSITIVITY, args[i + 1]); i++;	}
+
+			else if(arg == "--sharpness")
+			{	ConfigureValue(encoder, VP8E_SET_SHARPNESS, args[i + 1]); i++;	}
+
+			else if(arg == "--cpu-used")
+			{	ConfigureValue(encoder, VP8E_SET_CPUUSED, args[i + 1]); i++;	}
+
+			else if(arg == "--token-parts")
+			{	ConfigureValue(encoder, VP8E_SET_TOKEN_PARTITIONS, args[i + 1]); i++;	}
+
+			else if(arg == "--tile-columns")
+			{	ConfigureValue(encoder, VP9E_SET_TILE_COLUMNS, args[i + 1]); i++;	}
+
+			else if(arg == "--auto-alt-ref")
+			{	ConfigureValue(encoder, VP8E_SET_ENABLEAUTOALTREF, args[i + 1]); i++;	}
+
+			else if(arg == "--arnr-maxframes")
+			{	ConfigureValue(encoder, VP8E_SET_ARNR_MAXFRAMES, args[i + 1]); i++;	}
+
+			else if(arg == "--arnr-strength")
+			{	ConfigureValue(encoder, VP8E_SET_ARNR_STRENGTH, args[i + 1]); i++;	}
+
+			else if(arg == "--arnr-type")
+			{	ConfigureValue(encoder, VP8E_SET_ARNR_TYPE, args[i + 1]); i++;	}
+
+			else if(arg == "--tune")
+			{
+				unsigned int val = args[i + 1] == "psnr" ? VP8_TUNE_PSNR :
+									args[i + 1] == "ssim" ? VP8_TUNE_SSIM :
+									0;
+			
+				ConfigureValue(encoder, VP8E_SET_TUNING, val);
+				i++;
+			}
+
+			else if(arg == "--cq-level")
+			{	ConfigureValue(encoder, VP8E_SET_CQ_LEVEL, args[i + 1]); i++;	}
+			
+			else if(arg == "--max-intra-rate")
+			{	ConfigureValue(encoder, VP8E_SET_MAX_INTRA_BITRATE_PCT, args[i + 1]); i++;	}
+
+			else if(arg == "--lossless")
+			{	ConfigureValue(encoder, VP9E_SET_LOSSLESS, 1);	}
+			
+			
+			i++;	
+		}
+		
+		return true;
+	}
+	else
+		return false;
+}
+
+
+
+// VP9 splits the frame into tile columns, and that's what the threads get
+// to work on, so there's no point in having more threads than columns
+// (unless libvpx can do row-based threading).  A tile has to be at least
+// 256 pixels wide.  VP8 threads work on macroblock rows, and the token
+// partitions let the decoder do the same.
+// We set these up before the custom args, so the user can still override.
+
+static int
+Log2Floor(int n)
+{
+	int l = 0;
+	
+	while(n >>= 1)
+		l++;
+	
+	return l;
+}
+
+
+static int
+VP9TileColumnsLog2(unsigned int width, int num_cpus)
+{
+	const int superblock_cols = (width + 63) / 64;
+	
+	int max_log2 = 0;
+	
+	while(max_log2 < 6 && (superblock_cols >> (max_log2 + 1)) >= 4)
+		max_log2++;
+	
+	// enough columns to keep everyone busy, rounding up
+	int want_log2 = Log2Floor(num_cpus);
+	
+	if((1 << want_log2) < num_cpus)
+		want_log2++;
+	
+	return (want_log2 < max_log2 ? want_log2 : max_log2);
+}
+
+
+void
+ConfigureEncoderThreadsPre(vpx_codec_enc_cfg_t &config, bool vp9, int num_cpus)
+{
+	int threads = (num_cpus > 64 ? 64 : num_cpus < 1 ? 1 : num_cpus);
+	
+	if(vp9)
+	{
+#ifndef VPX_CTRL_VP9E_SET_ROW_MT
+		const int tile_columns = (1 << VP9TileColumnsLog2(config.g_w, threads));
+		
+		if(threads > tile_columns)
+			threads = tile_columns;
+#endif
+	}
+	else
+	{
+		const int mb_rows = (config.g_h + 15) / 16;
+		
+		if(threads > mb_rows)
+			threads = mb_rows;
+	}
+	
+	config.g_threads = threads;
+}
+
+
+void
+ConfigureEncoderThreadsPost(vpx_codec_ctx_t *encoder, const vpx_codec_enc_cfg_t &config, bool vp9)
+{
+	const int threads = (config.g_threads > 0 ? config.g_threads : 1);
+	
+	if(vp9)
+	{
+		vpx_codec_control(encoder, VP9E_SET_TILE_COLUMNS, VP9TileColumnsLog2(config.g_w, threads));
+		
+#ifdef VPX_CTRL_VP9E_SET_ROW_MT
+		// newer libvpx can put threads on rows within a tile too
+		vpx_codec_control(encoder, VP9E_SET_ROW_MT, (threads > 1 ? 1 : 0));
+#endif
+	}
+	else
+	{
+		// 1, 2, 4 or 8 partitions
+		int partitions_log2 = Log2Floor(threads);
+		
+		if(partitions_log2 > VP8_EIGHT_TOKENPARTITION)
+			partitions_log2 = VP8_EIGHT_TOKENPARTITION;
+		
+		vpx_codec_control(encoder, VP8E_SET_TOKEN_PARTITIONS, partitions_log2);
+	}
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_ENCODERCONFIG_H
+#define WEBM_ENCODERCONFIG_H
+
+// The export settings that aren't Premiere's business, and the libvpx
+// setup that goes with them, including the user's custom arguments
+// (the same ones vpxenc takes).
+
+extern "C" {
+#include "vpx/vpx_encoder.h"
+}
+
+typedef enum {
+	WEBM_CODEC_VP8 = 0,
+	WEBM_CODEC_VP9
+} WebM_Video_Codec;
+
+typedef enum {
+	WEBM_METHOD_QUALITY = 0,
+	WEBM_METHOD_BITRATE,
+	WEBM_METHOD_VBR
+} WebM_Video_Method;
+
+typedef enum {
+	WEBM_ENCODING_REALTIME = 0,
+	WEBM_ENCODING_GOOD,
+	WEBM_ENCODING_BEST,
+	WEBM_ENCODING_BUDGET
+} WebM_Video_Encoding;
+
+typedef enum {
+	WEBM_BUDGET_MINUTES = 0,
+	WEBM_BUDGET_REALTIME
+} WebM_Budget_Mode;
+
+
+typedef enum {
+	WEBM_CODEC_VORBIS = 0,
+	WEBM_CODEC_OPUS
+} WebM_Audio_Codec;
+
+typedef enum {
+	OGG_QUALITY = 0,
+	OGG_BITRATE
+} Ogg_Method;
+
+
+bool ConfigureEncoderPre(vpx_codec_enc_cfg_t &config, const char *txt);
+
+bool ConfigureEncoderPost(vpx_codec_ctx_t *encoder, const char *txt);
+
+// Threads, VP9 tile columns and VP8 token partitions to suit the frame size and
+// the number of cores.  Pre goes before ConfigureEncoderPre, Post before ConfigureEncoderPost.
+void ConfigureEncoderThreadsPre(vpx_codec_enc_cfg_t &config, bool vp9, int num_cpus);
+
+void ConfigureEncoderThreadsPost(vpx_codec_ctx_t *encoder, const vpx_codec_enc_cfg_t &config, bool vp9);
+
+
+#endif // WEBM_ENCODERCONFIG_H
@@ -0,0 +1,1409 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_Export.h"
+
+#include "WebM_Rendition.h"
+#include "WebM_AlphaEncoder.h"
+#include "WebM_Passthrough.h"
+
+#include "WebM_Color.h"
+#include "WebM_DASH.h"
+#include "WebM_Speed.h"
+#include "WebM_SceneCut.h"
+
+
+extern "C" {
+
+#include "vpx/vpx_encoder.h"
+#include "vpx/vp8cx.h"
+
+#include <vorbis/codec.h>
+#include <vorbis/vorbisenc.h>
+
+#include <opus_multistream.h>
+
+}
+
+#include "mkvmuxer.hpp"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+#include <sstream>
+
+
+using mkvmuxer::uint8;
+using mkvmuxer::uint64;
+
+
+void
+WebM_InitExportSettings(WebM_ExportSettings &settings)
+{
+	memset(&settings, 0, sizeof(settings));
+	
+	settings.export_video = true;
+	settings.export_audio = true;
+	
+	settings.ticks_per_second = 254016000000LL; // what Premiere uses
+	
+	settings.width = 1920;
+	settings.height = 1080;
+	settings.frame_ticks = settings.ticks_per_second / 24;
+	
+	settings.codec = WEBM_CODEC_VP8;
+	settings.method = WEBM_METHOD_QUALITY;
+	settings.quality = 50;
+	settings.bitrate = 500;
+	settings.encoding = WEBM_ENCODING_GOOD;
+	
+	settings.budget_mode = WEBM_BUDGET_MINUTES;
+	settings.budget_minutes = 10;
+	settings.budget_speed = 1.f;
+	
+	settings.keyframe_interval = 2;
+	
+	settings.num_cpus = 1;
+	
+	settings.audio_codec = WEBM_CODEC_VORBIS;
+	settings.audio_method = OGG_QUALITY;
+	settings.audio_quality = 0.5f;
+	settings.audio_bitrate = 128;
+	settings.sample_rate = 48000;
+	settings.channels = 2;
+	
+	settings.writing_app = "fnord WebM";
+}
+
+
+typedef struct {
+	int		numerator;
+	int		denominator;
+} FrameRate;
+
+static void get_framerate(long long ticksPerSecond, long long ticks_per_frame, FrameRate *fps)
+{
+	long long frameRates[] = {	10, 15, 23,
+								24, 25, 29,
+								30, 50, 59,
+								60};
+													
+	long long frameRateNumDens[][2] = {{10, 1}, {15, 1}, {24000, 1001},
+										{24, 1}, {25, 1}, {30000, 1001},
+										{30, 1}, {50, 1}, {60000, 1001},
+										{60, 1}};
+	
+	int frameRateIndex = -1;
+	
+	for(int i=0; i < sizeof(frameRates) / sizeof (long long); i++)
+	{
+		frameRates[i] = ticksPerSecond / frameRateNumDens[i][0] * frameRateNumDens[i][1];
+		
+		if(ticks_per_frame == frameRates[i])
+			frameRateIndex = i;
+	}
+	
+	if(frameRateIndex >= 0)
+	{
+		fps->numerator = frameRateNumDens[frameRateIndex][0];
+		fps->denominator = frameRateNumDens[frameRateIndex][1];
+	}
+	else
+	{
+		fps->numerator = 1000 * ticksPerSecond / ticks_per_frame;
+		fps->denominator = 1000;
+	}
+}
+
+
+// Reads compressed frames out of the source files for smart rendering.
+// Keeps the last file open, because the frames usually come in long runs.
+class PassthroughReader
+{
+  public:
+	PassthroughReader() : _file(NULL), _source(-1) {}
+	~PassthroughReader() { Close(); }
+	
+	bool Read(const WebM_PassthroughFrame &frame, std::vector<unsigned char> &data);
+	
+	void Close();
+	
+  private:
+	FILE *_file;
+	int _source;
+};
+
+
+bool
+PassthroughReader::Read(const WebM_PassthroughFrame &frame, std::vector<unsigned char> &data)
+{
+	if(frame.source != _source)
+	{
+		Close();
+		
+		UTF16String path;
+		
+		if( WebM_PassthroughPath(frame.source, path) )
+		{
+			_file = WebM_OpenFile(path.c_str(), "rb");
+			
+			if(_file != NULL)
+				_source = frame.source;
+		}
+	}
+	
+	if(_file == NULL || frame.size == 0)
+		return false;
+	
+	if(WebM_SeekFile(_file, frame.pos) != 0)
+		return false;
+	
+	data.resize(frame.size);
+	
+	return (fread(&data[0], 1, frame.size, _file) == frame.size);
+}
+
+
+void
+PassthroughReader::Close()
+{
+	if(_file != NULL)
+	{
+		fclose(_file);
+		
+		_file = NULL;
+	}
+	
+	_source = -1;
+}
+
+
+// The importer only hashes its frames while somebody is smart rendering
+class PassthroughScope
+{
+  public:
+	PassthroughScope(bool active) : _active(active) { if(_active) WebM_PassthroughBegin(); }
+	~PassthroughScope() { if(_active) WebM_PassthroughEnd(); }
+	
+  private:
+	const bool _active;
+};
+
+
+// Copies the rendered frame into img (and the alpha into alpha_img)
+static void
+HostFrameToImage(const WebM_HostFrame &frame, vpx_image_t *img, vpx_image_t *alpha_img)
+{
+	if(frame.format == WEBM_FRAME_YUV420)
+	{
+		WebM_CopyYUV420ToImage(img,
+								frame.data[0], frame.rowbytes[0],
+								frame.data[1], frame.rowbytes[1],
+								frame.data[2], frame.rowbytes[2]);
+	}
+	else if(frame.format == WEBM_FRAME_BGRA16)
+	{
+		WebM_BGRA16ToImage(img, (const unsigned short *)frame.data[0], frame.rowbytes[0], frame.flipped);
+		
+		if(alpha_img != NULL)
+			WebM_BGRA16AlphaToImage(alpha_img, (const unsigned short *)frame.data[0], frame.rowbytes[0], frame.flipped);
+	}
+	else if(frame.format == WEBM_FRAME_BGRA8)
+	{
+		WebM_BGRA8ToImage(img, frame.data[0], frame.rowbytes[0], frame.flipped);
+		
+		if(alpha_img != NULL)
+			WebM_BGRA8AlphaToImage(alpha_img, frame.data[0], frame.rowbytes[0], frame.flipped);
+	}
+}
+
+
+WebM_Result
+WebM_ExportMovie(const WebM_ExportSettings &settings, const WebM_PathChar *main_path,
+					WebM_ExportHost &host, WebM_ExportStats *stats)
+{
+	WebM_Result result = WEBM_OK;
+	
+	const long long ticksPerSecond = settings.ticks_per_second;
+	
+	const bool exportVideo = settings.export_video;
+	const bool exportAudio = settings.export_audio;
+	
+	const bool alpha = (settings.alpha && exportVideo);
+	
+	const int audioChannels = settings.channels;
+	
+	const bool dash = settings.dash;
+	
+	// DASH has its own keyframe schedule
+	const bool scene_cuts = (settings.scene_cuts && !dash);
+	
+	const bool skip_repeats = settings.skip_repeats;
+	
+	const WebM_Video_Method method = settings.method;
+	
+	const char *customArgs = settings.custom_args;
+	
+	const bool opus = (settings.audio_codec == WEBM_CODEC_OPUS);
+	
+	// Opus only runs at 48k, the host should be resampling for us
+	const int sampleRate = (opus ? 48000 : settings.sample_rate);
+	
+	const char *writing_app = (settings.writing_app != NULL ? settings.writing_app : "fnord WebM");
+	
+	if(stats != NULL)
+		memset(stats, 0, sizeof(WebM_ExportStats));
+	
+	
+	std::vector<unsigned char> vbr_buffer;
+	
+	
+	try{
+	
+	const double duration = (double)(settings.end_time - settings.start_time) / (double)ticksPerSecond;
+	
+	
+	const int passes = ( (exportVideo && method == WEBM_METHOD_VBR) ? 2 : 1);
+	
+	// Copied frames never go through the encoder, so a first pass wouldn't
+	// know about them.  DASH needs keyframes on its own schedule.
+	// Source frames don't come with our alpha.
+	const bool smart_render = (settings.smart_render && exportVideo && passes == 1 && !dash && !alpha);
+	
+	// the importer hashes the frames it decodes for us until we're done
+	const PassthroughScope passthrough_scope(smart_render);
+	
+	
+	// With a time budget, we pick the speed as we go.  One governor covers
+	// both passes, so if the analysis pass goes quickly, the real one gets the extra time.
+	const bool governed = (exportVideo && settings.encoding == WEBM_ENCODING_BUDGET);
+	
+	const double budget = (settings.budget_mode == WEBM_BUDGET_REALTIME ?
+							duration / (settings.budget_speed > 0.f ? settings.budget_speed : 1.f) :
+							settings.budget_minutes * 60.0);
+	
+	const long total_frames = (settings.end_time - settings.start_time + settings.frame_ticks - 1) / settings.frame_ticks;
+	
+	// cpu-used goes up to 16 for VP8, VP9 doesn't go as far
+	WebM_SpeedGovernor governor(budget, total_frames * passes, 0, (settings.codec == WEBM_CODEC_VP9 ? 8 : 16));
+	
+	
+	for(int pass = 0; pass < passes && result == WEBM_OK; pass++)
+	{
+		const bool vbr_pass = (passes > 1 && pass == 0);
+		
+
+		if(passes > 1)
+			host.Message(vbr_pass ? "Analyzing video" : "Encoding WebM movie");
+		
+		
+		FrameRate fps;
+		get_framerate(ticksPerSecond, settings.frame_ticks, &fps);
+		
+		// For DASH, we put the keyframes in ourselves, at the same frames in
+		// every rendition, so a player can switch between them on any one.
+		int keyframe_interval = ((double)settings.keyframe_interval * (double)fps.numerator / (double)fps.denominator) + 0.5;
+		
+		if(keyframe_interval < 1)
+			keyframe_interval = 1;
+		
+		
+		vpx_codec_err_t codec_err = VPX_CODEC_OK;
+		
+		vpx_codec_ctx_t encoder;
+		
+		std::vector<WebM_Rendition *> renditions;
+		
+		// Each pass gets a fresh detector, so both passes put keyframes in the same places
+		WebM_SceneDetector scene_detector;
+		
+		unsigned int min_keyframe_distance = 0;
+		unsigned int frames_since_keyframe = 0;
+		
+		// Alpha is encoded alongside the color, by its own encoder
+		WebM_AlphaEncoder *alpha_encoder = NULL;
+		std::vector<unsigned char> alpha_packet;
+		
+		unsigned int alpha_keyframe_interval = 0;
+		
+		// Screen recordings and slides have lots of frames that are exactly like
+		// the one before.  We don't encode those at all, the last frame just stays
+		// up longer.  WebM doesn't mind, frames end when the next one starts.
+		unsigned long long last_frame_hash = 0;
+		bool have_last_frame = false;
+		
+		long encoded_frames = 0;
+		long skipped_frames = 0;
+		
+		// Smart rendering: while the frames we get are the same as the ones
+		// in a source WebM, we copy the source's compressed frames.
+		PassthroughReader passthrough_reader;
+		std::vector<unsigned char> passthrough_data;
+		
+		WebM_PassthroughFormat passthrough_format; // what we're making
+		
+		bool copying = false;
+		int copy_source = -1;
+		int copy_next_frame = 0;
+		bool need_keyframe = false; // after copying, the encoder has to start fresh
+		
+		long copied_frames = 0;
+		
+		if(exportVideo)
+		{
+			const bool vp9 = (settings.codec == WEBM_CODEC_VP9);
+			
+			vpx_codec_iface_t *iface = vp9 ? vpx_codec_vp9_cx() :
+										vpx_codec_vp8_cx();
+			
+			vpx_codec_enc_cfg_t config;
+			vpx_codec_enc_config_default(iface, &config, 0);
+			
+			config.g_w = settings.width;
+			config.g_h = settings.height;
+			
+			
+			if(method == WEBM_METHOD_QUALITY)
+			{
+				config.g_usage = config.rc_end_usage = VPX_CQ;
+				config.rc_target_bitrate = 1000000; // what they do in libvpxenc.c in FFmpeg
+			}
+			else
+			{
+				if(method == WEBM_METHOD_VBR)
+				{
+					config.g_usage = config.rc_end_usage = VPX_VBR;
+					
+					if(vbr_pass)
+					{
+						config.g_pass = VPX_RC_FIRST_PASS;
+					}
+					else
+					{
+						config.g_pass = VPX_RC_LAST_PASS;
+						
+						config.rc_twopass_stats_in.buf = (vbr_buffer.empty() ? NULL : &vbr_buffer[0]);
+						config.rc_twopass_stats_in.sz = vbr_buffer.size();
+					}
+				}
+				else
+				{
+					config.g_usage = config.rc_end_usage = VPX_CBR;
+					config.g_pass = VPX_RC_ONE_PASS;
+				}
+				
+				config.rc_target_bitrate = settings.bitrate;
+			}
+			
+			
+			ConfigureEncoderThreadsPre(config, vp9, settings.num_cpus);
+			
+			config.g_timebase.num = fps.denominator;
+			config.g_timebase.den = fps.numerator;
+			
+			if(scene_cuts)
+			{
+				// We'll put in keyframes at cuts, but not closer than half a second
+				// apart.  The encoder still puts one in every 10 seconds, so seeking
+				// never has too far to decode.  Custom args can change either one.
+				config.kf_min_dist = ((double)fps.numerator / (double)fps.denominator / 2.0) + 0.5;
+				config.kf_max_dist = ((double)fps.numerator * 10.0 / (double)fps.denominator) + 0.5;
+			}
+			
+			ConfigureEncoderPre(config, customArgs);
+			
+			// Frames have to come out of the encoder right away, so they
+			// don't get mixed up with the copied ones.  Same when skipping
+			// repeats: a packet is muxed at the time of the frame that went
+			// in, and with a held frame in between a late one lands too early.
+			if(smart_render || skip_repeats)
+				config.g_lag_in_frames = 0;
+			
+			// The alpha encoder has to keep in step with this one:
+			// one frame out for every frame in, none dropped.
+			if(alpha)
+			{
+				config.g_lag_in_frames = 0;
+				config.rc_dropframe_thresh = 0;
+			}
+			
+			min_keyframe_distance = config.kf_min_dist;
+			
+			if(dash)
+			{
+				config.kf_mode = VPX_KF_DISABLED;
+				config.kf_min_dist = config.kf_max_dist = keyframe_interval;
+			}
+			else if(alpha)
+			{
+				// and keyframes in the same places, so we put them all in ourselves
+				alpha_keyframe_interval = (config.kf_max_dist > 0 ? config.kf_max_dist : 1);
+				
+				config.kf_mode = VPX_KF_DISABLED;
+			}
+		
+		
+			// We only ever give the encoder 8-bit frames, and write
+			// no CodecPrivate for the video track.
+			passthrough_format.codec_id = (vp9 ? "V_VP9" : "V_VP8");
+			passthrough_format.width = config.g_w;
+			passthrough_format.height = config.g_h;
+			passthrough_format.profile = config.g_profile;
+			passthrough_format.bit_depth = 8;
+			
+			codec_err = vpx_codec_enc_init(&encoder, iface, &config, 0);
+			
+			if(codec_err == VPX_CODEC_OK)
+			{
+				int cq_level = -1;
+				
+				if(method == WEBM_METHOD_QUALITY)
+				{
+					// our slider goes 0..100, quality goes 0..63, and it's reversed
+					int quan = (((float)(100 - settings.quality) / 100.f) * (config.rc_max_quantizer - config.rc_min_quantizer)) + config.rc_min_quantizer + 0.5f;
+				
+					vpx_codec_err_t config_err = vpx_codec_control(&encoder, VP8E_SET_CQ_LEVEL, quan);
+					
+					assert(config_err == VPX_CODEC_OK);
+					
+					cq_level = quan;
+				}
+				
+				ConfigureEncoderThreadsPost(&encoder, config, vp9);
+				
+				ConfigureEncoderPost(&encoder, customArgs);
+				
+				// the governor gets the last word on speed
+				if(governed)
+					vpx_codec_control(&encoder, VP8E_SET_CPUUSED, governor.Level());
+				
+				
+				// The smaller renditions get their frames from the ones we render
+				// for the main movie, so the timeline only gets rendered once.
+				if(!vbr_pass && settings.renditions > 0)
+				{
+					int heights[3];
+					
+					const int count = WebM_RenditionHeights(config.g_h, (settings.renditions < 3 ? settings.renditions : 3), heights);
+					
+					for(int r=0; r < count && result == WEBM_OK; r++)
+					{
+						// keep the shape, with an even width
+						const int width = (((long long)config.g_w * heights[r] / config.g_h) + 1) & ~1;
+						
+						WebM_Rendition *rendition = new WebM_Rendition(width, heights[r]);
+						
+						renditions.push_back(rendition);
+						
+						bool began = rendition->Begin(main_path, iface,
+														(vp9 ? "V_VP9" : mkvmuxer::Tracks::kVp8CodecId),
+														config, cq_level, customArgs,
+														(double)fps.numerator / (double)fps.denominator,
+														1000000UL, // same timeCodeScale as the main movie
+														dash);
+						
+						if(!began)
+							result = WEBM_ERR_INTERNAL;
+						else if(governed)
+							rendition->SetCpuUsed(governor.Level());
+					}
+				}
+				
+				// The proxy is just another rendition, half the width and height,
+				// but it goes as fast as it can on a couple of threads.
+				if(!vbr_pass && settings.proxy && result == WEBM_OK)
+				{
+					const int width = ((config.g_w / 2) + 1) & ~1;
+					const int height = ((config.g_h / 2) + 1) & ~1;
+					
+					WebM_Rendition *proxy = new WebM_Rendition(width, height, true);
+					
+					renditions.push_back(proxy);
+					
+					bool began = proxy->Begin(main_path, iface,
+												(vp9 ? "V_VP9" : mkvmuxer::Tracks::kVp8CodecId),
+												config, cq_level, customArgs,
+												(double)fps.numerator / (double)fps.denominator,
+												1000000UL,
+												false);
+					
+					if(!began)
+						result = WEBM_ERR_INTERNAL;
+				}
+				
+				if(!vbr_pass && alpha && result == WEBM_OK)
+				{
+					alpha_encoder = new WebM_AlphaEncoder;
+					
+					if( !alpha_encoder->Begin(iface, config, cq_level, customArgs) )
+						result = WEBM_ERR_INTERNAL;
+					else if(governed)
+						alpha_encoder->SetCpuUsed(governor.Level());
+				}
+			}
+		}
+		
+	
+	#define OV_OK 0
+	
+		int v_err = OV_OK;
+	
+		vorbis_info vi;
+		vorbis_comment vc;
+		vorbis_dsp_state vd;
+		vorbis_block vb;
+		
+		// only clear what got set up, since the encoder creation can fail
+		bool vorbis_initialized = false;
+		
+		OpusMSEncoder *opus_encoder = NULL;
+		int opus_pre_skip = 0;
+										
+		size_t private_size = 0;
+		void *private_data = NULL;
+		
+		int maxBlip = 100;
+		
+		if(exportAudio && !vbr_pass && opus)
+		{
+			// family 0 is mono or stereo, family 1 is the Vorbis channel layouts
+			const int mapping_family = (audioChannels > 2 ? 1 : 0);
+			
+			int streams = 0;
+			int coupled_streams = 0;
+			unsigned char mapping[8];
+			
+			int o_err = OPUS_OK;
+			
+			opus_encoder = opus_multistream_surround_encoder_create(48000, audioChannels, mapping_family,
+																	&streams, &coupled_streams, mapping,
+																	OPUS_APPLICATION_AUDIO, &o_err);
+			
+			if(opus_encoder != NULL && o_err == OPUS_OK)
+			{
+				opus_multistream_encoder_ctl(opus_encoder, OPUS_SET_BITRATE(settings.audio_bitrate * 1000));
+				
+				opus_int32 lookahead = 0;
+				opus_multistream_encoder_ctl(opus_encoder, OPUS_GET_LOOKAHEAD(&lookahead));
+				
+				opus_pre_skip = lookahead;
+				
+				private_data = WebM_OpusPrivateData(audioChannels, opus_pre_skip, mapping_family,
+													streams, coupled_streams, mapping, private_size);
+			}
+			else
+				v_err = OV_EIMPL; // our audio error flag, either codec
+		}
+		else if(exportAudio && !vbr_pass)
+		{
+			vorbis_info_init(&vi);
+			
+			if(settings.audio_method == OGG_BITRATE)
+			{
+				v_err = vorbis_encode_init(&vi,
+											audioChannels,
+											sampleRate,
+											-1,
+											settings.audio_bitrate * 1000,
+											-1);
+			}
+			else
+			{
+				v_err = vorbis_encode_init_vbr(&vi,
+												audioChannels,
+												sampleRate,
+												settings.audio_quality);
+			}
+			
+			if(v_err == OV_OK)
+			{
+				vorbis_comment_init(&vc);
+				vorbis_analysis_init(&vd, &vi);
+				vorbis_block_init(&vd, &vb);
+				
+				vorbis_initialized = true;
+				
+				
+				ogg_packet header;
+				ogg_packet header_comm;
+				ogg_packet header_code;
+				
+				vorbis_analysis_headerout(&vd, &vc, &header, &header_comm, &header_code);
+				
+				private_data = WebM_VorbisPrivateData(header, header_comm, header_code, private_size);
+			}
+			else
+				vorbis_info_clear(&vi);
+		}
+		
+		if(exportAudio && !vbr_pass)
+		{
+			// Without video we're not stepping through frames, so ask
+			// for a second's worth at a time and let the encoder rip.
+			const long long blipTicks = (exportVideo ? settings.frame_ticks : ticksPerSecond);
+			
+			maxBlip = host.MaxAudioBlip(blipTicks);
+		}
+		
+		
+		// For DASH, audio goes in its own file, so the video files are all alike
+		const bool separate_audio = (dash && exportVideo && exportAudio && !vbr_pass);
+		
+		WebM_MkvLayout main_layout, audio_layout;
+		
+		UTF16String audio_path;
+		
+		WebM_MkvWriter *writer = NULL;
+		
+		if(codec_err == VPX_CODEC_OK && v_err == OV_OK && (writer = host.OpenWriter()) != NULL)
+		{
+			mkvmuxer::Segment muxer_segment;
+			
+			muxer_segment.Init(writer);
+			muxer_segment.set_mode(mkvmuxer::Segment::kFile);
+			
+			
+			mkvmuxer::SegmentInfo* const info = muxer_segment.GetSegmentInfo();
+			
+			info->set_writing_app(writing_app);
+			
+			// I'd say think about lowering this to get better precision,
+			// but I get some messed up stuff when I do that.  Maybe a bug in the muxer?
+			long long timeCodeScale = 1000000UL;
+			
+			info->set_timecode_scale(timeCodeScale);
+			
+			
+			uint64 vid_track = 0;
+			
+			if(exportVideo)
+			{
+				vid_track = muxer_segment.AddVideoTrack(settings.width, settings.height, 1);
+				
+				mkvmuxer::VideoTrack* const video = static_cast<mkvmuxer::VideoTrack *>(muxer_segment.GetTrackByNumber(vid_track));
+				
+				video->set_frame_rate((double)fps.numerator / (double)fps.denominator);
+
+				video->set_codec_id(settings.codec == WEBM_CODEC_VP9 ? "V_VP9" :
+										mkvmuxer::Tracks::kVp8CodecId);
+				
+				if(alpha)
+					video->set_alpha_mode(mkvmuxer::VideoTrack::kAlpha);
+				
+				muxer_segment.CuesTrack(vid_track);
+			}
+			
+			
+			FileMkvWriter audio_writer;
+			
+			mkvmuxer::Segment audio_file_segment;
+			
+			mkvmuxer::Segment *audio_segment = &muxer_segment;
+			
+			if(separate_audio)
+			{
+				audio_path = WebM_SiblingPath(main_path, "_audio.webm");
+				
+				if( audio_writer.Open(audio_path.c_str()) )
+				{
+					audio_file_segment.Init(&audio_writer);
+					audio_file_segment.set_mode(mkvmuxer::Segment::kFile);
+					
+					mkvmuxer::SegmentInfo* const audio_info = audio_file_segment.GetSegmentInfo();
+					
+					audio_info->set_writing_app(writing_app);
+					audio_info->set_timecode_scale(timeCodeScale);
+					
+					audio_segment = &audio_file_segment;
+				}
+				else
+					result = WEBM_ERR_INTERNAL;
+			}
+			
+			
+			uint64 audio_track = 0;
+			
+			if(exportAudio)
+			{
+				audio_track = audio_segment->AddAudioTrack(sampleRate, audioChannels, 2);
+				
+				mkvmuxer::AudioTrack* const audio = static_cast<mkvmuxer::AudioTrack *>(audio_segment->GetTrackByNumber(audio_track));
+				
+				if(opus)
+				{
+					audio->set_codec_id(mkvmuxer::Tracks::kOpusCodecId);
+					
+					// in nanoseconds
+					audio->set_codec_delay((uint64)opus_pre_skip * 1000000000UL / 48000);
+					audio->set_seek_pre_roll(80000000UL);
+				}
+				else
+					audio->set_codec_id(mkvmuxer::Tracks::kVorbisCodecId);
+				
+				if(private_data)
+				{
+					bool copied = audio->SetCodecPrivate((const uint8 *)private_data, private_size);
+					
+					assert(copied);
+					
+					free(private_data);
+				}
+
+				if(audio_segment != &muxer_segment || !exportVideo)
+					audio_segment->CuesTrack(audio_track);
+			}
+			
+			// Audio has no keyframes, so for DASH we start a Cluster (and a Cue)
+			// every keyframe interval, to match the video.
+			const unsigned long long audio_cluster_interval = (unsigned long long)settings.keyframe_interval * 1000000000UL;
+			
+			unsigned long long next_audio_cluster = 0;
+			
+			WebM_AudioEncoder *audioThread = NULL;
+			
+			const long long audioRate = sampleRate;
+			
+			const long long endAudioSample = (settings.end_time - settings.start_time) * audioRate / ticksPerSecond;
+			
+			if(exportAudio && !vbr_pass)
+			{
+				if(opus)
+				{
+					audioThread = new WebM_OpusEncoder(&host, opus_encoder,
+														audioChannels, opus_pre_skip, maxBlip, endAudioSample);
+				}
+				else
+					audioThread = new WebM_VorbisEncoder(&host, &vd, &vb, maxBlip, endAudioSample);
+				
+				if( !audioThread->Start() )
+					result = WEBM_ERR_INTERNAL;
+			}
+			
+			
+			if(!exportVideo && audioThread != NULL)
+			{
+				// Audio-only, so there are no frames to pace us.  We just mux
+				// packets as fast as the encoder thread can make them.
+				WebM_AudioPacket *packet = NULL;
+				
+				float last_progress = 0.f;
+				
+				while(result == WEBM_OK && (packet = audioThread->NextPacket(-1)) )
+				{
+					const unsigned long long audioTimeStamp = WebM_AudioTimeStamp(packet->start_granule, audioRate, timeCodeScale);
+					
+					if(dash && audioTimeStamp >= next_audio_cluster)
+					{
+						audio_segment->ForceNewClusterOnNextFrame();
+						
+						next_audio_cluster = audioTimeStamp - (audioTimeStamp % audio_cluster_interval) + audio_cluster_interval;
+					}
+					
+					bool added = audio_segment->AddFrame(&packet->data[0], packet->data.size(),
+														audio_track, audioTimeStamp, 0);
+					
+					if(!added)
+						result = WEBM_ERR_INTERNAL;
+					
+					const float progress = (endAudioSample > 0 ? (double)packet->granulepos / (double)endAudioSample : 1.0);
+					
+					delete packet;
+					
+					// no need to bother the host for every little packet
+					if(result == WEBM_OK && (progress - last_progress) >= 0.01f)
+					{
+						last_progress = progress;
+						
+						result = host.Progress(progress);
+					}
+				}
+				
+				if(result == WEBM_OK)
+					result = audioThread->Result();
+			}
+			
+		
+			long long videoTime = settings.start_time;
+			
+			while(exportVideo && videoTime < settings.end_time && result == WEBM_OK)
+			{
+				const long long fileTime = videoTime - settings.start_time;
+				const long long nextFileTime = fileTime + settings.frame_ticks;
+				
+				// this is for the encoder, which does its own math based on config.g_timebase
+				// let's do the math
+				// time = timestamp * timebase :: time = videoTime / ticksPerSecond : timebase = 1 / fps
+				// timestamp = time / timebase
+				// timestamp = (videoTime / ticksPerSecond) * (fps.num / fps.den)
+				const vpx_codec_pts_t encoder_timeStamp = fileTime * fps.numerator / (ticksPerSecond * fps.denominator);
+				const vpx_codec_pts_t encoder_nextTimeStamp = (nextFileTime - settings.start_time) * fps.numerator / (ticksPerSecond * fps.denominator);
+				const unsigned long encoder_duration = encoder_nextTimeStamp - encoder_timeStamp;
+				
+				
+				// This is the key step, where we quantize our time based on the timeCode
+				// to match how the frames are actually stored by the muxer.  If you want more precision,
+				// lower timeCodeScale.  Time (in nanoseconds) = TimeCode * TimeCodeScale.
+				const long long timeCode = ((fileTime * (1000000000UL / timeCodeScale)) + (ticksPerSecond / 2)) / ticksPerSecond;
+				const long long nextTimeCode = ((nextFileTime * (1000000000UL / timeCodeScale)) + (ticksPerSecond / 2)) / ticksPerSecond;
+				
+				const unsigned long long timeStamp = timeCode * timeCodeScale;
+				const unsigned long long nextTimeStamp = nextTimeCode * timeCodeScale;
+			
+				
+				if(audioThread != NULL)
+				{
+					const long long nextBlockAudoSample = nextTimeStamp * audioRate / 1000000000UL;
+					
+					// take everything if this is the last frame
+					const bool last_frame = (videoTime >= (settings.end_time - settings.frame_ticks));
+					
+					WebM_AudioPacket *packet = NULL;
+					
+					while(result == WEBM_OK && (packet = audioThread->NextPacket(last_frame ? -1 : nextBlockAudoSample)) )
+					{
+						// We take packets by start time, so none will be earlier than the
+						// cluster started by the video frame we added last time around.
+						const unsigned long long audioTimeStamp = WebM_AudioTimeStamp(packet->start_granule, audioRate, timeCodeScale);
+						
+						if(dash && audioTimeStamp >= next_audio_cluster)
+						{
+							audio_segment->ForceNewClusterOnNextFrame();
+							
+							next_audio_cluster = audioTimeStamp - (audioTimeStamp % audio_cluster_interval) + audio_cluster_interval;
+						}
+						
+						bool added = audio_segment->AddFrame(&packet->data[0], packet->data.size(),
+															audio_track, audioTimeStamp, 0);
+						
+						if(!added)
+							result = WEBM_ERR_INTERNAL;
+						
+						delete packet;
+					}
+					
+					if(result == WEBM_OK)
+						result = audioThread->Result();
+				}
+				
+				
+				if(exportVideo && result == WEBM_OK)
+				{
+					unsigned long deadline = settings.encoding == WEBM_ENCODING_REALTIME ? VPX_DL_REALTIME :
+												settings.encoding == WEBM_ENCODING_BEST ? VPX_DL_BEST_QUALITY :
+												VPX_DL_GOOD_QUALITY;
+												
+					
+					WebM_HostFrame frame;
+					memset(&frame, 0, sizeof(frame));
+					
+					result = host.RenderFrame(videoTime, frame);
+					
+					if(result == WEBM_OK)
+					{
+						const int width = frame.width;
+						const int height = frame.height;
+						
+						
+						// libvpx can only take PX_IMG_FMT_YV12, VPX_IMG_FMT_I420, VPX_IMG_FMT_VPXI420, VPX_IMG_FMT_VPXYV12
+						// (the latter two are in "vpx color space"?)
+						// see validate_img() in vp8_cx_iface.c
+						// TODO: VP9 can take VPX_IMG_FMT_I422 and VPX_IMG_FMT_I444
+						// although you probably want to switch to YV12 and yuvconfig2image()
+						// Alpha gets an image of its own, for the alpha encoder.
+								
+						vpx_image_t img_data;
+						vpx_image_t *img = vpx_img_alloc(&img_data, VPX_IMG_FMT_I420, width, height, 32);
+						
+						vpx_image_t alpha_img_data;
+						vpx_image_t *alpha_img = (alpha ? vpx_img_alloc(&alpha_img_data, VPX_IMG_FMT_I420, width, height, 32) : NULL);
+						
+						if(img != NULL && (alpha_img != NULL || !alpha))
+						{
+							HostFrameToImage(frame, img, alpha_img);
+							
+							
+							const bool last_frame = (videoTime >= (settings.end_time - settings.frame_ticks));
+							
+							vpx_enc_frame_flags_t flags = 0;
+							
+							if(dash)
+							{
+								if((encoder_timeStamp % keyframe_interval) == 0)
+									flags = VPX_EFLAG_FORCE_KF;
+							}
+							else if(scene_cuts)
+							{
+								// have to look at every frame, even if we can't use the answer
+								const bool cut = scene_detector.IsCut(img);
+								
+								if(cut && frames_since_keyframe >= min_keyframe_distance)
+									flags = VPX_EFLAG_FORCE_KF;
+							}
+							
+							if(alpha && !dash && (frames_since_keyframe + 1) >= alpha_keyframe_interval)
+								flags |= VPX_EFLAG_FORCE_KF;
+							
+							unsigned long long frame_hash = ((skip_repeats || smart_render) ? WebM_HashImage(img) : 0);
+							
+							// a frame is only a repeat if the alpha didn't change either
+							if(skip_repeats && alpha_img != NULL)
+								frame_hash = (frame_hash * 31) + WebM_HashImage(alpha_img);
+							
+							
+							// A run of copied frames has to start on a source keyframe
+							// and keep going frame by frame from the same source.
+							bool copied = false;
+							bool copied_keyframe = false;
+							
+							if(smart_render)
+							{
+								WebM_PassthroughFrame source_frame;
+								
+								bool found = (copying && WebM_PassthroughFindFrame(copy_source, copy_next_frame, frame_hash, source_frame));
+								
+								if(!found)
+								{
+									found = WebM_PassthroughFindKeyframe(frame_hash, passthrough_format, source_frame);
+								}
+								
+								if(found && passthrough_reader.Read(source_frame, passthrough_data))
+								{
+									bool added = muxer_segment.AddFrame(&passthrough_data[0], passthrough_data.size(),
+																		vid_track, timeStamp, source_frame.keyframe);
+									
+									if(!added)
+										result = WEBM_ERR_INTERNAL;
+									
+									copying = true;
+									copy_source = source_frame.source;
+									copy_next_frame = source_frame.frame + 1;
+									
+									copied = true;
+									copied_keyframe = source_frame.keyframe;
+									copied_frames++;
+								}
+								else
+								{
+									if(copying)
+										need_keyframe = true;
+									
+									copying = false;
+								}
+							}
+							
+							if(need_keyframe && !copied)
+								flags |= VPX_EFLAG_FORCE_KF;
+							
+							if((flags & VPX_EFLAG_FORCE_KF) || copied_keyframe)
+								frames_since_keyframe = 0;
+							else
+								frames_since_keyframe++;
+							
+							
+							// Always do the last frame, so the movie ends when it should,
+							// and any keyframe we asked for.
+							bool repeat = false;
+							
+							if(skip_repeats)
+							{
+								repeat = (have_last_frame && frame_hash == last_frame_hash &&
+											!last_frame && !(flags & VPX_EFLAG_FORCE_KF) && !copied);
+								
+								last_frame_hash = frame_hash;
+								have_last_frame = true;
+							}
+							
+							if(repeat)
+							{
+								skipped_frames++;
+							}
+							else
+							{
+								if(alpha_encoder != NULL)
+									alpha_encoder->Submit(alpha_img, encoder_timeStamp, encoder_duration, flags, deadline);
+								
+								for(int r=0; r < renditions.size(); r++)
+								{
+									renditions[r]->Submit(img, encoder_timeStamp, encoder_duration,
+															flags, timeStamp, deadline, last_frame);
+								}
+								
+								
+								vpx_codec_err_t encode_err = (copied ? VPX_CODEC_OK :
+																vpx_codec_encode(&encoder, img, encoder_timeStamp, encoder_duration, flags, deadline));
+								
+								if(!copied)
+									encoded_frames++;
+								
+								if(!copied && (flags & VPX_EFLAG_FORCE_KF))
+									need_keyframe = false;
+								
+								// the alpha frame that goes with this one
+								if(alpha_encoder != NULL)
+								{
+									WebM_Result alpha_result = alpha_encoder->Wait();
+									
+									if(result == WEBM_OK)
+										result = alpha_result;
+								}
+								
+								// nothing new comes out if we copied, but that's fine
+								if(encode_err == VPX_CODEC_OK)
+								{
+									const vpx_codec_cx_pkt_t *pkt = NULL;
+									vpx_codec_iter_t iter = NULL;
+									 
+									while( (pkt = vpx_codec_get_cx_data(&encoder, &iter)) )
+									{
+										if(pkt->kind == VPX_CODEC_CX_FRAME_PKT)
+										{
+											assert(!vbr_pass);
+											
+											if(dash && (pkt->data.frame.flags & VPX_FRAME_IS_KEY))
+												muxer_segment.ForceNewClusterOnNextFrame();
+											
+											bool added = false;
+											
+											if(alpha_encoder != NULL && alpha_encoder->TakePacket(alpha_packet))
+											{
+												added = muxer_segment.AddFrameWithAdditional((const uint8 *)pkt->data.frame.buf, pkt->data.frame.sz,
+																								&alpha_packet[0], alpha_packet.size(),
+																								WEBM_ALPHA_ADD_ID, vid_track, timeStamp,
+																								(pkt->data.frame.flags & VPX_FRAME_IS_KEY));
+											}
+											else
+											{
+												added = muxer_segment.AddFrame((const uint8 *)pkt->data.frame.buf, pkt->data.frame.sz,
+																				vid_track, timeStamp,
+																				(pkt->data.frame.flags & VPX_FRAME_IS_KEY));
+											}
+																				
+											if(!added)
+												result = WEBM_ERR_INTERNAL;
+										}
+										else if(pkt->kind == VPX_CODEC_STATS_PKT)
+										{
+											assert(vbr_pass);
+											
+											const unsigned char *stats_buf = (const unsigned char *)pkt->data.twopass_stats.buf;
+											
+											vbr_buffer.insert(vbr_buffer.end(), stats_buf, stats_buf + pkt->data.twopass_stats.sz);
+										}
+									}
+								}
+								else
+									result = WEBM_ERR_INTERNAL;
+								
+								
+								// renditions are still reading img
+								for(int r=0; r < renditions.size(); r++)
+								{
+									WebM_Result rendition_result = renditions[r]->Wait();
+									
+									if(result == WEBM_OK)
+										result = rendition_result;
+								}
+							}
+						}
+						else
+							result = WEBM_ERR_MEMORY;
+						
+						if(img != NULL)
+							vpx_img_free(img);
+						
+						if(alpha_img != NULL)
+							vpx_img_free(alpha_img);
+						
+						host.ReleaseFrame(frame);
+					}
+					
+					
+					// squeeze last bits from encoder
+					if(result == WEBM_OK &&
+						(videoTime >= (settings.end_time - settings.frame_ticks)))
+					{
+						const vpx_codec_cx_pkt_t *pkt = NULL;
+						vpx_codec_iter_t iter = NULL;
+						
+						do{
+							vpx_codec_encode(&encoder, NULL, encoder_timeStamp, encoder_duration, 0, deadline);
+							
+							pkt = vpx_codec_get_cx_data(&encoder, &iter);
+							
+							if(pkt != NULL)
+							{
+								if(pkt->kind == VPX_CODEC_CX_FRAME_PKT)
+								{
+									assert(!vbr_pass);
+									
+									if(dash && (pkt->data.frame.flags & VPX_FRAME_IS_KEY))
+										muxer_segment.ForceNewClusterOnNextFrame();
+									
+									bool added = muxer_segment.AddFrame((const uint8 *)pkt->data.frame.buf, pkt->data.frame.sz,
+																		vid_track, timeStamp,
+																		(pkt->data.frame.flags & VPX_FRAME_IS_KEY));
+									assert(added);
+								}
+								else if(pkt->kind == VPX_CODEC_STATS_PKT)
+								{
+									assert(vbr_pass);
+									
+									const unsigned char *stats_buf = (const unsigned char *)pkt->data.twopass_stats.buf;
+									
+									vbr_buffer.insert(vbr_buffer.end(), stats_buf, stats_buf + pkt->data.twopass_stats.sz);
+								}
+							}
+							
+						}while(pkt != NULL);
+					}
+					
+					
+					// renditions are waiting for the next frame, so it's safe to change them too
+					if(governed && result == WEBM_OK && governor.FrameDone())
+					{
+						vpx_codec_control(&encoder, VP8E_SET_CPUUSED, governor.Level());
+						
+						if(alpha_encoder != NULL)
+							alpha_encoder->SetCpuUsed(governor.Level());
+						
+						for(int r=0; r < renditions.size(); r++)
+							renditions[r]->SetCpuUsed(governor.Level());
+					}
+				}
+				
+				
+				if(result == WEBM_OK)
+				{
+					float progress = (double)(videoTime - settings.start_time) / (double)(settings.end_time - settings.start_time);
+					
+					if(passes == 2)
+						progress = (progress / 2.f) + (0.5f * pass);
+
+					result = host.Progress(progress);
+				}
+				
+				
+				videoTime += settings.frame_ticks;
+			}
+			
+			
+			// stops the thread if we bailed early
+			delete audioThread;
+			
+			
+			bool final = muxer_segment.Finalize();
+			
+			if(!final && !vbr_pass && result == WEBM_OK)
+				result = WEBM_ERR_INTERNAL;
+			
+			if(audio_segment != &muxer_segment)
+			{
+				bool audio_final = audio_file_segment.Finalize();
+				
+				if(!audio_final && result == WEBM_OK)
+					result = WEBM_ERR_INTERNAL;
+				
+				audio_writer.Close();
+				
+				audio_layout = audio_writer.Layout();
+			}
+			
+			main_layout = writer->Layout();
+			
+			host.CloseWriter(writer);
+		}
+		else if(codec_err != VPX_CODEC_OK || v_err != OV_OK)
+			result = WEBM_ERR_INTERNAL;
+		else
+			result = WEBM_ERR_HOST; // couldn't open the file
+		
+		
+		for(int r=0; r < renditions.size(); r++)
+		{
+			WebM_Result rendition_result = renditions[r]->End();
+			
+			if(result == WEBM_OK)
+				result = rendition_result;
+		}
+		
+		
+		if(dash && !vbr_pass && result == WEBM_OK)
+		{
+			const char *video_codec = (settings.codec == WEBM_CODEC_VP9 ? "vp9" : "vp8");
+			const char *audio_codec = (opus ? "opus" : "vorbis");
+			
+			std::vector<WebM_DASHRepresentation> video_reps, audio_reps;
+			
+			WebM_DASHRepresentation main_rep;
+			
+			main_rep.url = WebM_FileNameUTF8(main_path);
+			main_rep.layout = main_layout;
+			
+			if(exportVideo)
+			{
+				main_rep.codecs = video_codec;
+				main_rep.width = settings.width;
+				main_rep.height = settings.height;
+				
+				video_reps.push_back(main_rep);
+				
+				for(int r=0; r < renditions.size(); r++)
+				{
+					if(renditions[r]->IsProxy())
+						continue;
+					
+					WebM_DASHRepresentation rep;
+					
+					rep.url = WebM_FileNameUTF8(renditions[r]->Path());
+					rep.codecs = video_codec;
+					rep.width = renditions[r]->Width();
+					rep.height = renditions[r]->Height();
+					rep.layout = renditions[r]->Layout();
+					
+					video_reps.push_back(rep);
+				}
+			}
+			else
+			{
+				main_rep.codecs = audio_codec;
+				main_rep.sample_rate = sampleRate;
+				main_rep.channels = audioChannels;
+				
+				audio_reps.push_back(main_rep);
+			}
+			
+			if(separate_audio)
+			{
+				WebM_DASHRepresentation rep;
+				
+				rep.url = WebM_FileNameUTF8(audio_path);
+				rep.codecs = audio_codec;
+				rep.sample_rate = sampleRate;
+				rep.channels = audioChannels;
+				rep.layout = audio_layout;
+				
+				audio_reps.push_back(rep);
+			}
+			
+			const std::string mpd = WebM_DASHManifest(video_reps, audio_reps, duration,
+														settings.keyframe_interval);
+			
+			// it's not a Matroska file, but it writes bytes just the same
+			FileMkvWriter mpd_writer;
+			
+			const UTF16String mpd_path = WebM_SiblingPath(main_path, ".mpd");
+			
+			if( !mpd_writer.Open(mpd_path.c_str()) || mpd_writer.Write(mpd.c_str(), mpd.size()) != 0 )
+				result = WEBM_ERR_INTERNAL;
+		}
+		
+		for(int r=0; r < renditions.size(); r++)
+			delete renditions[r];
+		
+		delete alpha_encoder;
+		
+		
+		if(!vbr_pass)
+		{
+			if(stats != NULL)
+			{
+				stats->encoded = encoded_frames;
+				stats->skipped = skipped_frames;
+				stats->copied = copied_frames;
+			}
+			
+			if(skipped_frames > 0 || copied_frames > 0)
+			{
+				std::stringstream skip_message;
+				
+				if(skipped_frames > 0)
+					skip_message << "Skipped " << skipped_frames << " repeated frames";
+				
+				if(copied_frames > 0)
+					skip_message << (skipped_frames > 0 ? ", copied " : "Copied ") << copied_frames << " frames from source";
+				
+				host.Message(skip_message.str().c_str());
+			}
+		}
+		
+		
+		// Leave a record of what the governor did, next to the movie
+		if(governed && !vbr_pass)
+		{
+			governor.Finish();
+			
+			const std::string &log = governor.Log();
+			
+			FileMkvWriter log_writer;
+			
+			const UTF16String log_path = WebM_SiblingPath(main_path, "_speed.log");
+			
+			if( log_writer.Open(log_path.c_str()) )
+				log_writer.Write(log.c_str(), log.size());
+		}
+		
+
+
+		if(exportVideo && codec_err == VPX_CODEC_OK)
+		{
+			vpx_codec_err_t destroy_err = vpx_codec_destroy(&encoder);
+			assert(destroy_err == VPX_CODEC_OK);
+		}
+			
+		if(opus_encoder != NULL)
+		{
+			opus_multistream_encoder_destroy(opus_encoder);
+		}
+		
+		if(vorbis_initialized)
+		{
+			vorbis_block_clear(&vb);
+			vorbis_dsp_clear(&vd);
+			vorbis_comment_clear(&vc);
+			vorbis_info_clear(&vi);
+		}
+	}
+	
+	}catch(...) { result = WEBM_ERR_INTERNAL; }
+	
+	
+	return result;
+}
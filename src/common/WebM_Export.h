@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_EXPORT_H
+#define WEBM_EXPORT_H
+
+// The whole export, minus the host: render frames, encode them (along with
+// alpha, renditions and a proxy), encode the audio, mux it all, and write
+// the DASH manifest.  The plug-in fills in the settings from its parameters
+// and hands us a WebM_ExportHost to get frames, audio and a file from.
+
+#include "WebM_Result.h"
+#include "WebM_File.h"
+#include "WebM_EncoderConfig.h"
+#include "WebM_AudioEncoder.h"
+
+
+typedef enum {
+	WEBM_FRAME_YUV420 = 0,	// planar 8-bit 4:2:0, Rec. 709
+	WEBM_FRAME_BGRA8,
+	WEBM_FRAME_BGRA16
+} WebM_FrameFormat;
+
+// A rendered frame.  YUV uses all three planes, BGRA just the first.
+typedef struct {
+	WebM_FrameFormat		format;
+	int						width;
+	int						height;
+	const unsigned char		*data[3];
+	long					rowbytes[3];
+	bool					flipped;	// bottom row first, like Premiere's BGRA
+	void					*host_data;	// whatever the host needs to let go of it
+} WebM_HostFrame;
+
+
+class WebM_ExportHost : public WebM_AudioSource
+{
+  public:
+	virtual ~WebM_ExportHost() {}
+	
+	// Where the main movie goes.  Every pass opens it again.
+	virtual WebM_MkvWriter * OpenWriter() = 0;
+	virtual void CloseWriter(WebM_MkvWriter *writer) = 0;
+	
+	// time is in ticks, from the start of the host's timeline
+	virtual WebM_Result RenderFrame(long long time, WebM_HostFrame &frame) = 0;
+	virtual void ReleaseFrame(WebM_HostFrame &frame) = 0;
+	
+	// the most samples the host would like to hand over for this many ticks
+	virtual int MaxAudioBlip(long long ticks) = 0;
+	
+	// 0 to 1, returning an error (WEBM_ERR_HOST) if the user canceled
+	virtual WebM_Result Progress(float progress) = 0;
+	
+	// for the progress bar, if there is one
+	virtual void Message(const char *message) {}
+};
+
+
+typedef struct {
+	bool				export_video;
+	bool				export_audio;
+	
+	long long			ticks_per_second;
+	long long			start_time;		// in ticks
+	long long			end_time;
+	
+	// video
+	int					width;
+	int					height;
+	long long			frame_ticks;	// duration of one frame
+	bool				alpha;
+	
+	WebM_Video_Codec	codec;
+	WebM_Video_Method	method;
+	int					quality;		// 0..100
+	int					bitrate;		// kbps
+	WebM_Video_Encoding	encoding;
+	char				custom_args[256];
+	
+	WebM_Budget_Mode	budget_mode;
+	int					budget_minutes;
+	float				budget_speed;	// times realtime
+	
+	int					renditions;
+	bool				proxy;
+	bool				dash;
+	int					keyframe_interval; // seconds, for DASH
+	bool				scene_cuts;
+	bool				skip_repeats;
+	bool				smart_render;
+	
+	int					num_cpus;
+	
+	// audio
+	WebM_Audio_Codec	audio_codec;
+	Ogg_Method			audio_method;
+	float				audio_quality;	// Vorbis -0.1..1
+	int					audio_bitrate;	// kbps
+	int					sample_rate;	// Opus gets 48k regardless
+	int					channels;
+	
+	const char			*writing_app;
+} WebM_ExportSettings;
+
+// Somewhere sensible for everything, so a host only sets what it has
+void WebM_InitExportSettings(WebM_ExportSettings &settings);
+
+
+typedef struct {
+	long		encoded;
+	long		skipped;	// repeats
+	long		copied;		// smart rendered
+} WebM_ExportStats;
+
+
+// main_path is where the host is putting the movie, so the other files
+// (renditions, audio for DASH, the manifest, the speed log) can go next to it.
+WebM_Result WebM_ExportMovie(const WebM_ExportSettings &settings, const WebM_PathChar *main_path,
+								WebM_ExportHost &host, WebM_ExportStats *stats = NULL);
+
+
+#endif // WEBM_EXPORT_H
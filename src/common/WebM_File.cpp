@@ -0,0 +1,433 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_File.h"
+
+#include <assert.h>
+
+#ifdef __APPLE__
+	#include <CoreFoundation/CoreFoundation.h>
+	#include <sys/syslimits.h>
+#endif
+
+
+using mkvmuxer::int32;
+using mkvmuxer::uint32;
+using mkvmuxer::int64;
+using mkvmuxer::uint64;
+
+
+size_t
+WebM_PathLength(const WebM_PathChar *path)
+{
+	size_t len = 0;
+	
+	while(path[len] != 0)
+		len++;
+	
+	return len;
+}
+
+
+FILE *
+WebM_OpenFile(const WebM_PathChar *path, const char *mode)
+{
+	FILE *file = NULL;
+	
+#ifdef PRWIN_ENV
+	wchar_t wmode[8];
+	
+	int i = 0;
+	
+	while(mode[i] != '\0' && i < 7)
+	{
+		wmode[i] = mode[i];
+		i++;
+	}
+	
+	wmode[i] = L'\0';
+
+	file = _wfopen(path, wmode);
+#elif defined(__APPLE__)
+	CFStringRef filePathCFSR = CFStringCreateWithCharacters(NULL, path, WebM_PathLength(path));
+	
+	char posix_path[PATH_MAX];
+	
+	Boolean got_path = CFStringGetFileSystemRepresentation(filePathCFSR, posix_path, PATH_MAX);
+	
+	CFRelease(filePathCFSR);
+	
+	if(got_path)
+		file = fopen(posix_path, mode);
+#else
+	// everybody else takes UTF-8
+	file = fopen(WebM_PathToUTF8(path).c_str(), mode);
+#endif
+
+	return file;
+}
+
+
+int
+WebM_SeekFile(FILE *file, long long pos)
+{
+#ifdef PRWIN_ENV
+	return _fseeki64(file, pos, SEEK_SET);
+#else
+	return fseeko(file, pos, SEEK_SET);
+#endif
+}
+
+
+long long
+WebM_TellFile(FILE *file)
+{
+#ifdef PRWIN_ENV
+	return _ftelli64(file);
+#else
+	return ftello(file);
+#endif
+}
+
+
+UTF16String
+WebM_SiblingPath(const WebM_PathChar *main_path, const char *suffix)
+{
+	UTF16String path(main_path);
+	
+	const size_t dot = path.find_last_of((WebM_PathChar)'.');
+	
+#ifdef PRWIN_ENV
+	const size_t sep = path.find_last_of(L"\\/");
+#else
+	const size_t sep = path.find_last_of((WebM_PathChar)'/');
+#endif
+
+	if(dot != UTF16String::npos && (sep == UTF16String::npos || dot > sep))
+		path.erase(dot);
+	
+	for(const char *c = suffix; *c != '\0'; c++)
+		path += (WebM_PathChar)*c;
+	
+	return path;
+}
+
+
+std::string
+WebM_FileNameUTF8(const UTF16String &path)
+{
+#ifdef PRWIN_ENV
+	const size_t sep = path.find_last_of(L"\\/");
+#else
+	const size_t sep = path.find_last_of((WebM_PathChar)'/');
+#endif
+
+	return WebM_PathToUTF8(sep == UTF16String::npos ? path : path.substr(sep + 1));
+}
+
+
+std::string
+WebM_PathToUTF8(const UTF16String &path)
+{
+	std::string utf8;
+	
+	for(size_t i=0; i < path.size(); i++)
+	{
+		unsigned long c = path[i];
+		
+		// put surrogate pairs back together
+		if(c >= 0xd800 && c < 0xdc00 && (i + 1) < path.size() &&
+			path[i + 1] >= 0xdc00 && path[i + 1] < 0xe000)
+		{
+			c = 0x10000 + ((c - 0xd800) << 10) + (path[i + 1] - 0xdc00);
+			i++;
+		}
+		
+		if(c < 0x80)
+		{
+			utf8 += (char)c;
+		}
+		else if(c < 0x800)
+		{
+			utf8 += (char)(0xc0 | (c >> 6));
+			utf8 += (char)(0x80 | (c & 0x3f));
+		}
+		else if(c < 0x10000)
+		{
+			utf8 += (char)(0xe0 | (c >> 12));
+			utf8 += (char)(0x80 | ((c >> 6) & 0x3f));
+			utf8 += (char)(0x80 | (c & 0x3f));
+		}
+		else
+		{
+			utf8 += (char)(0xf0 | (c >> 18));
+			utf8 += (char)(0x80 | ((c >> 12) & 0x3f));
+			utf8 += (char)(0x80 | ((c >> 6) & 0x3f));
+			utf8 += (char)(0x80 | (c & 0x3f));
+		}
+	}
+	
+	return utf8;
+}
+
+
+UTF16String
+WebM_PathFromUTF8(const char *path)
+{
+	UTF16String utf16;
+	
+	const unsigned char *p = (const unsigned char *)path;
+	
+	while(*p != '\0')
+	{
+		unsigned long c = *p++;
+		
+		int extra = (c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0);
+		
+		if(extra > 0)
+			c &= (0x3f >> extra);
+		
+		while(extra-- > 0 && (*p & 0xc0) == 0x80)
+			c = (c << 6) | (*p++ & 0x3f);
+		
+		if(c >= 0x10000)
+		{
+			c -= 0x10000;
+			
+			utf16 += (WebM_PathChar)(0xd800 + (c >> 10));
+			utf16 += (WebM_PathChar)(0xdc00 + (c & 0x3ff));
+		}
+		else
+			utf16 += (WebM_PathChar)c;
+	}
+	
+	return utf16;
+}
+
+
+void
+WebM_MkvWriter::ElementStartNotify(uint64 element_id, int64 position)
+{
+	WebM_NoteElement(_layout, element_id, position);
+}
+
+
+FileMkvWriter::FileMkvWriter() :
+	_file(NULL)
+{
+
+}
+
+
+FileMkvWriter::~FileMkvWriter()
+{
+	Close();
+}
+
+
+bool
+FileMkvWriter::Open(const WebM_PathChar *path)
+{
+	assert(_file == NULL);
+	
+	_file = WebM_OpenFile(path, "wb");
+
+	return (_file != NULL);
+}
+
+
+void
+FileMkvWriter::Close()
+{
+	if(_file != NULL)
+	{
+		fclose(_file);
+		
+		_file = NULL;
+	}
+}
+
+
+int32
+FileMkvWriter::Write(const void* buf, uint32 len)
+{
+	if(_file == NULL)
+		return -1;
+	
+	if(fwrite(buf, 1, len, _file) != len)
+		return -1;
+	
+	const int64 end = Position();
+	
+	if(end > _layout.size)
+		_layout.size = end;
+	
+	return 0;
+}
+
+
+int64
+FileMkvWriter::Position() const
+{
+	return WebM_TellFile(_file);
+}
+
+
+int32
+FileMkvWriter::Position(int64 position)
+{
+	return WebM_SeekFile(_file, position);
+}
+
+
+WebM_Reader::WebM_Reader() :
+	_size(-1),
+	_growing(false)
+{
+
+}
+
+
+int
+WebM_Reader::Length(long long* total, long long* available)
+{
+	// total appears to mean the total length of the file, while
+	// available means the amount of data that has been downloaded,
+	// as in for a stream.  For a disk-based file, these two are the same,
+	// unless somebody is still writing it.
+	
+	if(_size >= 0)
+	{
+		*total = (_growing ? -1 : _size);
+		*available = _size;
+		
+		return WebM_ReadSuccess;
+	}
+	else
+		return WebM_ReadError;
+}
+
+
+bool
+WebM_Reader::Refresh()
+{
+	const long long size = FileSize();
+	
+	if(size > _size)
+	{
+		_size = size;
+		
+		return true;
+	}
+	else
+		return false;
+}
+
+
+WebM_FileReader::WebM_FileReader() :
+	_file(NULL)
+{
+
+}
+
+
+WebM_FileReader::~WebM_FileReader()
+{
+	Close();
+}
+
+
+bool
+WebM_FileReader::Open(const WebM_PathChar *path)
+{
+	Close();
+	
+	_file = WebM_OpenFile(path, "rb");
+	
+	UpdateSize();
+	
+	return (_file != NULL);
+}
+
+
+void
+WebM_FileReader::Close()
+{
+	if(_file != NULL)
+	{
+		fclose(_file);
+		
+		_file = NULL;
+	}
+	
+	ForgetSize();
+}
+
+
+int
+WebM_FileReader::Read(long long pos, long len, unsigned char* buf)
+{
+	if(_file == NULL || WebM_SeekFile(_file, pos) != 0)
+		return WebM_ReadError;
+	
+	return (fread(buf, 1, len, _file) == (size_t)len ? WebM_ReadSuccess : WebM_ReadError);
+}
+
+
+long long
+WebM_FileReader::FileSize() const
+{
+	if(_file == NULL)
+		return -1;
+	
+	// a writer might have added some since we last looked
+	const long long pos = WebM_TellFile(_file);
+	
+#ifdef PRWIN_ENV
+	_fseeki64(_file, 0, SEEK_END);
+#else
+	fseeko(_file, 0, SEEK_END);
+#endif
+
+	const long long size = WebM_TellFile(_file);
+	
+	WebM_SeekFile(_file, pos);
+	
+	return size;
+}
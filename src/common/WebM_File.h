@@ -0,0 +1,179 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#ifndef WEBM_FILE_H
+#define WEBM_FILE_H
+
+// Paths, files and the libwebm readers and writers that go with them.
+// No host SDK in here: paths are UTF-16 the way Premiere hands them to us,
+// which is wchar_t on Windows and 16-bit everywhere else.
+
+#include "WebM_DASH.h"
+
+#include "mkvparser.hpp"
+#include "mkvmuxer.hpp"
+
+#include <stdio.h>
+
+#include <string>
+
+
+#ifdef PRWIN_ENV
+typedef wchar_t WebM_PathChar;
+#else
+typedef unsigned short WebM_PathChar;
+#endif
+
+typedef std::basic_string<WebM_PathChar> UTF16String;
+
+
+// The exporter can write a low-res proxy next to the movie, and the
+// importer looks for it there.
+#define WEBM_PROXY_SUFFIX	"_proxy.webm"
+
+
+size_t WebM_PathLength(const WebM_PathChar *path);
+
+// fopen() with one of our paths
+FILE *WebM_OpenFile(const WebM_PathChar *path, const char *mode);
+
+// fseek() and ftell() that get past 2 GB
+int WebM_SeekFile(FILE *file, long long pos);
+long long WebM_TellFile(FILE *file);
+
+// movie.webm becomes movie<suffix>, like movie_720p.webm or movie.mpd
+UTF16String WebM_SiblingPath(const WebM_PathChar *main_path, const char *suffix);
+
+// just the file name part of path, in UTF-8
+std::string WebM_FileNameUTF8(const UTF16String &path);
+
+// the whole path, in UTF-8 and back
+std::string WebM_PathToUTF8(const UTF16String &path);
+UTF16String WebM_PathFromUTF8(const char *path);
+
+
+// A muxer writer that keeps track of where the Clusters and Cues went,
+// for the DASH manifest.  Subclasses update _layout.size as they write.
+class WebM_MkvWriter : public mkvmuxer::IMkvWriter
+{
+  public:
+	virtual void ElementStartNotify(mkvmuxer::uint64 element_id, mkvmuxer::int64 position);
+	
+	const WebM_MkvLayout & Layout() const { return _layout; }
+	
+  protected:
+	WebM_MkvLayout _layout;
+};
+
+
+class FileMkvWriter : public WebM_MkvWriter
+{
+  public:
+	FileMkvWriter();
+	virtual ~FileMkvWriter();
+	
+	bool Open(const WebM_PathChar *path);
+	void Close();
+	
+	virtual mkvmuxer::int32 Write(const void* buf, mkvmuxer::uint32 len);
+	virtual mkvmuxer::int64 Position() const;
+	virtual mkvmuxer::int32 Position(mkvmuxer::int64 position); // seek
+	virtual bool Seekable() const { return true; }
+	
+  private:
+	FILE *_file;
+};
+
+
+// A parser reader for a file that might still be growing (edit while capture).
+// The parser is told the total length is unknown and only gets what's there now.
+// Refresh() checks for more and returns true if the file got longer.
+// Subclasses say how big the file is and do the reading.
+class WebM_Reader : public mkvparser::IMkvReader
+{
+  public:
+	WebM_Reader();
+	virtual ~WebM_Reader() {}
+	
+	virtual int Length(long long* total, long long* available);
+	
+	void SetGrowing(bool growing) { _growing = growing; }
+	bool IsGrowing() const { return _growing; }
+	bool Refresh();
+	
+	enum {
+		WebM_ReadError = -1,
+		WebM_ReadSuccess = 0
+	};
+	
+  protected:
+	virtual long long FileSize() const = 0;
+	
+	// when the file changes hands
+	void UpdateSize() { _size = FileSize(); }
+	void ForgetSize() { _size = -1; }
+	
+  private:
+	long long _size;
+	bool _growing;
+};
+
+
+// ...and one that reads with stdio, for when there's no host to do it
+class WebM_FileReader : public WebM_Reader
+{
+  public:
+	WebM_FileReader();
+	virtual ~WebM_FileReader();
+	
+	bool Open(const WebM_PathChar *path);
+	void Close();
+	
+	virtual int Read(long long pos, long len, unsigned char* buf);
+	
+  protected:
+	virtual long long FileSize() const;
+	
+  private:
+	FILE *_file;
+};
+
+
+#endif // WEBM_FILE_H
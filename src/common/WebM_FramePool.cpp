@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+#include "WebM_FramePool.h"
+
+#include "WebM_Thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+
+#ifdef VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER
+
+typedef struct {
+	unsigned char	*data;
+	size_t			size;
+	bool			in_use;
+	unsigned long	last_used;	// gClock when it was last handed out
+} PoolBuffer;
+
+
+// VP9 frame threading calls us from its own threads, so everything is locked
+static WebM_Mutex gPoolMutex;
+
+static std::vector<PoolBuffer *> gPool;
+
+static size_t gPoolBytes = 0;		// in use or not
+static int gDecoders = 0;			// using the pool right now
+static unsigned long gClock = 0;
+
+// Buffers nobody is using are kept around for the next decoder, up to a point.
+// A VP9 decoder holds 8 reference frames plus a few it's working on, and
+// a couple of clips can be decoding at once.  That's a lot of 4K frames,
+// so there's a limit on the bytes too.
+static const int kMaxIdleBuffers = 32;
+static const size_t kMaxPoolBytes = 512 * 1024 * 1024;
+
+// with no decoders left, about one decoder's worth waits for the next one
+static const int kKeepBuffers = 12;
+
+
+// Free idle buffers, the ones that went unused longest first, until there
+// are at most max_idle of them and the pool is down to max_bytes (or as
+// close as it gets without touching the ones in use).  Lock first.
+static void
+TrimPool(int max_idle, size_t max_bytes)
+{
+	int idle = 0;
+	
+	for(int i=0; i < gPool.size(); i++)
+	{
+		if(!gPool[i]->in_use)
+			idle++;
+	}
+	
+	while(idle > 0 && (idle > max_idle || gPoolBytes > max_bytes))
+	{
+		int oldest = -1;
+		
+		for(int i=0; i < gPool.size(); i++)
+		{
+			if(!gPool[i]->in_use && (oldest < 0 || gPool[i]->last_used < gPool[oldest]->last_used))
+				oldest = i;
+		}
+		
+		PoolBuffer *buffer = gPool[oldest];
+		
+		gPool.erase(gPool.begin() + oldest);
+		
+		gPoolBytes -= buffer->size;
+		
+		free(buffer->data);
+		
+		delete buffer;
+		
+		idle--;
+	}
+}
+
+
+static int
+GetFrameBuffer(void *priv, size_t min_size, vpx_codec_frame_buffer_t *fb)
+{
+	WebM_Lock lock(gPoolMutex);
+	
+	// the smallest free one that's big enough
+	PoolBuffer *best = NULL;
+	
+	for(int i=0; i < gPool.size(); i++)
+	{
+		PoolBuffer *buffer = gPool[i];
+		
+		if(!buffer->in_use && buffer->size >= min_size && (best == NULL || buffer->size < best->size))
+			best = buffer;
+	}
+	
+	if(best == NULL)
+	{
+		// make room, the idle ones are the wrong size anyway
+		TrimPool(kMaxIdleBuffers, (kMaxPoolBytes > min_size ? kMaxPoolBytes - min_size : 0));
+		
+		best = new PoolBuffer;
+		
+		// libvpx wants new frame buffers cleared, reused ones can have anything in them
+		best->data = (unsigned char *)calloc(min_size, 1);
+		best->size = min_size;
+		best->in_use = false;
+		
+		if(best->data == NULL)
+		{
+			delete best;
+			
+			return -1;
+		}
+		
+		gPool.push_back(best);
+		
+		gPoolBytes += best->size;
+	}
+	
+	best->in_use = true;
+	best->last_used = gClock++;
+	
+	fb->data = best->data;
+	fb->size = best->size;
+	fb->priv = best;
+	
+	return 0;
+}
+
+
+static int
+ReleaseFrameBuffer(void *priv, vpx_codec_frame_buffer_t *fb)
+{
+	WebM_Lock lock(gPoolMutex);
+	
+	PoolBuffer *released = (PoolBuffer *)fb->priv;
+	
+	if(released == NULL)
+		return 0;
+	
+	released->in_use = false;
+	
+	fb->priv = NULL;
+	
+	TrimPool(kMaxIdleBuffers, kMaxPoolBytes);
+	
+	return 0;
+}
+
+#endif // VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER
+
+
+bool
+WebM_UseFramePool(vpx_codec_ctx_t *decoder)
+{
+#ifdef VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER
+	if( !(vpx_codec_get_caps(decoder->iface) & VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER) )
+		return false;
+	
+	if(vpx_codec_set_frame_buffer_functions(decoder, GetFrameBuffer, ReleaseFrameBuffer, NULL) == VPX_CODEC_OK)
+	{
+		WebM_Lock lock(gPoolMutex);
+		
+		gDecoders++;
+		
+		return true;
+	}
+#endif
+	
+	return false;
+}
+
+
+void
+WebM_DoneWithFramePool()
+{
+#ifdef VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER
+	WebM_Lock lock(gPoolMutex);
+	
+	if(gDecoders > 0)
+		gDecoders--;
+	
+	if(gDecoders == 0)
+		TrimPool(kKeepBuffers, kMaxPoolBytes);
+#endif
+}
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#ifndef WEBM_FRAMEPOOL_H
+#define WEBM_FRAMEPOOL_H
+
+// The importer makes a new decoder every time Premiere asks for a frame
+// that isn't cached, and every new VP9 decoder used to allocate (and clear)
+// its own set of frame buffers, only to free them a GOP later.  At 4K that's
+// a lot of memory going around for nothing.  This pool hands out frame
+// buffers that outlive the decoders, so they get reused instead.  It only
+// holds on to so many, and so many bytes, that nobody's using.
+//
+// Premiere can't wrap a PPix around our memory, so we still copy each frame
+// into the PPix once.  That copy reads straight from the pool.
+
+extern "C" {
+#include "vpx/vpx_decoder.h"
+}
+
+
+// Call right after vpx_codec_dec_init(), before decoding anything.
+// Only VP9 takes outside frame buffers; returns false if the decoder said no
+// (or our libvpx is too old to ask), in which case it just uses its own,
+// like before.
+bool WebM_UseFramePool(vpx_codec_ctx_t *decoder);
+
+// Call after vpx_codec_destroy() on a decoder WebM_UseFramePool() said yes
+// to.  When the last one is gone, the pool lets go of all but a few buffers.
+void WebM_DoneWithFramePool();
+
+
+#endif // WEBM_FRAMEPOOL_H
@@ -0,0 +1,1233 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_Import.h"
+
+#include "WebM_Passthrough.h"
+
+#include "WebM_Color.h"
+#include "WebM_AlphaDecoder.h"
+#include "WebM_DecoderThreads.h"
+#include "WebM_FramePool.h"
+#include "WebM_Speed.h"
+
+#include "webmids.hpp"
+
+
+extern "C" {
+
+#include "vpx/vpx_decoder.h"
+#include "vpx/vp8dx.h"
+
+#include <vorbis/codec.h>
+#include <opus_multistream.h>
+
+}
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <algorithm>
+
+
+template <typename T>
+static inline T minimum(T one, T two)
+{
+	return (one < two ? one : two);
+}
+
+
+// Alpha comes in every frame or none, so the first one tells us
+static bool
+IndexHasAlpha(const WebM_Index &index)
+{
+	return (index.video.size() > 0 && index.video[0].alpha_size > 0);
+}
+
+
+WebM_Clip::WebM_Clip(int id) :
+	_id(id),
+	_reader(NULL),
+	_segment(NULL),
+	_index(NULL),
+	_index_resume(NULL),
+	_video_track(-1),
+	_codec(WEBM_CLIP_NONE),
+	_width(0),
+	_height(0),
+	_fps_num(0),
+	_fps_den(0),
+	_has_alpha(false),
+	_audio_track(-1),
+	_passthrough_source(-1),
+	_proxy(NULL),
+	_read_ahead(NULL),
+	_have_identity(false),
+	_finished_checked(0.0)
+{
+	memset(&_identity, 0, sizeof(_identity));
+}
+
+
+WebM_Clip::~WebM_Clip()
+{
+	Close();
+}
+
+
+WebM_Result
+WebM_Clip::Open(WebM_Reader *reader, const WebM_PathChar *path)
+{
+	Close();
+	
+	_reader = reader;
+	_path = path;
+	
+	WebM_Result result = WEBM_OK;
+	
+	long long pos = 0;
+
+	mkvparser::EBMLHeader ebmlHeader;
+
+	ebmlHeader.Parse(_reader, pos);
+	
+	long long ret = mkvparser::Segment::CreateInstance(_reader, pos, _segment);
+	
+	if(ret >= 0 && _segment != NULL)
+	{
+		// A file that's still being captured doesn't know how big its
+		// Segment is yet.  We parse what's there and add to it as it grows,
+		// so no index cache for this one.
+		const bool growing = (_segment->m_size < 0);
+		
+		_reader->SetGrowing(growing);
+		
+		// If we've seen this file before, the index cache has everything that
+		// Segment::Load() would have walked the whole file to find out.
+		// Then we only need the headers for the track info.
+		_have_identity = !growing && WebM_GetFileIdentity(_reader, path, _identity);
+		
+		_index = new WebM_Index;
+		
+		const bool cached = _have_identity && WebM_LoadIndexCache(_identity, *_index);
+		
+		ret = ((cached || growing) ? _segment->ParseHeaders() : _segment->Load());
+		
+		if(ret >= 0)
+		{
+			const mkvparser::Tracks* pTracks = _segment->GetTracks();
+			
+			for(int t=0; t < pTracks->GetTracksCount(); t++)
+			{
+				const mkvparser::Track* const pTrack = pTracks->GetTrackByIndex(t);
+				
+				if(pTrack != NULL)
+				{
+					const long trackType = pTrack->GetType();
+					const long trackNumber = pTrack->GetNumber();
+					
+					if(trackType == mkvparser::Track::kVideo)
+					{
+						const mkvparser::VideoTrack* const pVideoTrack = static_cast<const mkvparser::VideoTrack*>(pTrack);
+						
+						if(pVideoTrack)
+						{
+							_width = pVideoTrack->GetWidth();
+							_height = pVideoTrack->GetHeight();
+							
+							_codec = pVideoTrack->GetCodecId() == std::string("V_VP8") ? WEBM_CLIP_VP8 :
+										pVideoTrack->GetCodecId() == std::string("V_VP9") ? WEBM_CLIP_VP9 :
+										WEBM_CLIP_NONE;
+						
+							_video_track = trackNumber;
+						}
+					}
+					else if(trackType == mkvparser::Track::kAudio)
+					{
+						const mkvparser::AudioTrack* const pAudioTrack = static_cast<const mkvparser::AudioTrack*>(pTrack);
+						
+						if(pAudioTrack)
+						{
+							_audio_track = trackNumber;
+						}
+					}
+				}
+			}
+			
+			if(_video_track == -1 && _audio_track == -1)
+			{
+				result = WEBM_ERR_NO_STREAMS;
+			}
+			else
+			{
+				if(growing)
+				{
+					_index_resume = new WebM_IndexResume;
+					
+					WebM_ExtendIndex(_segment, _reader, _video_track, _audio_track,
+										*_index, *_index_resume);
+				}
+				else if(!cached)
+				{
+					WebM_BuildIndex(_segment, _reader, _video_track, _audio_track, *_index);
+					
+					if(_have_identity)
+						WebM_SaveIndexCache(_identity, *_index);
+				}
+				
+				// hang on to the frame rate so nobody has to work it out again
+				_fps_num = _index->fps_num;
+				_fps_den = _index->fps_den;
+				
+				_has_alpha = IndexHasAlpha(*_index);
+				
+				_read_ahead = new WebM_ReadAhead;
+				
+				if(_codec != WEBM_CLIP_NONE && !growing)
+				{
+					// a proxy the exporter wrote along with the movie
+					WebM_ProxyFile *proxy = new WebM_ProxyFile;
+					
+					if( proxy->Open(path, _reader, *_index) )
+						_proxy = proxy;
+					else
+						delete proxy;
+				}
+			}
+		}
+		else
+			result = WEBM_ERR_FORMAT;
+	}
+	else
+		result = WEBM_ERR_FORMAT;
+	
+	if(result != WEBM_OK)
+		Close();
+	
+	return result;
+}
+
+
+void
+WebM_Clip::Close()
+{
+	if(_passthrough_source >= 0)
+		WebM_PassthroughRemoveSource(_passthrough_source);
+	
+	delete _read_ahead;
+	delete _proxy;
+	delete _index_resume;
+	delete _index;
+	delete _segment;
+	delete _reader;
+	
+	_read_ahead = NULL;
+	_proxy = NULL;
+	_index_resume = NULL;
+	_index = NULL;
+	_segment = NULL;
+	_reader = NULL;
+	
+	_video_track = -1;
+	_codec = WEBM_CLIP_NONE;
+	_width = _height = 0;
+	_fps_num = _fps_den = 0;
+	_has_alpha = false;
+	_audio_track = -1;
+	_passthrough_source = -1;
+	_have_identity = false;
+	_finished_checked = 0.0;
+	_path.clear();
+}
+
+
+// The exporter only wants to hear about us while it's smart rendering,
+// and the source it had for us is gone once it stops.
+int
+WebM_Clip::PassthroughSource()
+{
+	if(_codec == WEBM_CLIP_NONE || _index_resume != NULL || !WebM_PassthroughActive())
+		return -1;
+	
+	if(_passthrough_source < 0 || !WebM_PassthroughHasSource(_passthrough_source))
+		_passthrough_source = WebM_PassthroughAddSource(_path.c_str(), PassthroughFormat(), *_index);
+	
+	return _passthrough_source;
+}
+
+
+WebM_PassthroughFormat
+WebM_Clip::PassthroughFormat() const
+{
+	WebM_PassthroughFormat format;
+	
+	format.codec_id = (_codec == WEBM_CLIP_VP9 ? "V_VP9" : "V_VP8");
+	format.width = _width;
+	format.height = _height;
+	format.profile = -1; // matches nothing, unless the keyframe says otherwise
+	format.bit_depth = -1;
+	
+	// profile and bit depth are only in the frames themselves
+	for(int i=0; i < _index->video.size(); i++)
+	{
+		const WebM_IndexVideoFrame &frame = _index->video[i];
+		
+		if(frame.flags & WEBM_INDEX_KEYFRAME)
+		{
+			unsigned char header[16];
+			
+			const long header_size = (frame.size < sizeof(header) ? frame.size : sizeof(header));
+			
+			if(_reader->Read(frame.pos, header_size, header) == WebM_Reader::WebM_ReadSuccess)
+				WebM_PassthroughParseKeyframe(format.codec_id.c_str(), header, header_size, format.profile, format.bit_depth);
+			
+			break;
+		}
+	}
+	
+	const mkvparser::Track *track = _segment->GetTracks()->GetTrackByNumber(_video_track);
+	
+	if(track != NULL)
+	{
+		size_t private_size = 0;
+		
+		const unsigned char *private_data = track->GetCodecPrivate(private_size);
+		
+		if(private_data != NULL)
+			format.codec_private.assign(private_data, private_data + private_size);
+	}
+	
+	return format;
+}
+
+
+void
+WebM_Clip::Quiet()
+{
+	if(_proxy)
+		_proxy->Quiet();
+}
+
+
+bool
+WebM_Clip::Reopen(const WebM_PathChar *path)
+{
+	if(_reader == NULL)
+		return false;
+	
+	WebM_FileIdentity identity;
+	
+	// A growing file changes all the time, that's the point.  We keep
+	// going from where we were and pick up whatever's been added.
+	const bool same_file = _reader->IsGrowing() ||
+							(_have_identity &&
+							WebM_GetFileIdentity(_reader, path, identity) &&
+							WebM_SameFileIdentity(identity, _identity));
+	
+	if(same_file)
+		Update(true);
+	
+	return same_file;
+}
+
+
+// Reads through the clip's reader, but gives the length it has now as the
+// total.  The parser only believes a Segment size when it knows how big
+// the file is, and the clip's reader has to keep saying it doesn't.
+class SettledReader : public mkvparser::IMkvReader
+{
+  public:
+	SettledReader(WebM_Reader *reader) : _reader(reader) {}
+	virtual ~SettledReader() {}
+	
+	virtual int Read(long long pos, long len, unsigned char *buf)
+	{
+		return _reader->Read(pos, len, buf);
+	}
+	
+	virtual int Length(long long *total, long long *available)
+	{
+		long long reader_total, reader_available;
+		
+		const int result = _reader->Length(&reader_total, &reader_available);
+		
+		if(result == WebM_Reader::WebM_ReadSuccess)
+			*total = *available = reader_available;
+		
+		return result;
+	}
+	
+  private:
+	WebM_Reader * const _reader;
+};
+
+
+// The writer is done when the Segment has a size that fits in the file and
+// the SeekHead points to Cues, which mkvmuxer only writes when it finalizes.
+// Our own Segment was parsed with the size unknown and stays that way, so
+// this looks with a new one.
+static bool
+WriterFinished(WebM_Reader *reader)
+{
+	SettledReader settled(reader);
+	
+	bool finished = false;
+	
+	long long pos = 0;
+	
+	mkvparser::EBMLHeader ebmlHeader;
+	
+	mkvparser::Segment *segment = NULL;
+	
+	if(ebmlHeader.Parse(&settled, pos) == 0 &&
+		mkvparser::Segment::CreateInstance(&settled, pos, segment) == 0 && segment != NULL &&
+		segment->m_size >= 0 && segment->ParseHeaders() == 0)
+	{
+		const mkvparser::SeekHead *seek_head = segment->GetSeekHead();
+		
+		for(int i=0; seek_head != NULL && i < seek_head->GetCount() && !finished; i++)
+		{
+			const mkvparser::SeekHead::Entry *entry = seek_head->GetEntry(i);
+			
+			finished = (entry != NULL && entry->id == mkvmuxer::kMkvCues);
+		}
+	}
+	
+	delete segment;
+	
+	return finished;
+}
+
+
+static const double kFinishedCheckSeconds = 1.0;
+
+
+// Only the new clusters get parsed.  The host asks for the info again
+// when it refreshes the clip, which is when it sees the longer duration.
+// When the file stops getting longer, we see if the capture is over: right
+// away the first time, then no more than once a second, since the host
+// calls this for every frame and a paused capture never finishes.
+void
+WebM_Clip::Update(bool reopened)
+{
+	if(_index_resume != NULL && _reader != NULL)
+	{
+		if(_reader->Refresh() || reopened)
+		{
+			ExtendIndex();
+			
+			_finished_checked = 0.0;
+		}
+		else
+		{
+			const double now = WebM_Seconds();
+			
+			if(now - _finished_checked >= kFinishedCheckSeconds)
+			{
+				_finished_checked = now;
+				
+				if( WriterFinished(_reader) )
+					Finished();
+			}
+		}
+	}
+}
+
+
+void
+WebM_Clip::ExtendIndex()
+{
+	const bool grew = WebM_ExtendIndex(_segment, _reader, _video_track, _audio_track,
+										*_index, *_index_resume);
+	
+	// the frame rate guess gets better as frames come in
+	if(grew && _index->fps_num > 0)
+	{
+		_fps_num = _index->fps_num;
+		_fps_den = _index->fps_den;
+	}
+	
+	if(grew)
+		_has_alpha = IndexHasAlpha(*_index);
+}
+
+
+// The capture's over, so from here on it's a file like any other: the index
+// goes in the cache and the exporter can copy our frames.
+void
+WebM_Clip::Finished()
+{
+	// anything that came in with the Cues
+	ExtendIndex();
+	
+	delete _index_resume;
+	
+	_index_resume = NULL;
+	
+	_reader->SetGrowing(false);
+	
+	_have_identity = WebM_GetFileIdentity(_reader, _path.c_str(), _identity);
+	
+	if(_have_identity)
+		WebM_SaveIndexCache(_identity, *_index);
+}
+
+
+const mkvparser::AudioTrack *
+WebM_Clip::GetAudioTrack() const
+{
+	if(_segment != NULL && _audio_track >= 0)
+	{
+		const mkvparser::Track* const pTrack = _segment->GetTracks()->GetTrackByNumber(_audio_track);
+		
+		if(pTrack != NULL && pTrack->GetType() == mkvparser::Track::kAudio)
+			return static_cast<const mkvparser::AudioTrack*>(pTrack);
+	}
+	
+	return NULL;
+}
+
+
+int
+WebM_Clip::AudioChannels() const
+{
+	const mkvparser::AudioTrack *pAudioTrack = GetAudioTrack();
+	
+	return (pAudioTrack != NULL ? pAudioTrack->GetChannels() : 0);
+}
+
+
+int
+WebM_Clip::AudioSampleRate() const
+{
+	const mkvparser::AudioTrack *pAudioTrack = GetAudioTrack();
+	
+	if(pAudioTrack == NULL)
+		return 0;
+	
+	return (pAudioTrack->GetCodecId() == std::string("A_OPUS") ?
+				WEBM_OPUS_SAMPLE_RATE : // no matter what the input rate was
+				pAudioTrack->GetSamplingRate());
+}
+
+
+int
+WebM_Clip::AudioBitDepth() const
+{
+	const mkvparser::AudioTrack *pAudioTrack = GetAudioTrack();
+	
+	return (pAudioTrack != NULL ? pAudioTrack->GetBitDepth() : 0);
+}
+
+
+bool
+WebM_Clip::FrameSize(int index, int &width, int &height) const
+{
+	if(index == 0)
+	{
+		width = _width;
+		height = _height;
+		
+		return true;
+	}
+	
+	// VP8 and VP9 can't decode any smaller, but a proxy can stand in
+	// (the proxy doesn't have alpha)
+	if(index == 1 && _proxy != NULL && !_has_alpha &&
+		_proxy->Width() < _width && _proxy->Height() < _height)
+	{
+		width = _proxy->Width();
+		height = _proxy->Height();
+		
+		return true;
+	}
+	
+	return false;
+}
+
+
+static WebM_Result
+ReadVorbisAudio(
+	mkvparser::IMkvReader				*reader,
+	const WebM_Index					&index,
+	const mkvparser::AudioTrack			*pAudioTrack,
+	int									numChannels,
+	long long							position,
+	int									size,
+	float								**buffers)
+{
+	WebM_Result result = WEBM_OK;
+	
+	vorbis_info vi;
+	vorbis_comment vc;
+	vorbis_dsp_state vd;
+	vorbis_block vb;
+	
+	if(pAudioTrack && WebM_VorbisHeadersIn(pAudioTrack, vi, vc))
+	{
+		memset(&vd, 0, sizeof(vd));
+		memset(&vb, 0, sizeof(vb));
+		
+		int v_err = vorbis_synthesis_init(&vd, &vi);
+		
+		if(v_err == OV_OK)
+			v_err = vorbis_block_init(&vd, &vb);
+		
+		if(v_err == OV_OK)
+		{
+			// We used to have to guess about this from block timestamps.
+			// Now the index has a granule map, so we know exactly which packet
+			// holds the sample the host wants.  Vorbis blocks overlap, so we
+			// start one packet early.  A fresh decoder never returns samples for
+			// the first packet it gets, and after that each packet gives us
+			// exactly the samples the granule map says it does.
+			const int packet_count = index.audio.size();
+			
+			const int want_packet = WebM_FindAudioPacket(index, position);
+			
+			const int start_packet = (want_packet > 0 ? want_packet - 1 : 0);
+			
+			long long pcm_position = (start_packet < packet_count ?
+										index.audio[start_packet].sample + index.audio[start_packet].samples :
+										0);
+			
+			const long long end_position = position + size;
+			
+			int ogg_packet_num = 3;
+			
+			for(int p = start_packet; p < packet_count && pcm_position < end_position && result == WEBM_OK; p++)
+			{
+				const WebM_IndexAudioPacket &index_packet = index.audio[p];
+				
+				unsigned int length = index_packet.size;
+				uint8_t *data = (uint8_t *)malloc(length);
+				
+				if(data != NULL)
+				{
+					int read_err = reader->Read(index_packet.pos, index_packet.size, data);
+					
+					if(read_err == WebM_Reader::WebM_ReadSuccess)
+					{
+						ogg_packet packet;
+	
+						packet.packet = data;
+						packet.bytes = length;
+						packet.b_o_s = false;
+						packet.e_o_s = false;
+						packet.granulepos = -1;
+						packet.packetno = ogg_packet_num++;
+
+						int synth_err = vorbis_synthesis(&vb, &packet);
+						
+						if(synth_err == OV_OK)
+						{
+							int block_err = vorbis_synthesis_blockin(&vd, &vb);
+							
+							if(block_err == OV_OK)
+							{
+								float **pcm = NULL;
+								int samples = 0;
+								
+								while((samples = vorbis_synthesis_pcmout(&vd, &pcm)) > 0)
+								{
+									// copy whatever part of these samples the host asked for
+									const long long copy_start = (pcm_position > position ? pcm_position : position);
+									const long long copy_end = minimum<long long>(pcm_position + samples, end_position);
+									
+									if(copy_end > copy_start)
+									{
+										const int pcm_offset = copy_start - pcm_position;
+										const int buffer_offset = copy_start - position;
+										const int samples_to_copy = copy_end - copy_start;
+										
+										// how nice, audio samples are float, just like Premiere wants 'em
+										for(int c=0; c < numChannels; c++)
+										{
+											memcpy(buffers[c] + buffer_offset, pcm[c] + pcm_offset, samples_to_copy * sizeof(float));
+										}
+									}
+									
+									pcm_position += samples;
+									
+									vorbis_synthesis_read(&vd, samples);
+								}
+							}
+							else
+								result = WEBM_ERR_READ;
+						}
+						else
+							result = WEBM_ERR_READ;
+					}
+					else
+						result = WEBM_ERR_READ;
+					
+					free(data);
+				}
+				else
+					result = WEBM_ERR_MEMORY;
+			}
+			
+			// there might not be samples left at the end; not much we can do about that
+		}
+		else
+			result = WEBM_ERR_READ;
+		
+		
+		vorbis_block_clear(&vb);
+		vorbis_dsp_clear(&vd);
+		vorbis_info_clear(&vi);
+		vorbis_comment_clear(&vc);
+	}
+	else
+		result = WEBM_ERR_READ;
+	
+	return result;
+}
+
+
+static WebM_Result
+ReadOpusAudio(
+	mkvparser::IMkvReader				*reader,
+	const WebM_Index					&index,
+	const mkvparser::AudioTrack			*pAudioTrack,
+	int									numChannels,
+	long long							position,
+	int									size,
+	float								**buffers)
+{
+	WebM_Result result = WEBM_OK;
+	
+	WebM_OpusHeader header;
+	
+	if(pAudioTrack && WebM_OpusHeaderIn(pAudioTrack, header) && header.channels == numChannels)
+	{
+		int o_err = OPUS_OK;
+		
+		OpusMSDecoder *decoder = opus_multistream_decoder_create(WEBM_OPUS_SAMPLE_RATE, header.channels,
+																	header.stream_count, header.coupled_count,
+																	header.mapping, &o_err);
+		
+		if(decoder != NULL && o_err == OPUS_OK)
+		{
+			// The index positions count every sample the decoder puts out, including
+			// the pre-skip at the start, which isn't really part of the audio.
+			// An Opus decoder needs some run-up after a seek before its output is
+			// right, so we start WEBM_OPUS_PREROLL samples early and throw those away.
+			const int packet_count = index.audio.size();
+			
+			const long long want_sample = position + header.pre_skip;
+			
+			const int start_packet = WebM_FindAudioPacket(index, (want_sample > WEBM_OPUS_PREROLL ?
+																	want_sample - WEBM_OPUS_PREROLL : 0));
+			
+			long long pcm_position = (start_packet < packet_count ? index.audio[start_packet].sample : 0) - header.pre_skip;
+			
+			const long long end_position = position + size;
+			
+			// 120 ms is the longest an Opus packet can be
+			const int max_frame_size = WEBM_OPUS_SAMPLE_RATE * 120 / 1000;
+			
+			std::vector<float> pcm(max_frame_size * header.channels);
+			
+			for(int p = start_packet; p < packet_count && pcm_position < end_position && result == WEBM_OK; p++)
+			{
+				const WebM_IndexAudioPacket &index_packet = index.audio[p];
+				
+				std::vector<unsigned char> data(index_packet.size > 0 ? index_packet.size : 1);
+				
+				int read_err = reader->Read(index_packet.pos, index_packet.size, &data[0]);
+				
+				if(read_err == WebM_Reader::WebM_ReadSuccess)
+				{
+					const int samples = opus_multistream_decode_float(decoder, &data[0], index_packet.size,
+																		&pcm[0], max_frame_size, 0);
+					
+					if(samples >= 0)
+					{
+						const long long copy_start = (pcm_position > position ? pcm_position : position);
+						const long long copy_end = minimum<long long>(pcm_position + samples, end_position);
+						
+						// Opus gives us interleaved samples, the host wants them by channel
+						for(long long s = copy_start; s < copy_end; s++)
+						{
+							const float *in = &pcm[(s - pcm_position) * header.channels];
+							
+							const int buffer_offset = s - position;
+							
+							for(int c=0; c < numChannels; c++)
+							{
+								buffers[c][buffer_offset] = in[c];
+							}
+						}
+						
+						pcm_position += samples;
+					}
+					else
+						result = WEBM_ERR_READ;
+				}
+				else
+					result = WEBM_ERR_READ;
+			}
+		}
+		else
+			result = WEBM_ERR_READ;
+		
+		if(decoder != NULL)
+			opus_multistream_decoder_destroy(decoder);
+	}
+	else
+		result = WEBM_ERR_READ;
+	
+	return result;
+}
+
+
+WebM_Result
+WebM_Clip::ReadAudio(long long position, int samples, float **buffers)
+{
+	assert(position >= 0); // Do they really want contiguous samples?
+	
+	if(_index == NULL)
+		return WEBM_ERR_INTERNAL;
+	
+	if(_audio_track < 0)
+		return WEBM_OK;
+	
+	Update();
+	
+	const mkvparser::AudioTrack *pAudioTrack = GetAudioTrack();
+	
+	if(pAudioTrack == NULL)
+		return WEBM_ERR_READ;
+	
+	if(pAudioTrack->GetCodecId() == std::string("A_OPUS"))
+	{
+		return ReadOpusAudio(_reader, *_index, pAudioTrack, AudioChannels(),
+								position, samples, buffers);
+	}
+	else
+	{
+		assert(pAudioTrack->GetCodecId() == std::string("A_VORBIS"));
+		
+		return ReadVorbisAudio(_reader, *_index, pAudioTrack, AudioChannels(),
+								position, samples, buffers);
+	}
+}
+
+
+WebM_Result
+WebM_DecodeFrame(WebM_Clip &clip, const WebM_DecodeRequest &request, WebM_FrameSink &sink)
+{
+	if(!clip.IsOpen() || !clip.HasVideo())
+		return WEBM_ERR_INTERNAL;
+	
+	WebM_Result result = WEBM_OK;
+	
+	const long theFrame = request.frame;
+	
+	// Smaller frames come out of the proxy, if there is one and
+	// it's big enough.  We scale down the rest of the way.
+	WebM_ProxyFile *proxy = clip.Proxy();
+	
+	// (the proxy doesn't have alpha)
+	const bool use_proxy = (proxy != NULL && !clip.HasAlpha() &&
+							request.width < clip.Width() &&
+							request.height < clip.Height() &&
+							request.width <= proxy->Width() &&
+							request.height <= proxy->Height());
+	
+	mkvparser::IMkvReader *reader = (use_proxy ? (mkvparser::IMkvReader *)proxy : (mkvparser::IMkvReader *)clip.Reader());
+	
+	const WebM_Index &index = (use_proxy ? proxy->Index() : clip.Index());
+	
+	const WebM_Clip_Codec video_codec = (use_proxy ? (proxy->IsVP9() ? WEBM_CLIP_VP9 : WEBM_CLIP_VP8) : clip.Codec());
+	
+	const unsigned long long fps_num = clip.FpsNum();
+	const unsigned long long fps_den = clip.FpsDen();
+	
+	WebM_ReadAhead *read_ahead = clip.ReadAhead();
+	
+	const bool keyframes_only = request.keyframes_only;
+	
+	// The index knows where every frame is, so no more binary searching
+	// through clusters.  Find the frame the host asked for, then back up
+	// to the keyframe before it.
+	const int frame_count = index.video.size();
+	
+	int want_frame = WebM_FindFrame(index, theFrame, fps_num, fps_den);
+	
+	int start_frame = want_frame;
+	
+	while(start_frame > 0 && !(index.video[start_frame].flags & WEBM_INDEX_KEYFRAME))
+		start_frame--;
+	
+	
+	// Thumbnails, hover scrub and shuttling don't need the exact frame.
+	// For those we just decode the nearest keyframe, so no rolling
+	// forward through the GOP.  The keyframe gets cached as itself, so
+	// nobody asking for the real frame later gets it by mistake.
+	if(keyframes_only && want_frame >= 0)
+	{
+		int next_key = want_frame + 1;
+		
+		while(next_key < frame_count && !(index.video[next_key].flags & WEBM_INDEX_KEYFRAME))
+			next_key++;
+		
+		if(next_key < frame_count && (next_key - want_frame) < (want_frame - start_frame))
+			start_frame = next_key;
+		
+		want_frame = start_frame;
+		
+		if( sink.InCache(WebM_FrameNumber(index.video[want_frame].tstamp, fps_num, fps_den)) )
+			return WEBM_OK; // already got it
+	}
+	
+	if(want_frame < 0)
+		return WEBM_OK;
+	
+	
+	vpx_codec_iface_t *iface = (video_codec == WEBM_CLIP_VP8 ? vpx_codec_vp8_dx() :
+								video_codec == WEBM_CLIP_VP9 ? vpx_codec_vp9_dx() :
+								NULL);
+	
+	vpx_codec_err_t codec_err = VPX_CODEC_OK;
+	
+	vpx_codec_ctx_t decoder;
+	
+	bool pooled = false;
+	
+	const int decode_width = (use_proxy ? proxy->Width() : request.width);
+	const int decode_height = (use_proxy ? proxy->Height() : request.height);
+	
+	// our share of the cores, while this decoder is around
+	WebM_DecoderThreads decoder_threads(clip.Id(), decode_width, decode_height, request.num_cpus);
+	
+	if(iface != NULL)
+	{
+		vpx_codec_dec_cfg_t config;
+		config.threads = decoder_threads.Threads();
+		config.w = decode_width;
+		config.h = decode_height;
+		
+		vpx_codec_flags_t flags = VPX_CODEC_CAP_FRAME_THREADING |
+									//VPX_CODEC_USE_ERROR_CONCEALMENT | // this doesn't seem to work
+									VPX_CODEC_USE_FRAME_THREADING;
+		
+		// Postprocessing is only in the VP8 decoder (our libvpx is built
+		// without CONFIG_VP9_POSTPROC), so ask before turning it on.
+		const bool postproc = ((request.mode == WEBM_DECODE_POSTPROC || request.mode == WEBM_DECODE_MFQE) &&
+								(vpx_codec_get_caps(iface) & VPX_CODEC_CAP_POSTPROC));
+		
+		if(postproc)
+			flags |= VPX_CODEC_USE_POSTPROC;
+		
+		codec_err = vpx_codec_dec_init(&decoder, iface, &config, flags);
+		
+		if(codec_err == VPX_CODEC_OK && postproc)
+		{
+			vp8_postproc_cfg_t pp_config;
+			
+			pp_config.post_proc_flag = VP8_DEBLOCK | VP8_DEMACROBLOCK |
+										(request.mode == WEBM_DECODE_MFQE ? VP8_MFQE : 0);
+			pp_config.deblocking_level = 4;
+			pp_config.noise_level = 0;
+			
+			vpx_codec_control(&decoder, VP8_SET_POSTPROC, &pp_config);
+		}
+		
+		// VP9 can use frame buffers that stick around after the decoder is gone
+		if(codec_err == VPX_CODEC_OK && video_codec == WEBM_CLIP_VP9)
+			pooled = WebM_UseFramePool(&decoder);
+	}
+	else
+		codec_err = VPX_CODEC_ERROR;
+	
+	if(codec_err != VPX_CODEC_OK)
+		return WEBM_OK; // no frame, no complaint, same as always
+	
+	
+	// the proxy frame, scaled to what the host wants
+	vpx_image_t scaled_data;
+	vpx_image_t *scaled = NULL;
+	
+	if(use_proxy && (request.width != proxy->Width() || request.height != proxy->Height()))
+	{
+		scaled = vpx_img_alloc(&scaled_data, VPX_IMG_FMT_I420, request.width, request.height, 32);
+		
+		if(scaled == NULL)
+		{
+			vpx_codec_destroy(&decoder);
+			
+			if(pooled)
+				WebM_DoneWithFramePool();
+			
+			return WEBM_ERR_MEMORY;
+		}
+	}
+	
+	// Alpha has its own stream and its own decoder, on its own thread,
+	// so it decodes while the color does.
+	WebM_AlphaDecoder *alpha_decoder = NULL;
+	
+	std::vector<unsigned char> alpha_data;
+	
+	if(clip.HasAlpha() && !use_proxy && request.alpha)
+	{
+		alpha_decoder = new WebM_AlphaDecoder;
+		
+		// if it doesn't work out, the frames come out opaque
+		if( !alpha_decoder->Begin(iface, decode_width, decode_height, (decoder_threads.Threads() + 1) / 2) )
+		{
+			delete alpha_decoder;
+			
+			alpha_decoder = NULL;
+		}
+	}
+	
+	
+	// I have to decode each frame starting with the keyframe,
+	// and then I may continue afterwards, as far as the end of
+	// the cluster, caching those frames as I go.  How far is up to
+	// the read-ahead policy, which watches how we're being asked.
+	int ahead = 0;
+	bool cache_behind = true;
+	
+	if(!keyframes_only && read_ahead != NULL)
+	{
+		int last_in_cluster = want_frame;
+		
+		while(last_in_cluster + 1 < frame_count && !(index.video[last_in_cluster + 1].flags & WEBM_INDEX_CLUSTER_START))
+			last_in_cluster++;
+		
+		const long frames_left = WebM_FrameNumber(index.video[last_in_cluster].tstamp, fps_num, fps_den) - theFrame;
+		
+		const size_t frame_bytes = (size_t)request.width * (size_t)request.height * 3 / 2;
+		
+		ahead = read_ahead->FramesAhead(theFrame, (frames_left > 0 ? frames_left : 0), frame_bytes,
+										want_frame - start_frame);
+		
+		cache_behind = read_ahead->CacheBehind();
+	}
+	
+	// Skipping the loop filter leaves blocky frames that the next
+	// ones are predicted from, so the errors build up until the next
+	// keyframe.  Fine while things are moving, not for a still frame.
+	bool fast_decode = false;
+	
+#ifdef VPX_CTRL_VP9_SET_SKIP_LOOP_FILTER
+	if(request.mode == WEBM_DECODE_FAST && video_codec == WEBM_CLIP_VP9 && !keyframes_only &&
+		!request.high_quality && read_ahead != NULL && read_ahead->Playing())
+	{
+		fast_decode = (vpx_codec_control(&decoder, VP9_SET_SKIP_LOOP_FILTER, 1) == VPX_CODEC_OK);
+	}
+#endif
+	
+	bool got_frame = false;
+	
+	for(int i = start_frame; i < frame_count && result == WEBM_OK; i++)
+	{
+		const WebM_IndexVideoFrame &frame = index.video[i];
+		
+		if(got_frame && (keyframes_only || (frame.flags & WEBM_INDEX_CLUSTER_START) ||
+							WebM_FrameNumber(frame.tstamp, fps_num, fps_den) > theFrame + ahead))
+			break;
+		
+		unsigned int length = frame.size;
+		uint8_t *data = (uint8_t *)malloc(length);
+		
+		if(data != NULL)
+		{
+			int read_err = reader->Read(frame.pos, frame.size, data);
+			
+			if(read_err == WebM_Reader::WebM_ReadSuccess && alpha_decoder != NULL)
+			{
+				alpha_data.resize(frame.alpha_size);
+				
+				const bool have_alpha = (frame.alpha_size > 0 &&
+											reader->Read(frame.pos + frame.alpha_offset, frame.alpha_size, &alpha_data[0]) == WebM_Reader::WebM_ReadSuccess);
+				
+				alpha_decoder->Submit((have_alpha ? &alpha_data[0] : NULL), (have_alpha ? alpha_data.size() : 0));
+			}
+			
+			if(read_err == WebM_Reader::WebM_ReadSuccess)
+			{
+				vpx_codec_err_t decode_err = vpx_codec_decode(&decoder, data, length, NULL, 0);
+				
+				assert(decode_err == VPX_CODEC_OK);
+
+				if(decode_err == VPX_CODEC_OK)
+				{
+					const long decodedFrame = WebM_FrameNumber(frame.tstamp, fps_num, fps_den);
+					
+					vpx_codec_iter_t iter = NULL;
+					
+					vpx_image_t *img = vpx_codec_get_frame(&decoder, &iter);
+					
+					if(img)
+					{
+						const vpx_image_t *out_img = img;
+						
+						if(scaled != NULL)
+						{
+							WebM_ScaleImage(img, scaled);
+							
+							out_img = scaled;
+						}
+						
+						// the alpha frame was decoding while we did the color
+						const vpx_image_t *alpha_img = (alpha_decoder != NULL ? alpha_decoder->Wait() : NULL);
+						
+						if(alpha_img != NULL && (alpha_img->d_w != img->d_w || alpha_img->d_h != img->d_h))
+							alpha_img = NULL;
+						
+						// the exporter can only copy frames out of the movie itself
+						if(!use_proxy && !fast_decode && !request.alpha)
+						{
+							const int passthrough_source = clip.PassthroughSource();
+							
+							if(passthrough_source >= 0)
+								WebM_PassthroughAddFrame(passthrough_source, i, WebM_HashImage(img));
+						}
+						
+						// We often have to decode many frames in a GOP (group of pictures)
+						// before we decode the one the host asked for.  The host can cache
+						// those frames for later.  We keep going past the requested frame to
+						// save us the trouble in the future.  When playing forward, the
+						// frames before the one we want won't be asked for again.
+						const bool wanted = (i == want_frame);
+						
+						result = sink.Frame(decodedFrame, out_img, alpha_img, wanted,
+											(i >= want_frame || cache_behind), fast_decode);
+						
+						if(wanted && result == WEBM_OK)
+							got_frame = true;
+						
+						// It says we can get more than one frame off one decode operation?  What would I do with it?
+						assert( NULL == (img = vpx_codec_get_frame(&decoder, &iter) ) );
+					}
+				}
+				else
+					result = WEBM_ERR_READ;
+			}
+			else
+				result = WEBM_ERR_READ;
+			
+			free(data);
+		}
+		else
+			result = WEBM_ERR_MEMORY;
+	}
+	
+	assert(got_frame || result != WEBM_OK);
+	
+	vpx_codec_err_t destroy_err = vpx_codec_destroy(&decoder);
+	assert(destroy_err == VPX_CODEC_OK);
+	
+	delete alpha_decoder;
+	
+	// (after the alpha decoder, which may be using the pool too)
+	if(pooled)
+		WebM_DoneWithFramePool();
+	
+	if(scaled != NULL)
+		vpx_img_free(scaled);
+	
+	return result;
+}
+
+
+bool
+WebM_DataRate(const WebM_Index &index, unsigned int fps_num, unsigned int fps_den,
+				std::vector<WebM_DataSample> &samples)
+{
+	samples.clear();
+	
+	if(fps_den == 0)
+		return false;
+	
+	// Sample durations are in units of 1/baserate seconds,
+	// so a constant rate file has every duration == fps_den.
+	const long long baserate = fps_num;
+	
+	// Going backwards, the next visible frame has always been seen already,
+	// and the invisible frames that get folded into it come right after.
+	long long next_tstamp = -1;
+	
+	for(size_t i=index.video.size(); i > 0; i--)
+	{
+		const WebM_IndexVideoFrame &frame = index.video[i - 1];
+		
+		if(frame.flags & WEBM_INDEX_INVISIBLE)
+		{
+			// goes with the visible frame after it, if there is one
+			if( !samples.empty() )
+			{
+				samples.back().size += frame.size;
+				samples.back().keyframe = samples.back().keyframe || (frame.flags & WEBM_INDEX_KEYFRAME);
+			}
+		}
+		else
+		{
+			// duration is the gap to the next visible frame
+			unsigned int duration = fps_den;
+			
+			if(next_tstamp > frame.tstamp)
+				duration = (((next_tstamp - frame.tstamp) * baserate) + 500000000LL) / 1000000000LL;
+			
+			WebM_DataSample sample;
+			
+			sample.duration = (duration > 0 ? duration : 1);
+			sample.size = frame.size;
+			sample.keyframe = (frame.flags & WEBM_INDEX_KEYFRAME);
+			
+			samples.push_back(sample);
+			
+			next_tstamp = frame.tstamp;
+		}
+	}
+	
+	if( samples.empty() )
+		return false;
+	
+	std::reverse(samples.begin(), samples.end());
+	
+	return true;
+}
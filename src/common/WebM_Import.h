@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_IMPORT_H
+#define WEBM_IMPORT_H
+
+// The importer, minus the host: parse the file and index it (or get the index
+// out of the cache), keep up with a file that's still being captured, decode
+// video frames and audio samples.  The plug-in hands us a reader for its file
+// handle and a WebM_FrameSink to put the decoded frames in.
+
+#include "WebM_Result.h"
+#include "WebM_File.h"
+#include "WebM_Index.h"
+#include "WebM_IndexCache.h"
+#include "WebM_Passthrough.h"
+#include "WebM_Proxy.h"
+#include "WebM_ReadAhead.h"
+
+
+extern "C" {
+
+#include "vpx/vpx_image.h"
+
+}
+
+#include "mkvparser.hpp"
+
+#include <vector>
+
+
+typedef enum {
+	WEBM_CLIP_NONE = 0,
+	WEBM_CLIP_VP8,
+	WEBM_CLIP_VP9
+} WebM_Clip_Codec;
+
+
+// Trading decode speed for quality.
+// FAST skips the VP9 loop filter during (less than high quality) playback.
+// POSTPROC turns on VP8 deblocking and demacroblocking, MFQE adds
+// multiframe quality enhancement on top of that.
+typedef enum {
+	WEBM_DECODE_NORMAL = 0,
+	WEBM_DECODE_FAST,
+	WEBM_DECODE_POSTPROC,
+	WEBM_DECODE_MFQE
+} WebM_Decode_Mode;
+
+
+class WebM_Clip
+{
+  public:
+	// id is whatever the host calls this clip, for sharing out the decoder threads
+	WebM_Clip(int id);
+	~WebM_Clip();
+	
+	// We take the reader and delete it when we're done.
+	// path is only for the index cache, the proxy and smart rendering.
+	WebM_Result Open(WebM_Reader *reader, const WebM_PathChar *path);
+	void Close();
+	
+	// The host closed the file handle, but it'll be back
+	void Quiet();
+	
+	// The reader has a handle again.  If the file is the same as before,
+	// everything we parsed still holds.  Returns false if it isn't,
+	// and then you'll want to Close() and Open() again.
+	bool Reopen(const WebM_PathChar *path);
+	
+	// For a file that's still being captured, pick up whatever has been
+	// appended since we last looked.  Pass reopened=true when the reader
+	// just got a new handle, because it already has the new length.
+	// Once the writer has finished the file, it stops being a growing one.
+	void Update(bool reopened = false);
+	
+	bool IsOpen() const { return (_segment != NULL); }
+	
+	WebM_Reader * Reader() const { return _reader; }
+	mkvparser::Segment * Segment() const { return _segment; }
+	const WebM_Index & Index() const { return *_index; }
+	
+	bool HasVideo() const { return (_video_track >= 0); }
+	WebM_Clip_Codec Codec() const { return _codec; }
+	int Width() const { return _width; }
+	int Height() const { return _height; }
+	unsigned int FpsNum() const { return _fps_num; }
+	unsigned int FpsDen() const { return _fps_den; }
+	bool HasAlpha() const { return _has_alpha; }
+	
+	// The sizes we decode at, biggest first: the movie's own, then the
+	// proxy's if there is one.  False when index is past the last one.
+	bool FrameSize(int index, int &width, int &height) const;
+	
+	bool HasAudio() const { return (_audio_track >= 0); }
+	int AudioChannels() const;
+	int AudioSampleRate() const;	// Opus always comes out at 48k
+	int AudioBitDepth() const;		// 0 when there isn't one
+	
+	long long Duration() const { return (_index != NULL ? _index->duration : 0); }
+	
+	WebM_ProxyFile * Proxy() const { return _proxy; }
+	
+	// Our id with the exporter, registering first if it's smart rendering.
+	// -1 if it isn't, or the file is still being written.
+	int PassthroughSource();
+	
+	WebM_ReadAhead * ReadAhead() const { return _read_ahead; }
+	
+	int Id() const { return _id; }
+	
+	// float samples by channel, starting at position, like Premiere wants 'em
+	WebM_Result ReadAudio(long long position, int samples, float **buffers);
+	
+  private:
+	const mkvparser::AudioTrack * GetAudioTrack() const;
+	
+	// what the exporter has to be making to copy our frames
+	WebM_PassthroughFormat PassthroughFormat() const;
+	
+	void ExtendIndex();
+	void Finished();
+	
+	const int _id;
+	
+	WebM_Reader *_reader;
+	mkvparser::Segment *_segment;
+	WebM_Index *_index;
+	WebM_IndexResume *_index_resume; // only for a growing file
+	
+	int _video_track;
+	WebM_Clip_Codec _codec;
+	int _width;
+	int _height;
+	unsigned int _fps_num;
+	unsigned int _fps_den;
+	bool _has_alpha;
+	
+	int _audio_track;
+	
+	int _passthrough_source;
+	WebM_ProxyFile *_proxy;
+	WebM_ReadAhead *_read_ahead;
+	
+	WebM_FileIdentity _identity;
+	bool _have_identity;
+	
+	double _finished_checked; // WebM_Seconds(), 0 when the file just grew
+	
+	UTF16String _path;
+};
+
+
+// What the host wants decoded
+typedef struct {
+	long				frame;			// in the clip's frame rate
+	int					width;			// might be smaller than the clip
+	int					height;
+	bool				alpha;			// the host is taking BGRA, so decode the alpha too
+	bool				keyframes_only;	// nearest keyframe is close enough (scrubbing)
+	bool				high_quality;	// no shortcuts, even in WEBM_DECODE_FAST
+	WebM_Decode_Mode	mode;
+	int					num_cpus;
+} WebM_DecodeRequest;
+
+
+// Where the decoded frames go
+class WebM_FrameSink
+{
+  public:
+	virtual ~WebM_FrameSink() {}
+	
+	// Does the host already have this frame (decoded at full quality)?
+	virtual bool InCache(long frame) = 0;
+	
+	// A decoded frame at the requested size.  alpha is NULL unless the request
+	// asked for it and the clip has it.  wanted means it's the one the host
+	// asked for, which may have a lower number if the exporter skipped repeats.
+	// cache says whether to keep it for later, fast says it was decoded
+	// without the loop filter and shouldn't be mixed up with the real thing.
+	virtual WebM_Result Frame(long frame, const vpx_image_t *img, const vpx_image_t *alpha,
+								bool wanted, bool cache, bool fast) = 0;
+};
+
+
+// Finds the frame, backs up to the keyframe and decodes forward, maybe
+// going a bit past the one we want if the read-ahead policy says so.
+// Returns WEBM_OK without calling the sink if a keyframes-only request
+// found its keyframe already in the cache.
+WebM_Result WebM_DecodeFrame(WebM_Clip &clip, const WebM_DecodeRequest &request, WebM_FrameSink &sink);
+
+
+// One sample for the host's data rate graph.  Invisible frames get folded
+// into the next visible one.
+typedef struct {
+	unsigned int	duration;	// in 1/fps_num seconds, so usually fps_den
+	unsigned int	size;
+	bool			keyframe;
+} WebM_DataSample;
+
+bool WebM_DataRate(const WebM_Index &index, unsigned int fps_num, unsigned int fps_den,
+					std::vector<WebM_DataSample> &samples);
+
+
+#endif // WEBM_IMPORT_H
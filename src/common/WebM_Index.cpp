@@ -0,0 +1,789 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_Index.h"
+
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+#include <algorithm>
+
+
+static int PrivateDataCount(const unsigned char *private_data, size_t private_size)
+{
+	// the first byte
+	unsigned char *p = (unsigned char *)private_data;
+	
+	return *p + 1;
+}
+
+static unsigned long long
+xiph_lace_value(const unsigned char ** np)
+{
+	unsigned long long lace;
+	unsigned long long value;
+	const unsigned char *p = *np;
+
+	lace = *p++;
+	value = lace;
+	while (lace == 255) {
+		lace = *p++;
+		value += lace;
+	}
+
+	*np = p;
+
+	return value;
+}
+
+static const unsigned char *GetPrivateDataPart(const unsigned char *private_data,
+												size_t private_size, int part,
+												size_t *part_size)
+{
+	const unsigned char *result = NULL;
+	size_t result_size = 0;
+	
+	const unsigned char *p = private_data;
+	
+	int count = *p++ + 1;
+	assert(count == 3);
+	
+	
+	if(*p >= part)
+	{
+		unsigned long long sizes[3];
+		unsigned long long total = 0;
+		int i = 0;
+		
+		while(--count)
+		{
+			sizes[i] = xiph_lace_value(&p);
+			total += sizes[i];
+			i++;
+		}
+		sizes[i] = private_size - total - (p - private_data);
+		
+		for(i=0; i < part; ++i)
+			p += sizes[i];
+		
+		result = p;
+		result_size = sizes[part];
+	}
+	
+	*part_size = result_size;
+	
+	return result;
+}
+												
+static void
+webm_match_framerate(double fps, unsigned int *fps_num, unsigned int *fps_den)
+{
+	// known frame rates
+	static const int frameRateNumDens[15][2] = {{5, 1}, {10, 1}, {12, 1}, {15, 1},
+												{24000, 1001}, {24, 1}, {25, 1},
+												{30000, 1001}, {30, 1}, {48, 1},
+												{50, 1}, {60000, 1001}, {60, 1},
+												{100, 1}, {120, 1}};
+
+	int match_index = -1;
+	double match_episilon = 999;
+
+	for(int i=0; i < 15; i++)
+	{
+		double rate = (double)frameRateNumDens[i][0] / (double)frameRateNumDens[i][1];
+		double episilon = fabs(fps - rate);
+
+		if(episilon < match_episilon)
+		{
+			match_index = i;
+			match_episilon = episilon;
+		}
+	}
+
+	if(match_index >=0 && match_episilon < 0.01)
+	{
+		*fps_num = frameRateNumDens[match_index][0];
+		*fps_den = frameRateNumDens[match_index][1];
+	}
+	else
+	{
+		*fps_num = (fps * 1000.0) + 0.5;
+		*fps_den = 1000;
+	}
+}
+
+
+static void
+webm_guess_framerate(const mkvparser::VideoTrack *pVideoTrack,
+						const WebM_Index	&index,
+						unsigned int		*fps_den,
+						unsigned int		*fps_num)
+{
+	// Quite a way to deduce the framerate.  Of course *we* are flagging
+	// our WebM files with the appropriate frame rate, but many files
+	// do not have it.  They just play sound and then pop frames on screen
+	// at the right timestamp.  What a life.
+	
+	// Best case, the track tells us.  DefaultDuration is nanoseconds per frame.
+	const unsigned long long default_duration = pVideoTrack->GetDefaultDuration();
+	
+	if(default_duration > 0)
+	{
+		webm_match_framerate(1000000000.0 / (double)default_duration, fps_num, fps_den);
+		return;
+	}
+	
+	const double embedded_rate = pVideoTrack->GetFrameRate();
+	
+	if(embedded_rate > 0)
+	{
+		webm_match_framerate(embedded_rate, fps_num, fps_den);
+		return;
+	}
+	
+	
+	// But some of us have to work for a living, so we watch the
+	// timestamps go by and make a judgement to tell our host.
+	// The index already has them, so this doesn't touch the file.
+	// The median spacing over the first couple hundred frames tells us
+	// roughly what the rate is, without a dropped or doubled frame in a
+	// variable rate file throwing us off.  But timestamps are usually in
+	// milliseconds, so 29.97 goes 33, 34, 33, 33, 34... and the median
+	// alone would say 30.3.  Averaging the spacings that are close to the
+	// median gets the fraction back.
+	// Invisible frames (VP8 alt-refs, VP9 superframe parts) don't get their own
+	// slot on the timeline, so they don't count.
+	std::vector<long long> deltas;
+	
+	long long last_tstamp = -1;
+	
+	for(size_t i=0; i < index.video.size() && deltas.size() < 200; i++)
+	{
+		const WebM_IndexVideoFrame &frame = index.video[i];
+		
+		if( !(frame.flags & WEBM_INDEX_INVISIBLE) )
+		{
+			if(last_tstamp >= 0 && frame.tstamp > last_tstamp)
+				deltas.push_back(frame.tstamp - last_tstamp);
+			
+			last_tstamp = frame.tstamp;
+		}
+	}
+	
+	if(deltas.size() > 0)
+	{
+		std::nth_element(deltas.begin(), deltas.begin() + (deltas.size() / 2), deltas.end());
+		
+		const long long median_delta = deltas[deltas.size() / 2];
+		
+		// within a tenth, plus a millisecond for the rounding
+		const long long slop = (median_delta / 10) + 1000000LL;
+		
+		long long total = 0;
+		int count = 0;
+		
+		for(size_t i=0; i < deltas.size(); i++)
+		{
+			if(deltas[i] > median_delta - slop && deltas[i] < median_delta + slop)
+			{
+				total += deltas[i];
+				count++;
+			}
+		}
+		
+		const double average_delta = (count > 0 ? (double)total / (double)count : (double)median_delta);
+		
+		webm_match_framerate(1000000000.0 / average_delta, fps_num, fps_den);
+	}
+	else
+	{
+		// a single frame, so any rate will do
+		*fps_num = 24;
+		*fps_den = 1;
+	}
+}
+
+
+bool
+WebM_VorbisHeadersIn(const mkvparser::AudioTrack *pAudioTrack, vorbis_info &vi, vorbis_comment &vc)
+{
+	// The three Vorbis header packets are laced together in CodecPrivate
+	size_t private_size = 0;
+	const unsigned char *private_data = pAudioTrack->GetCodecPrivate(private_size);
+	
+	if(private_data && private_size && PrivateDataCount(private_data, private_size) == 3)
+	{
+		vorbis_info_init(&vi);
+		vorbis_comment_init(&vc);
+		
+		int v_err = OV_OK;
+		
+		for(int h=0; h < 3 && v_err == OV_OK; h++)
+		{
+			size_t length = 0;
+			const unsigned char *data = GetPrivateDataPart(private_data, private_size,
+															h, &length);
+			
+			if(data != NULL)
+			{
+				ogg_packet packet;
+				
+				packet.packet = (unsigned char *)data;
+				packet.bytes = length;
+				packet.b_o_s = (h == 0);
+				packet.e_o_s = false;
+				packet.granulepos = 0;
+				packet.packetno = h;
+				
+				v_err = vorbis_synthesis_headerin(&vi, &vc, &packet);
+			}
+		}
+		
+		if(v_err == OV_OK)
+			return true;
+		
+		vorbis_comment_clear(&vc);
+		vorbis_info_clear(&vi);
+	}
+	
+	return false;
+}
+
+
+bool
+WebM_OpusHeaderIn(const mkvparser::AudioTrack *pAudioTrack, WebM_OpusHeader &header)
+{
+	// CodecPrivate is the OpusHead packet, just as it would be in Ogg.
+	// Everything is little-endian.
+	size_t private_size = 0;
+	const unsigned char *p = pAudioTrack->GetCodecPrivate(private_size);
+	
+	if(p == NULL || private_size < 19 || memcmp(p, "OpusHead", 8) != 0)
+		return false;
+	
+	const int version = p[8];
+	
+	if((version & 0xf0) != 0) // major version we don't know
+		return false;
+	
+	header.channels = p[9];
+	header.pre_skip = p[10] | (p[11] << 8);
+	header.mapping_family = p[18];
+	
+	if(header.channels < 1)
+		return false;
+	
+	if(header.mapping_family == 0)
+	{
+		// mono or stereo in a single stream
+		if(header.channels > 2)
+			return false;
+		
+		header.stream_count = 1;
+		header.coupled_count = header.channels - 1;
+		header.mapping[0] = 0;
+		header.mapping[1] = 1;
+	}
+	else
+	{
+		if(private_size < (size_t)(21 + header.channels))
+			return false;
+		
+		header.stream_count = p[19];
+		header.coupled_count = p[20];
+		
+		memcpy(header.mapping, &p[21], header.channels);
+	}
+	
+	return true;
+}
+
+
+// mkvparser doesn't tell us about BlockAdditions, so we read them ourselves.
+// These are just enough EBML to do it: an ID (marker bits and all, the way
+// the spec writes them) and a size.  Returns false on anything we don't like.
+static bool
+ReadEBMLNumber(mkvparser::IMkvReader *reader, long long &pos, bool keep_marker, unsigned long long &value)
+{
+	unsigned char first = 0;
+	
+	if(reader->Read(pos, 1, &first) != 0 || first == 0)
+		return false;
+	
+	int len = 1;
+	
+	while(!(first & (0x80 >> (len - 1))))
+		len++;
+	
+	value = (keep_marker ? first : (first & (0xff >> len)));
+	
+	for(int i=1; i < len; i++)
+	{
+		unsigned char next = 0;
+		
+		if(reader->Read(pos + i, 1, &next) != 0)
+			return false;
+		
+		value = (value << 8) | next;
+	}
+	
+	// all ones means unknown size, which we can't skip
+	if(!keep_marker && value == ((1ULL << (7 * len)) - 1))
+		return false;
+	
+	pos += len;
+	
+	return true;
+}
+
+
+enum {
+	kEBMLBlockAdditions		= 0x75A1,
+	kEBMLBlockMore			= 0xA6,
+	kEBMLBlockAddID			= 0xEE,
+	kEBMLBlockAdditional	= 0xA5,
+	
+	// other things that can be next to a Block in a BlockGroup
+	kEBMLBlockDuration		= 0x9B,
+	kEBMLReferencePriority	= 0xFA,
+	kEBMLReferenceBlock		= 0xFB,
+	kEBMLCodecState			= 0xA4,
+	kEBMLDiscardPadding		= 0x75A2,
+	kEBMLVoid				= 0xEC
+};
+
+
+// An alpha frame is BlockAdditional with BlockAddID 1 (or no ID, 1 is the default).
+// Muxers put BlockAdditions after the Block, so we look at what comes after it
+// in the BlockGroup, until we find them or get to something that's not in a group.
+static bool
+FindBlockAlpha(mkvparser::IMkvReader *reader, const mkvparser::Block *pBlock,
+				long long &alpha_pos, long long &alpha_size)
+{
+	long long pos = pBlock->m_start + pBlock->m_size;
+	
+	for(int e=0; e < 8; e++)
+	{
+		unsigned long long id = 0, size = 0;
+		
+		if( !ReadEBMLNumber(reader, pos, true, id) || !ReadEBMLNumber(reader, pos, false, size) )
+			return false;
+		
+		if(id == kEBMLBlockAdditions)
+		{
+			const long long additions_end = pos + size;
+			
+			while(pos < additions_end)
+			{
+				if( !ReadEBMLNumber(reader, pos, true, id) || !ReadEBMLNumber(reader, pos, false, size) )
+					return false;
+				
+				const long long more_end = pos + size;
+				
+				if(id == kEBMLBlockMore)
+				{
+					unsigned long long add_id = 1;
+					long long data_pos = -1, data_size = 0;
+					
+					while(pos < more_end)
+					{
+						if( !ReadEBMLNumber(reader, pos, true, id) || !ReadEBMLNumber(reader, pos, false, size) )
+							return false;
+						
+						if(id == kEBMLBlockAddID && size > 0 && size <= 8)
+						{
+							unsigned char buf[8];
+							
+							if(reader->Read(pos, size, buf) != 0)
+								return false;
+							
+							add_id = 0;
+							
+							for(int i=0; i < size; i++)
+								add_id = (add_id << 8) | buf[i];
+						}
+						else if(id == kEBMLBlockAdditional)
+						{
+							data_pos = pos;
+							data_size = size;
+						}
+						
+						pos += size;
+					}
+					
+					if(add_id == 1 && data_pos >= 0 && data_size > 0)
+					{
+						alpha_pos = data_pos;
+						alpha_size = data_size;
+						
+						return true;
+					}
+				}
+				
+				pos = more_end;
+			}
+			
+			return false;
+		}
+		else if(id == kEBMLBlockDuration || id == kEBMLReferencePriority || id == kEBMLReferenceBlock ||
+				id == kEBMLCodecState || id == kEBMLDiscardPadding || id == kEBMLVoid)
+		{
+			pos += size;
+		}
+		else
+			return false;
+	}
+	
+	return false;
+}
+
+
+// One trip through the clusters we haven't seen yet, noting where every frame
+// and audio packet lives.  For a finished file that's all of them, in one go.
+static void
+WalkClusters(mkvparser::Segment *segment, mkvparser::IMkvReader *reader,
+				long video_track, long audio_track, WebM_Index &index, WebM_IndexResume &resume)
+{
+	const mkvparser::Tracks* pTracks = segment->GetTracks();
+	
+	
+	// Vorbis packets don't say how many samples they hold, but the blocksize
+	// is in the first byte of each one.  Two neighboring blocks overlap by half,
+	// so each packet produces (previous blocksize + this blocksize) / 4 samples.
+	// Opus is easier, the TOC byte(s) at the front tell us directly.
+	vorbis_info vi;
+	vorbis_comment vc;
+	
+	bool have_vorbis = false;
+	bool have_opus = false;
+	
+	if(audio_track >= 0)
+	{
+		const mkvparser::Track* const pTrack = pTracks->GetTrackByNumber(audio_track);
+		
+		if(pTrack != NULL && pTrack->GetType() == mkvparser::Track::kAudio)
+		{
+			if(pTrack->GetCodecId() == std::string("A_VORBIS"))
+			{
+				have_vorbis = WebM_VorbisHeadersIn(static_cast<const mkvparser::AudioTrack*>(pTrack), vi, vc);
+			}
+			else if(pTrack->GetCodecId() == std::string("A_OPUS"))
+			{
+				have_opus = true;
+			}
+		}
+	}
+	
+	
+	const mkvparser::Cluster* pCluster = (resume.cluster != NULL ? resume.cluster : segment->GetFirst());
+	
+	while((pCluster != NULL) && !pCluster->EOS())
+	{
+		bool cluster_start = true;
+		
+		const mkvparser::BlockEntry* pBlockEntry = NULL;
+		
+		long status = 0;
+		
+		// pick up after the last block we got to
+		if(pCluster == resume.cluster && resume.entry != NULL)
+		{
+			status = pCluster->GetNext(resume.entry, pBlockEntry);
+			
+			cluster_start = false;
+		}
+		else
+			status = pCluster->GetFirst(pBlockEntry);
+		
+		resume.cluster = pCluster;
+		
+		while((pBlockEntry != NULL) && !pBlockEntry->EOS() && status >= 0)
+		{
+			const mkvparser::Block* const pBlock = pBlockEntry->GetBlock();
+			const long long trackNum = pBlock->GetTrackNumber();
+			const long long tstamp = pBlock->GetTime(pCluster);
+			
+			if(trackNum == video_track)
+			{
+				assert(pBlock->GetFrameCount() == 1);
+				
+				for(int f=0; f < pBlock->GetFrameCount(); f++)
+				{
+					const mkvparser::Block::Frame& blockFrame = pBlock->GetFrame(f);
+					
+					WebM_IndexVideoFrame frame;
+					
+					frame.pos = blockFrame.pos;
+					frame.size = blockFrame.len;
+					frame.tstamp = tstamp;
+					frame.flags = (pBlock->IsKey() ? WEBM_INDEX_KEYFRAME : 0) |
+									(pBlock->IsInvisible() ? WEBM_INDEX_INVISIBLE : 0) |
+									(cluster_start ? WEBM_INDEX_CLUSTER_START : 0);
+					frame.alpha_offset = 0;
+					frame.alpha_size = 0;
+					
+					// only a BlockGroup can have BlockAdditions
+					long long alpha_pos = 0, alpha_size = 0;
+					
+					if(pBlockEntry->GetKind() == mkvparser::BlockEntry::kBlockGroup &&
+						FindBlockAlpha(reader, pBlock, alpha_pos, alpha_size) && alpha_pos > frame.pos)
+					{
+						frame.alpha_offset = alpha_pos - frame.pos;
+						frame.alpha_size = alpha_size;
+					}
+					
+					index.video.push_back(frame);
+					
+					cluster_start = false;
+				}
+			}
+			else if(trackNum == audio_track)
+			{
+				for(int f=0; f < pBlock->GetFrameCount(); f++)
+				{
+					const mkvparser::Block::Frame& blockFrame = pBlock->GetFrame(f);
+					
+					WebM_IndexAudioPacket packet;
+					
+					packet.pos = blockFrame.pos;
+					packet.size = blockFrame.len;
+					packet.sample = resume.audio_sample;
+					packet.samples = 0;
+					
+					unsigned char first_byte = 0;
+					
+					if(have_opus && blockFrame.len > 0)
+					{
+						// code 3 packets keep their frame count in the second byte
+						unsigned char toc[2];
+						
+						const long toc_len = (blockFrame.len > 1 ? 2 : 1);
+						
+						if(reader->Read(blockFrame.pos, toc_len, toc) == 0)
+						{
+							const int samples = opus_packet_get_nb_samples(toc, toc_len, WEBM_OPUS_SAMPLE_RATE);
+							
+							if(samples > 0)
+								packet.samples = samples;
+						}
+					}
+					else if(have_vorbis && blockFrame.len > 0 &&
+						reader->Read(blockFrame.pos, 1, &first_byte) == 0)
+					{
+						ogg_packet op;
+						
+						op.packet = &first_byte;
+						op.bytes = 1;
+						op.b_o_s = false;
+						op.e_o_s = false;
+						op.granulepos = -1;
+						op.packetno = index.audio.size() + 3;
+						
+						const long blocksize = vorbis_packet_blocksize(&vi, &op);
+						
+						if(blocksize > 0)
+						{
+							if(resume.prev_blocksize > 0)
+								packet.samples = (resume.prev_blocksize + blocksize) / 4;
+							
+							resume.prev_blocksize = blocksize;
+						}
+					}
+					
+					resume.audio_sample += packet.samples;
+					
+					index.audio.push_back(packet);
+				}
+			}
+			
+			if(tstamp > resume.last_tstamp)
+				resume.last_tstamp = tstamp;
+			
+			resume.entry = pBlockEntry;
+			
+			status = pCluster->GetNext(pBlockEntry, pBlockEntry);
+		}
+		
+		// the rest of this cluster hasn't been written yet
+		if(status == mkvparser::E_BUFFER_NOT_FULL)
+			break;
+		
+		const mkvparser::Cluster* pNext = segment->GetNext(pCluster);
+		
+		if(pNext != NULL && !pNext->EOS())
+		{
+			resume.cluster = pNext;
+			resume.entry = NULL;
+		}
+		
+		pCluster = pNext;
+	}
+	
+	if(have_vorbis)
+	{
+		vorbis_comment_clear(&vc);
+		vorbis_info_clear(&vi);
+	}
+}
+
+
+static void
+FinishIndex(mkvparser::Segment *segment, long video_track, const WebM_IndexResume &resume, WebM_Index &index)
+{
+	const long long segment_duration = segment->GetInfo()->GetDuration();
+	
+	index.duration = (segment_duration > 0 ? segment_duration : resume.last_tstamp);
+	
+	if(video_track >= 0)
+	{
+		const mkvparser::Track* const pTrack = segment->GetTracks()->GetTrackByNumber(video_track);
+		
+		if(pTrack != NULL && pTrack->GetType() == mkvparser::Track::kVideo)
+		{
+			webm_guess_framerate(static_cast<const mkvparser::VideoTrack*>(pTrack), index, &index.fps_den, &index.fps_num);
+		}
+	}
+}
+
+
+void
+WebM_BuildIndex(mkvparser::Segment *segment, mkvparser::IMkvReader *reader,
+				long video_track, long audio_track, WebM_Index &index)
+{
+	// This is what the index cache saves us from next time.
+	WebM_IndexResume resume;
+	
+	WalkClusters(segment, reader, video_track, audio_track, index, resume);
+	
+	FinishIndex(segment, video_track, resume, index);
+}
+
+
+bool
+WebM_ExtendIndex(mkvparser::Segment *segment, mkvparser::IMkvReader *reader,
+					long video_track, long audio_track, WebM_Index &index, WebM_IndexResume &resume)
+{
+	const size_t video_count = index.video.size();
+	const size_t audio_count = index.audio.size();
+	
+	// load whatever clusters have shown up since last time
+	long status = 0;
+	
+	do{
+		long long pos = 0;
+		long len = 0;
+		
+		status = segment->LoadCluster(pos, len);
+		
+	}while(status == 0);
+	
+	WalkClusters(segment, reader, video_track, audio_track, index, resume);
+	
+	const bool grew = (index.video.size() > video_count || index.audio.size() > audio_count);
+	
+	if(grew)
+		FinishIndex(segment, video_track, resume, index);
+	
+	return grew;
+}
+
+
+int
+WebM_FindFrame(const WebM_Index &index, long frame_num, unsigned long long fps_num, unsigned long long fps_den)
+{
+	// binary search for the last frame at or before the requested one,
+	// which is the one on screen if the file skipped some repeated frames
+	const int frame_count = index.video.size();
+	
+	if(frame_count == 0)
+		return -1;
+	
+	int low = 0;
+	int high = frame_count;
+	
+	while(low < high)
+	{
+		const int mid = (low + high) / 2;
+		
+		if(WebM_FrameNumber(index.video[mid].tstamp, fps_num, fps_den) <= frame_num)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	
+	int found = (low > 0 ? low - 1 : 0);
+	
+	// Invisible frames (alt-refs) never make a picture, so they can't be
+	// the one on screen.  Back up to the last visible one, or forward to
+	// the first if there's nothing before.
+	while(found > 0 && (index.video[found].flags & WEBM_INDEX_INVISIBLE))
+		found--;
+	
+	while(found < frame_count - 1 && (index.video[found].flags & WEBM_INDEX_INVISIBLE))
+		found++;
+	
+	return found;
+}
+
+
+int
+WebM_FindAudioPacket(const WebM_Index &index, long long position)
+{
+	// binary search for the packet whose samples include position
+	const int packet_count = index.audio.size();
+	
+	int low = 0;
+	int high = packet_count;
+	
+	while(low < high)
+	{
+		const int mid = (low + high) / 2;
+		
+		const WebM_IndexAudioPacket &packet = index.audio[mid];
+		
+		if(packet.sample + packet.samples <= position)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	
+	return low;
+}
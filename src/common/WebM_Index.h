@@ -0,0 +1,161 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_INDEX_H
+#define WEBM_INDEX_H
+
+// Nothing in here knows about Premiere, so it can be built and
+// exercised on its own, with nothing but libwebm, libvorbis and libopus.
+
+#include "mkvparser.hpp"
+
+extern "C" {
+#include <vorbis/codec.h>
+#include <opus_multistream.h>
+}
+
+#include <vector>
+
+#ifndef OV_OK
+#define OV_OK 0
+#endif
+
+
+// The index is everything we learn by walking the clusters of a file.
+// Once we have it, we can find and read any frame or audio packet without
+// asking mkvparser to load the whole segment.
+
+enum {
+	WEBM_INDEX_KEYFRAME			= (1L << 0),
+	WEBM_INDEX_INVISIBLE		= (1L << 1),
+	WEBM_INDEX_CLUSTER_START	= (1L << 2)
+};
+
+typedef struct {
+	long long		pos;		// absolute file position of the frame data
+	long long		tstamp;		// in nanoseconds
+	unsigned int	size;
+	unsigned int	flags;
+	unsigned int	alpha_offset;	// alpha frame (BlockAdditional 1) is at pos + alpha_offset
+	unsigned int	alpha_size;		// 0 if there's no alpha
+} WebM_IndexVideoFrame;
+
+typedef struct {
+	long long		pos;		// absolute file position of the packet data
+	long long		sample;		// first PCM sample the packet produces (the granule map)
+	unsigned int	size;
+	unsigned int	samples;	// number of PCM samples the packet produces
+} WebM_IndexAudioPacket;
+
+typedef struct WebM_Index
+{
+	unsigned int						fps_num;
+	unsigned int						fps_den;
+	long long							duration; // in nanoseconds
+	
+	std::vector<WebM_IndexVideoFrame>	video;
+	std::vector<WebM_IndexAudioPacket>	audio;
+	
+	WebM_Index() : fps_num(0), fps_den(0), duration(0) {}
+} WebM_Index;
+
+
+// Walk every cluster in a segment that has been Load()ed and fill in the index
+void WebM_BuildIndex(mkvparser::Segment *segment, mkvparser::IMkvReader *reader,
+						long video_track, long audio_track, WebM_Index &index);
+
+// Where the index left off in a file that's still being written (edit while
+// capture).  The segment has to stay around, these point into it.
+typedef struct WebM_IndexResume
+{
+	const mkvparser::Cluster		*cluster;	// last cluster we got into
+	const mkvparser::BlockEntry		*entry;		// last block we indexed in it
+	long							prev_blocksize;
+	long long						audio_sample;
+	long long						last_tstamp;
+	
+	WebM_IndexResume() : cluster(NULL), entry(NULL), prev_blocksize(0), audio_sample(0), last_tstamp(0) {}
+} WebM_IndexResume;
+
+// For a growing file: load the clusters that have been appended since last
+// time and add their frames and packets to the index, without going back over
+// what's already there.  Start with an empty index and a fresh resume, after
+// Segment::ParseHeaders().  Returns true if the index got longer.
+bool WebM_ExtendIndex(mkvparser::Segment *segment, mkvparser::IMkvReader *reader,
+						long video_track, long audio_track, WebM_Index &index, WebM_IndexResume &resume);
+
+// Read the three Vorbis headers out of the track's CodecPrivate.
+// On success, the caller must clear vi and vc.
+bool WebM_VorbisHeadersIn(const mkvparser::AudioTrack *pAudioTrack, vorbis_info &vi, vorbis_comment &vc);
+
+
+// What an Opus decoder needs to know, from the OpusHead in CodecPrivate
+typedef struct {
+	int				channels;
+	int				pre_skip;		// samples at the start that are just encoder delay
+	int				mapping_family;
+	int				stream_count;
+	int				coupled_count;
+	unsigned char	mapping[255];
+} WebM_OpusHeader;
+
+// Opus always decodes at 48k, whatever the track says
+#define WEBM_OPUS_SAMPLE_RATE	48000
+
+// Decoding has to start this far (80 ms) ahead of a seek for the output to settle
+#define WEBM_OPUS_PREROLL		3840
+
+bool WebM_OpusHeaderIn(const mkvparser::AudioTrack *pAudioTrack, WebM_OpusHeader &header);
+
+
+// nanosecond timestamp to frame number
+static inline long
+WebM_FrameNumber(long long tstamp, unsigned long long fps_num, unsigned long long fps_den)
+{
+	return ((tstamp * fps_num / fps_den) + 500000000UL) / 1000000000UL;
+}
+
+// index of the frame showing at frame_num (the last one at or before it), -1 if there's no video
+int WebM_FindFrame(const WebM_Index &index, long frame_num, unsigned long long fps_num, unsigned long long fps_den);
+
+// index of the audio packet that produces the sample at position
+int WebM_FindAudioPacket(const WebM_Index &index, long long position);
+
+
+#endif // WEBM_INDEX_H
@@ -0,0 +1,525 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_IndexCache.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include <string>
+
+#ifdef PRWIN_ENV
+	#include <shlobj.h>
+	#include <stdio.h>
+#else
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <stdio.h>
+	#include <stdlib.h>
+	#include <errno.h>
+#endif
+
+#ifdef __APPLE__
+	#include <CoreServices/CoreServices.h>
+	#include <sys/syslimits.h>
+#endif
+
+
+// The index cache is a header followed by the video frame array and then
+// the audio packet array, written straight out of memory.  It's only ever read
+// back by the same plug-in on the same machine, so we don't worry about endianness,
+// but header_size will catch a build with different struct packing.
+
+static const char			kIndexCacheMagic[4]		= { 'W', 'M', 'I', 'X' };
+static const unsigned int	kIndexCacheVersion		= 4;
+static const long			kHeaderHashBytes		= 64 * 1024;
+
+typedef struct {
+	char				magic[4];
+	unsigned int		version;
+	unsigned int		header_size;
+	unsigned int		reserved;
+	WebM_FileIdentity	identity;
+	unsigned int		fps_num;
+	unsigned int		fps_den;
+	long long			duration;
+	unsigned long long	video_count;
+	unsigned long long	audio_count;
+	unsigned long long	checksum; // of everything after the header
+} WebM_IndexCacheHeader;
+
+
+#ifdef PRWIN_ENV
+typedef std::wstring PathString;
+#else
+typedef std::string PathString;
+#endif
+
+
+static const unsigned long long kFNVOffset = 14695981039346656037ULL;
+
+static unsigned long long
+fnv_hash(const void *data, size_t len, unsigned long long hash = kFNVOffset)
+{
+	// 64-bit FNV-1a
+	const unsigned char *p = (const unsigned char *)data;
+	
+	while(len--)
+	{
+		hash ^= *p++;
+		hash *= 1099511628211ULL;
+	}
+	
+	return hash;
+}
+
+
+bool
+WebM_GetFileIdentity(mkvparser::IMkvReader *reader, const WebM_PathChar *path, WebM_FileIdentity &identity)
+{
+	memset(&identity, 0, sizeof(identity));
+	
+	long long total = 0, available = 0;
+	
+	if(reader->Length(&total, &available) < 0)
+		return false;
+	
+	identity.file_size = total;
+	identity.path_hash = fnv_hash(path, WebM_PathLength(path) * sizeof(WebM_PathChar));
+	
+#ifdef PRWIN_ENV
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	
+	if( GetFileAttributesExW(path, GetFileExInfoStandard, &attributes) )
+	{
+		identity.mod_time = ((long long)attributes.ftLastWriteTime.dwHighDateTime << 32) |
+								(long long)attributes.ftLastWriteTime.dwLowDateTime;
+	}
+	else
+		return false;
+#elif defined(__APPLE__)
+	CFStringRef filePathCFSR = CFStringCreateWithCharacters(NULL, path, WebM_PathLength(path));
+	
+	char posix_path[PATH_MAX];
+	
+	Boolean got_path = CFStringGetFileSystemRepresentation(filePathCFSR, posix_path, PATH_MAX);
+	
+	CFRelease(filePathCFSR);
+	
+	struct stat file_stat;
+	
+	if(got_path && stat(posix_path, &file_stat) == 0)
+	{
+		identity.mod_time = file_stat.st_mtime;
+	}
+	else
+		return false;
+#else
+	struct stat file_stat;
+	
+	if(stat(WebM_PathToUTF8(path).c_str(), &file_stat) == 0)
+	{
+		identity.mod_time = file_stat.st_mtime;
+	}
+	else
+		return false;
+#endif
+
+	// Size and date can lie (copied files, coarse timestamps), so we also
+	// hash the beginning of the file, where the EBML header and track info live.
+	const long header_len = (total < kHeaderHashBytes ? total : kHeaderHashBytes);
+	
+	if(header_len > 0)
+	{
+		std::vector<unsigned char> header_data(header_len);
+		
+		if(reader->Read(0, header_len, &header_data[0]) != 0)
+			return false;
+		
+		identity.header_hash = fnv_hash(&header_data[0], header_len);
+	}
+	
+	return true;
+}
+
+
+bool
+WebM_SameFileIdentity(const WebM_FileIdentity &one, const WebM_FileIdentity &two)
+{
+	return (one.file_size == two.file_size &&
+			one.mod_time == two.mod_time &&
+			one.header_hash == two.header_hash &&
+			one.path_hash == two.path_hash);
+}
+
+
+static bool
+GetCachePath(const WebM_FileIdentity &identity, PathString &cache_path)
+{
+#ifdef PRWIN_ENV
+	wchar_t folder[MAX_PATH];
+	
+	HRESULT hr = SHGetFolderPathW(NULL, CSIDL_LOCAL_APPDATA | CSIDL_FLAG_CREATE, NULL, SHGFP_TYPE_CURRENT, folder);
+	
+	if(hr != S_OK)
+		return false;
+	
+	// CreateDirectory fails if it already exists, which is fine
+	cache_path = folder;
+	cache_path += L"\\fnord";
+	CreateDirectoryW(cache_path.c_str(), NULL);
+	
+	cache_path += L"\\WebM Index Cache";
+	CreateDirectoryW(cache_path.c_str(), NULL);
+	
+	wchar_t file_name[64];
+	swprintf_s(file_name, 64, L"\\%016I64x.webmidx", identity.path_hash);
+	
+	cache_path += file_name;
+#elif defined(__APPLE__)
+	FSRef folderRef;
+	
+	OSErr err = FSFindFolder(kUserDomain, kCachedDataFolderType, kCreateFolder, &folderRef);
+	
+	if(err != noErr)
+		return false;
+	
+	char folder[PATH_MAX];
+	
+	err = FSRefMakePath(&folderRef, (UInt8 *)folder, PATH_MAX);
+	
+	if(err != noErr)
+		return false;
+	
+	// mkdir fails if it already exists, which is fine
+	cache_path = folder;
+	cache_path += "/com.fnordware.WebM";
+	mkdir(cache_path.c_str(), 0755);
+	
+	char file_name[64];
+	snprintf(file_name, 64, "/%016llx.webmidx", identity.path_hash);
+	
+	cache_path += file_name;
+#else
+	// $WEBM_CACHE_DIR if somebody (like the tests) wants it somewhere else,
+	// otherwise the usual XDG spot
+	const char *dir = getenv("WEBM_CACHE_DIR");
+	
+	if(dir != NULL && *dir != '\0')
+	{
+		cache_path = dir;
+	}
+	else
+	{
+		const char *xdg = getenv("XDG_CACHE_HOME");
+		
+		if(xdg != NULL && *xdg != '\0')
+		{
+			cache_path = xdg;
+		}
+		else
+		{
+			const char *home = getenv("HOME");
+			
+			if(home == NULL || *home == '\0')
+				return false;
+			
+			cache_path = home;
+			cache_path += "/.cache";
+			mkdir(cache_path.c_str(), 0755);
+		}
+		
+		cache_path += "/fnord-webm";
+	}
+	
+	if(mkdir(cache_path.c_str(), 0755) != 0 && errno != EEXIST)
+		return false;
+	
+	char file_name[64];
+	snprintf(file_name, 64, "/%016llx.webmidx", identity.path_hash);
+	
+	cache_path += file_name;
+#endif
+
+	return true;
+}
+
+
+static bool
+ReadIndex(const void *buf, long long len, const WebM_FileIdentity &identity, WebM_Index &index)
+{
+	if(len < (long long)sizeof(WebM_IndexCacheHeader))
+		return false;
+	
+	const WebM_IndexCacheHeader *header = (const WebM_IndexCacheHeader *)buf;
+	
+	if(memcmp(header->magic, kIndexCacheMagic, 4) != 0 ||
+		header->version != kIndexCacheVersion ||
+		header->header_size != sizeof(WebM_IndexCacheHeader))
+	{
+		return false;
+	}
+	
+	// the movie was changed since we indexed it
+	if( !WebM_SameFileIdentity(header->identity, identity) )
+		return false;
+	
+	const long long payload_len = len - sizeof(WebM_IndexCacheHeader);
+	
+	if(header->video_count > (unsigned long long)payload_len / sizeof(WebM_IndexVideoFrame) ||
+		header->audio_count > (unsigned long long)payload_len / sizeof(WebM_IndexAudioPacket))
+	{
+		return false;
+	}
+	
+	const long long video_bytes = header->video_count * sizeof(WebM_IndexVideoFrame);
+	const long long audio_bytes = header->audio_count * sizeof(WebM_IndexAudioPacket);
+	
+	// truncated or padded file
+	if(video_bytes + audio_bytes != payload_len)
+		return false;
+	
+	const unsigned char *payload = (const unsigned char *)buf + sizeof(WebM_IndexCacheHeader);
+	
+	// scribbled on
+	if(fnv_hash(payload, payload_len) != header->checksum)
+		return false;
+	
+	
+	index.fps_num = header->fps_num;
+	index.fps_den = header->fps_den;
+	index.duration = header->duration;
+	
+	const WebM_IndexVideoFrame *video = (const WebM_IndexVideoFrame *)payload;
+	const WebM_IndexAudioPacket *audio = (const WebM_IndexAudioPacket *)(payload + video_bytes);
+	
+	index.video.assign(video, video + header->video_count);
+	index.audio.assign(audio, audio + header->audio_count);
+	
+	return true;
+}
+
+
+bool
+WebM_LoadIndexCache(const WebM_FileIdentity &identity, WebM_Index &index)
+{
+	PathString cache_path;
+	
+	if( !GetCachePath(identity, cache_path) )
+		return false;
+	
+	bool loaded = false;
+	
+#ifdef PRWIN_ENV
+	HANDLE fileH = CreateFileW(cache_path.c_str(),
+								GENERIC_READ,
+								FILE_SHARE_READ,
+								NULL,
+								OPEN_EXISTING,
+								FILE_ATTRIBUTE_NORMAL,
+								NULL);
+	
+	if(fileH != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER len;
+		
+		if(GetFileSizeEx(fileH, &len) && len.QuadPart > 0)
+		{
+			HANDLE mapH = CreateFileMappingW(fileH, NULL, PAGE_READONLY, 0, 0, NULL);
+			
+			if(mapH != NULL)
+			{
+				const void *buf = MapViewOfFile(mapH, FILE_MAP_READ, 0, 0, 0);
+				
+				if(buf != NULL)
+				{
+					loaded = ReadIndex(buf, len.QuadPart, identity, index);
+					
+					UnmapViewOfFile(buf);
+				}
+				
+				CloseHandle(mapH);
+			}
+		}
+		
+		CloseHandle(fileH);
+	}
+#else
+	int fd = open(cache_path.c_str(), O_RDONLY);
+	
+	if(fd >= 0)
+	{
+		struct stat file_stat;
+		
+		if(fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+		{
+			void *buf = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			
+			if(buf != MAP_FAILED)
+			{
+				loaded = ReadIndex(buf, file_stat.st_size, identity, index);
+				
+				munmap(buf, file_stat.st_size);
+			}
+		}
+		
+		close(fd);
+	}
+#endif
+
+	if(!loaded)
+	{
+		// don't leave anything half-read behind
+		index.video.clear();
+		index.audio.clear();
+	}
+
+	return loaded;
+}
+
+
+#ifdef PRWIN_ENV
+static bool
+WriteBuffer(HANDLE fileH, const void *buf, size_t len)
+{
+	DWORD written = 0;
+	
+	return (len == 0) || (WriteFile(fileH, buf, (DWORD)len, &written, NULL) && written == len);
+}
+#else
+static bool
+WriteBuffer(FILE *f, const void *buf, size_t len)
+{
+	return (len == 0) || (fwrite(buf, len, 1, f) == 1);
+}
+#endif
+
+
+bool
+WebM_SaveIndexCache(const WebM_FileIdentity &identity, const WebM_Index &index)
+{
+	PathString cache_path;
+	
+	if( !GetCachePath(identity, cache_path) )
+		return false;
+	
+	const size_t video_bytes = index.video.size() * sizeof(WebM_IndexVideoFrame);
+	const size_t audio_bytes = index.audio.size() * sizeof(WebM_IndexAudioPacket);
+	
+	const void *video_buf = (video_bytes > 0 ? (const void *)&index.video[0] : NULL);
+	const void *audio_buf = (audio_bytes > 0 ? (const void *)&index.audio[0] : NULL);
+	
+	WebM_IndexCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	
+	memcpy(header.magic, kIndexCacheMagic, 4);
+	header.version = kIndexCacheVersion;
+	header.header_size = sizeof(WebM_IndexCacheHeader);
+	header.identity = identity;
+	header.fps_num = index.fps_num;
+	header.fps_den = index.fps_den;
+	header.duration = index.duration;
+	header.video_count = index.video.size();
+	header.audio_count = index.audio.size();
+	
+	header.checksum = kFNVOffset;
+	
+	if(video_buf)
+		header.checksum = fnv_hash(video_buf, video_bytes, header.checksum);
+	
+	if(audio_buf)
+		header.checksum = fnv_hash(audio_buf, audio_bytes, header.checksum);
+	
+	
+	// Write to a temp file and then swap it in, so that another
+	// Premiere that's opening the same movie never sees half an index.
+	bool saved = false;
+	
+#ifdef PRWIN_ENV
+	const PathString temp_path = cache_path + L".tmp";
+	
+	HANDLE fileH = CreateFileW(temp_path.c_str(),
+								GENERIC_WRITE,
+								0,
+								NULL,
+								CREATE_ALWAYS,
+								FILE_ATTRIBUTE_NORMAL,
+								NULL);
+	
+	if(fileH != INVALID_HANDLE_VALUE)
+	{
+		saved = WriteBuffer(fileH, &header, sizeof(header)) &&
+				WriteBuffer(fileH, video_buf, video_bytes) &&
+				WriteBuffer(fileH, audio_buf, audio_bytes);
+		
+		CloseHandle(fileH);
+		
+		if(saved)
+			saved = (MoveFileExW(temp_path.c_str(), cache_path.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE);
+		
+		if(!saved)
+			DeleteFileW(temp_path.c_str());
+	}
+#else
+	const PathString temp_path = cache_path + ".tmp";
+	
+	FILE *f = fopen(temp_path.c_str(), "wb");
+	
+	if(f != NULL)
+	{
+		saved = WriteBuffer(f, &header, sizeof(header)) &&
+				WriteBuffer(f, video_buf, video_bytes) &&
+				WriteBuffer(f, audio_buf, audio_bytes);
+		
+		if(fclose(f) != 0)
+			saved = false;
+		
+		if(saved)
+			saved = (rename(temp_path.c_str(), cache_path.c_str()) == 0);
+		
+		if(!saved)
+			unlink(temp_path.c_str());
+	}
+#endif
+
+	return saved;
+}
@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_INDEXCACHE_H
+#define WEBM_INDEXCACHE_H
+
+#include "WebM_File.h"
+
+#include "WebM_Index.h"
+
+
+// Everything that has to match for a cached index to be trusted
+typedef struct {
+	long long			file_size;
+	long long			mod_time;
+	unsigned long long	header_hash;	// hash of the first bytes of the file
+	unsigned long long	path_hash;
+} WebM_FileIdentity;
+
+
+bool WebM_GetFileIdentity(mkvparser::IMkvReader *reader, const WebM_PathChar *path, WebM_FileIdentity &identity);
+
+bool WebM_SameFileIdentity(const WebM_FileIdentity &one, const WebM_FileIdentity &two);
+
+bool WebM_LoadIndexCache(const WebM_FileIdentity &identity, WebM_Index &index);
+
+bool WebM_SaveIndexCache(const WebM_FileIdentity &identity, const WebM_Index &index);
+
+
+#endif // WEBM_INDEXCACHE_H
@@ -0,0 +1,394 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#include "WebM_Passthrough.h"
+
+#include "WebM_Thread.h"
+
+#include <map>
+#include <vector>
+
+#include <assert.h>
+
+using std::string;
+
+
+typedef struct {
+	UTF16String							path;
+	WebM_PassthroughFormat				format;
+	WebM_Index							index;
+	std::vector<unsigned long long>		hashes; // 0 until we've decoded the frame
+} PassthroughSource;
+
+typedef struct {
+	int		source;
+	int		frame;
+} PassthroughKey;
+
+
+static WebM_Mutex gPassthroughMutex;
+
+static std::map<int, PassthroughSource *> gSources;
+
+// just the keyframes, that's where copying has to start
+static std::map<unsigned long long, PassthroughKey> gKeyframes;
+
+static int gNextSource = 0;
+
+// exporters that are smart rendering
+static int gActive = 0;
+
+// Every source has a copy of its index, so don't keep them forever
+static const int kMaxSources = 32;
+
+
+static void
+ForgetSource(int id)
+{
+	std::map<int, PassthroughSource *>::iterator source = gSources.find(id);
+	
+	if(source != gSources.end())
+	{
+		delete source->second;
+		
+		gSources.erase(source);
+	}
+	
+	std::map<unsigned long long, PassthroughKey>::iterator key = gKeyframes.begin();
+	
+	while(key != gKeyframes.end())
+	{
+		if(key->second.source == id)
+			gKeyframes.erase(key++);
+		else
+			++key;
+	}
+}
+
+
+// Reads the bits of a VP9 frame header, most significant first
+class BitReader
+{
+  public:
+	BitReader(const unsigned char *data, size_t size) : _data(data), _size(size), _bit(0) {}
+	
+	bool More(int bits) const { return (_bit + bits <= _size * 8); }
+	
+	int Read(int bits)
+	{
+		int value = 0;
+		
+		while(bits--)
+		{
+			value = (value << 1) | ((_data[_bit / 8] >> (7 - (_bit % 8))) & 1);
+			
+			_bit++;
+		}
+		
+		return value;
+	}
+	
+  private:
+	const unsigned char *_data;
+	const size_t _size;
+	size_t _bit;
+};
+
+
+bool
+WebM_PassthroughParseKeyframe(const char *codec_id, const unsigned char *data, size_t size,
+								int &profile, int &bit_depth)
+{
+	if(data == NULL)
+		return false;
+	
+	if(string(codec_id) == "V_VP8")
+	{
+		// The frame tag: keyframe bit (0 for a keyframe), then a 3 bit version,
+		// which is what the encoder calls the profile.  Always 8 bits.
+		if(size < 6 || (data[0] & 1) || data[3] != 0x9d || data[4] != 0x01 || data[5] != 0x2a)
+			return false;
+		
+		profile = (data[0] >> 1) & 7;
+		bit_depth = 8;
+		
+		return true;
+	}
+	else if(string(codec_id) == "V_VP9")
+	{
+		BitReader bits(data, size);
+		
+		if(!bits.More(8) || bits.Read(2) != 2) // frame marker
+			return false;
+		
+		profile = bits.Read(1);
+		profile |= (bits.Read(1) << 1);
+		
+		if(profile == 3)
+			bits.Read(1); // reserved
+		
+		// show_existing_frame, frame_type (0 is a keyframe), show_frame, error_resilient_mode
+		if(!bits.More(4 + 24 + 1) || bits.Read(1) != 0 || bits.Read(1) != 0)
+			return false;
+		
+		bits.Read(2);
+		
+		if(bits.Read(8) != 0x49 || bits.Read(8) != 0x83 || bits.Read(8) != 0x42)
+			return false;
+		
+		// profiles 2 and 3 start the color config with the bit depth
+		bit_depth = (profile >= 2 ? (bits.Read(1) ? 12 : 10) : 8);
+		
+		return true;
+	}
+	
+	return false;
+}
+
+
+void
+WebM_PassthroughBegin()
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	gActive++;
+}
+
+
+void
+WebM_PassthroughEnd()
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	assert(gActive > 0);
+	
+	if(gActive > 0)
+		gActive--;
+	
+	if(gActive == 0)
+	{
+		while(!gSources.empty())
+			ForgetSource(gSources.begin()->first);
+	}
+}
+
+
+bool
+WebM_PassthroughActive()
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	return (gActive > 0);
+}
+
+
+void
+WebM_PassthroughRemoveSource(int source_id)
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	ForgetSource(source_id);
+}
+
+
+bool
+WebM_PassthroughHasSource(int source_id)
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	return (gSources.find(source_id) != gSources.end());
+}
+
+
+int
+WebM_PassthroughAddSource(const WebM_PathChar *path, const WebM_PassthroughFormat &format,
+							const WebM_Index &index)
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	const UTF16String source_path(path);
+	
+	// the file might have changed since we saw it, so start over
+	for(std::map<int, PassthroughSource *>::iterator i = gSources.begin(); i != gSources.end(); ++i)
+	{
+		if(i->second->path == source_path)
+		{
+			ForgetSource(i->first);
+			break;
+		}
+	}
+	
+	// ids only go up, so the lowest one is the oldest
+	while(gSources.size() >= kMaxSources)
+		ForgetSource(gSources.begin()->first);
+	
+	PassthroughSource *source = new PassthroughSource;
+	
+	source->path = source_path;
+	source->format = format;
+	source->index = index;
+	source->hashes.resize(index.video.size(), 0);
+	
+	const int id = gNextSource++;
+	
+	gSources[id] = source;
+	
+	return id;
+}
+
+
+void
+WebM_PassthroughAddFrame(int source_id, int frame, unsigned long long hash)
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	std::map<int, PassthroughSource *>::iterator source = gSources.find(source_id);
+	
+	if(source != gSources.end() && frame >= 0 && frame < source->second->hashes.size())
+	{
+		source->second->hashes[frame] = hash;
+		
+		if(source->second->index.video[frame].flags & WEBM_INDEX_KEYFRAME)
+		{
+			PassthroughKey key;
+			
+			key.source = source_id;
+			key.frame = frame;
+			
+			gKeyframes[hash] = key;
+		}
+	}
+}
+
+
+static void
+FillFrame(int source_id, int frame, const PassthroughSource &source, WebM_PassthroughFrame &found)
+{
+	const WebM_IndexVideoFrame &index_frame = source.index.video[frame];
+	
+	found.source = source_id;
+	found.frame = frame;
+	found.pos = index_frame.pos;
+	found.size = index_frame.size;
+	found.keyframe = (index_frame.flags & WEBM_INDEX_KEYFRAME);
+}
+
+
+static bool
+SameFormat(const WebM_PassthroughFormat &a, const WebM_PassthroughFormat &b)
+{
+	return (a.codec_id == b.codec_id &&
+			a.width == b.width &&
+			a.height == b.height &&
+			a.profile == b.profile &&
+			a.bit_depth == b.bit_depth &&
+			a.codec_private == b.codec_private);
+}
+
+
+bool
+WebM_PassthroughFindKeyframe(unsigned long long hash, const WebM_PassthroughFormat &format,
+								WebM_PassthroughFrame &found)
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	std::map<unsigned long long, PassthroughKey>::const_iterator key = gKeyframes.find(hash);
+	
+	if(key != gKeyframes.end())
+	{
+		std::map<int, PassthroughSource *>::const_iterator source = gSources.find(key->second.source);
+		
+		if(source != gSources.end())
+		{
+			const PassthroughSource &s = *source->second;
+			
+			if( SameFormat(s.format, format) )
+			{
+				FillFrame(key->second.source, key->second.frame, s, found);
+				
+				return true;
+			}
+		}
+	}
+	
+	return false;
+}
+
+
+bool
+WebM_PassthroughFindFrame(int source_id, int frame, unsigned long long hash,
+							WebM_PassthroughFrame &found)
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	std::map<int, PassthroughSource *>::const_iterator source = gSources.find(source_id);
+	
+	if(source != gSources.end())
+	{
+		const PassthroughSource &s = *source->second;
+		
+		if(frame >= 0 && frame < s.hashes.size() && s.hashes[frame] == hash)
+		{
+			FillFrame(source_id, frame, s, found);
+			
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
+bool
+WebM_PassthroughPath(int source_id, UTF16String &path)
+{
+	WebM_Lock lock(gPassthroughMutex);
+	
+	std::map<int, PassthroughSource *>::const_iterator source = gSources.find(source_id);
+	
+	if(source != gSources.end())
+	{
+		path = source->second->path;
+		
+		return true;
+	}
+	
+	return false;
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#ifndef WEBM_PASSTHROUGH_H
+#define WEBM_PASSTHROUGH_H
+
+#include "WebM_File.h"
+
+#include "WebM_Index.h"
+
+#include <string>
+#include <vector>
+
+
+// Smart rendering, sort of.  Premiere doesn't tell an exporter where its
+// frames came from, but the importer and exporter live in the same plug-in.
+// So the importer writes down a hash of every frame it decodes, and if a frame
+// the exporter gets from Premiere has the same hash, it must be that source
+// frame, untouched.  Then we can copy the compressed frame instead of encoding
+// it again, as long as we start copying on a keyframe and keep going in order.
+// This only works when the export happens inside the same process as the
+// import, so not in Media Encoder.  And it's only switched on while an
+// exporter is set to smart render, so until then the importer doesn't pay
+// for hashing its frames or keeping copies of its index.
+
+typedef struct {
+	int				source;		// id from WebM_PassthroughAddSource()
+	int				frame;		// index in the source's WebM_Index
+	long long		pos;
+	unsigned int	size;
+	bool			keyframe;
+} WebM_PassthroughFrame;
+
+
+// What a source's frames have to match before we copy them into our movie.
+// A decoder set up for one of these can't take the other's frames.
+typedef struct {
+	std::string					codec_id;	// the Matroska one, like "V_VP8"
+	int							width;
+	int							height;
+	int							profile;	// from the keyframe header
+	int							bit_depth;
+	std::vector<unsigned char>	codec_private;
+} WebM_PassthroughFormat;
+
+// The profile and bit depth from the start of a keyframe.  False if it
+// isn't one, or we can't tell.
+bool WebM_PassthroughParseKeyframe(const char *codec_id, const unsigned char *data, size_t size,
+									int &profile, int &bit_depth);
+
+
+// The exporter calls Begin when smart rendering gets turned on, and End when
+// it's turned off again or the exporter goes away.  They nest.  When the
+// last one ends, every source is forgotten.
+void WebM_PassthroughBegin();
+void WebM_PassthroughEnd();
+
+// Should the importer be registering sources and hashing frames?
+bool WebM_PassthroughActive();
+
+
+// Called by the importer the first time it decodes a frame while we're
+// active.  Opening the same path again starts that source over.
+int WebM_PassthroughAddSource(const WebM_PathChar *path, const WebM_PassthroughFormat &format,
+								const WebM_Index &index);
+
+// Called by the importer when it closes the file, so we're not holding on
+// to its index for nothing.
+void WebM_PassthroughRemoveSource(int source);
+
+// False once the source is removed, or forgotten by WebM_PassthroughEnd().
+bool WebM_PassthroughHasSource(int source);
+
+// Called by the importer for every frame it decodes.
+void WebM_PassthroughAddFrame(int source, int frame, unsigned long long hash);
+
+
+// Is this hash a keyframe we decoded, from a source that matches our settings?
+bool WebM_PassthroughFindKeyframe(unsigned long long hash, const WebM_PassthroughFormat &format,
+									WebM_PassthroughFrame &found);
+
+// Does frame number `frame` in the source have this hash?
+bool WebM_PassthroughFindFrame(int source, int frame, unsigned long long hash,
+								WebM_PassthroughFrame &found);
+
+bool WebM_PassthroughPath(int source, UTF16String &path);
+
+
+#endif // WEBM_PASSTHROUGH_H
@@ -0,0 +1,227 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_Proxy.h"
+
+#include "WebM_IndexCache.h"
+
+#include <string>
+
+
+// how far apart the two files' modification times can be
+#ifdef PRWIN_ENV
+static const long long kModTimeSlack = 60LL * 10000000LL; // FILETIME is in 100 ns units
+#else
+static const long long kModTimeSlack = 60;
+#endif
+
+
+WebM_ProxyFile::WebM_ProxyFile() :
+	_file(NULL),
+	_size(-1),
+	_width(0),
+	_height(0),
+	_vp9(false)
+{
+
+}
+
+
+WebM_ProxyFile::~WebM_ProxyFile()
+{
+	Close();
+}
+
+
+void
+WebM_ProxyFile::Close()
+{
+	if(_file != NULL)
+	{
+		fclose(_file);
+		
+		_file = NULL;
+	}
+	
+	_size = -1;
+}
+
+
+bool
+WebM_ProxyFile::Open(const WebM_PathChar *main_path, mkvparser::IMkvReader *main_reader, const WebM_Index &main_index)
+{
+	const UTF16String proxy_path = WebM_SiblingPath(main_path, WEBM_PROXY_SUFFIX);
+	
+	// if we were handed the proxy itself, it doesn't get a proxy
+	if(proxy_path == UTF16String(main_path))
+		return false;
+	
+	_file = WebM_OpenFile(proxy_path.c_str(), "rb");
+	
+	if(_file == NULL)
+		return false;
+	
+#ifdef PRWIN_ENV
+	_fseeki64(_file, 0, SEEK_END);
+#else
+	fseeko(_file, 0, SEEK_END);
+#endif
+	_size = WebM_TellFile(_file);
+
+	// written along with the movie?
+	WebM_FileIdentity main_identity, proxy_identity;
+	
+	if( !WebM_GetFileIdentity(main_reader, main_path, main_identity) ||
+		!WebM_GetFileIdentity(this, proxy_path.c_str(), proxy_identity) ||
+		main_identity.mod_time - proxy_identity.mod_time > kModTimeSlack ||
+		proxy_identity.mod_time - main_identity.mod_time > kModTimeSlack )
+	{
+		Close();
+		return false;
+	}
+	
+	
+	long long pos = 0;
+	
+	mkvparser::EBMLHeader ebmlHeader;
+	
+	ebmlHeader.Parse(this, pos);
+	
+	mkvparser::Segment *segment = NULL;
+	
+	long long ret = mkvparser::Segment::CreateInstance(this, pos, segment);
+	
+	bool opened = false;
+	
+	if(ret >= 0 && segment != NULL && segment->Load() >= 0)
+	{
+		const mkvparser::Tracks* pTracks = segment->GetTracks();
+		
+		for(int t=0; t < pTracks->GetTracksCount() && !opened; t++)
+		{
+			const mkvparser::Track* const pTrack = pTracks->GetTrackByIndex(t);
+			
+			if(pTrack != NULL && pTrack->GetType() == mkvparser::Track::kVideo)
+			{
+				const mkvparser::VideoTrack* const pVideoTrack = static_cast<const mkvparser::VideoTrack*>(pTrack);
+				
+				const std::string codec_id = pVideoTrack->GetCodecId();
+				
+				if(codec_id == "V_VP8" || codec_id == "V_VP9")
+				{
+					_width = pVideoTrack->GetWidth();
+					_height = pVideoTrack->GetHeight();
+					_vp9 = (codec_id == "V_VP9");
+					
+					WebM_BuildIndex(segment, this, pTrack->GetNumber(), -1, _index);
+					
+					opened = true;
+				}
+			}
+		}
+	}
+	
+	delete segment;
+	
+	// same frames at the same times
+	if(opened)
+	{
+		if(_index.video.size() != main_index.video.size())
+		{
+			opened = false;
+		}
+		else
+		{
+			for(int i=0; i < _index.video.size() && opened; i++)
+			{
+				if(_index.video[i].tstamp != main_index.video[i].tstamp)
+					opened = false;
+			}
+		}
+	}
+	
+	if(opened)
+		_path = proxy_path;
+	else
+		Close();
+	
+	return opened;
+}
+
+
+void
+WebM_ProxyFile::Quiet()
+{
+	if(_file != NULL)
+	{
+		fclose(_file);
+		
+		_file = NULL;
+	}
+}
+
+
+int
+WebM_ProxyFile::Read(long long pos, long len, unsigned char* buf)
+{
+	if(_file == NULL && !_path.empty())
+		_file = WebM_OpenFile(_path.c_str(), "rb");
+	
+	if(_file == NULL)
+		return -1;
+	
+	if(WebM_SeekFile(_file, pos) != 0)
+		return -1;
+	
+	return (fread(buf, 1, len, _file) == len ? 0 : -1);
+}
+
+
+int
+WebM_ProxyFile::Length(long long* total, long long* available)
+{
+	if(_size >= 0)
+	{
+		*total = *available = _size;
+		
+		return 0;
+	}
+	else
+		return -1;
+}
@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#ifndef WEBM_PROXY_H
+#define WEBM_PROXY_H
+
+#include "WebM_File.h"
+
+#include "WebM_Index.h"
+
+
+// The exporter can write movie_proxy.webm next to movie.webm, half the
+// width and height, with a keyframe every second.  When Premiere asks us
+// for frames smaller than the movie (scrubbing, 1/2 or 1/4 playback
+// resolution), it's much faster to decode those out of the proxy.
+//
+// A proxy only counts if it was written along with the movie: the same
+// frames at the same times, and modified at about the same time.
+
+class WebM_ProxyFile : public mkvparser::IMkvReader
+{
+  public:
+	WebM_ProxyFile();
+	virtual ~WebM_ProxyFile();
+	
+	bool Open(const WebM_PathChar *main_path, mkvparser::IMkvReader *main_reader, const WebM_Index &main_index);
+	
+	// Closes the file when Premiere quiets the movie.  The next Read() opens it again.
+	void Quiet();
+	
+	virtual int Read(long long pos, long len, unsigned char* buf);
+	virtual int Length(long long* total, long long* available);
+	
+	const WebM_Index & Index() const { return _index; }
+	
+	int Width() const { return _width; }
+	int Height() const { return _height; }
+	bool IsVP9() const { return _vp9; }
+	
+  private:
+	void Close();
+	
+	UTF16String _path;
+	FILE *_file;
+	long long _size;
+	
+	WebM_Index _index;
+	
+	int _width;
+	int _height;
+	bool _vp9;
+};
+
+
+#endif // WEBM_PROXY_H
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_ReadAhead.h"
+
+#include "WebM_Speed.h"
+
+
+// Never put more than this much in the cache past one request (96 MB,
+// about 8 frames of 4K or 30 of 1080p)
+static const double kMaxAheadBytes = 96.0 * 1024.0 * 1024.0;
+
+// read ahead about this many seconds of playback
+static const double kAheadSeconds = 1.0;
+
+// requests further apart than this aren't playback any more, someone paused
+static const double kPauseSeconds = 2.0;
+
+static const int kMinMaxAhead = 2;
+static const int kMaxMaxAhead = 240;
+
+
+WebM_ReadAhead::WebM_ReadAhead() :
+	_last_frame(-1),
+	_last_time(0.0),
+	_pending_end(-1),
+	_forward(false),
+	_speed(0.0),
+	_max_ahead(30),
+	_useful(0),
+	_wasted(0)
+{
+
+}
+
+
+int
+WebM_ReadAhead::FramesAhead(long frame, int frames_left, size_t frame_bytes, int frames_behind)
+{
+	const double now = WebM_Seconds();
+	
+	// First, how did the last read-ahead do?
+	if(_last_frame >= 0 && _pending_end > _last_frame)
+	{
+		const long pending = _pending_end - _last_frame;
+		
+		if(frame > _last_frame && frame <= _pending_end + 1)
+		{
+			// The host played through the frames in between, from the cache.
+			// If it's asking for one we cached, that one got pushed out.
+			const long played = frame - _last_frame - 1;
+			
+			_useful += played;
+			
+			if(frame <= _pending_end)
+				_wasted++;
+			
+			if(played > 0 && _max_ahead < kMaxMaxAhead)
+				_max_ahead++;
+		}
+		else
+		{
+			// went somewhere else, none of them got used
+			_wasted += pending;
+			
+			_max_ahead /= 2;
+			
+			if(_max_ahead < kMinMaxAhead)
+				_max_ahead = kMinMaxAhead;
+		}
+	}
+	
+	
+	// Which way are we going, and how fast?
+	const double elapsed = now - _last_time;
+	
+	const bool moving_forward = (_last_frame >= 0 && frame > _last_frame &&
+									frame <= (_pending_end > _last_frame ? _pending_end : _last_frame) + 1 &&
+									elapsed < kPauseSeconds);
+	
+	if(moving_forward)
+	{
+		const double speed = (elapsed > 0.0 ? (double)(frame - _last_frame) / elapsed : 0.0);
+		
+		_speed = (_forward ? (_speed * 0.75) + (speed * 0.25) : speed);
+	}
+	else
+		_speed = 0.0;
+	
+	_forward = moving_forward;
+	
+	
+	int ahead = 0;
+	
+	if(_forward)
+	{
+		ahead = frames_left;
+		
+		const double second_of_frames = (_speed * kAheadSeconds) + 0.5;
+		
+		if(second_of_frames > 0.0 && ahead > second_of_frames)
+			ahead = second_of_frames;
+		
+		if(ahead > _max_ahead)
+			ahead = _max_ahead;
+		
+		// Every request starts a new decoder at the keyframe, so stopping
+		// here means rolling forward through everything behind us and
+		// everything we read ahead to get the next frame.  Going at least
+		// as far ahead as we came costs no more than this request did and
+		// saves doing it all over again next time.
+		if(ahead < frames_behind)
+			ahead = (frames_behind < frames_left ? frames_behind : frames_left);
+		
+		if(frame_bytes > 0 && ((double)ahead * (double)frame_bytes) > kMaxAheadBytes)
+			ahead = kMaxAheadBytes / (double)frame_bytes;
+		
+		// always a little, otherwise we'd never find out if it helps
+		if(ahead < 1 && frames_left > 0)
+			ahead = 1;
+	}
+	
+	_last_frame = frame;
+	_last_time = now;
+	_pending_end = frame + ahead;
+	
+	return ahead;
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#ifndef WEBM_READAHEAD_H
+#define WEBM_READAHEAD_H
+
+// Decides how far past the frame Premiere asked for we should keep decoding
+// and caching.  We used to always go to the end of the cluster, which is
+// great for playback but on long GOPs or big clusters just fills the cache
+// with frames nobody looks at, pushing out ones they would have.
+//
+// It watches where the requests go: playing forward gets read-ahead, as much
+// as about a second of playback and never more than a memory budget, scrubbing
+// around gets none.  It also keeps score: frames we read ahead that the host
+// then played through (out of the cache, so we never hear about them) were
+// useful, ones it jumped away from were wasted.  Too much waste and we read
+// ahead less.  No host SDK in here.
+
+#include <stddef.h>
+
+
+class WebM_ReadAhead
+{
+  public:
+	WebM_ReadAhead();
+	
+	// Premiere wants frame.  There are frames_left more frames in its cluster
+	// (that's as far as we ever go), each taking frame_bytes in the cache.
+	// We had to decode frames_behind frames since the keyframe to get to it,
+	// and the next request past where we stop has to decode them all again.
+	// Returns how many frames after it to decode and cache.
+	int FramesAhead(long frame, int frames_left, size_t frame_bytes, int frames_behind);
+	
+	// Should the frames we decode on the way to the requested one be cached?
+	// Not when playing forward, we've been past them already.
+	bool CacheBehind() const { return !_forward; }
+	
+	// Is the last request part of playback?
+	bool Playing() const { return _forward; }
+	
+	long UsefulFrames() const { return _useful; }
+	long WastedFrames() const { return _wasted; }
+	
+  private:
+	long _last_frame;		// -1 before the first request
+	double _last_time;
+	
+	long _pending_end;		// last frame we read ahead to, last time
+	
+	bool _forward;
+	double _speed;			// frames per second the requests are moving forward
+	
+	int _max_ahead;			// goes down when we waste, up when we don't
+	
+	long _useful;
+	long _wasted;
+};
+
+
+#endif // WEBM_READAHEAD_H
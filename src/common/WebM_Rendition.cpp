@@ -0,0 +1,396 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_Rendition.h"
+
+#include "WebM_EncoderConfig.h"
+
+#include "WebM_Color.h"
+
+extern "C" {
+#include "vpx/vp8cx.h"
+}
+
+#include <assert.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+
+WebM_Rendition::WebM_Rendition(int width, int height, bool proxy) :
+	_width(width),
+	_height(height),
+	_proxy(proxy),
+	_dash(false),
+	_segment(NULL),
+	_track(0),
+	_encoder_open(false),
+	_img(NULL),
+	_have_frame(false),
+	_quit(false),
+	_result(WEBM_OK),
+	_src(NULL),
+	_pts(0),
+	_duration(0),
+	_flags(0),
+	_timestamp(0),
+	_deadline(0),
+	_last_frame(false)
+{
+
+}
+
+
+WebM_Rendition::~WebM_Rendition()
+{
+	{
+		WebM_Lock lock(_mutex);
+		
+		_quit = true;
+		
+		_cond.Signal();
+	}
+	
+	Join();
+	
+	delete _segment;
+	
+	if(_encoder_open)
+		vpx_codec_destroy(&_encoder);
+	
+	if(_img != NULL)
+		vpx_img_free(_img);
+	
+	_writer.Close();
+}
+
+
+bool
+WebM_Rendition::Begin(const WebM_PathChar *main_path, vpx_codec_iface_t *iface, const char *codec_id,
+						const vpx_codec_enc_cfg_t &main_config, int cq_level, const char *custom_args,
+						double frame_rate, long long timecode_scale, bool dash)
+{
+	char suffix[32];
+	
+	if(_proxy)
+		strcpy(suffix, WEBM_PROXY_SUFFIX);
+	else
+		sprintf(suffix, "_%dp.webm", _height);
+	
+	_path = WebM_SiblingPath(main_path, suffix);
+	
+	_dash = (dash && !_proxy);
+	
+	if( !_writer.Open(_path.c_str()) )
+		return false;
+	
+	
+	vpx_codec_enc_cfg_t config = main_config;
+	
+	// same bits per pixel as the main movie
+	const double pixel_ratio = ((double)_width * (double)_height) / ((double)main_config.g_w * (double)main_config.g_h);
+	
+	config.g_w = _width;
+	config.g_h = _height;
+	
+	if(cq_level < 0)
+	{
+		config.rc_target_bitrate = (double)main_config.rc_target_bitrate * pixel_ratio;
+		
+		if(config.rc_target_bitrate < 50)
+			config.rc_target_bitrate = 50;
+	}
+	
+	// We only come along for the final pass, and we don't have stats of our own
+	if(config.g_pass != VPX_RC_ONE_PASS)
+	{
+		config.g_pass = VPX_RC_ONE_PASS;
+		config.rc_twopass_stats_in.buf = NULL;
+		config.rc_twopass_stats_in.sz = 0;
+	}
+	
+	// Threads for our own size.  The renditions are smaller than the main movie,
+	// so they get fewer tiles, which is about right since they share the cores with it.
+	const bool vp9 = (iface == vpx_codec_vp9_cx());
+	
+	if(_proxy)
+	{
+		// The proxy is for scrubbing, so it gets a keyframe every second
+		// and frames come out right away.  Two threads is plenty at this
+		// size, and leaves the cores to the main movie.
+		config.g_lag_in_frames = 0;
+		config.kf_mode = VPX_KF_AUTO;
+		config.kf_min_dist = 0;
+		config.kf_max_dist = frame_rate + 0.5;
+		
+		ConfigureEncoderThreadsPre(config, vp9, (main_config.g_threads < 2 ? main_config.g_threads : 2));
+	}
+	else
+		ConfigureEncoderThreadsPre(config, vp9, main_config.g_threads);
+	
+	vpx_codec_err_t codec_err = vpx_codec_enc_init(&_encoder, iface, &config, 0);
+	
+	if(codec_err != VPX_CODEC_OK)
+		return false;
+	
+	_encoder_open = true;
+	
+	if(cq_level >= 0)
+		vpx_codec_control(&_encoder, VP8E_SET_CQ_LEVEL, cq_level);
+	
+	ConfigureEncoderThreadsPost(&_encoder, config, vp9);
+	
+	ConfigureEncoderPost(&_encoder, custom_args);
+	
+	// as fast as realtime encoding goes, whatever the custom args say
+	if(_proxy)
+		vpx_codec_control(&_encoder, VP8E_SET_CPUUSED, (vp9 ? WEBM_PROXY_CPUUSED_VP9 : WEBM_PROXY_CPUUSED_VP8));
+	
+	
+	_img = vpx_img_alloc(&_img_data, VPX_IMG_FMT_I420, _width, _height, 32);
+	
+	if(_img == NULL)
+		return false;
+	
+	
+	_segment = new mkvmuxer::Segment;
+	
+	_segment->Init(&_writer);
+	_segment->set_mode(mkvmuxer::Segment::kFile);
+	
+	mkvmuxer::SegmentInfo* const info = _segment->GetSegmentInfo();
+	
+	info->set_writing_app("fnord WebM for Premiere");
+	info->set_timecode_scale(timecode_scale);
+	
+	_track = _segment->AddVideoTrack(_width, _height, 1);
+	
+	mkvmuxer::VideoTrack* const video = static_cast<mkvmuxer::VideoTrack *>(_segment->GetTrackByNumber(_track));
+	
+	video->set_frame_rate(frame_rate);
+	video->set_codec_id(codec_id);
+	
+	_segment->CuesTrack(_track);
+	
+	
+	return Start();
+}
+
+
+void
+WebM_Rendition::Submit(const vpx_image_t *img, vpx_codec_pts_t pts, unsigned long duration,
+						vpx_enc_frame_flags_t flags, unsigned long long timestamp,
+						unsigned long deadline, bool last_frame)
+{
+	WebM_Lock lock(_mutex);
+	
+	while(_have_frame)
+		_cond.Wait(_mutex);
+	
+	_src = img;
+	_pts = pts;
+	_duration = duration;
+	_flags = flags;
+	_timestamp = timestamp;
+	_deadline = (_proxy ? VPX_DL_REALTIME : deadline);
+	_last_frame = last_frame;
+	
+	_have_frame = true;
+	
+	_cond.Signal();
+}
+
+
+WebM_Result
+WebM_Rendition::Wait()
+{
+	WebM_Lock lock(_mutex);
+	
+	while(_have_frame)
+		_cond.Wait(_mutex);
+	
+	return _result;
+}
+
+
+void
+WebM_Rendition::SetCpuUsed(int cpu_used)
+{
+	// the proxy is already going as fast as it can
+	if(_encoder_open && !_proxy)
+		vpx_codec_control(&_encoder, VP8E_SET_CPUUSED, cpu_used);
+}
+
+
+WebM_Result
+WebM_Rendition::End()
+{
+	{
+		WebM_Lock lock(_mutex);
+		
+		_quit = true;
+		
+		_cond.Signal();
+	}
+	
+	Join();
+	
+	WebM_Result result = _result;
+	
+	if(_segment != NULL)
+	{
+		bool final = _segment->Finalize();
+		
+		if(!final && result == WEBM_OK)
+			result = WEBM_ERR_INTERNAL;
+	}
+	
+	_writer.Close();
+	
+	return result;
+}
+
+
+void
+WebM_Rendition::Run()
+{
+	bool quit = false;
+	
+	while(!quit)
+	{
+		WebM_Result result = WEBM_OK;
+		
+		{
+			WebM_Lock lock(_mutex);
+			
+			while(!_have_frame && !_quit)
+				_cond.Wait(_mutex);
+			
+			quit = !_have_frame;
+			
+			result = _result;
+		}
+		
+		if(!quit)
+		{
+			// once something's gone wrong, we just keep saying so
+			if(result == WEBM_OK)
+				result = EncodeFrame();
+			
+			WebM_Lock lock(_mutex);
+			
+			_result = result;
+			_have_frame = false;
+			
+			_cond.Signal();
+		}
+	}
+}
+
+
+WebM_Result
+WebM_Rendition::EncodeFrame()
+{
+	WebM_ScaleImage(_src, _img);
+	
+	vpx_codec_err_t encode_err = vpx_codec_encode(&_encoder, _img, _pts, _duration, _flags, _deadline);
+	
+	if(encode_err != VPX_CODEC_OK)
+		return WEBM_ERR_INTERNAL;
+	
+	WebM_Result result = MuxPackets(_timestamp);
+	
+	if(result == WEBM_OK && _last_frame)
+	{
+		// squeeze last bits from encoder, same as the main movie
+		vpx_codec_encode(&_encoder, NULL, _pts, _duration, 0, _deadline);
+		
+		result = MuxPackets(_timestamp);
+	}
+	
+	return result;
+}
+
+
+WebM_Result
+WebM_Rendition::MuxPackets(unsigned long long timestamp)
+{
+	WebM_Result result = WEBM_OK;
+	
+	const vpx_codec_cx_pkt_t *pkt = NULL;
+	vpx_codec_iter_t iter = NULL;
+	
+	while( (pkt = vpx_codec_get_cx_data(&_encoder, &iter)) )
+	{
+		if(pkt->kind == VPX_CODEC_CX_FRAME_PKT)
+		{
+			if(_dash && (pkt->data.frame.flags & VPX_FRAME_IS_KEY))
+				_segment->ForceNewClusterOnNextFrame();
+			
+			bool added = _segment->AddFrame((const mkvmuxer::uint8 *)pkt->data.frame.buf, pkt->data.frame.sz,
+											_track, timestamp,
+											(pkt->data.frame.flags & VPX_FRAME_IS_KEY));
+			
+			if(!added)
+				result = WEBM_ERR_INTERNAL;
+		}
+	}
+	
+	return result;
+}
+
+
+int
+WebM_RenditionHeights(int main_height, int count, int *heights)
+{
+	static const int ladder[] = { 1080, 720, 480, 360, 240, 144 };
+	
+	const int ladder_size = sizeof(ladder) / sizeof(ladder[0]);
+	
+	int found = 0;
+	
+	for(int i=0; i < ladder_size && found < count; i++)
+	{
+		if(ladder[i] < main_height)
+			heights[found++] = ladder[i];
+	}
+	
+	return found;
+}
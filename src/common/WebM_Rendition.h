@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+
+#ifndef WEBM_RENDITION_H
+#define WEBM_RENDITION_H
+
+#include "WebM_Result.h"
+#include "WebM_File.h"
+
+#include "WebM_Thread.h"
+#include "WebM_DASH.h"
+
+extern "C" {
+#include "vpx/vpx_encoder.h"
+}
+
+
+// A smaller copy of the video, encoded from the same rendered frames as the
+// main movie and written to its own file next to it, like movie_720p.webm.
+// Scaling and encoding happen on the rendition's own thread, so all the
+// renditions (and the main movie) get encoded at the same time.
+//
+// A proxy is a rendition for editing, not for playback: it's written to
+// movie_proxy.webm, encoded at realtime speed with frequent keyframes,
+// and left out of any DASH manifest.  The importer picks it up when
+// Premiere asks for smaller frames.
+
+class WebM_Rendition : public WebM_Thread
+{
+  public:
+	WebM_Rendition(int width, int height, bool proxy = false);
+	virtual ~WebM_Rendition();
+	
+	// main_config is what the main movie's encoder got.  We change the size
+	// and scale the bitrate down to match.  Pass cq_level < 0 if not in quality mode.
+	// For DASH, every keyframe starts a new Cluster.
+	bool Begin(const WebM_PathChar *main_path, vpx_codec_iface_t *iface, const char *codec_id,
+				const vpx_codec_enc_cfg_t &main_config, int cq_level, const char *custom_args,
+				double frame_rate, long long timecode_scale, bool dash);
+	
+	// Starts scaling and encoding img.  It has to stay put until Wait() returns.
+	// Pass the same flags as the main movie, so forced keyframes line up.
+	void Submit(const vpx_image_t *img, vpx_codec_pts_t pts, unsigned long duration,
+				vpx_enc_frame_flags_t flags, unsigned long long timestamp,
+				unsigned long deadline, bool last_frame);
+	
+	WebM_Result Wait();
+	
+	// Only while we're not working on a frame, i.e. after Wait()
+	void SetCpuUsed(int cpu_used);
+	
+	// stops the thread and finishes the file
+	WebM_Result End();
+	
+	int Width() const { return _width; }
+	int Height() const { return _height; }
+	bool IsProxy() const { return _proxy; }
+	
+	const UTF16String & Path() const { return _path; }
+	const WebM_MkvLayout & Layout() const { return _writer.Layout(); }
+	
+  protected:
+	virtual void Run();
+	
+  private:
+	WebM_Result EncodeFrame();
+	WebM_Result MuxPackets(unsigned long long timestamp);
+	
+	const int _width;
+	const int _height;
+	const bool _proxy;
+	
+	UTF16String _path;
+	bool _dash;
+	
+	FileMkvWriter _writer;
+	mkvmuxer::Segment *_segment;
+	mkvmuxer::uint64 _track;
+	
+	vpx_codec_ctx_t _encoder;
+	bool _encoder_open;
+	
+	vpx_image_t _img_data;
+	vpx_image_t *_img;
+	
+	WebM_Mutex _mutex;
+	WebM_Condition _cond;
+	bool _have_frame;
+	bool _quit;
+	WebM_Result _result;
+	
+	// the frame we're working on
+	const vpx_image_t *_src;
+	vpx_codec_pts_t _pts;
+	unsigned long _duration;
+	vpx_enc_frame_flags_t _flags;
+	unsigned long long _timestamp;
+	unsigned long _deadline;
+	bool _last_frame;
+};
+
+
+// realtime speeds, the fastest that still look like something
+#define WEBM_PROXY_CPUUSED_VP8	12
+#define WEBM_PROXY_CPUUSED_VP9	8
+
+
+// Picks up to count heights from a standard ladder (720, 480, 360...)
+// that are smaller than the main movie.  Returns how many it found.
+int WebM_RenditionHeights(int main_height, int count, int *heights);
+
+
+#endif // WEBM_RENDITION_H
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_SceneCut.h"
+
+#include <stdlib.h>
+
+
+static const int kGridWidth = 32;
+static const int kGridHeight = 18;
+
+// Average difference per grid cell (0-255) that counts as a cut, but only
+// if it's also well above what we've been seeing, so a fast pan isn't a cut.
+static const double kCutThreshold = 30.0;
+static const double kCutRatio = 3.0;
+
+
+WebM_SceneDetector::WebM_SceneDetector() :
+	_grid(kGridWidth * kGridHeight, 0),
+	_last_grid(kGridWidth * kGridHeight, 0),
+	_have_last(false),
+	_average_diff(0.0)
+{
+
+}
+
+
+static void
+ShrinkLuma(const vpx_image_t *img, std::vector<int> &grid)
+{
+	const unsigned char *plane = img->planes[VPX_PLANE_Y];
+	const int stride = img->stride[VPX_PLANE_Y];
+	
+	const int width = img->d_w;
+	const int height = img->d_h;
+	
+	for(int gy = 0; gy < kGridHeight; gy++)
+	{
+		const int y0 = (gy * height) / kGridHeight;
+		const int y1 = ((gy + 1) * height) / kGridHeight;
+		
+		for(int gx = 0; gx < kGridWidth; gx++)
+		{
+			const int x0 = (gx * width) / kGridWidth;
+			const int x1 = ((gx + 1) * width) / kGridWidth;
+			
+			// every other pixel on every other row is plenty for this
+			int sum = 0;
+			int count = 0;
+			
+			for(int y = y0; y < y1; y += 2)
+			{
+				const unsigned char *row = plane + (stride * y);
+				
+				for(int x = x0; x < x1; x += 2)
+				{
+					sum += row[x];
+					count++;
+				}
+			}
+			
+			grid[(gy * kGridWidth) + gx] = (count > 0 ? sum / count : 0);
+		}
+	}
+}
+
+
+bool
+WebM_SceneDetector::IsCut(const vpx_image_t *img)
+{
+	ShrinkLuma(img, _grid);
+	
+	bool cut = false;
+	
+	if(_have_last)
+	{
+		int sad = 0;
+		
+		for(int i=0; i < _grid.size(); i++)
+			sad += abs(_grid[i] - _last_grid[i]);
+		
+		const double diff = (double)sad / (double)_grid.size();
+		
+		cut = (diff > kCutThreshold && diff > (_average_diff * kCutRatio));
+		
+		// start over with the new shot
+		if(cut)
+			_average_diff = 0.0;
+		else
+			_average_diff = (0.8 * _average_diff) + (0.2 * diff);
+	}
+	
+	_grid.swap(_last_grid);
+	
+	_have_last = true;
+	
+	return cut;
+}
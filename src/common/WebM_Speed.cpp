@@ -0,0 +1,172 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_Speed.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifdef PRWIN_ENV
+	#include <windows.h>
+#else
+	#include <sys/time.h>
+#endif
+
+
+double
+WebM_Seconds()
+{
+#ifdef PRWIN_ENV
+	LARGE_INTEGER count, frequency;
+	
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	
+	return (double)count.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timeval tv;
+	
+	gettimeofday(&tv, NULL);
+	
+	return (double)tv.tv_sec + ((double)tv.tv_usec / 1000000.0);
+#endif
+}
+
+
+// Don't change again until this many frames have gone by at the new level,
+// otherwise we're just reacting to the last change.
+static const long kSettleFrames = 8;
+
+// How far off we have to be before doing anything about it.  We'd rather
+// finish a little early than late, so slowing down takes more slack.
+static const double kSpeedUpRatio = 1.05;
+static const double kSlowDownRatio = 0.75;
+
+
+WebM_SpeedGovernor::WebM_SpeedGovernor(double budget, long total_frames, int min_level, int max_level) :
+	_budget(budget),
+	_total_frames(total_frames),
+	_min_level(min_level),
+	_max_level(max_level),
+	_level(min_level),
+	_start(WebM_Seconds()),
+	_last(_start),
+	_frames_done(0),
+	_frames_since_change(0),
+	_average(0.0)
+{
+	LogLine("budget %.1f seconds for %ld frames (%.3f sec/frame), starting at cpu-used %d\n",
+				_budget, _total_frames, (_total_frames > 0 ? _budget / _total_frames : 0.0), _level);
+}
+
+
+bool
+WebM_SpeedGovernor::FrameDone()
+{
+	const double now = WebM_Seconds();
+	
+	const double frame_time = now - _last;
+	
+	_last = now;
+	
+	_frames_done++;
+	_frames_since_change++;
+	
+	_average = (_frames_done == 1 ? frame_time : (0.9 * _average) + (0.1 * frame_time));
+	
+	
+	const long frames_left = _total_frames - _frames_done;
+	
+	if(_frames_since_change < kSettleFrames || frames_left <= 0)
+		return false;
+	
+	
+	const double time_left = _budget - (now - _start);
+	
+	// if we've already blown it, just go as fast as we can
+	const double target = (time_left > 0.0 ? time_left / frames_left : 0.0);
+	
+	int new_level = _level;
+	
+	if(_average > (target * kSpeedUpRatio) && _level < _max_level)
+		new_level++;
+	else if(_average < (target * kSlowDownRatio) && _level > _min_level)
+		new_level--;
+	
+	if(new_level != _level)
+	{
+		LogLine("frame %ld: %.3f sec/frame, need %.3f with %.1f seconds left, cpu-used %d -> %d\n",
+					_frames_done, _average, target, time_left, _level, new_level);
+		
+		_level = new_level;
+		_frames_since_change = 0;
+		
+		return true;
+	}
+	else
+		return false;
+}
+
+
+void
+WebM_SpeedGovernor::Finish()
+{
+	const double elapsed = WebM_Seconds() - _start;
+	
+	LogLine("finished %ld frames in %.1f seconds (budget %.1f), ending at cpu-used %d\n",
+				_frames_done, elapsed, _budget, _level);
+}
+
+
+void
+WebM_SpeedGovernor::LogLine(const char *format, ...)
+{
+	char line[256];
+	
+	va_list args;
+	va_start(args, format);
+	
+	vsnprintf(line, 255, format, args);
+	
+	va_end(args);
+	
+	line[255] = '\0';
+	
+	_log += line;
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_SPEED_H
+#define WEBM_SPEED_H
+
+// Keeps an encode on schedule by turning the encoder's speed setting
+// (cpu-used) up when we're falling behind and down when there's time to spare.
+// No host SDK or codec calls in here, the caller applies the level.
+
+#include <string>
+
+
+class WebM_SpeedGovernor
+{
+  public:
+	// We have budget seconds of wall-clock time for total_frames frames.
+	// Levels run from min_level (slowest, best) to max_level (fastest).
+	WebM_SpeedGovernor(double budget, long total_frames, int min_level, int max_level);
+	
+	int Level() const { return _level; }
+	
+	// Call after every frame.  Returns true if Level() changed.
+	bool FrameDone();
+	
+	// adds the final tally to the log
+	void Finish();
+	
+	// everything we decided and why, one line per decision
+	const std::string & Log() const { return _log; }
+	
+  private:
+	void LogLine(const char *format, ...);
+	
+	const double _budget;
+	const long _total_frames;
+	const int _min_level;
+	const int _max_level;
+	
+	int _level;
+	
+	double _start;
+	double _last;
+	
+	long _frames_done;
+	long _frames_since_change;
+	
+	double _average; // seconds per frame, smoothed
+	
+	std::string _log;
+};
+
+
+// seconds since some time in the past
+double WebM_Seconds();
+
+
+#endif // WEBM_SPEED_H
@@ -0,0 +1,202 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebM_Thread.h"
+
+#include <assert.h>
+
+#ifdef PRWIN_ENV
+	#include <process.h>
+#endif
+
+
+WebM_Mutex::WebM_Mutex()
+{
+#ifdef PRWIN_ENV
+	InitializeCriticalSection(&_cs);
+#else
+	pthread_mutex_init(&_mutex, NULL);
+#endif
+}
+
+
+WebM_Mutex::~WebM_Mutex()
+{
+#ifdef PRWIN_ENV
+	DeleteCriticalSection(&_cs);
+#else
+	pthread_mutex_destroy(&_mutex);
+#endif
+}
+
+
+void
+WebM_Mutex::Lock()
+{
+#ifdef PRWIN_ENV
+	EnterCriticalSection(&_cs);
+#else
+	pthread_mutex_lock(&_mutex);
+#endif
+}
+
+
+void
+WebM_Mutex::Unlock()
+{
+#ifdef PRWIN_ENV
+	LeaveCriticalSection(&_cs);
+#else
+	pthread_mutex_unlock(&_mutex);
+#endif
+}
+
+
+WebM_Condition::WebM_Condition()
+{
+#ifdef PRWIN_ENV
+	InitializeConditionVariable(&_cond);
+#else
+	pthread_cond_init(&_cond, NULL);
+#endif
+}
+
+
+WebM_Condition::~WebM_Condition()
+{
+#ifdef PRWIN_ENV
+	// nothing to delete
+#else
+	pthread_cond_destroy(&_cond);
+#endif
+}
+
+
+void
+WebM_Condition::Wait(WebM_Mutex &mutex)
+{
+#ifdef PRWIN_ENV
+	SleepConditionVariableCS(&_cond, &mutex._cs, INFINITE);
+#else
+	pthread_cond_wait(&_cond, &mutex._mutex);
+#endif
+}
+
+
+void
+WebM_Condition::Signal()
+{
+#ifdef PRWIN_ENV
+	WakeAllConditionVariable(&_cond);
+#else
+	pthread_cond_broadcast(&_cond);
+#endif
+}
+
+
+WebM_Thread::WebM_Thread() :
+	_running(false)
+{
+
+}
+
+
+WebM_Thread::~WebM_Thread()
+{
+	// subclass should have called Join() already,
+	// because by now its Run() is gone
+	assert(!_running);
+}
+
+
+#ifdef PRWIN_ENV
+unsigned __stdcall
+WebM_Thread::ThreadProc(void *arg)
+{
+	WebM_Thread *thread = static_cast<WebM_Thread *>(arg);
+	
+	thread->Run();
+	
+	return 0;
+}
+#else
+void *
+WebM_Thread::ThreadProc(void *arg)
+{
+	WebM_Thread *thread = static_cast<WebM_Thread *>(arg);
+	
+	thread->Run();
+	
+	return NULL;
+}
+#endif
+
+
+bool
+WebM_Thread::Start()
+{
+	assert(!_running);
+
+#ifdef PRWIN_ENV
+	_thread = (HANDLE)_beginthreadex(NULL, 0, ThreadProc, this, 0, NULL);
+	
+	_running = (_thread != NULL);
+#else
+	_running = (pthread_create(&_thread, NULL, ThreadProc, this) == 0);
+#endif
+
+	return _running;
+}
+
+
+void
+WebM_Thread::Join()
+{
+	if(_running)
+	{
+	#ifdef PRWIN_ENV
+		WaitForSingleObject(_thread, INFINITE);
+		CloseHandle(_thread);
+	#else
+		pthread_join(_thread, NULL);
+	#endif
+	
+		_running = false;
+	}
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_THREAD_H
+#define WEBM_THREAD_H
+
+// Just enough threading to get work off the host's thread.
+// Windows gets native calls, everyone else gets pthreads.
+
+#ifdef PRWIN_ENV
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
+
+
+class WebM_Mutex
+{
+  public:
+	WebM_Mutex();
+	~WebM_Mutex();
+	
+	void Lock();
+	void Unlock();
+	
+  private:
+	friend class WebM_Condition;
+	
+#ifdef PRWIN_ENV
+	CRITICAL_SECTION _cs;
+#else
+	pthread_mutex_t _mutex;
+#endif
+};
+
+
+// locks for as long as it's in scope
+class WebM_Lock
+{
+  public:
+	WebM_Lock(WebM_Mutex &mutex) : _mutex(mutex) { _mutex.Lock(); }
+	~WebM_Lock() { _mutex.Unlock(); }
+	
+  private:
+	WebM_Mutex &_mutex;
+};
+
+
+class WebM_Condition
+{
+  public:
+	WebM_Condition();
+	~WebM_Condition();
+	
+	// mutex must be locked, and will be locked again when this returns
+	void Wait(WebM_Mutex &mutex);
+	
+	// wakes up everyone waiting
+	void Signal();
+	
+  private:
+#ifdef PRWIN_ENV
+	CONDITION_VARIABLE _cond;
+#else
+	pthread_cond_t _cond;
+#endif
+};
+
+
+class WebM_Thread
+{
+  public:
+	WebM_Thread();
+	virtual ~WebM_Thread();
+	
+	bool Start();
+	void Join();
+	
+  protected:
+	virtual void Run() = 0;
+	
+  private:
+	bool _running;
+	
+#ifdef PRWIN_ENV
+	HANDLE _thread;
+	
+	static unsigned __stdcall ThreadProc(void *arg);
+#else
+	pthread_t _thread;
+	
+	static void * ThreadProc(void *arg);
+#endif
+};
+
+
+#endif // WEBM_THREAD_H
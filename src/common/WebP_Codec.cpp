@@ -0,0 +1,344 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "WebP_Codec.h"
+
+#include "webp/demux.h"
+#include "webp/mux.h"
+#include "webp/decode.h"
+#include "webp/encode.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static void
+GetChunk(WebPDemuxer *demux, const char *fourcc, std::vector<unsigned char> &chunk)
+{
+	WebPChunkIterator chunk_iter;
+	
+	if( WebPDemuxGetChunk(demux, fourcc, 1, &chunk_iter) )
+	{
+		chunk.assign(chunk_iter.chunk.bytes, chunk_iter.chunk.bytes + chunk_iter.chunk.size);
+		
+		WebPDemuxReleaseChunkIterator(&chunk_iter);
+	}
+	else
+		chunk.clear();
+}
+
+
+bool
+WebP_GetInfo(const unsigned char *data, size_t size, WebP_Info &info)
+{
+	WebPData webp_data = { (const uint8_t *)data, size };
+
+	WebPDemuxer *demux = WebPDemux(&webp_data);
+
+	if(demux == NULL)
+		return false;
+	
+	info.width = WebPDemuxGetI(demux, WEBP_FF_CANVAS_WIDTH);
+	info.height = WebPDemuxGetI(demux, WEBP_FF_CANVAS_HEIGHT);
+	info.frame_count = WebPDemuxGetI(demux, WEBP_FF_FRAME_COUNT);
+	
+	const uint32_t flags = WebPDemuxGetI(demux, WEBP_FF_FORMAT_FLAGS);
+	
+	info.has_alpha = (flags & ALPHA_FLAG);
+	
+	// check the bitstream to see if we REALLY have an alpha
+	// (lossless images are always compressed with an alpha)
+	WebPIterator iter;
+	
+	if(info.has_alpha && WebPDemuxGetFrame(demux, 0, &iter) )
+	{
+		WebPBitstreamFeatures features;
+	
+		VP8StatusCode status = WebPGetFeatures(iter.fragment.bytes, iter.fragment.size, &features);
+		
+		if(status == VP8_STATUS_OK)
+			info.has_alpha = features.has_alpha;
+		
+		WebPDemuxReleaseIterator(&iter);
+	}
+
+	assert(info.frame_count >= 1);
+	
+	if(flags & ICCP_FLAG)
+		GetChunk(demux, "ICCP", info.metadata.icc);
+	else
+		info.metadata.icc.clear();
+	
+	if(flags & EXIF_FLAG)
+		GetChunk(demux, "EXIF", info.metadata.exif);
+	else
+		info.metadata.exif.clear();
+	
+	if(flags & XMP_FLAG)
+		GetChunk(demux, "XMP ", info.metadata.xmp);
+	else
+		info.metadata.xmp.clear();
+	
+	WebPDemuxDelete(demux);
+	
+	return true;
+}
+
+
+bool
+WebP_Decode(const unsigned char *data, size_t size,
+			unsigned char *rgb, int width, int height, long rowbytes, bool alpha)
+{
+	bool result = false;
+	
+	WebPData webp_data = { (const uint8_t *)data, size };
+
+	WebPDemuxer *demux = WebPDemux(&webp_data);
+
+	if(demux)
+	{
+		WebPIterator iter;
+		
+		if( WebPDemuxGetFrame(demux, 0, &iter) )
+		{
+			WebPDecoderConfig config;
+			WebPInitDecoderConfig(&config);
+			
+			config.options.use_threads = 1;
+			
+			VP8StatusCode status = WebPGetFeatures(iter.fragment.bytes, iter.fragment.size, &config.input);
+			
+			if(status == VP8_STATUS_OK)
+			{
+				WebPDecBuffer* const output_buffer = &config.output;
+				
+				output_buffer->colorspace = (alpha ? MODE_RGBA : MODE_RGB);
+				output_buffer->width = width;
+				output_buffer->height = height;
+				output_buffer->is_external_memory = 1;
+				
+				WebPRGBABuffer *buf_info = &output_buffer->u.RGBA;
+				
+				buf_info->rgba = (uint8_t *)rgb;
+				buf_info->stride = rowbytes;
+				buf_info->size = (size_t)rowbytes * height;
+				
+				status = WebPDecode((const uint8_t *)iter.fragment.bytes, iter.fragment.size, &config);
+				
+				result = (status == VP8_STATUS_OK);
+			}
+			
+			WebPDemuxReleaseIterator(&iter);
+		}
+		
+		WebPDemuxDelete(demux);
+	}
+	
+	return result;
+}
+
+
+typedef struct {
+	unsigned char	r;
+	unsigned char	g;
+	unsigned char	b;
+	unsigned char	a;
+} RGBApixel8;
+
+void
+WebP_Premultiply(unsigned char *rgba, long long len)
+{
+	RGBApixel8 *buf = (RGBApixel8 *)rgba;
+	
+	while(len--)
+	{
+		if(buf->a != 255)
+		{	
+			float mult = (float)buf->a / 255.f;
+			
+			buf->r = ((float)buf->r * mult) + 0.5f;
+			buf->g = ((float)buf->g * mult) + 0.5f;
+			buf->b = ((float)buf->b * mult) + 0.5f;
+		}
+		
+		buf++;
+	}
+}
+
+
+void
+WebP_AlphaCleanup(unsigned char *rgba, long long len)
+{
+	// could use WebPCleanupTransparentArea(), but will just do this myself
+	RGBApixel8 *buf = (RGBApixel8 *)rgba;
+	
+	while(len--)
+	{
+		if(buf->a == 0)
+		{	
+			buf->r = buf->g = buf->b = 0;
+		}
+		
+		buf++;
+	}
+}
+
+
+typedef struct {
+	WebP_ProgressProc	progress;
+	void				*refcon;
+} ProgressData;
+
+static int
+ProgressReport(int percent, const WebPPicture* const picture)
+{
+	const ProgressData *progress_data = (const ProgressData *)picture->user_data;
+	
+	return progress_data->progress(percent, progress_data->refcon);
+}
+
+
+static void
+SetChunk(WebPMux *mux, const char *fourcc, const std::vector<unsigned char> &chunk)
+{
+	if(chunk.size() > 0)
+	{
+		WebPData chunk_data = { &chunk[0], chunk.size() };
+		
+		WebPMuxError chunk_err = WebPMuxSetChunk(mux, fourcc, &chunk_data, 1);
+		
+		assert(chunk_err == WEBP_MUX_OK);
+	}
+}
+
+
+bool
+WebP_Encode(const unsigned char *rgb, int width, int height, long rowbytes, bool alpha,
+				const WebP_EncodeOptions &options, const WebP_Metadata *metadata,
+				WebP_ProgressProc progress, void *refcon,
+				std::vector<unsigned char> &out)
+{
+	bool result = false;
+	
+	WebPMux *mux = WebPMuxNew();
+	
+	if(mux)
+	{
+		WebPPicture picture;
+		WebPPictureInit(&picture);
+		
+		picture.width = width;
+		picture.height = height;
+		picture.use_argb = 1;
+		
+		int ok = alpha ? WebPPictureImportRGBA(&picture, (const uint8_t *)rgb, rowbytes) :
+							WebPPictureImportRGB(&picture, (const uint8_t *)rgb, rowbytes);
+		
+		if(ok)
+		{
+			WebPMemoryWriter memory_writer;
+			WebPMemoryWriterInit(&memory_writer);
+		
+			WebPConfig config;
+			WebPConfigInit(&config);
+			
+			config.thread_level = 1;
+			config.lossless = options.lossless;
+			config.quality = options.quality;
+			config.method = options.method;
+			
+			if(alpha && !options.lossless && options.lossy_alpha)
+				config.alpha_quality = options.quality;
+			
+			ProgressData progress_data = { progress, refcon };
+			
+			if(progress != NULL)
+			{
+				picture.progress_hook = ProgressReport;
+				picture.user_data = &progress_data;
+			}
+			
+			picture.writer = WebPMemoryWrite;
+			picture.custom_ptr = &memory_writer;
+			
+			int success = WebPEncode(&config, &picture);
+			
+			if(success)
+			{
+				WebPData image_data = { memory_writer.mem, memory_writer.size };
+			
+				WebPMuxError img_err = WebPMuxSetImage(mux, &image_data, 0);
+				
+				if(img_err == WEBP_MUX_OK)
+				{
+					if(metadata != NULL)
+					{
+						SetChunk(mux, "ICCP", metadata->icc);
+						SetChunk(mux, "EXIF", metadata->exif);
+						SetChunk(mux, "XMP ", metadata->xmp);
+					}
+					
+					// assemble the file
+					WebPData output_data;
+					
+					WebPMuxError err = WebPMuxAssemble(mux, &output_data);
+					
+					if(err == WEBP_MUX_OK)
+					{
+						out.assign(output_data.bytes, output_data.bytes + output_data.size);
+						
+						WebPDataClear(&output_data);
+						
+						result = true;
+					}
+				}
+			}
+			
+			if(memory_writer.mem)
+				free(memory_writer.mem);
+			
+			WebPPictureFree(&picture);
+		}
+	
+		WebPMuxDelete(mux);
+	}
+	
+	return result;
+}
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBP_CODEC_H
+#define WEBP_CODEC_H
+
+// Reading and writing WebP stills, minus the host.  The Photoshop plug-in
+// gets the file into memory and the pixels out of the document, and we do
+// the rest.  Pixels are 8-bit RGB or RGBA, top row first.
+
+#include <stddef.h>
+
+#include <vector>
+
+
+typedef struct {
+	std::vector<unsigned char>	icc;
+	std::vector<unsigned char>	exif;
+	std::vector<unsigned char>	xmp;
+} WebP_Metadata;
+
+
+typedef struct {
+	int				width;
+	int				height;
+	bool			has_alpha;	// really has it, not just flagged
+	int				frame_count;
+	WebP_Metadata	metadata;
+} WebP_Info;
+
+bool WebP_GetInfo(const unsigned char *data, size_t size, WebP_Info &info);
+
+// Decodes the first frame into rgb, which is width x height
+bool WebP_Decode(const unsigned char *data, size_t size,
+					unsigned char *rgb, int width, int height, long rowbytes, bool alpha);
+
+
+// Alpha helpers, len is in pixels
+void WebP_Premultiply(unsigned char *rgba, long long len);
+
+// Clear the color under fully transparent pixels, so it compresses better
+void WebP_AlphaCleanup(unsigned char *rgba, long long len);
+
+
+typedef struct {
+	bool	lossless;
+	int		quality;		// 0..100
+	bool	lossy_alpha;	// compress the alpha at quality too (lossy only)
+	int		method;			// 0 (fast) .. 6 (small)
+} WebP_EncodeOptions;
+
+// Return false to cancel
+typedef bool (*WebP_ProgressProc)(int percent, void *refcon);
+
+// The whole file ends up in out.  metadata can be NULL.
+bool WebP_Encode(const unsigned char *rgb, int width, int height, long rowbytes, bool alpha,
+					const WebP_EncodeOptions &options, const WebP_Metadata *metadata,
+					WebP_ProgressProc progress, void *refcon,
+					std::vector<unsigned char> &out);
+
+
+#endif // WEBP_CODEC_H
@@ -42,10 +42,7 @@
 #include "WebP_UI.h"
 
 
-#include "webp/demux.h"
-#include "webp/mux.h"
-#include "webp/decode.h"
-#include "webp/encode.h"
+#include "WebP_Codec.h"
 
 #include <stdio.h>
 #include <assert.h>
@@ -438,34 +435,11 @@ static void DoReadStart(GPtr globals)
 			
 			if(file_size == my_fread(globals, buf, file_size))
 			{
-				WebPData webp_data = { (const uint8_t *)buf, file_size };
-
-				WebPDemuxer *demux = WebPDemux(&webp_data);
-
-				if(demux)
+				WebP_Info info;
+				
+				if( WebP_GetInfo((const unsigned char *)buf, file_size, info) )
 				{
-					uint32_t width = WebPDemuxGetI(demux, WEBP_FF_CANVAS_WIDTH);
-					uint32_t height = WebPDemuxGetI(demux, WEBP_FF_CANVAS_HEIGHT);
-					uint32_t flags = WebPDemuxGetI(demux, WEBP_FF_FORMAT_FLAGS);
-					
-					bool has_alpha = (flags & ALPHA_FLAG);
-					
-					// check the bitstream to see if we REALLY have an alpha
-					// (lossless images are always compressed with an alpha)
-					WebPIterator iter;
-					
-					if(has_alpha && WebPDemuxGetFrame(demux, 0, &iter) )
-					{
-						WebPBitstreamFeatures features;
-					
-						VP8StatusCode status = WebPGetFeatures(iter.fragment.bytes, iter.fragment.size, &features);
-						
-						has_alpha = features.has_alpha;
-						
-						WebPDemuxReleaseIterator(&iter);
-					}
-
-					assert(WebPDemuxGetI(demux, WEBP_FF_FRAME_COUNT) >= 1);
+					const bool has_alpha = info.has_alpha;
 					
 
 					if(!reverting)
@@ -501,8 +475,8 @@ static void DoReadStart(GPtr globals)
 						gStuff->imageMode = plugInModeRGBColor;
 						gStuff->depth = 8;
 
-						gStuff->imageSize.h = gStuff->imageSize32.h = width;
-						gStuff->imageSize.v = gStuff->imageSize32.v = height;
+						gStuff->imageSize.h = gStuff->imageSize32.h = info.width;
+						gStuff->imageSize.v = gStuff->imageSize32.v = info.height;
 						
 						gStuff->planes = (has_alpha ? 4 : 3);
 						
@@ -513,66 +487,56 @@ static void DoReadStart(GPtr globals)
 						}
 						
 						
-						WebPChunkIterator chunk_iter;
-						
-						if(gStuff->canUseICCProfiles && (flags & ICCP_FLAG) && WebPDemuxGetChunk(demux, "ICCP", 1, &chunk_iter) )
+						if(gStuff->canUseICCProfiles && info.metadata.icc.size() > 0)
 						{
-							gStuff->iCCprofileSize = chunk_iter.chunk.size;
+							gStuff->iCCprofileSize = info.metadata.icc.size();
 							gStuff->iCCprofileData = myNewHandle(globals, gStuff->iCCprofileSize);
 							
 							if(gStuff->iCCprofileData)
 							{
 								Ptr iccP = myLockHandle(globals, gStuff->iCCprofileData);
 								
-								memcpy(iccP, chunk_iter.chunk.bytes, gStuff->iCCprofileSize);
+								memcpy(iccP, &info.metadata.icc[0], gStuff->iCCprofileSize);
 								
 								myUnlockHandle(globals, gStuff->iCCprofileData);
 							}
-							
-							WebPDemuxReleaseChunkIterator(&chunk_iter);
 						}
 						
 						if(gStuff->propertyProcs && PISetProp)
 						{
-							if( (flags & EXIF_FLAG) && WebPDemuxGetChunk(demux, "EXIF", 1, &chunk_iter) )
+							if(info.metadata.exif.size() > 0)
 							{
-								Handle exif_handle = myNewHandle(globals, chunk_iter.chunk.size);
+								Handle exif_handle = myNewHandle(globals, info.metadata.exif.size());
 								
 								if(exif_handle)
 								{
 									Ptr exifP = myLockHandle(globals, exif_handle);
 									
-									memcpy(exifP, chunk_iter.chunk.bytes, chunk_iter.chunk.size);
+									memcpy(exifP, &info.metadata.exif[0], info.metadata.exif.size());
 									
 									myUnlockHandle(globals, exif_handle);
 									
 									PISetProp(kPhotoshopSignature, propEXIFData, 0, NULL, exif_handle);
 								}
-								
-								WebPDemuxReleaseChunkIterator(&chunk_iter);
 							}
 
-							if( (flags & XMP_FLAG) && WebPDemuxGetChunk(demux, "XMP ", 1, &chunk_iter) )
+							if(info.metadata.xmp.size() > 0)
 							{
-								Handle xmp_handle = myNewHandle(globals, chunk_iter.chunk.size);
+								Handle xmp_handle = myNewHandle(globals, info.metadata.xmp.size());
 								
 								if(xmp_handle)
 								{
 									Ptr xmpP = myLockHandle(globals, xmp_handle);
 									
-									memcpy(xmpP, chunk_iter.chunk.bytes, chunk_iter.chunk.size);
+									memcpy(xmpP, &info.metadata.xmp[0], info.metadata.xmp.size());
 									
 									myUnlockHandle(globals, xmp_handle);
 									
 									PISetProp(kPhotoshopSignature, propXMP, 0, NULL, xmp_handle);
 								}
-								
-								WebPDemuxReleaseChunkIterator(&chunk_iter);
 							}
 						}
 					}
-					
-					WebPDemuxDelete(demux);
 				}
 				else
 					gResult = formatCannotRead;
@@ -596,30 +560,6 @@ static void DoReadStart(GPtr globals)
 }
 
 
-typedef struct {
-	unsigned8	r;
-	unsigned8	g;
-	unsigned8	b;
-	unsigned8	a;
-} RGBApixel8;
-
-static void Premultiply(RGBApixel8 *buf, int64 len)
-{
-	while(len--)
-	{
-		if(buf->a != 255)
-		{	
-			float mult = (float)buf->a / 255.f;
-			
-			buf->r = ((float)buf->r * mult) + 0.5f;
-			buf->g = ((float)buf->g * mult) + 0.5f;
-			buf->b = ((float)buf->b * mult) + 0.5f;
-		}
-		
-		buf++;
-	}
-}
-
 static void DoReadContinue(GPtr globals)
 {
 	if(globals->fileH)
@@ -628,93 +568,50 @@ static void DoReadContinue(GPtr globals)
 		
 		Ptr data = myLockHandle(globals, globals->fileH);
 		
-
-		WebPData webp_data = { (const uint8_t *)data, data_size };
-
-		WebPDemuxer *demux = WebPDemux(&webp_data);
-
-		if(demux)
+		
+		int32 rowbytes = sizeof(unsigned char) * gStuff->planes * gStuff->imageSize.h;
+		int32 buffer_size = rowbytes * gStuff->imageSize.v;
+		
+		BufferID bufferID = 0;
+		
+		gResult = myAllocateBuffer(globals, buffer_size, &bufferID);
+		
+		if(gResult == noErr)
 		{
-			WebPIterator iter;
+			gStuff->data = myLockBuffer(globals, bufferID, TRUE);
 			
-			if( WebPDemuxGetFrame(demux, 0, &iter) )
+			const bool ok = WebP_Decode((const unsigned char *)data, data_size,
+										(unsigned char *)gStuff->data, gStuff->imageSize.h, gStuff->imageSize.v, rowbytes,
+										(gStuff->planes == 4));
+			
+			if(ok)
 			{
-				WebPDecoderConfig config;
-				WebPInitDecoderConfig(&config);
-				
-				config.options.use_threads = TRUE;
-				
-				VP8StatusCode status = WebPGetFeatures(iter.fragment.bytes, iter.fragment.size, &config.input);
-				
-				if(status == VP8_STATUS_OK)
+				if(gStuff->planes == 4 && gInOptions.alpha == WEBP_ALPHA_CHANNEL && gInOptions.mult == TRUE)
 				{
-					WebPDecBuffer* const output_buffer = &config.output;
-					
-					output_buffer->colorspace = (gStuff->planes == 4 ? MODE_RGBA : MODE_RGB);
-					output_buffer->width = gStuff->imageSize.h;
-					output_buffer->height = gStuff->imageSize.v;
-					output_buffer->is_external_memory = TRUE;
-					
-					int32 rowbytes = sizeof(unsigned char) * gStuff->planes * gStuff->imageSize.h;
-					int32 buffer_size = rowbytes * gStuff->imageSize.v;
-					
-					BufferID bufferID = 0;
-					
-					gResult = myAllocateBuffer(globals, buffer_size, &bufferID);
-					
-					if(gResult == noErr)
-					{
-						gStuff->data = myLockBuffer(globals, bufferID, TRUE);
-						
-						WebPRGBABuffer *buf_info = &output_buffer->u.RGBA;
-						
-						buf_info->rgba = (uint8_t *)gStuff->data;
-						buf_info->stride = rowbytes;
-						buf_info->size = buffer_size;
-						
-						
-						status = WebPDecode((const uint8_t *)iter.fragment.bytes, iter.fragment.size, &config);
-						
-						if(status == VP8_STATUS_OK)
-						{
-							if(gStuff->planes == 4 && gInOptions.alpha == WEBP_ALPHA_CHANNEL && gInOptions.mult == TRUE)
-							{
-								Premultiply((RGBApixel8 *)gStuff->data, gStuff->imageSize.h * gStuff->imageSize.v);
-							}
-						
-							gStuff->planeBytes = 1;
-							gStuff->colBytes = gStuff->planeBytes * gStuff->planes;
-							gStuff->rowBytes = rowbytes;
-							
-							gStuff->loPlane = 0;
-							gStuff->hiPlane = gStuff->planes - 1;
-									
-							gStuff->theRect.left = gStuff->theRect32.left = 0;
-							gStuff->theRect.right = gStuff->theRect32.right = gStuff->imageSize.h;
-							
-							gStuff->theRect.top = gStuff->theRect32.top = 0;
-							gStuff->theRect.bottom = gStuff->theRect32.bottom = gStuff->imageSize.v;
-							
-							gResult = AdvanceState();
-						}
-						else
-							gResult = formatCannotRead;
-						
-						
-						myFreeBuffer(globals, bufferID);
-					}
+					WebP_Premultiply((unsigned char *)gStuff->data, (int64)gStuff->imageSize.h * gStuff->imageSize.v);
 				}
+			
+				gStuff->planeBytes = 1;
+				gStuff->colBytes = gStuff->planeBytes * gStuff->planes;
+				gStuff->rowBytes = rowbytes;
 				
-				WebPDemuxReleaseIterator(&iter);
+				gStuff->loPlane = 0;
+				gStuff->hiPlane = gStuff->planes - 1;
+						
+				gStuff->theRect.left = gStuff->theRect32.left = 0;
+				gStuff->theRect.right = gStuff->theRect32.right = gStuff->imageSize.h;
+				
+				gStuff->theRect.top = gStuff->theRect32.top = 0;
+				gStuff->theRect.bottom = gStuff->theRect32.bottom = gStuff->imageSize.v;
+				
+				gResult = AdvanceState();
 			}
 			else
 				gResult = formatCannotRead;
 			
 			
-			WebPDemuxDelete(demux);
+			myFreeBuffer(globals, bufferID);
 		}
-		else
-			gResult = formatCannotRead;
 		
 		
 		myUnlockHandle(globals, globals->fileH);
@@ -865,9 +762,9 @@ static void DoWritePrepare(GPtr globals)
 }
 
 
-static int ProgressReport(int percent, const WebPPicture* const picture)
+static bool ProgressReport(int percent, void *refcon)
 {
-	GPtr globals = (GPtr)picture->user_data;
+	GPtr globals = (GPtr)refcon;
 	
 	PIUpdateProgress(percent, 100);
 	
@@ -875,19 +772,6 @@ static int ProgressReport(int percent, const WebPPicture* const picture)
 }
 
 
-static void AlphaCleanup(RGBApixel8 *buf, int64 len)
-{
-	while(len--)
-	{
-		if(buf->a == 0)
-		{	
-			buf->r = buf->g = buf->b = 0;
-		}
-		
-		buf++;
-	}
-}
-
 static void DoWriteStart(GPtr globals)
 {
 	ReadParams(globals, &gOptions);
@@ -961,145 +845,83 @@ static void DoWriteStart(GPtr globals)
 		
 		if(gResult == noErr && use_transparency && gOptions.alpha_cleanup)
 		{
-			// could use WebPCleanupTransparentArea(), but will just do this myself
-			AlphaCleanup((RGBApixel8 *)gStuff->data, width * height);
+			WebP_AlphaCleanup((unsigned char *)gStuff->data, (int64)width * height);
 		}
 		
 		
 		if(gResult == noErr)
 		{
-			WebPMux *mux = WebPMuxNew();
+			WebP_EncodeOptions options;
 			
-			if(mux)
+			options.lossless = gOptions.lossless;
+			options.quality = gOptions.quality;
+			options.lossy_alpha = gOptions.lossy_alpha;
+			options.method = 6;
+			
+			WebP_Metadata metadata;
+			
+			if(gOptions.save_metadata)
 			{
-				WebPPicture picture;
-				WebPPictureInit(&picture);
-				
-				picture.width = width;
-				picture.height = height;
-				picture.use_argb = TRUE;
-				
-				int ok = use_alpha ? WebPPictureImportRGBA(&picture, (const uint8_t *)gStuff->data, gStuff->rowBytes) :
-										WebPPictureImportRGB(&picture, (const uint8_t *)gStuff->data, gStuff->rowBytes);
-				
-				if(ok)
+				if(gStuff->canUseICCProfiles && (gStuff->iCCprofileSize > 0) && (gStuff->iCCprofileData != NULL))
 				{
-					WebPMemoryWriter memory_writer;
-					WebPMemoryWriterInit(&memory_writer);
-				
-					WebPConfig config;
-					WebPConfigInit(&config);
+					const unsigned char *iccP = (const unsigned char *)myLockHandle(globals, gStuff->iCCprofileData);
 					
-					config.thread_level = TRUE;
-					config.lossless = gOptions.lossless;
-					config.quality = gOptions.quality;
-					config.method = 6;
+					metadata.icc.assign(iccP, iccP + myGetHandleSize(globals, gStuff->iCCprofileData));
+					
+					myUnlockHandle(globals, gStuff->iCCprofileData);
+				}
+			
+				if(gStuff->propertyProcs && PIGetProp)
+				{
+					intptr_t simp;
 					
-					if(use_alpha && !gOptions.lossless && gOptions.lossy_alpha)
-						config.alpha_quality = gOptions.quality;
 					
-					picture.progress_hook = ProgressReport;
-					picture.user_data = globals;
-					picture.writer = WebPMemoryWrite;
-					picture.custom_ptr = &memory_writer;
+					Handle exif_handle = NULL;
 					
-					int success = WebPEncode(&config, &picture);
+					PIGetProp(kPhotoshopSignature, propEXIFData, 0, &simp, &exif_handle);
 					
-					if(success && gResult == noErr)
+					if(exif_handle)
 					{
-						WebPData image_data = { memory_writer.mem, memory_writer.size };
-					
-						WebPMuxError img_err = WebPMuxSetImage(mux, &image_data, FALSE);
+						const unsigned char *exifP = (const unsigned char *)myLockHandle(globals, exif_handle);
 						
-						if(img_err == WEBP_MUX_OK)
-						{
-							if(gOptions.save_metadata)
-							{
-								if(gStuff->canUseICCProfiles && (gStuff->iCCprofileSize > 0) && (gStuff->iCCprofileData != NULL))
-								{
-									WebPData chunk_data;
-									
-									chunk_data.bytes = (const uint8_t *)myLockHandle(globals, gStuff->iCCprofileData);
-									chunk_data.size = myGetHandleSize(globals, gStuff->iCCprofileData);
-												
-									WebPMuxError chunk_err = WebPMuxSetChunk(mux, "ICCP", &chunk_data, TRUE);
-									
-									myUnlockHandle(globals, gStuff->iCCprofileData);
-								}
-							
-								if(gStuff->propertyProcs && PIGetProp)
-								{
-									intptr_t simp;
-									
-									
-									Handle exif_handle = NULL;
-									
-									PIGetProp(kPhotoshopSignature, propEXIFData, 0, &simp, &exif_handle);
-									
-									if(exif_handle)
-									{
-										WebPData chunk_data;
-										
-										chunk_data.bytes = (const uint8_t *)myLockHandle(globals, exif_handle);
-										chunk_data.size = myGetHandleSize(globals, exif_handle);
-										
-										WebPMuxError chunk_err = WebPMuxSetChunk(mux, "EXIF", &chunk_data, TRUE);
-										
-										myDisposeHandle(globals, exif_handle);
-									}
-
-
-									Handle xmp_handle = NULL;
-									
-									PIGetProp(kPhotoshopSignature, propXMP, 0, &simp, &xmp_handle);
-									
-									if(xmp_handle)
-									{
-										WebPData chunk_data;
-										
-										chunk_data.bytes = (const uint8_t *)myLockHandle(globals, xmp_handle);
-										chunk_data.size = myGetHandleSize(globals, xmp_handle);
-										
-										WebPMuxError chunk_err = WebPMuxSetChunk(mux, "XMP ", &chunk_data, TRUE);
-										
-										myDisposeHandle(globals, xmp_handle);
-									}
-								}
-							}
-							
-							// assemble and write the file
-							WebPData output_data;
-							
-							WebPMuxError err = WebPMuxAssemble(mux, &output_data);
-							
-							if(err == WEBP_MUX_OK)
-							{
-								bool ok = my_fwrite(globals, output_data.bytes, output_data.size);
-								
-								WebPDataClear(&output_data);
-								
-								if(!ok)
-									gResult = writErr; // or maybe dskFulErr
-							}
-							else
-								gResult = formatBadParameters;
-						}
-						else
-							gResult = formatBadParameters;
+						metadata.exif.assign(exifP, exifP + myGetHandleSize(globals, exif_handle));
+						
+						myDisposeHandle(globals, exif_handle);
 					}
-					else if(gResult == noErr)
+
+
+					Handle xmp_handle = NULL;
+					
+					PIGetProp(kPhotoshopSignature, propXMP, 0, &simp, &xmp_handle);
+					
+					if(xmp_handle)
 					{
-						gResult = formatBadParameters;
+						const unsigned char *xmpP = (const unsigned char *)myLockHandle(globals, xmp_handle);
+						
+						metadata.xmp.assign(xmpP, xmpP + myGetHandleSize(globals, xmp_handle));
+						
+						myDisposeHandle(globals, xmp_handle);
 					}
-					
-					if(memory_writer.mem)
-						free(memory_writer.mem);
 				}
+			}
+			
+			std::vector<unsigned char> output_data;
 			
-				WebPMuxDelete(mux);
+			const bool success = WebP_Encode((const unsigned char *)gStuff->data, width, height, gStuff->rowBytes, use_alpha,
+												options, &metadata, ProgressReport, globals, output_data);
+			
+			if(success && gResult == noErr)
+			{
+				// write the file
+				bool ok = my_fwrite(globals, &output_data[0], output_data.size());
+				
+				if(!ok)
+					gResult = writErr; // or maybe dskFulErr
 			}
-			else
+			else if(gResult == noErr)
+			{
 				gResult = formatBadParameters;
+			}
 		}
 		
 		myFreeBuffer(globals, bufferID);
@@ -42,37 +42,21 @@
 
 #include "WebM_Premiere_Export_Params.h"
 
+#include "WebM_Export.h"
 
-#ifdef PRMAC_ENV
-	#include <mach/mach.h>
-#else
-	#include <assert.h>
-	#include <time.h>
-	#include <sys/timeb.h>
-#endif
+#include "WebM_Passthrough.h"
 
+#include <assert.h>
 
-extern "C" {
+#include <vector>
 
-#include "vpx/vpx_encoder.h"
-#include "vpx/vp8cx.h"
 
-#include <vorbis/codec.h>
-#include <vorbis/vorbisenc.h>
-
-}
-
-#include "mkvmuxer.hpp"
-
-
-
-using mkvmuxer::uint8;
 using mkvmuxer::int32;
 using mkvmuxer::uint32;
 using mkvmuxer::int64;
 using mkvmuxer::uint64;
 
-class PrMkvWriter : public mkvmuxer::IMkvWriter
+class PrMkvWriter : public WebM_MkvWriter
 {
   public:
 	PrMkvWriter(PrSDKExportFileSuite *fileSuite, csSDK_uint32 fileObject);
@@ -82,17 +66,19 @@ class PrMkvWriter : public mkvmuxer::IMkvWriter
 	virtual int64 Position() const;
 	virtual int32 Position(int64 position); // seek
 	virtual bool Seekable() const { return true; }
-	virtual void ElementStartNotify(uint64 element_id, int64 position);
 	
   private:
 	const PrSDKExportFileSuite *_fileSuite;
 	const csSDK_uint32 _fileObject;
 	
+	// keeping track ourselves so we don't have to ask Premiere after every write
+	int64 _pos;
 };
 
 PrMkvWriter::PrMkvWriter(PrSDKExportFileSuite *fileSuite, csSDK_uint32 fileObject) :
 	_fileSuite(fileSuite),
-	_fileObject(fileObject)
+	_fileObject(fileObject),
+	_pos(0)
 {
 	prSuiteError err = _fileSuite->Open(_fileObject);
 	
@@ -110,6 +96,14 @@ PrMkvWriter::Write(const void* buf, uint32 len)
 {
 	prSuiteError err = _fileSuite->Write(_fileObject, (void *)buf, len);
 	
+	if(err == malNoError)
+	{
+		_pos += len;
+		
+		if(_pos > _layout.size)
+			_layout.size = _pos;
+	}
+	
 	return err;
 }
 
@@ -134,16 +128,12 @@ PrMkvWriter::Position(int64 position)
 
 	prSuiteError err = _fileSuite->Seek(_fileObject, position, pos, fileSeekMode_Begin);
 	
+	if(err == malNoError)
+		_pos = position;
+	
 	return err;
 }
 
-void
-PrMkvWriter::ElementStartNotify(uint64 element_id, int64 position)
-{
-	// ummm, should I do something?
-}
-
-
 #pragma mark-
 
 
@@ -317,6 +307,10 @@ exSDKEndInstance(
 	PrSDKMemoryManagerSuite	*memorySuite;
 	if(spBasic != NULL && lRec != NULL)
 	{
+		if(lRec->smartRender)
+		{
+			WebM_PassthroughEnd();
+		}
 		if (lRec->exportParamSuite)
 		{
 			result = spBasic->ReleaseSuite(kPrSDKExportParamSuite, kPrSDKExportParamSuiteVersion);
@@ -385,95 +379,219 @@ exSDKFileExtension(
 }
 
 
-static void get_framerate(PrTime ticksPerSecond, PrTime ticks_per_frame, exRatioValue *fps)
+// What the export pipeline needs from Premiere: rendered frames, audio,
+// the file and the progress bar.  Premiere's own error codes stay here,
+// the pipeline just hears WEBM_ERR_HOST.
+class PremiereExportHost : public WebM_ExportHost
+{
+  public:
+	PremiereExportHost(ExportSettings *mySettings, exDoExportRec *exportInfoP,
+						csSDK_uint32 videoRenderID, csSDK_uint32 audioRenderID,
+						SequenceRender_ParamsRec &renderParms);
+	virtual ~PremiereExportHost() {}
+	
+	virtual WebM_MkvWriter * OpenWriter();
+	virtual void CloseWriter(WebM_MkvWriter *writer);
+	
+	virtual WebM_Result RenderFrame(long long time, WebM_HostFrame &frame);
+	virtual void ReleaseFrame(WebM_HostFrame &frame);
+	
+	virtual WebM_Result GetAudio(int samples, float **buffers);
+	virtual int MaxAudioBlip(long long ticks);
+	
+	virtual WebM_Result Progress(float progress);
+	virtual void Message(const char *message);
+	
+	prMALError Error() const { return (_error != malNoError ? _error : _audio_error); }
+	
+  private:
+	ExportSettings * const _mySettings;
+	exDoExportRec * const _exportInfoP;
+	const csSDK_uint32 _videoRenderID;
+	const csSDK_uint32 _audioRenderID;
+	SequenceRender_ParamsRec &_renderParms;
+	
+	prMALError _error;
+	prMALError _audio_error; // from the audio thread
+};
+
+
+PremiereExportHost::PremiereExportHost(ExportSettings *mySettings, exDoExportRec *exportInfoP,
+										csSDK_uint32 videoRenderID, csSDK_uint32 audioRenderID,
+										SequenceRender_ParamsRec &renderParms) :
+	_mySettings(mySettings),
+	_exportInfoP(exportInfoP),
+	_videoRenderID(videoRenderID),
+	_audioRenderID(audioRenderID),
+	_renderParms(renderParms),
+	_error(malNoError),
+	_audio_error(malNoError)
+{
+
+}
+
+
+WebM_MkvWriter *
+PremiereExportHost::OpenWriter()
+{
+	try{
+		return new PrMkvWriter(_mySettings->exportFileSuite, _exportInfoP->fileObject);
+	}
+	catch(prSuiteError err)
+	{
+		_error = err;
+		
+		return NULL;
+	}
+}
+
+
+void
+PremiereExportHost::CloseWriter(WebM_MkvWriter *writer)
+{
+	delete writer;
+}
+
+
+WebM_Result
+PremiereExportHost::RenderFrame(long long time, WebM_HostFrame &frame)
 {
-	PrTime frameRates[] = {	10, 15, 23,
-							24, 25, 29,
-							30, 50, 59,
-							60};
-													
-	PrTime frameRateNumDens[][2] = {{10, 1}, {15, 1}, {24000, 1001},
-									{24, 1}, {25, 1}, {30000, 1001},
-									{30, 1}, {50, 1}, {60000, 1001},
-									{60, 1}};
-	
-	int frameRateIndex = -1;
-	
-	for(csSDK_int32 i=0; i < sizeof(frameRates) / sizeof (PrTime); i++)
+	PrSDKPPixSuite *pixSuite = _mySettings->ppixSuite;
+	
+	SequenceRender_GetFrameReturnRec renderResult;
+	
+	prMALError result = _mySettings->sequenceRenderSuite->RenderVideoFrame(_videoRenderID,
+																			time,
+																			&_renderParms,
+																			kRenderCacheType_None,
+																			&renderResult);
+	
+	if(result != suiteError_NoError)
 	{
-		frameRates[i] = ticksPerSecond / frameRateNumDens[i][0] * frameRateNumDens[i][1];
+		assert(false); // error retreiving frame?
+		
+		_error = result;
 		
-		if(ticks_per_frame == frameRates[i])
-			frameRateIndex = i;
+		return WEBM_ERR_HOST;
 	}
 	
-	if(frameRateIndex >= 0)
+	PrPixelFormat pixFormat;
+	prRect bounds;
+	
+	pixSuite->GetPixelFormat(renderResult.outFrame, &pixFormat);
+	pixSuite->GetBounds(renderResult.outFrame, &bounds);
+	
+	frame.width = bounds.right - bounds.left;
+	frame.height = bounds.bottom - bounds.top;
+	frame.host_data = renderResult.outFrame;
+	
+	if(pixFormat == PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709)
 	{
-		fps->numerator = frameRateNumDens[frameRateIndex][0];
-		fps->denominator = frameRateNumDens[frameRateIndex][1];
+		char *Y_PixelAddress, *U_PixelAddress, *V_PixelAddress;
+		csSDK_uint32 Y_RowBytes, U_RowBytes, V_RowBytes;
+		
+		_mySettings->ppix2Suite->GetYUV420PlanarBuffers(renderResult.outFrame, PrPPixBufferAccess_ReadOnly,
+														&Y_PixelAddress, &Y_RowBytes,
+														&U_PixelAddress, &U_RowBytes,
+														&V_PixelAddress, &V_RowBytes);
+		
+		frame.format = WEBM_FRAME_YUV420;
+		frame.data[0] = (unsigned char *)Y_PixelAddress;
+		frame.data[1] = (unsigned char *)U_PixelAddress;
+		frame.data[2] = (unsigned char *)V_PixelAddress;
+		frame.rowbytes[0] = Y_RowBytes;
+		frame.rowbytes[1] = U_RowBytes;
+		frame.rowbytes[2] = V_RowBytes;
 	}
 	else
 	{
-		fps->numerator = 1000 * ticksPerSecond / ticks_per_frame;
-		fps->denominator = 1000;
+		char *frameBufferP = NULL;
+		csSDK_int32 rowbytes = 0;
+		
+		pixSuite->GetPixels(renderResult.outFrame, PrPPixBufferAccess_ReadOnly, &frameBufferP);
+		pixSuite->GetRowBytes(renderResult.outFrame, &rowbytes);
+		
+		frame.format = (pixFormat == PrPixelFormat_BGRA_4444_16u ? WEBM_FRAME_BGRA16 : WEBM_FRAME_BGRA8);
+		frame.data[0] = (unsigned char *)frameBufferP;
+		frame.rowbytes[0] = rowbytes;
+		
+		// the rows in this kind of Premiere buffer are flipped, FYI (or is it flopped?)
+		frame.flipped = true;
 	}
+	
+	return WEBM_OK;
 }
 
 
-// converting from the Adobe 16-bit, i.e. max_val is 0x8000
-static inline unsigned char
-Convert16to8(const unsigned short &v)
+void
+PremiereExportHost::ReleaseFrame(WebM_HostFrame &frame)
 {
-	return ( (((long)(v) * 255) + 16384) / 32768);
+	if(frame.host_data != NULL)
+		_mySettings->ppixSuite->Dispose((PPixHand)frame.host_data);
+	
+	frame.host_data = NULL;
 }
 
 
-static int
-xiph_len(int l)
+WebM_Result
+PremiereExportHost::GetAudio(int samples, float **buffers)
 {
-    return 1 + l / 255 + l;
+	prMALError result = _mySettings->sequenceAudioSuite->GetAudio(_audioRenderID, samples, buffers, false);
+	
+	if(result != malNoError)
+	{
+		_audio_error = result;
+		
+		return WEBM_ERR_HOST;
+	}
+	
+	return WEBM_OK;
 }
 
-static void
-xiph_lace(unsigned char **np, uint64_t val)
-{
-	unsigned char *p = *np;
 
-	while(val >= 255)
-	{
-		*p++ = 255;
-		val -= 255;
-	}
+int
+PremiereExportHost::MaxAudioBlip(long long ticks)
+{
+	csSDK_int32 maxBlip = 100;
 	
-	*p++ = val;
+	_mySettings->sequenceAudioSuite->GetMaxBlip(_audioRenderID, ticks, &maxBlip);
 	
-	*np = p;
+	return maxBlip;
 }
 
-static void *
-MakePrivateData(ogg_packet &header, ogg_packet &header_comm, ogg_packet &header_code, size_t &size)
+
+WebM_Result
+PremiereExportHost::Progress(float progress)
 {
-	size = 1 + xiph_len(header.bytes) + xiph_len(header_comm.bytes) + header_code.bytes;
+	const csSDK_uint32 exID = _exportInfoP->exporterPluginID;
 	
-	void *buf = malloc(size);
+	prMALError result = _mySettings->exportProgressSuite->UpdateProgressPercent(exID, progress);
 	
-	if(buf)
+	if(result == suiteError_ExporterSuspended)
 	{
-		unsigned char *p = (unsigned char *)buf;
-		
-		*p++ = 2;
-		
-		xiph_lace(&p, header.bytes);
-		xiph_lace(&p, header_comm.bytes);
+		result = _mySettings->exportProgressSuite->WaitForResume(exID);
+	}
+	
+	if(result != malNoError)
+	{
+		_error = result;
 		
-		memcpy(p, header.packet, header.bytes);
-		p += header.bytes;
-		memcpy(p, header_comm.packet, header_comm.bytes);
-		p += header_comm.bytes;
-		memcpy(p, header_code.packet, header_code.bytes);
+		return WEBM_ERR_HOST;
 	}
 	
-	return buf;
+	return WEBM_OK;
+}
+
+
+void
+PremiereExportHost::Message(const char *message)
+{
+	prUTF16Char utf_str[256];
+	
+	utf16ncpy(utf_str, message, 255);
+	
+	// This doesn't seem to be doing anything
+	_mySettings->exportProgressSuite->SetProgressString(_exportInfoP->exporterPluginID, utf_str);
 }
 
 
@@ -488,10 +606,6 @@ exSDKExport(
 	PrSDKExportInfoSuite		*exportInfoSuite		= mySettings->exportInfoSuite;
 	PrSDKSequenceRenderSuite	*renderSuite			= mySettings->sequenceRenderSuite;
 	PrSDKSequenceAudioSuite		*audioSuite				= mySettings->sequenceAudioSuite;
-	PrSDKMemoryManagerSuite		*memorySuite			= mySettings->memorySuite;
-	PrSDKPPixCreatorSuite		*pixCreatorSuite		= mySettings->ppixCreatorSuite;
-	PrSDKPPixSuite				*pixSuite				= mySettings->ppixSuite;
-	PrSDKPPix2Suite				*pix2Suite				= mySettings->ppix2Suite;
 
 
 	PrTime ticksPerSecond = 0;
@@ -536,17 +650,13 @@ exSDKExport(
 	}
 	
 	exParamValues alphaP;
-	//paramSuite->GetParamValue(exID, gIdx, ADBEVideoAlpha, &alphaP);
-	alphaP.value.intValue = 0;
+	paramSuite->GetParamValue(exID, gIdx, ADBEVideoAlpha, &alphaP);
 	
 	exParamValues sampleRateP, channelTypeP;
 	paramSuite->GetParamValue(exID, gIdx, ADBEAudioRatePerSecond, &sampleRateP);
 	paramSuite->GetParamValue(exID, gIdx, ADBEAudioNumChannels, &channelTypeP);
 	
 	const PrAudioChannelType audioFormat = (PrAudioChannelType)channelTypeP.value.intValue;
-	const int audioChannels = (audioFormat == kPrAudioChannelType_51 ? 6 :
-								audioFormat == kPrAudioChannelType_Mono ? 1 :
-								2);
 	
 	exParamValues codecP, methodP, videoQualityP, bitrateP, vidEncodingP, customArgsP;
 	paramSuite->GetParamValue(exID, gIdx, WebMVideoCodec, &codecP);
@@ -556,26 +666,95 @@ exSDKExport(
 	paramSuite->GetParamValue(exID, gIdx, WebMVideoEncoding, &vidEncodingP);
 	paramSuite->GetParamValue(exID, gIdx, WebMCustomArgs, &customArgsP);
 	
-	WebM_Video_Method method = (WebM_Video_Method)methodP.value.intValue;
+	exParamValues budgetModeP, budgetMinutesP, budgetSpeedP;
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoBudgetMode, &budgetModeP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoBudgetMinutes, &budgetMinutesP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoBudgetSpeed, &budgetSpeedP);
 	
-	char customArgs[256];
-	ncpyUTF16(customArgs, customArgsP.paramString, 255);
-	customArgs[255] = '\0';
+	exParamValues renditionsP, proxyP, dashP, keyframeIntervalP;
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoRenditions, &renditionsP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoProxy, &proxyP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoDASH, &dashP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoKeyframeInterval, &keyframeIntervalP);
 	
+	exParamValues sceneCutsP, skipRepeatsP, smartRenderP;
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoSceneCuts, &sceneCutsP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoSkipRepeats, &skipRepeatsP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoSmartRender, &smartRenderP);
 
-	exParamValues audioMethodP, audioQualityP, audioBitrateP;
+	exParamValues audioCodecP, audioMethodP, audioQualityP, audioBitrateP;
+	paramSuite->GetParamValue(exID, gIdx, WebMAudioCodec, &audioCodecP);
 	paramSuite->GetParamValue(exID, gIdx, WebMAudioMethod, &audioMethodP);
 	paramSuite->GetParamValue(exID, gIdx, WebMAudioQuality, &audioQualityP);
 	paramSuite->GetParamValue(exID, gIdx, WebMAudioBitrate, &audioBitrateP);
 	
+	const bool opus = (audioCodecP.value.intValue == WEBM_CODEC_OPUS);
+	
+	// Opus only runs at 48k, and Premiere will resample for us
+	if(opus)
+		sampleRateP.value.floatValue = 48000.f;
+	
+	
+	WebM_ExportSettings settings;
+	WebM_InitExportSettings(settings);
+	
+	settings.export_video = exportInfoP->exportVideo;
+	settings.export_audio = exportInfoP->exportAudio;
+	
+	settings.ticks_per_second = ticksPerSecond;
+	settings.start_time = exportInfoP->startTime;
+	settings.end_time = exportInfoP->endTime;
+	
+	settings.width = widthP.value.intValue;
+	settings.height = heightP.value.intValue;
+	settings.frame_ticks = frameRateP.value.timeValue;
+	settings.alpha = alphaP.value.intValue;
+	
+	settings.codec = (WebM_Video_Codec)codecP.value.intValue;
+	settings.method = (WebM_Video_Method)methodP.value.intValue;
+	settings.quality = videoQualityP.value.intValue;
+	settings.bitrate = bitrateP.value.intValue;
+	settings.encoding = (WebM_Video_Encoding)vidEncodingP.value.intValue;
+	
+	ncpyUTF16(settings.custom_args, customArgsP.paramString, 255);
+	settings.custom_args[255] = '\0';
+	
+	settings.budget_mode = (WebM_Budget_Mode)budgetModeP.value.intValue;
+	settings.budget_minutes = budgetMinutesP.value.intValue;
+	settings.budget_speed = budgetSpeedP.value.floatValue;
+	
+	settings.renditions = renditionsP.value.intValue;
+	settings.proxy = proxyP.value.intValue;
+	settings.dash = dashP.value.intValue;
+	settings.keyframe_interval = keyframeIntervalP.value.intValue;
+	settings.scene_cuts = sceneCutsP.value.intValue;
+	settings.skip_repeats = skipRepeatsP.value.intValue;
+	settings.smart_render = smartRenderP.value.intValue;
+	
+	settings.num_cpus = g_num_cpus;
+	
+	settings.audio_codec = (WebM_Audio_Codec)audioCodecP.value.intValue;
+	settings.audio_method = (Ogg_Method)audioMethodP.value.intValue;
+	settings.audio_quality = audioQualityP.value.floatValue;
+	settings.audio_bitrate = audioBitrateP.value.intValue;
+	settings.sample_rate = sampleRateP.value.floatValue;
+	settings.channels = (audioFormat == kPrAudioChannelType_51 ? 6 :
+							audioFormat == kPrAudioChannelType_Mono ? 1 :
+							2);
+	
+	settings.writing_app = "fnord WebM for Premiere";
+	
+	
+	const bool alpha = (settings.alpha && settings.export_video);
 	
 	SequenceRender_ParamsRec renderParms;
 	PrPixelFormat pixelFormats[] = { PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709,
 									PrPixelFormat_BGRA_4444_16u, // must support BGRA, even if I don't want to
 									PrPixelFormat_BGRA_4444_8u };
 	
-	renderParms.inRequestedPixelFormatArray = pixelFormats;
-	renderParms.inRequestedPixelFormatArrayCount = 3;
+	// YUV has no alpha, so then we have to take BGRA
+	renderParms.inRequestedPixelFormatArray = (alpha ? &pixelFormats[1] : pixelFormats);
+	renderParms.inRequestedPixelFormatArrayCount = (alpha ? 2 : 3);
 	renderParms.inWidth = widthP.value.intValue;
 	renderParms.inHeight = heightP.value.intValue;
 	renderParms.inPixelAspectRatioNumerator = pixelAspectRatioP.value.ratioValue.numerator;
@@ -605,689 +784,24 @@ exSDKExport(
 												sampleRateP.value.floatValue, 
 												&audioRenderID);
 	}
-
 	
-	PrMemoryPtr vbr_buffer = NULL;
-	size_t vbr_buffer_size = 0;
-
-
-	try{
 	
-	const int passes = ( (exportInfoP->exportVideo && method == WEBM_METHOD_VBR) ? 2 : 1);
+	// where the movie is going, so we can put other files next to it
+	csSDK_int32 path_length = 0;
+	mySettings->exportFileSuite->GetPlatformPath(exportInfoP->fileObject, &path_length, NULL);
 	
-	for(int pass = 0; pass < passes && result == malNoError; pass++)
-	{
-		const bool vbr_pass = (passes > 1 && pass == 0);
-		
-
-		if(passes > 1)
-		{
-			prUTF16Char utf_str[256];
-		
-			if(vbr_pass)
-				utf16ncpy(utf_str, "Analyzing video", 255);
-			else
-				utf16ncpy(utf_str, "Encoding WebM movie", 255);
-			
-			// This doesn't seem to be doing anything
-			mySettings->exportProgressSuite->SetProgressString(exID, utf_str);
-		}
-		
-		
-	
-		exRatioValue fps;
-		get_framerate(ticksPerSecond, frameRateP.value.timeValue, &fps);
-		
-		
-		vpx_codec_err_t codec_err = VPX_CODEC_OK;
-		
-		vpx_codec_ctx_t encoder;
-		
-		if(exportInfoP->exportVideo)
-		{
-			vpx_codec_iface_t *iface = codecP.value.intValue == WEBM_CODEC_VP9 ? vpx_codec_vp9_cx() :
-										vpx_codec_vp8_cx();
-			
-			vpx_codec_enc_cfg_t config;
-			vpx_codec_enc_config_default(iface, &config, 0);
-			
-			config.g_w = renderParms.inWidth;
-			config.g_h = renderParms.inHeight;
-			
-			
-			if(method == WEBM_METHOD_QUALITY)
-			{
-				config.g_usage = config.rc_end_usage = VPX_CQ;
-				config.rc_target_bitrate = 1000000; // what they do in libvpxenc.c in FFmpeg
-			}
-			else
-			{
-				if(method == WEBM_METHOD_VBR)
-				{
-					config.g_usage = config.rc_end_usage = VPX_VBR;
-					
-					if(vbr_pass)
-					{
-						config.g_pass = VPX_RC_FIRST_PASS;
-					}
-					else
-					{
-						config.g_pass = VPX_RC_LAST_PASS;
-						
-						config.rc_twopass_stats_in.buf = vbr_buffer;
-						config.rc_twopass_stats_in.sz = vbr_buffer_size;
-					}
-				}
-				else
-				{
-					config.g_usage = config.rc_end_usage = VPX_CBR;
-					config.g_pass = VPX_RC_ONE_PASS;
-				}
-				
-				config.rc_target_bitrate = bitrateP.value.intValue;
-			}
-			
-			
-			config.g_threads = g_num_cpus;
-			
-			config.g_timebase.num = fps.denominator;
-			config.g_timebase.den = fps.numerator;
-			
-			ConfigureEncoderPre(config, customArgs);
-		
-		
-			codec_err = vpx_codec_enc_init(&encoder, iface, &config, 0);
-			
-			
-			if(codec_err == VPX_CODEC_OK)
-			{
-				if(method == WEBM_METHOD_QUALITY)
-				{
-					// our slider goes 0..100, quality goes 0..63, and it's reversed
-					int qual = ((float)videoQualityP.value.intValue * 63.f / 100.f) + 0.5f; // old formula for the header that says it's 0..63
-					int quan = (((float)(100 - videoQualityP.value.intValue) / 100.f) * (config.rc_max_quantizer - config.rc_min_quantizer)) + config.rc_min_quantizer + 0.5f;
-				
-					vpx_codec_err_t config_err = vpx_codec_control(&encoder, VP8E_SET_CQ_LEVEL, quan);
-					
-					assert(config_err == VPX_CODEC_OK);
-				}
-				
-				ConfigureEncoderPost(&encoder, customArgs);
-			}
-		}
-		
+	std::vector<prUTF16Char> main_path(path_length + 1, 0);
+	mySettings->exportFileSuite->GetPlatformPath(exportInfoP->fileObject, &path_length, &main_path[0]);
 	
-	#define OV_OK 0
-	
-		int v_err = OV_OK;
-	
-		vorbis_info vi;
-		vorbis_comment vc;
-		vorbis_dsp_state vd;
-		vorbis_block vb;
-		ogg_packet op;
-		
-		bool packet_waiting = false;
-		op.granulepos = 0;
-										
-		size_t private_size = 0;
-		void *private_data = NULL;
-		
-		csSDK_int32 maxBlip = 100;
-		
-		if(exportInfoP->exportAudio && !vbr_pass)
-		{
-			vorbis_info_init(&vi);
-			
-			if(audioMethodP.value.intValue == OGG_BITRATE)
-			{
-				v_err = vorbis_encode_init(&vi,
-											audioChannels,
-											sampleRateP.value.floatValue,
-											-1,
-											audioBitrateP.value.intValue * 1000,
-											-1);
-			}
-			else
-			{
-				v_err = vorbis_encode_init_vbr(&vi,
-												audioChannels,
-												sampleRateP.value.floatValue,
-												audioQualityP.value.floatValue);
-			}
-			
-			if(v_err == OV_OK)
-			{
-				vorbis_comment_init(&vc);
-				vorbis_analysis_init(&vd, &vi);
-				vorbis_block_init(&vd, &vb);
-				
-				
-				ogg_packet header;
-				ogg_packet header_comm;
-				ogg_packet header_code;
-				
-				vorbis_analysis_headerout(&vd, &vc, &header, &header_comm, &header_code);
-				
-				private_data = MakePrivateData(header, header_comm, header_code, private_size);
-			}
-			
-			mySettings->sequenceAudioSuite->GetMaxBlip(audioRenderID, frameRateP.value.timeValue, &maxBlip);
-		}
-		
-		
-		if(codec_err == VPX_CODEC_OK && v_err == OV_OK)
-		{
-			PrMkvWriter writer(mySettings->exportFileSuite, exportInfoP->fileObject);
-
-			mkvmuxer::Segment muxer_segment;
-			
-			muxer_segment.Init(&writer);
-			muxer_segment.set_mode(mkvmuxer::Segment::kFile);
-			
-			
-			mkvmuxer::SegmentInfo* const info = muxer_segment.GetSegmentInfo();
-			
-			info->set_writing_app("fnord WebM for Premiere");
-			
-			// I'd say think about lowering this to get better precision,
-			// but I get some messed up stuff when I do that.  Maybe a bug in the muxer?
-			long long timeCodeScale = 1000000UL;
-			
-			info->set_timecode_scale(timeCodeScale);
-			
-			
-			uint64 vid_track = 0;
-			
-			if(exportInfoP->exportVideo)
-			{
-				vid_track = muxer_segment.AddVideoTrack(renderParms.inWidth, renderParms.inHeight, 1);
-				
-				mkvmuxer::VideoTrack* const video = static_cast<mkvmuxer::VideoTrack *>(muxer_segment.GetTrackByNumber(vid_track));
-				
-				video->set_frame_rate((double)fps.numerator / (double)fps.denominator);
-
-				video->set_codec_id(codecP.value.intValue == WEBM_CODEC_VP9 ? "V_VP9" :
-										mkvmuxer::Tracks::kVp8CodecId);
-				
-				muxer_segment.CuesTrack(vid_track);
-			}
-			
-			
-			uint64 audio_track = 0;
-			
-			if(exportInfoP->exportAudio)
-			{
-				audio_track = muxer_segment.AddAudioTrack(sampleRateP.value.floatValue, audioChannels, 2);
-				
-				mkvmuxer::AudioTrack* const audio = static_cast<mkvmuxer::AudioTrack *>(muxer_segment.GetTrackByNumber(audio_track));
-				
-				audio->set_codec_id(mkvmuxer::Tracks::kVorbisCodecId);
-				
-				if(private_data)
-				{
-					bool copied = audio->SetCodecPrivate((const uint8 *)private_data, private_size);
-					
-					assert(copied);
-					
-					free(private_data);
-				}
-
-				if(!exportInfoP->exportVideo)
-					muxer_segment.CuesTrack(audio_track);
-			}
-			
-			PrAudioSample currentAudioSample = 0;
-			const PrAudioSample endAudioSample = exportInfoP->endTime * (PrAudioSample)sampleRateP.value.floatValue / ticksPerSecond;
-			
-		
-			PrTime videoTime = exportInfoP->startTime;
-			
-			while(videoTime < exportInfoP->endTime && result == malNoError)
-			{
-				const PrTime fileTime = videoTime - exportInfoP->startTime;
-				const PrTime nextFileTime = fileTime + frameRateP.value.timeValue;
-				
-				// this is for the encoder, which does its own math based on config.g_timebase
-				// let's do the math
-				// time = timestamp * timebase :: time = videoTime / ticksPerSecond : timebase = 1 / fps
-				// timestamp = time / timebase
-				// timestamp = (videoTime / ticksPerSecond) * (fps.num / fps.den)
-				const vpx_codec_pts_t encoder_timeStamp = fileTime * fps.numerator / (ticksPerSecond * fps.denominator);
-				const vpx_codec_pts_t encoder_nextTimeStamp = (nextFileTime - exportInfoP->startTime) * fps.numerator / (ticksPerSecond * fps.denominator);
-				const unsigned long encoder_duration = encoder_nextTimeStamp - encoder_timeStamp;
-				
-				
-				// This is the key step, where we quantize our time based on the timeCode
-				// to match how the frames are actually stored by the muxer.  If you want more precision,
-				// lower timeCodeScale.  Time (in nanoseconds) = TimeCode * TimeCodeScale.
-				const long long timeCode = ((fileTime * (1000000000UL / timeCodeScale)) + (ticksPerSecond / 2)) / ticksPerSecond;
-				const long long nextTimeCode = ((nextFileTime * (1000000000UL / timeCodeScale)) + (ticksPerSecond / 2)) / ticksPerSecond;
-				
-				const uint64_t timeStamp = timeCode * timeCodeScale;
-				const uint64_t nextTimeStamp = nextTimeCode * timeCodeScale;
-			
-				
-				if(exportInfoP->exportAudio && !vbr_pass)
-				{
-					const PrAudioSample nextBlockAudoSample = nextTimeStamp * (PrAudioSample)sampleRateP.value.floatValue / 1000000000UL;
-					
-					while(op.granulepos < nextBlockAudoSample && currentAudioSample < endAudioSample && result == malNoError)
-					{
-						if(packet_waiting && op.packet != NULL && op.bytes > 0)
-						{
-							bool added = muxer_segment.AddFrame(op.packet, op.bytes,
-																audio_track, timeStamp, 0);
-																	
-							if(added)
-							{
-								packet_waiting = false;
-								
-								// might also be extra blocks hanging around
-								while(vorbis_analysis_blockout(&vd, &vb) == 1)
-								{
-									vorbis_analysis(&vb, NULL);
-									vorbis_bitrate_addblock(&vb);
-									
-									while( vorbis_bitrate_flushpacket(&vd, &op) )
-									{
-										assert(packet_waiting == false);
-									
-										if(op.granulepos < nextBlockAudoSample)
-										{
-											bool added = muxer_segment.AddFrame(op.packet, op.bytes,
-																				audio_track, timeStamp, 0);
-																					
-											if(!added)
-												result = exportReturn_InternalError;
-										}
-										else
-											packet_waiting = true;
-									}
-									
-									if(packet_waiting)
-										break;
-								}
-							}
-							else
-								result = exportReturn_InternalError;
-						}
-						
-						
-						if(!packet_waiting)
-						{
-							int samples = maxBlip;
-							
-							if(samples > (endAudioSample - currentAudioSample))
-								samples = (endAudioSample - currentAudioSample);
-							
-							float **buffer = vorbis_analysis_buffer(&vd, samples);
-							
-							
-							result = audioSuite->GetAudio(audioRenderID, samples, buffer, false);
-							
-							currentAudioSample += samples;
-							
-							
-							if(result == malNoError)
-							{
-								vorbis_analysis_wrote(&vd, samples);
-						
-								while(vorbis_analysis_blockout(&vd, &vb) == 1)
-								{
-									vorbis_analysis(&vb, NULL);
-									vorbis_bitrate_addblock(&vb);
-
-									assert(packet_waiting == false);
-									
-									while( vorbis_bitrate_flushpacket(&vd, &op) )
-									{
-										assert(packet_waiting == false);
-									
-										if(op.granulepos < nextBlockAudoSample)
-										{
-											bool added = muxer_segment.AddFrame(op.packet, op.bytes,
-																				audio_track, timeStamp, 0);
-																					
-											if(!added)
-												result = exportReturn_InternalError;
-										}
-										else
-											packet_waiting = true;
-									}
-									
-									if(packet_waiting)
-										break;
-								}
-							}
-						}
-					}
-				
-					// save the rest of the audio if this is the last frame
-					if(result == malNoError &&
-						(videoTime >= (exportInfoP->endTime - frameRateP.value.timeValue)))
-					{
-						vorbis_analysis_wrote(&vd, NULL); // means there will be no more data
-				
-						while(vorbis_analysis_blockout(&vd, &vb) == 1)
-						{
-							vorbis_analysis(&vb, NULL);
-							vorbis_bitrate_addblock(&vb);
-
-							while( vorbis_bitrate_flushpacket(&vd, &op) )
-							{
-								bool added = muxer_segment.AddFrame(op.packet, op.bytes,
-																	audio_track, timeStamp, 0);
-																		
-								if(!added)
-									result = exportReturn_InternalError;
-							}
-						}
-					}
-				}
-				
-				
-				if(exportInfoP->exportVideo)
-				{
-					unsigned long deadline = vidEncodingP.value.intValue == WEBM_ENCODING_REALTIME ? VPX_DL_REALTIME :
-												vidEncodingP.value.intValue == WEBM_ENCODING_BEST ? VPX_DL_BEST_QUALITY :
-												VPX_DL_GOOD_QUALITY;
-												
-							
-					SequenceRender_GetFrameReturnRec renderResult;
-					
-					result = renderSuite->RenderVideoFrame(videoRenderID,
-															videoTime,
-															&renderParms,
-															kRenderCacheType_None,
-															&renderResult);
-					
-					if(result == suiteError_NoError)
-					{
-						PrPixelFormat pixFormat;
-						prRect bounds;
-						csSDK_uint32 parN, parD;
-						
-						pixSuite->GetPixelFormat(renderResult.outFrame, &pixFormat);
-						pixSuite->GetBounds(renderResult.outFrame, &bounds);
-						pixSuite->GetPixelAspectRatio(renderResult.outFrame, &parN, &parD);
-						
-						const int width = bounds.right - bounds.left;
-						const int height = bounds.bottom - bounds.top;
-						
-						
-						// libvpx can only take PX_IMG_FMT_YV12, VPX_IMG_FMT_I420, VPX_IMG_FMT_VPXI420, VPX_IMG_FMT_VPXYV12
-						// (the latter two are in "vpx color space"?)
-						// see validate_img() in vp8_cx_iface.c
-						// TODO: VP9 can take VPX_IMG_FMT_I422 and VPX_IMG_FMT_I444
-						// although you probably want to switch to YV12 and yuvconfig2image()
-						// Enable CONFIG_ALPHA to use alpha
-								
-						vpx_image_t img_data;
-						vpx_image_t *img = vpx_img_alloc(&img_data, VPX_IMG_FMT_I420, width, height, 32);
-						
-						if(img)
-						{
-							if(pixFormat == PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709)
-							{
-								char *Y_PixelAddress, *U_PixelAddress, *V_PixelAddress;
-								csSDK_uint32 Y_RowBytes, U_RowBytes, V_RowBytes;
-								
-								pix2Suite->GetYUV420PlanarBuffers(renderResult.outFrame, PrPPixBufferAccess_ReadOnly,
-																	&Y_PixelAddress, &Y_RowBytes,
-																	&U_PixelAddress, &U_RowBytes,
-																	&V_PixelAddress, &V_RowBytes);
-								
-								for(int y = 0; y < img->d_h; y++)
-								{
-									unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
-									
-									unsigned char *prY = (unsigned char *)Y_PixelAddress + (Y_RowBytes * y);
-									
-									memcpy(imgY, prY, img->d_w * sizeof(unsigned char));
-								}
-								
-								for(int y = 0; y < img->d_h / 2; y++)
-								{
-									unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * y);
-									unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * y);
-									
-									unsigned char *prU = (unsigned char *)U_PixelAddress + (U_RowBytes * y);
-									unsigned char *prV = (unsigned char *)V_PixelAddress + (V_RowBytes * y);
-									
-									memcpy(imgU, prU, (img->d_w / 2) * sizeof(unsigned char));
-									memcpy(imgV, prV, (img->d_w / 2) * sizeof(unsigned char));
-								}
-							}
-							else if(pixFormat == PrPixelFormat_BGRA_4444_16u)
-							{
-								// since we're doing an RGB to YUV conversion, it wouldn't hurt to have some extra bits
-								char *frameBufferP = NULL;
-								csSDK_int32 rowbytes = 0;
-								
-								pixSuite->GetPixels(renderResult.outFrame, PrPPixBufferAccess_ReadOnly, &frameBufferP);
-								pixSuite->GetRowBytes(renderResult.outFrame, &rowbytes);
-								
-								
-								for(int y = 0; y < img->d_h; y++)
-								{
-									unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
-									unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * (y / 2));
-									unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * (y / 2));
-									
-									unsigned short *prBGRA = (unsigned short *)((unsigned char *)frameBufferP + (rowbytes * (img->d_h - 1 - y)));
-									
-									unsigned short *prB = prBGRA + 0;
-									unsigned short *prG = prBGRA + 1;
-									unsigned short *prR = prBGRA + 2;
-									unsigned short *prA = prBGRA + 3;
-									
-									for(int x=0; x < img->d_w; x++)
-									{
-										*imgY++ = Convert16to8( ((257 * (int)*prR) + (504 * (int)*prG) + ( 98 * (int)*prB) + 2056500) / 1000 );
-										
-										if( (y % 2 == 0) && (x % 2 == 0) )
-										{
-											*imgV++ = Convert16to8( ((439 * (int)*prR) - (368 * (int)*prG) - ( 71 * (int)*prB) + 16449500) / 1000 );
-											*imgU++ = Convert16to8( (-(148 * (int)*prR) - (291 * (int)*prG) + (439 * (int)*prB) + 16449500) / 1000 );
-										}
-										
-										prR += 4;
-										prG += 4;
-										prB += 4;
-										prA += 4;
-									}
-								}
-							}
-							else if(pixFormat == PrPixelFormat_BGRA_4444_8u)
-							{
-								// so here's our dumb RGB to YUV conversion
-							
-								char *frameBufferP = NULL;
-								csSDK_int32 rowbytes = 0;
-								
-								pixSuite->GetPixels(renderResult.outFrame, PrPPixBufferAccess_ReadOnly, &frameBufferP);
-								pixSuite->GetRowBytes(renderResult.outFrame, &rowbytes);
-								
-								
-								for(int y = 0; y < img->d_h; y++)
-								{
-									// using the conversion found here: http://www.fourcc.org/fccyvrgb.php
-									
-									unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
-									unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * (y / 2));
-									unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * (y / 2));
-									
-									// the rows in this kind of Premiere buffer are flipped, FYI (or is it flopped?)
-									unsigned char *prBGRA = (unsigned char *)frameBufferP + (rowbytes * (img->d_h - 1 - y));
-									
-									unsigned char *prB = prBGRA + 0;
-									unsigned char *prG = prBGRA + 1;
-									unsigned char *prR = prBGRA + 2;
-									unsigned char *prA = prBGRA + 3;
-									
-									for(int x=0; x < img->d_w; x++)
-									{
-										// like the clever integer (fixed point) math?
-										*imgY++ = ((257 * (int)*prR) + (504 * (int)*prG) + ( 98 * (int)*prB) + 16500) / 1000;
-										
-										if( (y % 2 == 0) && (x % 2 == 0) )
-										{
-											*imgV++ = ((439 * (int)*prR) - (368 * (int)*prG) - ( 71 * (int)*prB) + 128500) / 1000;
-											*imgU++ = (-(148 * (int)*prR) - (291 * (int)*prG) + (439 * (int)*prB) + 128500) / 1000;
-										}
-										
-										prR += 4;
-										prG += 4;
-										prB += 4;
-										prA += 4;
-									}
-								}
-							}
-							
-							
-							vpx_codec_err_t encode_err = vpx_codec_encode(&encoder, img, encoder_timeStamp, encoder_duration, 0, deadline);
-							
-							if(encode_err == VPX_CODEC_OK)
-							{
-								const vpx_codec_cx_pkt_t *pkt = NULL;
-								vpx_codec_iter_t iter = NULL;
-								 
-								while( (pkt = vpx_codec_get_cx_data(&encoder, &iter)) )
-								{
-									if(pkt->kind == VPX_CODEC_CX_FRAME_PKT)
-									{
-										assert(!vbr_pass);
-									
-										bool added = muxer_segment.AddFrame((const uint8 *)pkt->data.frame.buf, pkt->data.frame.sz,
-																			vid_track, timeStamp,
-																			(pkt->data.frame.flags & VPX_FRAME_IS_KEY));
-																			
-										if(!added)
-											result = exportReturn_InternalError;
-									}
-									else if(pkt->kind == VPX_CODEC_STATS_PKT)
-									{
-										assert(vbr_pass);
-										
-										if(vbr_buffer_size == 0)
-											vbr_buffer = memorySuite->NewPtr(pkt->data.frame.sz);
-										else
-											memorySuite->SetPtrSize(&vbr_buffer, vbr_buffer_size + pkt->data.frame.sz);
-										
-										memcpy(&vbr_buffer[vbr_buffer_size], pkt->data.frame.buf, pkt->data.frame.sz);
-										
-										vbr_buffer_size += pkt->data.frame.sz;
-									}
-								}
-							}
-							else
-								result = exportReturn_InternalError;
-							
-							vpx_img_free(img);
-						}
-						else
-							result = exportReturn_ErrMemory;
-						
-						pixSuite->Dispose(renderResult.outFrame);
-					}
-					else
-						assert(false); // error retreiving frame?
-					
-					
-					// squeeze last bits from encoder
-					if(result == malNoError &&
-						(videoTime >= (exportInfoP->endTime - frameRateP.value.timeValue)))
-					{
-						const vpx_codec_cx_pkt_t *pkt = NULL;
-						vpx_codec_iter_t iter = NULL;
-						
-						do{
-							vpx_codec_encode(&encoder, NULL, encoder_timeStamp, encoder_duration, 0, deadline);
-							
-							pkt = vpx_codec_get_cx_data(&encoder, &iter);
-							
-							if(pkt != NULL)
-							{
-								if(pkt->kind == VPX_CODEC_CX_FRAME_PKT)
-								{
-									assert(!vbr_pass);
-									
-									bool added = muxer_segment.AddFrame((const uint8 *)pkt->data.frame.buf, pkt->data.frame.sz,
-																		vid_track, timeStamp,
-																		(pkt->data.frame.flags & VPX_FRAME_IS_KEY));
-									assert(added);
-								}
-								else if(pkt->kind == VPX_CODEC_STATS_PKT)
-								{
-									assert(vbr_pass);
-									
-									if(vbr_buffer_size == 0)
-										vbr_buffer = memorySuite->NewPtr(pkt->data.frame.sz);
-									else
-										memorySuite->SetPtrSize(&vbr_buffer, vbr_buffer_size + pkt->data.frame.sz);
-									
-									memcpy(&vbr_buffer[vbr_buffer_size], pkt->data.frame.buf, pkt->data.frame.sz);
-									
-									vbr_buffer_size += pkt->data.frame.sz;
-								}
-							}
-							
-						}while(pkt != NULL);
-					}
-				}
-				
-				
-				if(result == malNoError)
-				{
-					float progress = (double)(videoTime - exportInfoP->startTime) / (double)(exportInfoP->endTime - exportInfoP->startTime);
-					
-					if(passes == 2)
-						progress = (progress / 2.f) + (0.5f * pass);
-
-					result = mySettings->exportProgressSuite->UpdateProgressPercent(exID, progress);
-					
-					if(result == suiteError_ExporterSuspended)
-					{
-						result = mySettings->exportProgressSuite->WaitForResume(exID);
-					}
-				}
-				
-				
-				videoTime += frameRateP.value.timeValue;
-			}
-			
-			
-			bool final = muxer_segment.Finalize();
-			
-			if(!final && !vbr_pass)
-				result = exportReturn_InternalError;
-		}
-		else
-			result = exportReturn_InternalError;
-		
-
-
-		if(exportInfoP->exportVideo)
-		{
-			vpx_codec_err_t destroy_err = vpx_codec_destroy(&encoder);
-			assert(destroy_err == VPX_CODEC_OK);
-		}
-			
-		if(exportInfoP->exportAudio && !vbr_pass)
-		{
-			vorbis_block_clear(&vb);
-			vorbis_dsp_clear(&vd);
-			vorbis_comment_clear(&vc);
-			vorbis_info_clear(&vi);
-		}
-	}
 	
-	}catch(...) { result = exportReturn_InternalError; }
+	PremiereExportHost host(mySettings, exportInfoP, videoRenderID, audioRenderID, renderParms);
 	
+	const WebM_Result export_result = WebM_ExportMovie(settings, &main_path[0], host);
 	
-	if(vbr_buffer != NULL)
-		memorySuite->PrDisposePtr(vbr_buffer);
+	result = (export_result == WEBM_OK ? malNoError :
+				export_result == WEBM_ERR_MEMORY ? exportReturn_ErrMemory :
+				export_result == WEBM_ERR_HOST && host.Error() != malNoError ? host.Error() :
+				exportReturn_InternalError);
 	
 	
 	if(exportInfoP->exportVideo)
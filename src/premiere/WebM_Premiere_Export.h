@@ -72,6 +72,7 @@ typedef struct ExportSettings
 	PrSDKSequenceRenderSuite	*sequenceRenderSuite;
 	PrSDKSequenceAudioSuite		*sequenceAudioSuite;
 	PrSDKWindowSuite			*windowSuite;
+	bool						smartRender;	// we called WebM_PassthroughBegin()
 } ExportSettings;
 
 
@@ -39,16 +39,9 @@
 
 #include "WebM_Premiere_Export_Params.h"
 
-extern "C" {
-
-#include "vpx/vpx_encoder.h"
-#include "vpx/vp8cx.h"
-
-}
-
+#include "WebM_Passthrough.h"
 
 #include <sstream>
-#include <vector>
 
 using std::string;
 
@@ -64,6 +57,28 @@ utf16ncpy(prUTF16Char *dest, const char *src, int max_len)
 }
 
 
+// While smart render is on, the importer has to hash the frames it
+// decodes, so they're known by the time the export starts.
+static void
+UpdateSmartRender(ExportSettings *privateData, csSDK_int32 exID, csSDK_int32 gIdx)
+{
+	exParamValues smartRenderP;
+	privateData->exportParamSuite->GetParamValue(exID, gIdx, WebMVideoSmartRender, &smartRenderP);
+	
+	const bool smartRender = (smartRenderP.value.intValue && !smartRenderP.disabled);
+	
+	if(smartRender != privateData->smartRender)
+	{
+		if(smartRender)
+			WebM_PassthroughBegin();
+		else
+			WebM_PassthroughEnd();
+		
+		privateData->smartRender = smartRender;
+	}
+}
+
+
 prMALError
 exSDKQueryOutputSettings(
 	exportStdParms				*stdParmsP,
@@ -85,7 +100,10 @@ exSDKQueryOutputSettings(
 								videoBitrateP,
 								sampleRate,
 								channelType,
-								audioQualityP;
+								audioCodecP,
+								audioMethodP,
+								audioQualityP,
+								audioBitrateP;
 	PrSDKExportParamSuite		*paramSuite		= privateData->exportParamSuite;
 	csSDK_int32					mgroupIndex		= 0;
 	float						fps				= 0.0f;
@@ -113,7 +131,6 @@ exSDKQueryOutputSettings(
 		paramSuite->GetParamValue(exID, mgroupIndex, WebMVideoMethod, &methodP);
 		paramSuite->GetParamValue(exID, mgroupIndex, WebMVideoQuality, &videoQualityP);
 		paramSuite->GetParamValue(exID, mgroupIndex, WebMVideoBitrate, &videoBitrateP);
-		paramSuite->GetParamValue(exID, mgroupIndex, WebMAudioQuality, &audioQualityP);
 		
 		if(methodP.value.intValue == WEBM_METHOD_QUALITY)
 		{
@@ -140,15 +157,33 @@ exSDKQueryOutputSettings(
 		outputSettingsP->outAudioChannelType = (PrAudioChannelType)channelType.value.intValue;
 		outputSettingsP->outAudioSampleType = kPrAudioSampleType_Compressed;
 		
-		const PrAudioChannelType audioFormat = (PrAudioChannelType)channelType.value.intValue;
-		const int audioChannels = (audioFormat == kPrAudioChannelType_51 ? 6 :
-									audioFormat == kPrAudioChannelType_Mono ? 1 :
-									2);
-
-		float qualityMult = (audioQualityP.value.floatValue + 0.1) / 1.1;
-		float ogg_mult = (qualityMult * 0.4) + 0.1;
+		paramSuite->GetParamValue(exID, mgroupIndex, WebMAudioCodec, &audioCodecP);
+		paramSuite->GetParamValue(exID, mgroupIndex, WebMAudioMethod, &audioMethodP);
+		paramSuite->GetParamValue(exID, mgroupIndex, WebMAudioQuality, &audioQualityP);
+		paramSuite->GetParamValue(exID, mgroupIndex, WebMAudioBitrate, &audioBitrateP);
+		
+		if(audioCodecP.value.intValue == WEBM_CODEC_OPUS)
+		{
+			// Opus always runs at 48k
+			outputSettingsP->outAudioSampleRate = 48000;
+		}
 		
-		videoBitrate += (sampleRate.value.floatValue * audioChannels * 8 * 4 * ogg_mult) / 1024; // IDK
+		if(audioCodecP.value.intValue == WEBM_CODEC_OPUS || audioMethodP.value.intValue == OGG_BITRATE)
+		{
+			videoBitrate += audioBitrateP.value.intValue;
+		}
+		else
+		{
+			const PrAudioChannelType audioFormat = (PrAudioChannelType)channelType.value.intValue;
+			const int audioChannels = (audioFormat == kPrAudioChannelType_51 ? 6 :
+										audioFormat == kPrAudioChannelType_Mono ? 1 :
+										2);
+
+			float qualityMult = (audioQualityP.value.floatValue + 0.1) / 1.1;
+			float ogg_mult = (qualityMult * 0.4) + 0.1;
+			
+			videoBitrate += (sampleRate.value.floatValue * audioChannels * 8 * 4 * ogg_mult) / 1024; // IDK
+		}
 	}
 	
 	// return outBitratePerSecond in kbps
@@ -343,7 +378,7 @@ exSDKGenerateDefaultParams(
 	alphaParam.flags = exParamFlag_none;
 	alphaParam.paramValues = alphaValues;
 	
-	//exportParamSuite->AddParam(exID, gIdx, ADBEBasicVideoGroup, &alphaParam);
+	exportParamSuite->AddParam(exID, gIdx, ADBEBasicVideoGroup, &alphaParam);
 
 	
 	// Video Codec Settings Group
@@ -432,7 +467,7 @@ exSDKGenerateDefaultParams(
 	exParamValues vidEncodingValues;
 	vidEncodingValues.structVersion = 1;
 	vidEncodingValues.rangeMin.intValue = WEBM_ENCODING_REALTIME;
-	vidEncodingValues.rangeMax.intValue = WEBM_ENCODING_BEST;
+	vidEncodingValues.rangeMax.intValue = WEBM_ENCODING_BUDGET;
 	vidEncodingValues.value.intValue = WEBM_ENCODING_GOOD;
 	vidEncodingValues.disabled = kPrFalse;
 	vidEncodingValues.hidden = kPrFalse;
@@ -447,6 +482,186 @@ exSDKGenerateDefaultParams(
 	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &vidEncodingParam);
 	
 	
+	// Budget mode
+	exParamValues budgetModeValues;
+	budgetModeValues.structVersion = 1;
+	budgetModeValues.rangeMin.intValue = WEBM_BUDGET_MINUTES;
+	budgetModeValues.rangeMax.intValue = WEBM_BUDGET_REALTIME;
+	budgetModeValues.value.intValue = WEBM_BUDGET_MINUTES;
+	budgetModeValues.disabled = kPrFalse;
+	budgetModeValues.hidden = kPrTrue;
+	
+	exNewParamInfo budgetModeParam;
+	budgetModeParam.structVersion = 1;
+	strncpy(budgetModeParam.identifier, WebMVideoBudgetMode, 255);
+	budgetModeParam.paramType = exParamType_int;
+	budgetModeParam.flags = exParamFlag_none;
+	budgetModeParam.paramValues = budgetModeValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &budgetModeParam);
+	
+	
+	// Budget minutes
+	exParamValues budgetMinutesValues;
+	budgetMinutesValues.structVersion = 1;
+	budgetMinutesValues.rangeMin.intValue = 1;
+	budgetMinutesValues.rangeMax.intValue = 600;
+	budgetMinutesValues.value.intValue = 30;
+	budgetMinutesValues.disabled = kPrFalse;
+	budgetMinutesValues.hidden = kPrTrue;
+	
+	exNewParamInfo budgetMinutesParam;
+	budgetMinutesParam.structVersion = 1;
+	strncpy(budgetMinutesParam.identifier, WebMVideoBudgetMinutes, 255);
+	budgetMinutesParam.paramType = exParamType_int;
+	budgetMinutesParam.flags = exParamFlag_slider;
+	budgetMinutesParam.paramValues = budgetMinutesValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &budgetMinutesParam);
+	
+	
+	// Budget speed
+	exParamValues budgetSpeedValues;
+	budgetSpeedValues.structVersion = 1;
+	budgetSpeedValues.rangeMin.floatValue = 0.1f;
+	budgetSpeedValues.rangeMax.floatValue = 10.f;
+	budgetSpeedValues.value.floatValue = 1.f;
+	budgetSpeedValues.disabled = kPrFalse;
+	budgetSpeedValues.hidden = kPrTrue;
+	
+	exNewParamInfo budgetSpeedParam;
+	budgetSpeedParam.structVersion = 1;
+	strncpy(budgetSpeedParam.identifier, WebMVideoBudgetSpeed, 255);
+	budgetSpeedParam.paramType = exParamType_float;
+	budgetSpeedParam.flags = exParamFlag_slider;
+	budgetSpeedParam.paramValues = budgetSpeedValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &budgetSpeedParam);
+	
+	
+	// Scene cuts
+	exParamValues sceneCutsValues;
+	sceneCutsValues.structVersion = 1;
+	sceneCutsValues.value.intValue = kPrFalse;
+	sceneCutsValues.disabled = kPrFalse;
+	sceneCutsValues.hidden = kPrFalse;
+	
+	exNewParamInfo sceneCutsParam;
+	sceneCutsParam.structVersion = 1;
+	strncpy(sceneCutsParam.identifier, WebMVideoSceneCuts, 255);
+	sceneCutsParam.paramType = exParamType_bool;
+	sceneCutsParam.flags = exParamFlag_none;
+	sceneCutsParam.paramValues = sceneCutsValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &sceneCutsParam);
+	
+	
+	// Skip repeated frames
+	exParamValues skipRepeatsValues;
+	skipRepeatsValues.structVersion = 1;
+	skipRepeatsValues.value.intValue = kPrFalse;
+	skipRepeatsValues.disabled = kPrFalse;
+	skipRepeatsValues.hidden = kPrFalse;
+	
+	exNewParamInfo skipRepeatsParam;
+	skipRepeatsParam.structVersion = 1;
+	strncpy(skipRepeatsParam.identifier, WebMVideoSkipRepeats, 255);
+	skipRepeatsParam.paramType = exParamType_bool;
+	skipRepeatsParam.flags = exParamFlag_none;
+	skipRepeatsParam.paramValues = skipRepeatsValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &skipRepeatsParam);
+	
+	
+	// Smart render
+	exParamValues smartRenderValues;
+	smartRenderValues.structVersion = 1;
+	smartRenderValues.value.intValue = kPrFalse;
+	smartRenderValues.disabled = kPrFalse;
+	smartRenderValues.hidden = kPrFalse;
+	
+	exNewParamInfo smartRenderParam;
+	smartRenderParam.structVersion = 1;
+	strncpy(smartRenderParam.identifier, WebMVideoSmartRender, 255);
+	smartRenderParam.paramType = exParamType_bool;
+	smartRenderParam.flags = exParamFlag_none;
+	smartRenderParam.paramValues = smartRenderValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &smartRenderParam);
+	
+	
+	// Renditions
+	exParamValues renditionsValues;
+	renditionsValues.structVersion = 1;
+	renditionsValues.rangeMin.intValue = 0;
+	renditionsValues.rangeMax.intValue = 3;
+	renditionsValues.value.intValue = 0;
+	renditionsValues.disabled = kPrFalse;
+	renditionsValues.hidden = kPrFalse;
+	
+	exNewParamInfo renditionsParam;
+	renditionsParam.structVersion = 1;
+	strncpy(renditionsParam.identifier, WebMVideoRenditions, 255);
+	renditionsParam.paramType = exParamType_int;
+	renditionsParam.flags = exParamFlag_none;
+	renditionsParam.paramValues = renditionsValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &renditionsParam);
+	
+	
+	// Proxy
+	exParamValues proxyValues;
+	proxyValues.structVersion = 1;
+	proxyValues.value.intValue = kPrFalse;
+	proxyValues.disabled = kPrFalse;
+	proxyValues.hidden = kPrFalse;
+	
+	exNewParamInfo proxyParam;
+	proxyParam.structVersion = 1;
+	strncpy(proxyParam.identifier, WebMVideoProxy, 255);
+	proxyParam.paramType = exParamType_bool;
+	proxyParam.flags = exParamFlag_none;
+	proxyParam.paramValues = proxyValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &proxyParam);
+	
+	
+	// DASH
+	exParamValues dashValues;
+	dashValues.structVersion = 1;
+	dashValues.value.intValue = kPrFalse;
+	dashValues.disabled = kPrFalse;
+	dashValues.hidden = kPrFalse;
+	
+	exNewParamInfo dashParam;
+	dashParam.structVersion = 1;
+	strncpy(dashParam.identifier, WebMVideoDASH, 255);
+	dashParam.paramType = exParamType_bool;
+	dashParam.flags = exParamFlag_none;
+	dashParam.paramValues = dashValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &dashParam);
+	
+	
+	// Keyframe interval
+	exParamValues keyframeIntervalValues;
+	keyframeIntervalValues.structVersion = 1;
+	keyframeIntervalValues.rangeMin.intValue = 1;
+	keyframeIntervalValues.rangeMax.intValue = 10;
+	keyframeIntervalValues.value.intValue = 2;
+	keyframeIntervalValues.disabled = kPrTrue;
+	keyframeIntervalValues.hidden = kPrFalse;
+	
+	exNewParamInfo keyframeIntervalParam;
+	keyframeIntervalParam.structVersion = 1;
+	strncpy(keyframeIntervalParam.identifier, WebMVideoKeyframeInterval, 255);
+	keyframeIntervalParam.paramType = exParamType_int;
+	keyframeIntervalParam.flags = exParamFlag_slider;
+	keyframeIntervalParam.paramValues = keyframeIntervalValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEVideoCodecGroup, &keyframeIntervalParam);
+	
+	
 	// Version
 	exParamValues versionValues;
 	versionValues.structVersion = 1;
@@ -543,6 +758,25 @@ exSDKGenerateDefaultParams(
 									ADBEAudioTabGroup, ADBEAudioCodecGroup, groupString,
 									kPrFalse, kPrFalse, kPrFalse);
 									
+	// Codec
+	exParamValues audioCodecValues;
+	audioCodecValues.structVersion = 1;
+	audioCodecValues.rangeMin.intValue = WEBM_CODEC_VORBIS;
+	audioCodecValues.rangeMax.intValue = WEBM_CODEC_OPUS;
+	audioCodecValues.value.intValue = WEBM_CODEC_VORBIS;
+	audioCodecValues.disabled = kPrFalse;
+	audioCodecValues.hidden = kPrFalse;
+	
+	exNewParamInfo audioCodecParam;
+	audioCodecParam.structVersion = 1;
+	strncpy(audioCodecParam.identifier, WebMAudioCodec, 255);
+	audioCodecParam.paramType = exParamType_int;
+	audioCodecParam.flags = exParamFlag_none;
+	audioCodecParam.paramValues = audioCodecValues;
+	
+	exportParamSuite->AddParam(exID, gIdx, ADBEAudioCodecGroup, &audioCodecParam);
+	
+	
 	// Method
 	exParamValues audioMethodValues;
 	audioMethodValues.structVersion = 1;
@@ -762,7 +996,7 @@ exSDKPostProcessParams(
 	
 	// Alpha channel
 	utf16ncpy(paramString, "Include Alpha Channel", 255);
-	//exportParamSuite->SetParamName(exID, gIdx, ADBEVideoAlpha, paramString);
+	exportParamSuite->SetParamName(exID, gIdx, ADBEVideoAlpha, paramString);
 	
 	
 	// Video codec settings
@@ -849,16 +1083,18 @@ exSDKPostProcessParams(
 	
 	int vidQualities[] = {	WEBM_ENCODING_REALTIME,
 							WEBM_ENCODING_GOOD,
-							WEBM_ENCODING_BEST };
+							WEBM_ENCODING_BEST,
+							WEBM_ENCODING_BUDGET };
 	
 	const char *vidQualityStrings[]	= {	"Realtime",
 										"Good",
-										"Best" };
+										"Best",
+										"Time budget" };
 
 	exportParamSuite->ClearConstrainedValues(exID, gIdx, WebMVideoEncoding);
 	
 	exOneParamValueRec tempEncodingQuality;
-	for(int i=0; i < 3; i++)
+	for(int i=0; i < 4; i++)
 	{
 		tempEncodingQuality.intValue = vidQualities[i];
 		utf16ncpy(paramString, vidQualityStrings[i], 255);
@@ -866,6 +1102,114 @@ exSDKPostProcessParams(
 	}
 	
 	
+	// Time budget
+	utf16ncpy(paramString, "Budget", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoBudgetMode, paramString);
+	
+	int budgetModes[] = {	WEBM_BUDGET_MINUTES,
+							WEBM_BUDGET_REALTIME };
+	
+	const char *budgetModeStrings[]	= {	"Finish within",
+										"Times realtime" };
+	
+	exportParamSuite->ClearConstrainedValues(exID, gIdx, WebMVideoBudgetMode);
+	
+	exOneParamValueRec tempBudgetMode;
+	for(int i=0; i < 2; i++)
+	{
+		tempBudgetMode.intValue = budgetModes[i];
+		utf16ncpy(paramString, budgetModeStrings[i], 255);
+		exportParamSuite->AddConstrainedValuePair(exID, gIdx, WebMVideoBudgetMode, &tempBudgetMode, paramString);
+	}
+	
+	utf16ncpy(paramString, "Minutes", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoBudgetMinutes, paramString);
+	
+	utf16ncpy(paramString, "Speed (x realtime)", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoBudgetSpeed, paramString);
+	
+	exParamValues vidEncodingP, budgetModeP, budgetMinutesP, budgetSpeedP;
+	exportParamSuite->GetParamValue(exID, gIdx, WebMVideoEncoding, &vidEncodingP);
+	exportParamSuite->GetParamValue(exID, gIdx, WebMVideoBudgetMode, &budgetModeP);
+	exportParamSuite->GetParamValue(exID, gIdx, WebMVideoBudgetMinutes, &budgetMinutesP);
+	exportParamSuite->GetParamValue(exID, gIdx, WebMVideoBudgetSpeed, &budgetSpeedP);
+	
+	const bool budget = (vidEncodingP.value.intValue == WEBM_ENCODING_BUDGET);
+	
+	budgetModeP.hidden = !budget;
+	budgetMinutesP.hidden = !(budget && budgetModeP.value.intValue == WEBM_BUDGET_MINUTES);
+	budgetSpeedP.hidden = !(budget && budgetModeP.value.intValue == WEBM_BUDGET_REALTIME);
+	
+	exportParamSuite->ChangeParam(exID, gIdx, WebMVideoBudgetMode, &budgetModeP);
+	exportParamSuite->ChangeParam(exID, gIdx, WebMVideoBudgetMinutes, &budgetMinutesP);
+	exportParamSuite->ChangeParam(exID, gIdx, WebMVideoBudgetSpeed, &budgetSpeedP);
+	
+	
+	// Scene cuts
+	utf16ncpy(paramString, "Keyframes at scene cuts", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoSceneCuts, paramString);
+	
+	
+	// Skip repeated frames
+	utf16ncpy(paramString, "Skip repeated frames", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoSkipRepeats, paramString);
+	
+	
+	// Smart render
+	utf16ncpy(paramString, "Copy unchanged WebM frames", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoSmartRender, paramString);
+	
+	
+	// Renditions
+	utf16ncpy(paramString, "Smaller renditions", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoRenditions, paramString);
+	
+	const char *renditionStrings[]	= {	"None",
+										"1",
+										"2",
+										"3" };
+	
+	exportParamSuite->ClearConstrainedValues(exID, gIdx, WebMVideoRenditions);
+	
+	exOneParamValueRec tempRenditions;
+	for(int i=0; i < 4; i++)
+	{
+		tempRenditions.intValue = i;
+		utf16ncpy(paramString, renditionStrings[i], 255);
+		exportParamSuite->AddConstrainedValuePair(exID, gIdx, WebMVideoRenditions, &tempRenditions, paramString);
+	}
+	
+	
+	// Proxy
+	utf16ncpy(paramString, "Quarter-size proxy for editing", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoProxy, paramString);
+	
+	
+	// DASH
+	utf16ncpy(paramString, "DASH output", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoDASH, paramString);
+	
+	utf16ncpy(paramString, "Keyframe interval (sec)", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMVideoKeyframeInterval, paramString);
+	
+	exParamValues dashP, keyframeIntervalP, sceneCutsP, smartRenderP, alphaP;
+	exportParamSuite->GetParamValue(exID, gIdx, WebMVideoDASH, &dashP);
+	exportParamSuite->GetParamValue(exID, gIdx, WebMVideoKeyframeInterval, &keyframeIntervalP);
+	exportParamSuite->GetParamValue(exID, gIdx, WebMVideoSceneCuts, &sceneCutsP);
+	exportParamSuite->GetParamValue(exID, gIdx, WebMVideoSmartRender, &smartRenderP);
+	exportParamSuite->GetParamValue(exID, gIdx, ADBEVideoAlpha, &alphaP);
+	
+	// DASH puts the keyframes where it wants them.
+	// Source frames don't have our alpha, so nothing to copy with it.
+	keyframeIntervalP.disabled = !dashP.value.intValue;
+	sceneCutsP.disabled = dashP.value.intValue;
+	smartRenderP.disabled = (dashP.value.intValue || alphaP.value.intValue);
+	
+	exportParamSuite->ChangeParam(exID, gIdx, WebMVideoKeyframeInterval, &keyframeIntervalP);
+	exportParamSuite->ChangeParam(exID, gIdx, WebMVideoSceneCuts, &sceneCutsP);
+	exportParamSuite->ChangeParam(exID, gIdx, WebMVideoSmartRender, &smartRenderP);
+	
+	
 	// Custom settings
 	utf16ncpy(paramString, "Custom settings", 255);
 	exportParamSuite->SetParamName(exID, gIdx, WebMCustomGroup, paramString);
@@ -926,10 +1270,32 @@ exSDKPostProcessParams(
 	
 	
 	// Audio codec settings
-	utf16ncpy(paramString, "Vorbis settings", 255);
+	utf16ncpy(paramString, "Codec settings", 255);
 	exportParamSuite->SetParamName(exID, gIdx, ADBEAudioCodecGroup, paramString);
 
 
+	// Codec
+	utf16ncpy(paramString, "Codec", 255);
+	exportParamSuite->SetParamName(exID, gIdx, WebMAudioCodec, paramString);
+	
+	
+	WebM_Audio_Codec audioCodecs[] = {	WEBM_CODEC_VORBIS,
+										WEBM_CODEC_OPUS };
+	
+	const char *audioCodecStrings[]	= {	"Vorbis",
+										"Opus" };
+
+	exportParamSuite->ClearConstrainedValues(exID, gIdx, WebMAudioCodec);
+	
+	exOneParamValueRec tempAudioCodec;
+	for(int i=0; i < 2; i++)
+	{
+		tempAudioCodec.intValue = audioCodecs[i];
+		utf16ncpy(paramString, audioCodecStrings[i], 255);
+		exportParamSuite->AddConstrainedValuePair(exID, gIdx, WebMAudioCodec, &tempAudioCodec, paramString);
+	}
+
+
 	// Method
 	utf16ncpy(paramString, "Method", 255);
 	exportParamSuite->SetParamName(exID, gIdx, WebMAudioMethod, paramString);
@@ -976,6 +1342,9 @@ exSDKPostProcessParams(
 	audioBitrateValues.rangeMax.intValue = 1000;
 	
 	exportParamSuite->ChangeParam(exID, gIdx, WebMAudioBitrate, &audioBitrateValues);
+	
+	
+	UpdateSmartRender(lRec, exID, gIdx);
 
 	return result;
 }
@@ -1000,7 +1369,7 @@ exSDKGetParamSummary(
 	paramSuite->GetParamValue(exID, gIdx, ADBEVideoWidth, &width);
 	paramSuite->GetParamValue(exID, gIdx, ADBEVideoHeight, &height);
 	paramSuite->GetParamValue(exID, gIdx, ADBEVideoFPS, &frameRate);
-	//paramSuite->GetParamValue(exID, mgroupIndex, ADBEVideoAlpha, &alpha);
+	paramSuite->GetParamValue(exID, gIdx, ADBEVideoAlpha, &alpha);
 	
 	exParamValues sampleRateP, channelTypeP;
 	paramSuite->GetParamValue(exID, gIdx, ADBEAudioRatePerSecond, &sampleRateP);
@@ -1013,8 +1382,15 @@ exSDKGetParamSummary(
 	paramSuite->GetParamValue(exID, gIdx, WebMVideoBitrate, &videoBitrateP);
 	paramSuite->GetParamValue(exID, gIdx, WebMVideoEncoding, &vidEncodingP);
 	
+	exParamValues sceneCutsP, renditionsP, proxyP, dashP;
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoSceneCuts, &sceneCutsP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoRenditions, &renditionsP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoProxy, &proxyP);
+	paramSuite->GetParamValue(exID, gIdx, WebMVideoDASH, &dashP);
+	
 
-	exParamValues audioMethodP, audioQualityP, audioBitrateP;
+	exParamValues audioCodecP, audioMethodP, audioQualityP, audioBitrateP;
+	paramSuite->GetParamValue(exID, gIdx, WebMAudioCodec, &audioCodecP);
 	paramSuite->GetParamValue(exID, gIdx, WebMAudioMethod, &audioMethodP);
 	paramSuite->GetParamValue(exID, gIdx, WebMAudioQuality, &audioQualityP);
 	paramSuite->GetParamValue(exID, gIdx, WebMAudioBitrate, &audioBitrateP);
@@ -1062,21 +1438,24 @@ exSDKGetParamSummary(
 	if(frame_rate_index >= 0 && frame_rate_index < 10) 
 		stream1 << ", " << frameRateStrings[frame_rate_index] << " fps";
 	
-	//stream1 << ", " << (alpha.value.intValue ? "Alpha" : "No Alpha");
+	if(alpha.value.intValue)
+		stream1 << ", Alpha";
 	
 	summary1 = stream1.str();
 	
 	
 	std::stringstream stream2;
 	
-	stream2 << (int)sampleRateP.value.floatValue << " Hz";
+	const bool opus = (audioCodecP.value.intValue == WEBM_CODEC_OPUS);
+	
+	stream2 << (opus ? 48000 : (int)sampleRateP.value.floatValue) << " Hz";
 	stream2 << ", " << (channelTypeP.value.intValue == kPrAudioChannelType_51 ? "Dolby 5.1" :
 						channelTypeP.value.intValue == kPrAudioChannelType_Mono ? "Mono" :
 						"Stereo");
 
 	stream2 << ", ";
 	
-	if(audioMethodP.value.intValue == OGG_BITRATE)
+	if(opus || audioMethodP.value.intValue == OGG_BITRATE)
 	{
 		stream2 << audioBitrateP.value.intValue << " kbps";
 	}
@@ -1084,6 +1463,8 @@ exSDKGetParamSummary(
 	{
 		stream2 << "Quality " << audioQualityP.value.floatValue;
 	}
+	
+	stream2 << (opus ? ", Opus" : ", Vorbis");
 
 	
 	summary2 = stream2.str();
@@ -1111,6 +1492,20 @@ exSDKGetParamSummary(
 		stream3 << ", Realtime";
 	else if(vidEncodingP.value.intValue == WEBM_ENCODING_BEST)
 		stream3 << ", Best";
+	else if(vidEncodingP.value.intValue == WEBM_ENCODING_BUDGET)
+		stream3 << ", Time budget";
+	
+	if(sceneCutsP.value.intValue && !dashP.value.intValue)
+		stream3 << ", Scene cuts";
+	
+	if(renditionsP.value.intValue > 0)
+		stream3 << ", +" << renditionsP.value.intValue << " renditions";
+	
+	if(proxyP.value.intValue)
+		stream3 << ", Proxy";
+	
+	if(dashP.value.intValue)
+		stream3 << ", DASH";
 	
 	summary3 = stream3.str();
 	
@@ -1172,255 +1567,72 @@ exSDKValidateParamChanged (
 		paramSuite->ChangeParam(exID, gIdx, WebMVideoQuality, &videoQualityValue);
 		paramSuite->ChangeParam(exID, gIdx, WebMVideoBitrate, &videoBitrateValue);
 	}
-	else if(param == WebMAudioMethod)
+	else if(param == WebMVideoEncoding || param == WebMVideoBudgetMode)
 	{
-		exParamValues audioMethodP, audioQualityP, audioBitrateP;
-		paramSuite->GetParamValue(exID, gIdx, WebMAudioMethod, &audioMethodP);
-		paramSuite->GetParamValue(exID, gIdx, WebMAudioQuality, &audioQualityP);
-		paramSuite->GetParamValue(exID, gIdx, WebMAudioBitrate, &audioBitrateP);
+		exParamValues vidEncodingP, budgetModeP, budgetMinutesP, budgetSpeedP;
 		
-		audioQualityP.hidden = (audioMethodP.value.intValue == OGG_BITRATE);
-		audioBitrateP.hidden = !audioQualityP.hidden;
+		paramSuite->GetParamValue(exID, gIdx, WebMVideoEncoding, &vidEncodingP);
+		paramSuite->GetParamValue(exID, gIdx, WebMVideoBudgetMode, &budgetModeP);
+		paramSuite->GetParamValue(exID, gIdx, WebMVideoBudgetMinutes, &budgetMinutesP);
+		paramSuite->GetParamValue(exID, gIdx, WebMVideoBudgetSpeed, &budgetSpeedP);
 		
-		paramSuite->ChangeParam(exID, gIdx, WebMAudioQuality, &audioQualityP);
-		paramSuite->ChangeParam(exID, gIdx, WebMAudioBitrate, &audioBitrateP);
-	}
-
-	return malNoError;
-}
-
-
-static bool
-quotedTokenize(const string& str,
-				  std::vector<string>& tokens,
-				  const string& delimiters = " ")
-{
-	// this function will respect quoted strings when tokenizing
-	// the quotes will be included in the returned strings
-	
-	int i = 0;
-	bool in_quotes = false;
-	
-	// if there are un-quoted delimiters in the beginning, skip them
-	while(i < str.size() && str[i] != '\"' && string::npos != delimiters.find(str[i]) )
-		i++;
-	
-	string::size_type lastPos = i;
-	
-	while(i < str.size())
-	{
-		if(str[i] == '\"' && (i == 0 || str[i-1] != '\\'))
-			in_quotes = !in_quotes;
-		else if(!in_quotes)
-		{
-			if( string::npos != delimiters.find(str[i]) )
-			{
-				tokens.push_back(str.substr(lastPos, i - lastPos));
-				
-				lastPos = i + 1;
-				
-				// if there are more delimiters ahead, push forward
-				while(lastPos < str.size() && (str[lastPos] != '\"' || str[lastPos-1] != '\\') && string::npos != delimiters.find(str[lastPos]) )
-					lastPos++;
-					
-				i = lastPos;
-				continue;
-			}
-		}
+		const bool budget = (vidEncodingP.value.intValue == WEBM_ENCODING_BUDGET);
+		
+		budgetModeP.hidden = !budget;
+		budgetMinutesP.hidden = !(budget && budgetModeP.value.intValue == WEBM_BUDGET_MINUTES);
+		budgetSpeedP.hidden = !(budget && budgetModeP.value.intValue == WEBM_BUDGET_REALTIME);
 		
-		i++;
+		paramSuite->ChangeParam(exID, gIdx, WebMVideoBudgetMode, &budgetModeP);
+		paramSuite->ChangeParam(exID, gIdx, WebMVideoBudgetMinutes, &budgetMinutesP);
+		paramSuite->ChangeParam(exID, gIdx, WebMVideoBudgetSpeed, &budgetSpeedP);
 	}
-	
-	if(in_quotes)
-		return false;
-	
-	// we're at the end, was there anything left?
-	if(str.size() - lastPos > 0)
-		tokens.push_back( str.substr(lastPos) );
-	
-	return true;
-}
-
-
-template <typename T>
-static void SetValue(T &v, string s)
-{
-	std::stringstream ss;
-	
-	ss << s;
-	
-	ss >> v;
-}
-
-
-bool
-ConfigureEncoderPre(vpx_codec_enc_cfg_t &config, const char *txt)
-{
-	std::vector<string> args;
-	
-	if(quotedTokenize(txt, args, " =\t\r\n") && args.size() > 0)
+	else if(param == WebMVideoDASH || param == ADBEVideoAlpha)
 	{
-		args.push_back(""); // so there's always an i+1
+		exParamValues dashP, keyframeIntervalP, sceneCutsP, smartRenderP, alphaP;
 		
-		int i = 0;
+		paramSuite->GetParamValue(exID, gIdx, WebMVideoDASH, &dashP);
+		paramSuite->GetParamValue(exID, gIdx, WebMVideoKeyframeInterval, &keyframeIntervalP);
+		paramSuite->GetParamValue(exID, gIdx, WebMVideoSceneCuts, &sceneCutsP);
+		paramSuite->GetParamValue(exID, gIdx, WebMVideoSmartRender, &smartRenderP);
+		paramSuite->GetParamValue(exID, gIdx, ADBEVideoAlpha, &alphaP);
 		
-		while(i < args.size())
-		{
-			const string &arg = args[i];
-			
-			if(arg == "-t" || arg == "--threads")
-			{	SetValue(config.g_threads, args[i + 1]); i++;	}
-			
-			else if(arg == "--lag-in-frames")
-			{	SetValue(config.g_lag_in_frames, args[i + 1]); i++;	}
-			
-			else if(arg == "--drop-frame")
-			{	SetValue(config.rc_dropframe_thresh, args[i + 1]); i++;	}
-			
-			else if(arg == "--resize-allowed")
-			{	SetValue(config.rc_resize_allowed, args[i + 1]); i++;	}
-			
-			else if(arg == "--resize-up")
-			{	SetValue(config.rc_resize_up_thresh, args[i + 1]); i++;	}
-			
-			else if(arg == "--resize-down")
-			{	SetValue(config.rc_resize_down_thresh, args[i + 1]); i++;	}
-			
-			else if(arg == "--target-bitrate")
-			{	SetValue(config.rc_target_bitrate, args[i + 1]); i++;	}
-			
-			else if(arg == "--min-q")
-			{	SetValue(config.rc_min_quantizer, args[i + 1]); i++;	}
-			
-			else if(arg == "--max-q")
-			{	SetValue(config.rc_max_quantizer, args[i + 1]); i++;	}
-			
-			else if(arg == "--undershoot-pct")
-			{	SetValue(config.rc_undershoot_pct, args[i + 1]); i++;	}
-			
-			else if(arg == "--overshoot-pct")
-			{	SetValue(config.rc_overshoot_pct, args[i + 1]); i++;	}
-
-			else if(arg == "--buf-sz")
-			{	SetValue(config.rc_buf_sz, args[i + 1]); i++;	}
-
-			else if(arg == "--buf-initial-sz")
-			{	SetValue(config.rc_buf_initial_sz, args[i + 1]); i++;	}
-
-			else if(arg == "--buf-optimal-sz")
-			{	SetValue(config.rc_buf_optimal_sz, args[i + 1]); i++;	}
-
-			else if(arg == "--bias-pct")
-			{	SetValue(config.rc_2pass_vbr_bias_pct, args[i + 1]); i++;	}
-
-			else if(arg == "--minsection-pct")
-			{	SetValue(config.rc_2pass_vbr_minsection_pct, args[i + 1]); i++;	}
-
-			else if(arg == "--maxsection-pct")
-			{	SetValue(config.rc_2pass_vbr_maxsection_pct, args[i + 1]); i++;	}
-
-			else if(arg == "--kf-min-dist")
-			{	SetValue(config.kf_min_dist, args[i + 1]); i++;	}
-
-			else if(arg == "--kf-max-dist")
-			{	SetValue(config.kf_max_dist, args[i + 1]); i++;	}
-
-			else if(arg == "--disable-kf")
-			{	config.kf_mode = VPX_KF_DISABLED;	}
-
-			else if(arg == "--periodicity")
-			{	SetValue(config.ts_periodicity, args[i + 1]); i++;	}
-
-			
-			i++;
-		}
-	
-		return true;
+		keyframeIntervalP.disabled = !dashP.value.intValue;
+		sceneCutsP.disabled = dashP.value.intValue;
+		smartRenderP.disabled = (dashP.value.intValue || alphaP.value.intValue);
+		
+		paramSuite->ChangeParam(exID, gIdx, WebMVideoKeyframeInterval, &keyframeIntervalP);
+		paramSuite->ChangeParam(exID, gIdx, WebMVideoSceneCuts, &sceneCutsP);
+		paramSuite->ChangeParam(exID, gIdx, WebMVideoSmartRender, &smartRenderP);
 	}
-	else
-		return false;
-}
-
-
-#define ConfigureValue(encoder, ctrl_id, s) \
-	do{							\
-		std::stringstream ss;	\
-		ss << s;				\
-		unsigned int v = 0;		\
-		ss >> v;				\
-		config_err = vpx_codec_control(encoder, ctrl_id, v); \
-	}while(0)
-
-bool
-ConfigureEncoderPost(vpx_codec_ctx_t *encoder, const char *txt)
-{
-	std::vector<string> args;
-	
-	vpx_codec_err_t config_err = VPX_CODEC_OK;
-	
-	if(quotedTokenize(txt, args, " =\t\r\n") && args.size() > 0)
+	else if(param == WebMAudioCodec || param == WebMAudioMethod)
 	{
-		args.push_back(""); // so there's always an i+1
+		exParamValues audioCodecP, audioMethodP, audioQualityP, audioBitrateP, sampleRateP;
+		paramSuite->GetParamValue(exID, gIdx, WebMAudioCodec, &audioCodecP);
+		paramSuite->GetParamValue(exID, gIdx, WebMAudioMethod, &audioMethodP);
+		paramSuite->GetParamValue(exID, gIdx, WebMAudioQuality, &audioQualityP);
+		paramSuite->GetParamValue(exID, gIdx, WebMAudioBitrate, &audioBitrateP);
+		paramSuite->GetParamValue(exID, gIdx, ADBEAudioRatePerSecond, &sampleRateP);
 		
-		int i = 0;
+		// Opus only does bitrate, and only at 48k
+		const bool opus = (audioCodecP.value.intValue == WEBM_CODEC_OPUS);
 		
-		while(i < args.size())
-		{
-			const string &arg = args[i];
+		audioMethodP.hidden = opus;
+		audioQualityP.hidden = (opus || audioMethodP.value.intValue == OGG_BITRATE);
+		audioBitrateP.hidden = !audioQualityP.hidden;
 		
-			if(arg == "--noise-sensitivity")
-			{	ConfigureValue(encoder, VP8E_SET_NOISE_SENSITIVITY, args[i + 1]); i++;	}
-
-			else if(arg == "--sharpness")
-			{	ConfigureValue(encoder, VP8E_SET_SHARPNESS, args[i + 1]); i++;	}
-
-			else if(arg == "--cpu-used")
-			{	ConfigureValue(encoder, VP8E_SET_CPUUSED, args[i + 1]); i++;	}
-
-			else if(arg == "--token-parts")
-			{	ConfigureValue(encoder, VP8E_SET_TOKEN_PARTITIONS, args[i + 1]); i++;	}
-
-			else if(arg == "--tile-columns")
-			{	ConfigureValue(encoder, VP9E_SET_TILE_COLUMNS, args[i + 1]); i++;	}
-
-			else if(arg == "--auto-alt-ref")
-			{	ConfigureValue(encoder, VP8E_SET_ENABLEAUTOALTREF, args[i + 1]); i++;	}
-
-			else if(arg == "--arnr-maxframes")
-			{	ConfigureValue(encoder, VP8E_SET_ARNR_MAXFRAMES, args[i + 1]); i++;	}
-
-			else if(arg == "--arnr-strength")
-			{	ConfigureValue(encoder, VP8E_SET_ARNR_STRENGTH, args[i + 1]); i++;	}
-
-			else if(arg == "--arnr-type")
-			{	ConfigureValue(encoder, VP8E_SET_ARNR_TYPE, args[i + 1]); i++;	}
-
-			else if(arg == "--tune")
-			{
-				unsigned int val = args[i + 1] == "psnr" ? VP8_TUNE_PSNR :
-									args[i + 1] == "ssim" ? VP8_TUNE_SSIM :
-									0;
-			
-				ConfigureValue(encoder, VP8E_SET_TUNING, val);
-				i++;
-			}
-
-			else if(arg == "--cq-level")
-			{	ConfigureValue(encoder, VP8E_SET_CQ_LEVEL, args[i + 1]); i++;	}
-			
-			else if(arg == "--max-intra-rate")
-			{	ConfigureValue(encoder, VP8E_SET_MAX_INTRA_BITRATE_PCT, args[i + 1]); i++;	}
-
-			else if(arg == "--lossless")
-			{	ConfigureValue(encoder, VP9E_SET_LOSSLESS, 1);	}
-			
-			
-			i++;	
-		}
+		if(opus)
+			sampleRateP.value.floatValue = 48000.f;
+		
+		sampleRateP.disabled = opus;
 		
-		return true;
+		paramSuite->ChangeParam(exID, gIdx, WebMAudioMethod, &audioMethodP);
+		paramSuite->ChangeParam(exID, gIdx, WebMAudioQuality, &audioQualityP);
+		paramSuite->ChangeParam(exID, gIdx, WebMAudioBitrate, &audioBitrateP);
+		paramSuite->ChangeParam(exID, gIdx, ADBEAudioRatePerSecond, &sampleRateP);
 	}
-	else
-		return false;
-}
+	
+	if(param == WebMVideoSmartRender || param == WebMVideoDASH || param == ADBEVideoAlpha)
+		UpdateSmartRender(privateData, exID, gIdx);
 
+	return malNoError;
+}
@@ -43,26 +43,7 @@
 
 #include "WebM_Premiere_Export.h"
 
-extern "C" {
-#include "vpx/vpx_encoder.h"
-}
-
-typedef enum {
-	WEBM_CODEC_VP8 = 0,
-	WEBM_CODEC_VP9
-} WebM_Video_Codec;
-
-typedef enum {
-	WEBM_METHOD_QUALITY = 0,
-	WEBM_METHOD_BITRATE,
-	WEBM_METHOD_VBR
-} WebM_Video_Method;
-
-typedef enum {
-	WEBM_ENCODING_REALTIME = 0,
-	WEBM_ENCODING_GOOD,
-	WEBM_ENCODING_BEST
-} WebM_Video_Encoding;
+#include "WebM_EncoderConfig.h"
 
 
 #define ADBEVideoAlpha		"ADBEVideoAlpha"
@@ -77,16 +58,22 @@ typedef enum {
 #define WebMVideoQuality	"WebMVideoQuality"
 #define WebMVideoBitrate	"WebMVideoBitrate"
 #define WebMVideoEncoding	"WebMVideoEncoding"
+#define WebMVideoBudgetMode	"WebMVideoBudgetMode"
+#define WebMVideoBudgetMinutes	"WebMVideoBudgetMinutes"
+#define WebMVideoBudgetSpeed	"WebMVideoBudgetSpeed"
+#define WebMVideoSceneCuts	"WebMVideoSceneCuts"
+#define WebMVideoSkipRepeats	"WebMVideoSkipRepeats"
+#define WebMVideoSmartRender	"WebMVideoSmartRender"
+#define WebMVideoRenditions	"WebMVideoRenditions"
+#define WebMVideoProxy		"WebMVideoProxy"
+#define WebMVideoDASH		"WebMVideoDASH"
+#define WebMVideoKeyframeInterval	"WebMVideoKeyframeInterval"
 
 #define WebMCustomGroup		"WebMCustomGroup"
 #define WebMCustomArgs		"WebMCustomArgs"
 
 
-typedef enum {
-	OGG_QUALITY = 0,
-	OGG_BITRATE
-} Ogg_Method;
-
+#define WebMAudioCodec		"WebMAudioCodec"
 #define WebMAudioMethod	"WebMAudioMethod"
 #define WebMAudioQuality	"WebMAudioQuality"
 #define WebMAudioBitrate	"WebMAudioBitrate"
@@ -120,9 +107,4 @@ exSDKValidateParamChanged (
 	exParamChangedRec	*validateParamChangedRecP);
 	
 
-bool ConfigureEncoderPre(vpx_codec_enc_cfg_t &config, const char *txt);
-
-bool ConfigureEncoderPost(vpx_codec_ctx_t *encoder, const char *txt);
-
-
 #endif // WEBM_PREMIERE_EXPORT_PARAMS_H
\ No newline at end of file
@@ -39,22 +39,15 @@
 
 #include "WebM_Premiere_Import.h"
 
+#include "WebM_Import.h"
 
-extern "C" {
-
-#include "vpx/vpx_decoder.h"
-#include "vpx/vp8dx.h"
-
-#include <vorbis/codec.h>
-
-}
-
-#include "mkvparser.hpp"
+#include "WebM_Color.h"
 
 #include <assert.h>
-#include <math.h>
+#include <stdlib.h>
 
 #include <string>
+#include <vector>
 
 #ifdef PRMAC_ENV
 	#include <mach/mach.h>
@@ -62,6 +55,18 @@ extern "C" {
 
 int g_num_cpus = 1;
 
+// Set WEBM_KEYFRAMES_ONLY=1 in the environment to always get the fast,
+// keyframes-only scrubbing, not just when Premiere asks for draft frames.
+static bool g_keyframes_only = false;
+
+// Trading decode speed for quality, set with WEBM_DECODE in the environment:
+// "fast", "postproc" or "mfqe" (see WebM_Decode_Mode).
+static WebM_Decode_Mode g_decode_mode = WEBM_DECODE_NORMAL;
+
+// Fast frames are cached in their own stream, so a high quality request
+// (pausing, rendering) never gets one by mistake.
+#define FAST_DECODE_STREAM	1
+
 
 
 #if IMPORTMOD_VERSION <= IMPORTMOD_VERSION_9
@@ -73,50 +78,80 @@ typedef PrSDKPPixCacheSuite PrCacheSuite;
 #endif
 
 
-class PrMkvReader : public mkvparser::IMkvReader
+class PrMkvReader : public WebM_Reader
 {
   public:
 	PrMkvReader(imFileRef fileRef);
 	virtual ~PrMkvReader() {}
 	
 	virtual int Read(long long pos, long len, unsigned char* buf);
-	virtual int Length(long long* total, long long* available);
 	
 	const imFileRef FileRef() const { return _fileRef; }
 	
-	enum {
-		PrMkvError = -1,
-		PrMkvSuccess = 0
-	};
+	// When Premiere quiets the file, the handle goes away but the reader
+	// (and the Segment that points to it) stays.  Reopening attaches the new one.
+	void Attach(imFileRef fileRef);
+	void Detach();
 	
-  private:
-	const imFileRef _fileRef;
+  protected:
+	virtual long long FileSize() const;
 	
-	long long _size;
+  private:
+	imFileRef _fileRef;
 };
 
 
 PrMkvReader::PrMkvReader(imFileRef fileRef) :
-	_fileRef(fileRef),
-	_size(-1)
+	_fileRef(reinterpret_cast<imFileRef>(imInvalidHandleValue))
 {
+	Attach(fileRef);
+}
+
+
+long long
+PrMkvReader::FileSize() const
+{
+	if(_fileRef == imInvalidHandleValue)
+		return -1;
+	
 #ifdef PRWIN_ENV
 	LARGE_INTEGER len;
 
 	BOOL ok = GetFileSizeEx(_fileRef, &len);
 	
 	if(ok)
-		_size = len.QuadPart;
+		return len.QuadPart;
 #else
 	SInt64 fork_size = 0;
 	
 	OSErr result = FSGetForkSize(CAST_REFNUM(_fileRef), &fork_size);
 		
 	if(result == noErr)
-		_size = fork_size;
+		return fork_size;
 #endif
+
+	return -1;
+}
+
+
+void
+PrMkvReader::Attach(imFileRef fileRef)
+{
+	_fileRef = fileRef;
+	
+	UpdateSize();
 }
 
+
+void
+PrMkvReader::Detach()
+{
+	_fileRef = reinterpret_cast<imFileRef>(imInvalidHandleValue);
+	
+	ForgetSize();
+}
+
+
 int PrMkvReader::Read(long long pos, long len, unsigned char* buf)
 {
 #ifdef PRWIN_ENV
@@ -130,56 +165,26 @@ int PrMkvReader::Read(long long pos, long len, unsigned char* buf)
 	
 	result = ReadFile(_fileRef, (LPVOID)buf, count, &out2, NULL);
 
-	return (result && len == out2) ? PrMkvSuccess : PrMkvError;
+	return (result && len == out2) ? WebM_ReadSuccess : WebM_ReadError;
 #else
 	ByteCount count = len, out = 0;
 	
 	OSErr result = FSReadFork(CAST_REFNUM(_fileRef), fsFromStart, pos, count, buf, &out);
 
-	return (result == noErr && len == out) ? PrMkvSuccess : PrMkvError;
+	return (result == noErr && len == out) ? WebM_ReadSuccess : WebM_ReadError;
 #endif
 }
 
 
-int PrMkvReader::Length(long long* total, long long* available)
-{
-	// total appears to mean the total length of the file, while
-	// available means the amount of data that has been downloaded,
-	// as in for a stream.  For a disk-based file, these two are the same.
-	
-	if(_size >= 0)
-	{
-		*total = *available = _size;
-		
-		return PrMkvSuccess;
-	}
-	else
-		return PrMkvError;
-}
-
-
-typedef enum {
-	CODEC_NONE = 0,
-	CODEC_VP8,
-	CODEC_VP9
-} VideoCodec;
-
 typedef struct
 {	
 	csSDK_int32				importerID;
 	csSDK_int32				fileType;
-	csSDK_int32				width;
-	csSDK_int32				height;
-	csSDK_int32				frameRateNum;
-	csSDK_int32				frameRateDen;
 	float					audioSampleRate;
 	int						numChannels;
 	
-	PrMkvReader				*reader;
-	mkvparser::Segment		*segment;
-	int						video_track;
-	VideoCodec				video_codec;
-	int						audio_track;
+	WebM_Clip				*clip;		// everything we learned from parsing the file
+	PrMkvReader				*reader;	// (the clip owns it)
 	
 	PlugMemoryFuncsPtr		memFuncs;
 	SPBasicSuite			*BasicSuite;
@@ -230,6 +235,22 @@ SDKInit(
 	g_num_cpus = systemInfo.dwNumberOfProcessors;
 #endif
 
+	const char *keyframes_only = getenv("WEBM_KEYFRAMES_ONLY");
+	
+	g_keyframes_only = (keyframes_only != NULL && keyframes_only[0] != '\0' && keyframes_only[0] != '0');
+	
+	const char *decode_mode = getenv("WEBM_DECODE");
+	
+	if(decode_mode != NULL)
+	{
+		const std::string mode(decode_mode);
+		
+		g_decode_mode = (mode == "fast" ? WEBM_DECODE_FAST :
+							mode == "postproc" ? WEBM_DECODE_POSTPROC :
+							mode == "mfqe" ? WEBM_DECODE_MFQE :
+							WEBM_DECODE_NORMAL);
+	}
+
 	return malNoError;
 }
 
@@ -277,6 +298,17 @@ SDKGetIndFormat(
 }
 
 
+// Everything we learned from parsing the file
+static void
+DisposeParsedFile(ImporterLocalRec8Ptr localRecP)
+{
+	delete localRecP->clip; // and the reader
+	
+	localRecP->clip = NULL;
+	localRecP->reader = NULL;
+}
+
+
 prMALError 
 SDKOpenFile8(
 	imStdParms		*stdParms, 
@@ -305,11 +337,8 @@ SDKOpenFile8(
 
 		localRecP = reinterpret_cast<ImporterLocalRec8Ptr>( *localRecH );
 		
+		localRecP->clip = NULL;
 		localRecP->reader = NULL;
-		localRecP->segment = NULL;
-		localRecP->video_track = -1;
-		localRecP->video_codec = CODEC_NONE;
-		localRecP->audio_track = -1;
 		
 		// Acquire needed suites
 		localRecP->memFuncs = stdParms->piSuites->memFuncs;
@@ -337,9 +366,10 @@ SDKOpenFile8(
 		const prUTF16Char *path = SDKfileOpenRec8->fileinfo.filepath;
 	
 	#ifdef PRWIN_ENV
+		// FILE_SHARE_WRITE so we can open a file that's still being captured
 		HANDLE fileH = CreateFileW(path,
 									GENERIC_READ,
-									FILE_SHARE_READ,
+									FILE_SHARE_READ | FILE_SHARE_WRITE,
 									NULL,
 									OPEN_EXISTING,
 									FILE_ATTRIBUTE_NORMAL,
@@ -390,70 +420,28 @@ SDKOpenFile8(
 
 	}
 
-	if(result == malNoError && localRecP->reader == NULL)
+	// Coming back from being quiet.  If the file is the same as before,
+	// everything we parsed still holds, it just needs the new handle.
+	if(result == malNoError && localRecP->clip != NULL)
 	{
-		assert(localRecP->segment == NULL);
-	
-		localRecP->reader = new PrMkvReader(*SDKfileRef);
+		localRecP->reader->Attach(*SDKfileRef);
 		
-		long long pos = 0;
-
-		mkvparser::EBMLHeader ebmlHeader;
+		if( !localRecP->clip->Reopen(SDKfileOpenRec8->fileinfo.filepath) )
+			DisposeParsedFile(localRecP);
+	}
 
-		ebmlHeader.Parse(localRecP->reader, pos);
+	if(result == malNoError && localRecP->clip == NULL)
+	{
+		localRecP->reader = new PrMkvReader(*SDKfileRef);
 		
-		long long ret = mkvparser::Segment::CreateInstance(localRecP->reader, pos, localRecP->segment);
+		localRecP->clip = new WebM_Clip(localRecP->importerID);
 		
-		if(ret >= 0 && localRecP->segment != NULL)
-		{
-			ret = localRecP->segment->Load();
-			
-			if(ret >= 0)
-			{
-				const mkvparser::Tracks* pTracks = localRecP->segment->GetTracks();
-				
-				for(int t=0; t < pTracks->GetTracksCount(); t++)
-				{
-					const mkvparser::Track* const pTrack = pTracks->GetTrackByIndex(t);
-					
-					if(pTrack != NULL)
-					{
-						const long trackType = pTrack->GetType();
-						const long trackNumber = pTrack->GetNumber();
-						
-						if(trackType == mkvparser::Track::kVideo)
-						{
-							const mkvparser::VideoTrack* const pVideoTrack = static_cast<const mkvparser::VideoTrack*>(pTrack);
-							
-							if(pVideoTrack)
-							{
-								localRecP->video_codec = pVideoTrack->GetCodecId() == std::string("V_VP8") ? CODEC_VP8 :
-															pVideoTrack->GetCodecId() == std::string("V_VP9") ? CODEC_VP9 :
-															CODEC_NONE;
-							
-								localRecP->video_track = trackNumber;
-							}
-						}
-						else if(trackType == mkvparser::Track::kAudio)
-						{
-							const mkvparser::AudioTrack* const pAudioTrack = static_cast<const mkvparser::AudioTrack*>(pTrack);
-							
-							if(pAudioTrack)
-							{
-								localRecP->audio_track = trackNumber;
-							}
-						}
- 					}
-				}
-				
-				if(localRecP->video_track == -1 && localRecP->audio_track == -1)
-				{
-					result = imFileHasNoImportableStreams;
-				}
-			}
-		}
-		else
-			result = imBadHeader;
+		const WebM_Result open_result = localRecP->clip->Open(localRecP->reader, SDKfileOpenRec8->fileinfo.filepath);
+		
+		result = (open_result == WEBM_OK ? malNoError :
+					open_result == WEBM_ERR_NO_STREAMS ? imFileHasNoImportableStreams :
+					open_result == WEBM_ERR_MEMORY ? imMemErr :
+					imBadHeader);
 	}
 	
 	// close file and delete private data if we got a bad file
@@ -461,6 +449,9 @@ SDKOpenFile8(
 	{
 		if(SDKfileOpenRec8->privatedata)
 		{
+			if(localRecP)
+				DisposeParsedFile(localRecP);
+			
 			stdParms->piSuites->memFuncs->disposeHandle(reinterpret_cast<PrMemoryHandle>(SDKfileOpenRec8->privatedata));
 			SDKfileOpenRec8->privatedata = NULL;
 		}
@@ -475,6 +466,7 @@ SDKOpenFile8(
 
 
 
+
 static prMALError 
 SDKQuietFile(
 	imStdParms			*stdParms, 
@@ -483,7 +475,8 @@ SDKQuietFile(
 {
 	// "Quiet File" really means close the file handle, but we're still
 	// using it and might open it again, so hold on to any stored data
-	// structures you don't want to re-create.
+	// structures you don't want to re-create.  That's everything we parsed:
+	// Premiere quiets files all the time when a project has lots of clips.
 
 	// If file has not yet been closed
 	if(SDKfileRef && *SDKfileRef != imInvalidHandleValue)
@@ -494,19 +487,11 @@ SDKQuietFile(
 
 		ImporterLocalRec8Ptr localRecP = reinterpret_cast<ImporterLocalRec8Ptr>( *ldataH );
 
-		if(localRecP->segment)
-		{
-			delete localRecP->segment;
-			
-			localRecP->segment = NULL;
-		}
-		
 		if(localRecP->reader)
-		{
-			delete localRecP->reader;
-			
-			localRecP->reader = NULL;
-		}
+			localRecP->reader->Detach();
+		
+		if(localRecP->clip)
+			localRecP->clip->Quiet();
 
 		stdParms->piSuites->memFuncs->unlockHandle(reinterpret_cast<char**>(ldataH));
 
@@ -544,6 +529,8 @@ SDKCloseFile(
 		stdParms->piSuites->memFuncs->lockHandle(reinterpret_cast<char**>(ldataH));
 
 		ImporterLocalRec8Ptr localRecP = reinterpret_cast<ImporterLocalRec8Ptr>( *ldataH );
+		
+		DisposeParsedFile(localRecP);
 
 		localRecP->BasicSuite->ReleaseSuite(kPrSDKPPixCreatorSuite, kPrSDKPPixCreatorSuiteVersion);
 		localRecP->BasicSuite->ReleaseSuite(kPrSDKPPixCacheSuite, PrCacheVersion);
@@ -559,6 +546,8 @@ SDKCloseFile(
 }
 
 
+
+
 static prMALError 
 SDKGetIndPixelFormat(
 	imStdParms			*stdParms,
@@ -566,137 +555,102 @@ SDKGetIndPixelFormat(
 	imIndPixelFormatRec	*SDKIndPixelFormatRec) 
 {
 	prMALError	result	= malNoError;
-	//ImporterLocalRec8H	ldataH	= reinterpret_cast<ImporterLocalRec8H>(SDKIndPixelFormatRec->privatedata);
-
-	switch(idx)
-	{
-		case 0:
-			SDKIndPixelFormatRec->outPixelFormat = PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709;
-			break;
+	ImporterLocalRec8H	ldataH	= reinterpret_cast<ImporterLocalRec8H>(SDKIndPixelFormatRec->privatedata);
 	
-		default:
-			result = imBadFormatIndex;
-			break;
-	}
+	// YUV can't carry alpha, so those clips come as BGRA first
+	const bool has_alpha = (ldataH != NULL && *ldataH != NULL && (*ldataH)->clip != NULL && (*ldataH)->clip->HasAlpha());
+	
+	const PrPixelFormat alpha_formats[] = {	PrPixelFormat_BGRA_4444_8u,
+											PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709 };
+	
+	const PrPixelFormat formats[] = { PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709 };
+	
+	const csSDK_size_t count = (has_alpha ? 2 : 1);
+	
+	if(idx < count)
+		SDKIndPixelFormatRec->outPixelFormat = (has_alpha ? alpha_formats[idx] : formats[idx]);
+	else
+		result = imBadFormatIndex;
 
 	return result;	
 }
 
 
-// TODO: Support imDataRateAnalysis and we'll get a pretty graph in the Properties panel!
-// Sounds like a good task for someone who wants to contribute to this open source project.
-
-
 static prMALError 
-SDKAnalysis(
-	imStdParms		*stdParms,
-	imFileRef		SDKfileRef,
-	imAnalysisRec	*SDKAnalysisRec)
+SDKDataRateAnalysis(
+	imStdParms				*stdParms,
+	imFileRef				SDKfileRef,
+	imDataRateAnalysisRec	*SDKDataRateRec)
 {
-	// Is this all I'm supposed to do here?
-	// The string shows up in the properties dialog.
-	ImporterLocalRec8H ldataH = reinterpret_cast<ImporterLocalRec8H>(SDKAnalysisRec->privatedata);
-	ImporterLocalRec8Ptr localRecP = reinterpret_cast<ImporterLocalRec8Ptr>( *ldataH );
-
-	const char *properties_messsage = localRecP->video_codec == CODEC_VP8 ? "VP8 codec" :
-										localRecP->video_codec == CODEC_VP9 ? "VP9 codec" :
-										"Unknown codec";
-
-	if(SDKAnalysisRec->buffersize > strlen(properties_messsage))
-		strcpy(SDKAnalysisRec->buffer, properties_messsage);
-
-	return malNoError;
-}
-
+	// This gets us a pretty graph in the Properties panel.
+	// Frame sizes and keyframes all came from the block headers when we built
+	// the index, so we don't have to go back to the file for any of this.
+	prMALError result = malNoError;
 
-static void
-webm_guess_framerate(mkvparser::Segment *segment,
-						int				video_track,
-						unsigned int	*fps_den,
-						unsigned int	*fps_num)
-{
-	// Quite a way to deduce the framerate.  Of course *we* are flagging
-	// our WebM files with the appropriate frame rate, but many files
-	// do not have it.  They just play sound and then pop frames on screen
-	// at the right timestamp.  What a life.
-	// But some of us have to work for a living, so we watch the
-	// timestamps go by and make a judgement to tell our host.
-
-	unsigned int frame = 0;
-	uint64_t     tstamp = 0;
-
-	const mkvparser::Cluster* pCluster = segment->GetFirst();
-	const mkvparser::Tracks* pTracks = segment->GetTracks();
-
-	long status = 0;
-
-	while( (pCluster != NULL) && !pCluster->EOS() && status >= 0 && tstamp < 1000000000 && frame < 50)
+	ImporterLocalRec8H ldataH = reinterpret_cast<ImporterLocalRec8H>(SDKDataRateRec->privatedata);
+	ImporterLocalRec8Ptr localRecP = reinterpret_cast<ImporterLocalRec8Ptr>( *ldataH );
+	
+	WebM_Clip *clip = localRecP->clip;
+	
+	if(clip && clip->IsOpen() && clip->HasVideo() && clip->FpsDen() > 0)
 	{
-		const mkvparser::BlockEntry* pBlockEntry = NULL;
-		
-		status = pCluster->GetFirst(pBlockEntry);
+		std::vector<WebM_DataSample> data_samples;
 		
-		while( (pBlockEntry != NULL) && !pBlockEntry->EOS() && status >= 0 && tstamp < 1000000000 && frame < 50)
+		if( WebM_DataRate(clip->Index(), clip->FpsNum(), clip->FpsDen(), data_samples) )
 		{
-			const mkvparser::Block* const pBlock  = pBlockEntry->GetBlock();
-			const long long trackNum = pBlock->GetTrackNumber();
+			const csSDK_int32 num_samples = data_samples.size();
 			
-			if(trackNum == video_track)
+			char **sampleH = stdParms->piSuites->memFuncs->newHandle(num_samples * sizeof(imDataSample));
+			
+			if(sampleH)
 			{
-				const unsigned long tn = static_cast<unsigned long>(trackNum);
-				const mkvparser::Track* const pTrack = pTracks->GetTrackByNumber(tn);
+				imDataSample *samples = reinterpret_cast<imDataSample *>(*sampleH);
 				
-				if(pTrack)
+				for(csSDK_int32 s=0; s < num_samples; s++)
 				{
-					assert(pTrack->GetType() == mkvparser::Track::kVideo);
-					assert(pBlock->GetFrameCount() == 1);
-					
-					tstamp = pBlock->GetTime(pCluster);
+					samples[s].sampledur = data_samples[s].duration;
 					
-					frame++;
+					// high bit marks a keyframe
+					samples[s].samplesize = (data_samples[s].size & 0x7fffffff) | (data_samples[s].keyframe ? 0x80000000 : 0);
 				}
+				
+				SDKDataRateRec->buffer = sampleH;
+				SDKDataRateRec->baserate = clip->FpsNum();
 			}
-			
-			status = pCluster->GetNext(pBlockEntry, pBlockEntry);
+			else
+				result = imMemErr;
 		}
-		
-		pCluster = segment->GetNext(pCluster);
+		else
+			result = imNoContent;
 	}
+	else
+		result = imUnsupported;
+	
+	return result;
+}
 
 
-	// known frame rates
-	static const int frameRateNumDens[10][2] = {{10, 1}, {15, 1}, {24000, 1001},
-												{24, 1}, {25, 1}, {30000, 1001},
-												{30, 1}, {50, 1}, {60000, 1001},
-												{60, 1}};
-
-	double fps = (double)(frame - 1) * 1000000000.0 / (double)tstamp;
-
-	int match_index = -1;
-	double match_episilon = 999;
+static prMALError 
+SDKAnalysis(
+	imStdParms		*stdParms,
+	imFileRef		SDKfileRef,
+	imAnalysisRec	*SDKAnalysisRec)
+{
+	// Is this all I'm supposed to do here?
+	// The string shows up in the properties dialog.
+	ImporterLocalRec8H ldataH = reinterpret_cast<ImporterLocalRec8H>(SDKAnalysisRec->privatedata);
+	ImporterLocalRec8Ptr localRecP = reinterpret_cast<ImporterLocalRec8Ptr>( *ldataH );
+	
+	const WebM_Clip_Codec codec = (localRecP->clip != NULL ? localRecP->clip->Codec() : WEBM_CLIP_NONE);
 
-	for(int i=0; i < 10; i++)
-	{
-		double rate = (double)frameRateNumDens[i][0] / (double)frameRateNumDens[i][1];
-		double episilon = fabs(fps - rate);
+	const char *properties_messsage = codec == WEBM_CLIP_VP8 ? "VP8 codec" :
+										codec == WEBM_CLIP_VP9 ? "VP9 codec" :
+										"Unknown codec";
 
-		if(episilon < match_episilon)
-		{
-			match_index = i;
-			match_episilon = episilon;
-		}
-	}
+	if(SDKAnalysisRec->buffersize > strlen(properties_messsage))
+		strcpy(SDKAnalysisRec->buffer, properties_messsage);
 
-	if(match_index >=0 && match_episilon < 0.01)
-	{
-		*fps_num = frameRateNumDens[match_index][0];
-		*fps_den = frameRateNumDens[match_index][1];
-	}
-	else
-	{
-		*fps_num = (fps * 1000.0) + 0.5;
-		*fps_den = 1000;
-	}
+	return malNoError;
 }
 
 
@@ -712,7 +666,7 @@ SDKGetInfo8(
 	SDKFileInfo8->vidInfo.supportsAsyncIO			= kPrFalse;
 	SDKFileInfo8->vidInfo.supportsGetSourceVideo	= kPrTrue;
 	SDKFileInfo8->vidInfo.hasPulldown				= kPrFalse;
-	SDKFileInfo8->hasDataRate						= kPrFalse;
+	SDKFileInfo8->hasDataRate						= kPrFalse;	// set below if there's video
 
 
 	// private data
@@ -726,107 +680,65 @@ SDKGetInfo8(
 	SDKFileInfo8->hasAudio = kPrFalse;
 	
 	
-	if(localRecP && localRecP->segment)
+	WebM_Clip *clip = (localRecP ? localRecP->clip : NULL);
+	
+	if(clip && clip->IsOpen())
 	{
-		const mkvparser::SegmentInfo* const pSegmentInfo = localRecP->segment->GetInfo();
-		
-		const long long duration = pSegmentInfo->GetDuration();
+		clip->Update();
 		
-		const mkvparser::Tracks* pTracks = localRecP->segment->GetTracks();
+		const long long duration = clip->Duration();
 		
-		if(localRecP->video_track >= 0)
+		if( clip->HasVideo() )
 		{
-			const mkvparser::Track* const pTrack = pTracks->GetTrackByNumber(localRecP->video_track);
+			// worked out when we built the index
+			const unsigned int fps_num = clip->FpsNum();
+			const unsigned int fps_den = clip->FpsDen();
 			
-			if(pTrack != NULL)
-			{
-				const long trackType = pTrack->GetType();
 			
-				if(trackType == mkvparser::Track::kVideo)
-				{
-					const mkvparser::VideoTrack* const pVideoTrack = static_cast<const mkvparser::VideoTrack*>(pTrack);
-					
-					if(pVideoTrack)
-					{
-						const double embedded_rate = pVideoTrack->GetFrameRate(); // never seems to contain anything
-						
-						unsigned int fps_num = 0;
-						unsigned int fps_den = 0;
-						
-						webm_guess_framerate(localRecP->segment, localRecP->video_track, &fps_den, &fps_num);
-
-						if(embedded_rate > 0)
-							assert( fabs(embedded_rate - ((double)fps_num / (double)fps_den)) < 0.01 );
-						
-						
-						// Video information
-						SDKFileInfo8->hasVideo				= kPrTrue;
-						SDKFileInfo8->vidInfo.subType		= PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709;
-						SDKFileInfo8->vidInfo.imageWidth	= pVideoTrack->GetWidth();
-						SDKFileInfo8->vidInfo.imageHeight	= pVideoTrack->GetHeight();
-						SDKFileInfo8->vidInfo.depth			= 24;	// for RGB, no A
-						SDKFileInfo8->vidInfo.fieldType		= prFieldsUnknown; // Matroska talk about DefaultDecodedFieldDuration but...
-						SDKFileInfo8->vidInfo.isStill		= kPrFalse;
-						SDKFileInfo8->vidInfo.noDuration	= imNoDurationFalse;
-						SDKFileInfo8->vidDuration			= duration * fps_num / 1000000000UL;
-						SDKFileInfo8->vidScale				= fps_num;
-						SDKFileInfo8->vidSampleSize			= fps_den;
-
-						SDKFileInfo8->vidInfo.alphaType		= alphaNone;
-
-						// Matroska defined a chunk called DisplayUnit, but libwebm doesn't support it
-						// http://www.matroska.org/technical/specs/index.html#DisplayUnit
-						// We'll just let Premiere guess what the pixel aspect ratio is
-						//SDKFileInfo8->vidInfo.pixelAspectNum = 1;
-						//SDKFileInfo8->vidInfo.pixelAspectDen = 1;
-
-						// store some values we want to get without going to the file
-						localRecP->width = SDKFileInfo8->vidInfo.imageWidth;
-						localRecP->height = SDKFileInfo8->vidInfo.imageHeight;
-
-						localRecP->frameRateNum = SDKFileInfo8->vidScale;
-						localRecP->frameRateDen = SDKFileInfo8->vidSampleSize;
-					}
-				}
-			}
+			// Video information
+			SDKFileInfo8->hasVideo				= kPrTrue;
+			SDKFileInfo8->hasDataRate			= kPrTrue;
+			SDKFileInfo8->vidInfo.subType		= PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709;
+			SDKFileInfo8->vidInfo.imageWidth	= clip->Width();
+			SDKFileInfo8->vidInfo.imageHeight	= clip->Height();
+			SDKFileInfo8->vidInfo.depth			= (clip->HasAlpha() ? 32 : 24);	// for RGB, plus A if we have it
+			SDKFileInfo8->vidInfo.fieldType		= prFieldsUnknown; // Matroska talk about DefaultDecodedFieldDuration but...
+			SDKFileInfo8->vidInfo.isStill		= kPrFalse;
+			SDKFileInfo8->vidInfo.noDuration	= imNoDurationFalse;
+			SDKFileInfo8->vidDuration			= duration * fps_num / 1000000000UL;
+			SDKFileInfo8->vidScale				= fps_num;
+			SDKFileInfo8->vidSampleSize			= fps_den;
+
+			SDKFileInfo8->vidInfo.alphaType		= (clip->HasAlpha() ? alphaStraight : alphaNone);
+
+			// Matroska defined a chunk called DisplayUnit, but libwebm doesn't support it
+			// http://www.matroska.org/technical/specs/index.html#DisplayUnit
+			// We'll just let Premiere guess what the pixel aspect ratio is
+			//SDKFileInfo8->vidInfo.pixelAspectNum = 1;
+			//SDKFileInfo8->vidInfo.pixelAspectDen = 1;
 		}
 		
-		if(localRecP->audio_track >= 0)
+		if( clip->HasAudio() )
 		{
-			const mkvparser::Track* const pTrack = pTracks->GetTrackByNumber(localRecP->audio_track);
+			const int bitDepth = clip->AudioBitDepth();
 			
-			if(pTrack != NULL)
-			{
-				const long trackType = pTrack->GetType();
-				
-				if(trackType == mkvparser::Track::kAudio)
-				{
-					const mkvparser::AudioTrack* const pAudioTrack = static_cast<const mkvparser::AudioTrack*>(pTrack);
-					
-					if(pAudioTrack)
-					{
-						const long long bitDepth = pAudioTrack->GetBitDepth();
-						
-						
-						// Audio information
-						SDKFileInfo8->hasAudio				= kPrTrue;
-						SDKFileInfo8->audInfo.numChannels	= pAudioTrack->GetChannels();
-						SDKFileInfo8->audInfo.sampleRate	= pAudioTrack->GetSamplingRate();
-						SDKFileInfo8->audInfo.sampleType	= bitDepth == 8 ? kPrAudioSampleType_8BitInt :
-																bitDepth == 16 ? kPrAudioSampleType_16BitInt :
-																bitDepth == 24 ? kPrAudioSampleType_24BitInt :
-																bitDepth == 32 ? kPrAudioSampleType_32BitFloat :
-																bitDepth == 64 ? kPrAudioSampleType_64BitFloat :
-																kPrAudioSampleType_Compressed;
-																
-						SDKFileInfo8->audDuration			= (uint64_t)SDKFileInfo8->audInfo.sampleRate * duration / 1000000000UL;
-						
-						
-						localRecP->audioSampleRate			= SDKFileInfo8->audInfo.sampleRate;
-						localRecP->numChannels				= SDKFileInfo8->audInfo.numChannels;
-					}
-				}
-			}
+			
+			// Audio information
+			SDKFileInfo8->hasAudio				= kPrTrue;
+			SDKFileInfo8->audInfo.numChannels	= clip->AudioChannels();
+			SDKFileInfo8->audInfo.sampleRate	= clip->AudioSampleRate();
+			SDKFileInfo8->audInfo.sampleType	= bitDepth == 8 ? kPrAudioSampleType_8BitInt :
+													bitDepth == 16 ? kPrAudioSampleType_16BitInt :
+													bitDepth == 24 ? kPrAudioSampleType_24BitInt :
+													bitDepth == 32 ? kPrAudioSampleType_32BitFloat :
+													bitDepth == 64 ? kPrAudioSampleType_64BitFloat :
+													kPrAudioSampleType_Compressed;
+													
+			SDKFileInfo8->audDuration			= (uint64_t)SDKFileInfo8->audInfo.sampleRate * duration / 1000000000UL;
+			
+			
+			localRecP->audioSampleRate			= SDKFileInfo8->audInfo.sampleRate;
+			localRecP->numChannels				= SDKFileInfo8->audInfo.numChannels;
 		}
 	}
 		
@@ -847,37 +759,157 @@ SDKPreferredFrameSize(
 	stdparms->piSuites->memFuncs->lockHandle(reinterpret_cast<char**>(ldataH));
 
 	ImporterLocalRec8Ptr localRecP = reinterpret_cast<ImporterLocalRec8Ptr>( *ldataH );
+	
+	// The full size, then the proxy's if there's one, so Premiere knows
+	// to ask for it.  Anything smaller than the full size is decoded
+	// from the proxy.
+	int width = 0, height = 0;
+	
+	if(localRecP->clip && localRecP->clip->FrameSize(preferredFrameSizeRec->inIndex, width, height))
+	{
+		preferredFrameSizeRec->outWidth = width;
+		preferredFrameSizeRec->outHeight = height;
+	}
+	else
+		result = malNoError;
+
+
+	stdparms->piSuites->memFuncs->unlockHandle(reinterpret_cast<char**>(ldataH));
+
+	return result;
+}
+
+
+// Decoded frames go into PPixes and Premiere's frame cache
+class PremiereFrameSink : public WebM_FrameSink
+{
+  public:
+	PremiereFrameSink(ImporterLocalRec8Ptr localRecP, imSourceVideoRec *sourceVideoRec, csSDK_int32 theFrame, bool keyframes_only);
+	virtual ~PremiereFrameSink() {}
+	
+	virtual bool InCache(long frame);
+	
+	virtual WebM_Result Frame(long frame, const vpx_image_t *img, const vpx_image_t *alpha,
+								bool wanted, bool cache, bool fast);
+	
+  private:
+	ImporterLocalRec8Ptr _localRecP;
+	imSourceVideoRec *_sourceVideoRec;
+	const csSDK_int32 _theFrame;
+	const bool _keyframes_only;
+};
+
+
+PremiereFrameSink::PremiereFrameSink(ImporterLocalRec8Ptr localRecP, imSourceVideoRec *sourceVideoRec, csSDK_int32 theFrame, bool keyframes_only) :
+	_localRecP(localRecP),
+	_sourceVideoRec(sourceVideoRec),
+	_theFrame(theFrame),
+	_keyframes_only(keyframes_only)
+{
+
+}
+
+
+bool
+PremiereFrameSink::InCache(long frame)
+{
+	prSuiteError cache_err = _localRecP->PPixCacheSuite->GetFrameFromCache(	_localRecP->importerID,
+																			0,
+																			frame,
+																			1,
+																			_sourceVideoRec->inFrameFormats,
+																			_sourceVideoRec->outFrame,
+																			NULL,
+																			NULL);
+	
+	return (cache_err == suiteError_NoError);
+}
 
 
-	// TODO: Make sure it really isn't possible to decode a smaller frame
-	bool can_shrink = false;
+WebM_Result
+PremiereFrameSink::Frame(long frame, const vpx_image_t *img, const vpx_image_t *alpha,
+							bool wanted, bool cache, bool fast)
+{
+	const imFrameFormat *frameFormat = &_sourceVideoRec->inFrameFormats[0];
+	
+	// Windows and MacOS have different definitions of Rects, so use the cross-platform prSetRect
+	prRect theRect;
+	prSetRect(&theRect, 0, 0, frameFormat->inFrameWidth, frameFormat->inFrameHeight);
+	
+	assert(frameFormat->inFrameHeight == img->d_h);
+	assert(frameFormat->inFrameWidth == img->d_w);
+	
+	PPixHand ppix;
+	
+	_localRecP->PPixCreatorSuite->CreatePPix(&ppix, PrPPixBufferAccess_ReadWrite, frameFormat->inPixelFormat, &theRect);
 
-	if(preferredFrameSizeRec->inIndex == 0)
+	if(frameFormat->inPixelFormat == PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709)
 	{
-		preferredFrameSizeRec->outWidth = localRecP->width;
-		preferredFrameSizeRec->outHeight = localRecP->height;
+		char *Y_PixelAddress, *U_PixelAddress, *V_PixelAddress;
+		csSDK_uint32 Y_RowBytes, U_RowBytes, V_RowBytes;
+		
+		_localRecP->PPix2Suite->GetYUV420PlanarBuffers(ppix, PrPPixBufferAccess_ReadWrite,
+														&Y_PixelAddress, &Y_RowBytes,
+														&U_PixelAddress, &U_RowBytes,
+														&V_PixelAddress, &V_RowBytes);
+		
+		WebM_CopyImageToYUV420(img,
+								(unsigned char *)Y_PixelAddress, Y_RowBytes,
+								(unsigned char *)U_PixelAddress, U_RowBytes,
+								(unsigned char *)V_PixelAddress, V_RowBytes);
+	}
+	else if(frameFormat->inPixelFormat == PrPixelFormat_BGRA_4444_8u)
+	{
+		// we only offer this one for clips with alpha
+		char *frameBufferP = NULL;
+		csSDK_int32 rowbytes = 0;
+		
+		_localRecP->PPixSuite->GetPixels(ppix, PrPPixBufferAccess_ReadWrite, &frameBufferP);
+		_localRecP->PPixSuite->GetRowBytes(ppix, &rowbytes);
+		
+		// upside down, like the BGRA the exporter gets
+		WebM_CopyImageToBGRA8(img, alpha, (unsigned char *)frameBufferP, rowbytes, true);
 	}
 	else
+		assert(false); // looks like Premiere is happy to always give me this kind of buffer
+	
+	const int cache_stream = (fast ? FAST_DECODE_STREAM : 0);
+	
+	if(cache)
 	{
-		// we store width and height in private data so we can produce it here
-		const int divisor = pow(2.0, preferredFrameSizeRec->inIndex);
+		_localRecP->PPixCacheSuite->AddFrameToCache(_localRecP->importerID,
+													cache_stream,
+													ppix,
+													frame,
+													NULL,
+													NULL);
+	}
+	
+	// Usually frame == theFrame, but if the exporter skipped
+	// repeated frames, the one we want started a little earlier.
+	if(wanted)
+	{
+		*_sourceVideoRec->outFrame = ppix;
 		
-		if(can_shrink &&
-			preferredFrameSizeRec->inIndex < 4 &&
-			localRecP->width % divisor == 0 &&
-			localRecP->height % divisor == 0 )
+		// so the next time we're asked for this one, it's in the cache
+		if(frame != _theFrame && !_keyframes_only)
 		{
-			preferredFrameSizeRec->outWidth = localRecP->width / divisor;
-			preferredFrameSizeRec->outHeight = localRecP->height / divisor;
+			_localRecP->PPixCacheSuite->AddFrameToCache(_localRecP->importerID,
+														cache_stream,
+														ppix,
+														_theFrame,
+														NULL,
+														NULL);
 		}
-		else
-			result = malNoError;
 	}
-
-
-	stdparms->piSuites->memFuncs->unlockHandle(reinterpret_cast<char**>(ldataH));
-
-	return result;
+	else
+	{
+		// Premiere copied the frame to its cache, so we dispose ours.
+		// Very obvious memory leak if we don't.
+		_localRecP->PPixSuite->Dispose(ppix);
+	}
+	
+	return WEBM_OK;
 }
 
 
@@ -895,19 +927,26 @@ SDKGetSourceVideo(
 	ImporterLocalRec8H ldataH = reinterpret_cast<ImporterLocalRec8H>(sourceVideoRec->inPrivateData);
 	stdParms->piSuites->memFuncs->lockHandle(reinterpret_cast<char**>(ldataH));
 	ImporterLocalRec8Ptr localRecP = reinterpret_cast<ImporterLocalRec8Ptr>( *ldataH );
+	
+	WebM_Clip *clip = localRecP->clip;
+	
+	assert(clip != NULL && clip->IsOpen());
+	assert(localRecP->reader != NULL && localRecP->reader->FileRef() == fileRef);
+	
 
-
+	clip->Update();
+	
 	PrTime ticksPerSecond = 0;
 	localRecP->TimeSuite->GetTicksPerSecond(&ticksPerSecond);
 	
 
-	if(localRecP->frameRateDen == 0) // i.e. still frame
+	if(clip->FpsDen() == 0) // i.e. still frame
 	{
 		theFrame = 0;
 	}
 	else
 	{
-		PrTime ticksPerFrame = (ticksPerSecond * (PrTime)localRecP->frameRateDen) / (PrTime)localRecP->frameRateNum;
+		PrTime ticksPerFrame = (ticksPerSecond * (PrTime)clip->FpsDen()) / (PrTime)clip->FpsNum();
 		theFrame = sourceVideoRec->inFrameTime / ticksPerFrame;
 	}
 
@@ -920,6 +959,20 @@ SDKGetSourceVideo(
 															sourceVideoRec->outFrame,
 															NULL,
 															NULL);
+	
+	// a fast frame is good enough for playback
+	if(result != suiteError_NoError && g_decode_mode == WEBM_DECODE_FAST &&
+		sourceVideoRec->inQuality != kPrRenderQuality_High)
+	{
+		result = localRecP->PPixCacheSuite->GetFrameFromCache(	localRecP->importerID,
+																FAST_DECODE_STREAM,
+																theFrame,
+																1,
+																sourceVideoRec->inFrameFormats,
+																sourceVideoRec->outFrame,
+																NULL,
+																NULL);
+	}
 
 	// If frame is not in the cache, read the frame and put it in the cache; otherwise, we're done
 	if(result != suiteError_NoError)
@@ -929,261 +982,37 @@ SDKGetSourceVideo(
 		
 		// get the Premiere buffer
 		frameFormat = &sourceVideoRec->inFrameFormats[0];
-		prRect theRect;
+		
 		if(frameFormat->inFrameWidth == 0 && frameFormat->inFrameHeight == 0)
 		{
-			frameFormat->inFrameWidth = localRecP->width;
-			frameFormat->inFrameHeight = localRecP->height;
+			frameFormat->inFrameWidth = clip->Width();
+			frameFormat->inFrameHeight = clip->Height();
 		}
 		
-		// Windows and MacOS have different definitions of Rects, so use the cross-platform prSetRect
-		prSetRect(&theRect, 0, 0, frameFormat->inFrameWidth, frameFormat->inFrameHeight);
-		
-
-		assert(localRecP->reader != NULL && localRecP->reader->FileRef() == fileRef);
-		assert(localRecP->segment != NULL);
-		
-		if(localRecP->segment)
+		if(clip->HasVideo())
 		{
-			const uint64_t fps_num = localRecP->frameRateNum;
-			const uint64_t fps_den = localRecP->frameRateDen;
+			WebM_DecodeRequest request;
 			
+			request.frame = theFrame;
+			request.width = frameFormat->inFrameWidth;
+			request.height = frameFormat->inFrameHeight;
+			request.alpha = (frameFormat->inPixelFormat == PrPixelFormat_BGRA_4444_8u);
+			request.high_quality = (sourceVideoRec->inQuality == kPrRenderQuality_High);
+			request.mode = g_decode_mode;
+			request.num_cpus = g_num_cpus;
 			
-			// convert PrTime to timeCode and then to absolute time
-			// http://matroska.org/technical/specs/notes.html#TimecodeScale
-			// Time (in nanoseconds) = TimeCode * TimeCodeScale.
-			// This is the source of some very imprecise timings.  If the time scale is 1 million (as it is by default),
-			// That means 1 second is time code of 1000.  For 24 frames per second, each frame would
-			// be 41.6666 of time code, but that gets rounded off to 42.  If the TimeCode scale were lower,
-			// we could be more precise, the problem presumably being that our biggest time would be
-			// reduced.
-			const long long timeCodeScale = localRecP->segment->GetInfo()->GetTimeCodeScale();
-			const long long timeCode = ((sourceVideoRec->inFrameTime * (1000000000UL / timeCodeScale)) + (ticksPerSecond / 2)) / ticksPerSecond;
-			const long long tstamp = timeCode * timeCodeScale;
+			// Thumbnails, hover scrub and shuttling don't need the exact frame.
+			// Low is still playback, just at a lower resolution, so it does.
+			request.keyframes_only = (g_keyframes_only ||
+										sourceVideoRec->inQuality == kPrRenderQuality_Draft);
 			
+			PremiereFrameSink sink(localRecP, sourceVideoRec, theFrame, request.keyframes_only);
 			
-			if(localRecP->video_track >= 0)
-			{
-				const mkvparser::Tracks* pTracks = localRecP->segment->GetTracks();
+			const WebM_Result decode_result = WebM_DecodeFrame(*clip, request, sink);
 			
-				const mkvparser::Track* const pTrack = pTracks->GetTrackByNumber(localRecP->video_track);
-				
-				if(pTrack != NULL)
-				{
-					const long trackType = pTrack->GetType();
-				
-					if(trackType == mkvparser::Track::kVideo)
-					{
-						const mkvparser::VideoTrack* const pVideoTrack = static_cast<const mkvparser::VideoTrack*>(pTrack);
-						
-						if(pVideoTrack)
-						{
-							const mkvparser::BlockEntry* pSeekBlockEntry = NULL;
-							
-							pVideoTrack->Seek(tstamp, pSeekBlockEntry);
-							
-							// TODO: Any way I can seek with cues instead of a binary search through clusters?
-							//const mkvparser::Cues* cues = localRecP->segment->GetCues();
-							
-							if(pSeekBlockEntry != NULL)
-							{
-								const char* codec_id = pTrack->GetCodecId();
-							
-								const vpx_codec_iface_t *iface = (codec_id == std::string("V_VP8") ? vpx_codec_vp8_dx() :
-																	codec_id == std::string("V_VP9") ? vpx_codec_vp9_dx() :
-																	NULL);
-								
-								vpx_codec_err_t codec_err = VPX_CODEC_OK;
-								
-								vpx_codec_ctx_t decoder;
-								
-								if(iface != NULL)
-								{
-									vpx_codec_dec_cfg_t config;
-									config.threads = g_num_cpus;
-									config.w = frameFormat->inFrameWidth;
-									config.h = frameFormat->inFrameHeight;
-									
-									vpx_codec_flags_t flags = VPX_CODEC_CAP_FRAME_THREADING |
-																//VPX_CODEC_USE_ERROR_CONCEALMENT | // this doesn't seem to work
-																VPX_CODEC_USE_FRAME_THREADING;
-									
-									// TODO: Explore possibilities of decoding options by setting
-									// VPX_CODEC_USE_POSTPROC here.  Things like VP8_DEMACROBLOCK and
-									// VP8_MFQE (Multiframe Quality Enhancement) could be cool.
-									
-									codec_err = vpx_codec_dec_init(&decoder, iface, &config, flags);
-								}
-								else
-									codec_err = VPX_CODEC_ERROR;
-								
-								
-								if(codec_err == VPX_CODEC_OK)
-								{
-									const mkvparser::Cluster *pCluster = pSeekBlockEntry->GetCluster();
-
-									// The seek took us to this Cluster for a reason.
-									// It stars with a keyframe, although not necessarily the last keyframe before
-									// the requested frame. I have to decode each frame starting with the keyframe,
-									// and then I continue afterwards until I decode the entire cluster.
-									// TODO: Maybe we should seek for keyframes within the cluster.
-
-									assert(tstamp >= pSeekBlockEntry->GetBlock()->GetTime(pCluster));
-									assert(tstamp >= pCluster->GetTime());
-
-									bool got_frame = false;
-									
-									while((pCluster != NULL) && !pCluster->EOS() && !got_frame && result == malNoError)
-									{
-										assert(pCluster->GetTime() >= 0);
-										assert(pCluster->GetTime() == pCluster->GetFirstTime());
-										assert(got_frame || tstamp >= pCluster->GetTime());
-
-										const mkvparser::BlockEntry* pBlockEntry = NULL;
-										
-										pCluster->GetFirst(pBlockEntry);
-
-										while((pBlockEntry != NULL) && !pBlockEntry->EOS() && result == malNoError)
-										{
-											const mkvparser::Block *pBlock = pBlockEntry->GetBlock();
-										
-											if(pBlock->GetTrackNumber() == localRecP->video_track)
-											{
-												assert(pBlock->GetFrameCount() == 1);
-												
-												long long packet_tstamp = pBlock->GetTime(pCluster);
-												
-												long long packet_tcode = pBlock->GetTimeCode(pCluster);
-												long long tcode_scale = localRecP->segment->GetInfo()->GetTimeCodeScale();
-												
-												const mkvparser::Block::Frame& blockFrame = pBlock->GetFrame(0);
-												
-												unsigned int length = blockFrame.len;
-												uint8_t *data = (uint8_t *)malloc(length);
-												
-												if(data != NULL)
-												{
-													int read_err = localRecP->reader->Read(blockFrame.pos, blockFrame.len, data);
-													
-													if(read_err == PrMkvReader::PrMkvSuccess)
-													{
-														vpx_codec_err_t decode_err = vpx_codec_decode(&decoder, data, length, NULL, 0);
-														
-														assert(decode_err == VPX_CODEC_OK);
-
-														if(decode_err == VPX_CODEC_OK)
-														{
-															csSDK_int32 decodedFrame = ((packet_tstamp * fps_num / fps_den) + 500000000UL) / 1000000000UL;
-															
-															vpx_codec_iter_t iter = NULL;
-															
-															vpx_image_t *img = vpx_codec_get_frame(&decoder, &iter);
-															
-															if(img)
-															{
-																PPixHand ppix;
-																
-																localRecP->PPixCreatorSuite->CreatePPix(&ppix, PrPPixBufferAccess_ReadWrite, frameFormat->inPixelFormat, &theRect);
-
-																if(frameFormat->inPixelFormat == PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709)
-																{
-																	char *Y_PixelAddress, *U_PixelAddress, *V_PixelAddress;
-																	csSDK_uint32 Y_RowBytes, U_RowBytes, V_RowBytes;
-																	
-																	localRecP->PPix2Suite->GetYUV420PlanarBuffers(ppix, PrPPixBufferAccess_ReadWrite,
-																													&Y_PixelAddress, &Y_RowBytes,
-																													&U_PixelAddress, &U_RowBytes,
-																													&V_PixelAddress, &V_RowBytes);
-																												
-																	assert(frameFormat->inFrameHeight == img->d_h);
-																	assert(frameFormat->inFrameWidth == img->d_w);
-
-																	for(int y = 0; y < img->d_h; y++)
-																	{
-																		unsigned char *imgY = img->planes[VPX_PLANE_Y] + (img->stride[VPX_PLANE_Y] * y);
-																		
-																		unsigned char *prY = (unsigned char *)Y_PixelAddress + (Y_RowBytes * y);
-																		
-																		memcpy(prY, imgY, img->d_w * sizeof(unsigned char));
-																	}
-																	
-																	for(int y = 0; y < img->d_h / 2; y++)
-																	{
-																		unsigned char *imgU = img->planes[VPX_PLANE_U] + (img->stride[VPX_PLANE_U] * y);
-																		unsigned char *imgV = img->planes[VPX_PLANE_V] + (img->stride[VPX_PLANE_V] * y);
-																		
-																		unsigned char *prU = (unsigned char *)U_PixelAddress + (U_RowBytes * y);
-																		unsigned char *prV = (unsigned char *)V_PixelAddress + (V_RowBytes * y);
-																		
-																		memcpy(prU, imgU, (img->d_w / 2) * sizeof(unsigned char));
-																		memcpy(prV, imgV, (img->d_w / 2) * sizeof(unsigned char));
-																	}
-																	
-																	// It says we can get more than one frame off one decode operation?  What would I do with it?
-																	assert( NULL == (img = vpx_codec_get_frame(&decoder, &iter) ) );
-																}
-																else
-																	assert(false); // looks like Premiere is happy to always give me this kind of buffer
-																
-																// This is a nice Premiere feature.  We often have to decode many frames
-																// in a GOP (group of pictures) before we decode the one Premiere asked for.
-																// This suite lets us cache those frames for later.  We keep going past the
-																// requested frame to end of the cluster to save us the trouble in the future.
-																localRecP->PPixCacheSuite->AddFrameToCache(	localRecP->importerID,
-																											0,
-																											ppix,
-																											decodedFrame,
-																											NULL,
-																											NULL);
-																
-																if(decodedFrame == theFrame)
-																{
-																	*sourceVideoRec->outFrame = ppix;
-																	
-																	got_frame = true;
-																}
-																else
-																{
-																	// Premiere copied the frame to its cache, so we dispose ours.
-																	// Very obvious memory leak if we don't.
-																	localRecP->PPixSuite->Dispose(ppix);
-																}
-																
-																vpx_img_free(img);
-															}
-														}
-														else
-															result = imFileReadFailed;
-													}
-													else
-														result = imFileReadFailed;
-													
-													free(data);
-												}
-												else
-													result = imMemErr;
-											}
-											
-											long status = pCluster->GetNext(pBlockEntry, pBlockEntry);
-											
-											assert(status == 0);
-										}
-										
-										//assert(got_frame); // otherwise our cluster seek function has failed us (turns out it will)
-										
-										pCluster = localRecP->segment->GetNext(pCluster);
-									}
-
-									assert(got_frame);
-									
-									vpx_codec_err_t destroy_err = vpx_codec_destroy(&decoder);
-									assert(destroy_err == VPX_CODEC_OK);
-								}
-							}
-						}
-					}
-				}
-			}
+			result = (decode_result == WEBM_OK ? malNoError :
+						decode_result == WEBM_ERR_MEMORY ? imMemErr :
+						imFileReadFailed);
 		}
 	}
 
@@ -1194,79 +1023,6 @@ SDKGetSourceVideo(
 }
 
 
-static int PrivateDataCount(const unsigned char *private_data, size_t private_size)
-{
-	// the first byte
-	unsigned char *p = (unsigned char *)private_data;
-	
-	return *p + 1;
-}
-
-static uint64_t
-xiph_lace_value(const unsigned char ** np)
-{
-	uint64_t lace;
-	uint64_t value;
-	const unsigned char *p = *np;
-
-	lace = *p++;
-	value = lace;
-	while (lace == 255) {
-		lace = *p++;
-		value += lace;
-	}
-
-	*np = p;
-
-	return value;
-}
-
-static const unsigned char *GetPrivateDataPart(const unsigned char *private_data,
-												size_t private_size, int part,
-												size_t *part_size)
-{
-	const unsigned char *result = NULL;
-	size_t result_size = 0;
-	
-	const unsigned char *p = private_data;
-	
-	int count = *p++ + 1;
-	assert(count == 3);
-	
-	
-	if(*p >= part)
-	{
-		uint64_t sizes[3];
-		uint64_t total = 0;
-		int i = 0;
-		
-		while(--count)
-		{
-			sizes[i] = xiph_lace_value(&p);
-			total += sizes[i];
-			i++;
-		}
-		sizes[i] = private_size - total - (p - private_data);
-		
-		for(i=0; i < part; ++i)
-			p += sizes[i];
-		
-		result = p;
-		result_size = sizes[part];
-	}
-	
-	*part_size = result_size;
-	
-	return result;
-}
-												
-template <typename T>
-static inline T minimum(T one, T two)
-{
-	return (one < two ? one : two);
-}
-
-
 static prMALError 
 SDKImportAudio7(
 	imStdParms			*stdParms, 
@@ -1280,257 +1036,18 @@ SDKImportAudio7(
 	stdParms->piSuites->memFuncs->lockHandle(reinterpret_cast<char**>(ldataH));
 	ImporterLocalRec8Ptr localRecP = reinterpret_cast<ImporterLocalRec8Ptr>( *ldataH );
 
+	WebM_Clip *clip = localRecP->clip;
 
+	assert(clip != NULL && clip->IsOpen());
 	assert(localRecP->reader != NULL && localRecP->reader->FileRef() == SDKfileRef);
-	assert(localRecP->segment != NULL);
 	
-	if(localRecP->segment)
+	if(clip && clip->IsOpen())
 	{
-		assert(audioRec7->position >= 0); // Do they really want contiguous samples?
-
-
-		const long long tstamp = audioRec7->position * 1000000000UL / localRecP->audioSampleRate;
+		const WebM_Result audio_result = clip->ReadAudio(audioRec7->position, audioRec7->size, audioRec7->buffer);
 		
-		
-		if(localRecP->audio_track >= 0)
-		{
-			const mkvparser::Tracks* pTracks = localRecP->segment->GetTracks();
-		
-			const mkvparser::Track* const pTrack = pTracks->GetTrackByNumber(localRecP->audio_track);
-			
-			if(pTrack != NULL)
-			{
-				const long trackType = pTrack->GetType();
-			
-				if(trackType == mkvparser::Track::kAudio)
-				{
-					assert(pTrack->GetCodecId() == std::string("A_VORBIS"));
-				
-					const mkvparser::AudioTrack* const pAudioTrack = static_cast<const mkvparser::AudioTrack*>(pTrack);
-					
-					if(pAudioTrack)
-					{
-						size_t private_size = 0;
-						const unsigned char *private_data = pAudioTrack->GetCodecPrivate(private_size);
-						
-						if(private_data && private_size && PrivateDataCount(private_data, private_size) == 3)
-						{
-							vorbis_info vi;
-							vorbis_comment vc;
-							vorbis_dsp_state vd;
-							vorbis_block vb;
-							
-							vorbis_info_init(&vi);
-							vorbis_comment_init(&vc);
-							
-							int ogg_packet_num = 0;
-							
-						#define OV_OK 0
-						
-							int v_err = OV_OK;
-							
-							for(int h=0; h < 3 && v_err == OV_OK; h++)
-							{
-								size_t length = 0;
-								const unsigned char *data = GetPrivateDataPart(private_data, private_size,
-																				h, &length);
-								
-								if(data != NULL)
-								{
-									ogg_packet packet;
-									
-									packet.packet = (unsigned char *)data;
-									packet.bytes = length;
-									packet.b_o_s = (h == 0);
-									packet.e_o_s = false;
-									packet.granulepos = 0;
-									packet.packetno = ogg_packet_num++;
-									
-									v_err = vorbis_synthesis_headerin(&vi, &vc, &packet);
-								}
-							}
-									
-							if(v_err == OV_OK)
-							{
-								v_err = vorbis_synthesis_init(&vd, &vi);
-								
-								if(v_err == OV_OK)
-									v_err = vorbis_block_init(&vd, &vb);
-								
-								// TODO: Figure out how to seek compressed audio exactly.
-								// From watching the audio encoding process, I know that you don't
-								// get to put a frame's worth of audio into each block, you have to
-								// do what the encoder lets you.  That means some of the audio you intended
-								// for this block could find its way into the next one.
-								// Movie players typically just worry about playing the audio straight
-								// through and then put up frames at the appointed times.  You sync video
-								// to audio, not the other way around.
-								// But Premiere asks for a specific sample of audio.  The only guaranteed way
-								// to provide that would be to decompress the entire audio stream from the
-								// beginning.  Uncompressed formats have it easy.
-								
-								const mkvparser::BlockEntry* pSeekBlockEntry = NULL;
-								
-								pAudioTrack->Seek(tstamp, pSeekBlockEntry);
-								
-								if(pSeekBlockEntry != NULL)
-								{
-									csSDK_uint32 samples_copied = 0;
-									csSDK_uint32 samples_left = audioRec7->size;
-									
-									const mkvparser::Cluster *pCluster = pSeekBlockEntry->GetCluster();
-									
-									while((pCluster != NULL) && !pCluster->EOS() && samples_left > 0 && result == malNoError)
-									{
-										const mkvparser::BlockEntry* pBlockEntry = NULL;
-										
-										pCluster->GetFirst(pBlockEntry);
-										
-										while((pBlockEntry != NULL) && !pBlockEntry->EOS() && samples_left > 0 && result == malNoError)
-										{
-											const mkvparser::Block *pBlock = pBlockEntry->GetBlock();
-											
-											if(pBlock->GetTrackNumber() == localRecP->audio_track)
-											{
-												long long packet_tstamp = pBlock->GetTime(pCluster);
-												
-												PrAudioSample packet_offset = 0;
-													
-												PrAudioSample packet_start = localRecP->audioSampleRate * packet_tstamp / 1000000000UL;
-													
-												if(audioRec7->position > packet_start)
-													packet_offset = audioRec7->position - packet_start; // in other words the audio frames in the beginning that we'll skip over
-												
-													
-												int position_in_packet = 0;
-												
-													
-												for(int f=0; f < pBlock->GetFrameCount(); f++)
-												{
-													const mkvparser::Block::Frame& blockFrame = pBlock->GetFrame(f);
-													
-													unsigned int length = blockFrame.len;
-													uint8_t *data = (uint8_t *)malloc(length);
-													
-													if(data != NULL)
-													{
-														int read_err = localRecP->reader->Read(blockFrame.pos, blockFrame.len, data);
-														
-														if(read_err == PrMkvReader::PrMkvSuccess)
-														{
-															ogg_packet packet;
-										
-															packet.packet = data;
-															packet.bytes = length;
-															packet.b_o_s = false;
-															packet.e_o_s = false;
-															packet.granulepos = -1;
-															packet.packetno = ogg_packet_num++;
-
-															int synth_err = vorbis_synthesis(&vb, &packet);
-															
-															if(synth_err == OV_OK)
-															{
-																int block_err = vorbis_synthesis_blockin(&vd, &vb);
-																
-																if(block_err == OV_OK)
-																{
-																	float **pcm = NULL;
-																	int samples = 0;
-																	
-																	int synth_result = 1;
-																	
-																	while(synth_result != 0 && (samples = vorbis_synthesis_pcmout(&vd, &pcm)) > 0)
-																	{
-																		// I feel like the code here is hard to read.  Sorry about that.
-																	
-																		int samples_to_copy = 0;
-																		
-																		// if the offset is bigger than the samples, we'll just move along
-																		if(packet_offset < samples)
-																		{
-																			int samples_after_offset = samples - packet_offset;
-																			
-																			samples_to_copy = minimum<int>(samples_left, samples_after_offset);
-																		}
-																	
-																		// how nice, audio samples are float, just like Premiere wants 'em
-																		for(int c=0; c < localRecP->numChannels && samples_to_copy > 0; c++)
-																		{
-																			memcpy(audioRec7->buffer[c] + samples_copied, pcm[c] + packet_offset, samples_to_copy * sizeof(float));
-																		}
-																		
-																		// now samples_to_copy is more like samples_I_just_copied
-																		samples_copied += samples_to_copy;
-																		samples_left -= samples_to_copy;
-																		
-																		
-																		// If we copied any samples, that means the offset has been gobbled up
-																		// If we didn't, reduce the offset by number of samples
-																		if(samples_to_copy > 0)
-																		{
-																			packet_offset = 0;
-																			
-																			position_in_packet += samples_to_copy;
-																		}
-																		else
-																			packet_offset -= samples;
-																		
-																		
-																		synth_result = vorbis_synthesis_read(&vd, samples);
-																	}
-																}
-																else
-																	result = imFileReadFailed;
-															}
-															else
-																result = imFileReadFailed;
-														}
-														else
-															result = imFileReadFailed;
-														
-														free(data);
-													}
-													else
-														result = imMemErr;
-												}
-											}
-											
-											long status = pCluster->GetNext(pBlockEntry, pBlockEntry);
-											
-											assert(status == 0);
-										}
-										
-										pCluster = localRecP->segment->GetNext(pCluster);
-									}
-
-									// there might not be samples left at the end; not much we can do about that
-									assert(pCluster == NULL || pCluster->EOS() || (samples_left == 0 && samples_copied == audioRec7->size));
-								}
-								else
-									result = imFileReadFailed;
-							}
-							else
-								result = imFileReadFailed;
-							
-							
-							vorbis_block_clear(&vb);
-							vorbis_dsp_clear(&vd);
-							vorbis_info_clear(&vi);
-							vorbis_comment_clear(&vc);
-						}
-						else
-							result = imFileReadFailed;
-					}
-					else
-						result = imFileReadFailed;
-				}
-				else
-					result = imFileReadFailed;
-			}
-			else
-				result = imFileReadFailed;
-		}
+		result = (audio_result == WEBM_OK ? malNoError :
+					audio_result == WEBM_ERR_MEMORY ? imMemErr :
+					imFileReadFailed);
 	}
 	
 					
@@ -1589,6 +1106,12 @@ PREMPLUGENTRY DllExport xImportEntry (
 										reinterpret_cast<imAnalysisRec*>(param2));
 			break;
 
+		case imDataRateAnalysis:
+			result =	SDKDataRateAnalysis(	stdParms,
+												reinterpret_cast<imFileRef>(param1),
+												reinterpret_cast<imDataRateAnalysisRec*>(param2));
+			break;
+
 		case imGetIndFormat:
 			result =	SDKGetIndFormat(stdParms, 
 										reinterpret_cast<csSDK_size_t>(param1),
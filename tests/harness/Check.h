@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_TEST_CHECK_H
+#define WEBM_TEST_CHECK_H
+
+// Just enough of a test framework.  A failed check says where and keeps
+// going, so one run shows everything that's broken.  main() returns
+// WebM_TestResult() and ctest takes it from there.
+
+#include <stdio.h>
+
+
+void WebM_TestFailed(const char *file, int line, const char *what);
+
+// prints the tally, returns what main() should
+int WebM_TestResult(const char *test_name);
+
+
+#define CHECK(cond) \
+	do{ if( !(cond) ) WebM_TestFailed(__FILE__, __LINE__, #cond); }while(0)
+
+#define CHECK_EQ(a, b) \
+	do{ if( !((a) == (b)) ) WebM_TestFailed(__FILE__, __LINE__, #a " == " #b); }while(0)
+
+// a check that there's no point going on without
+#define REQUIRE(cond) \
+	do{ if( !(cond) ) { WebM_TestFailed(__FILE__, __LINE__, #cond); return; } }while(0)
+
+
+#endif // WEBM_TEST_CHECK_H
@@ -0,0 +1,535 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "Generators.h"
+
+#include "WebM_Color.h"
+
+extern "C" {
+#include "vpx/vp8cx.h"
+}
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+FrameGenerator::FrameGenerator(int width, int height, bool alpha, int hold) :
+	_width(width),
+	_height(height),
+	_alpha(alpha),
+	_hold(hold > 0 ? hold : 1)
+{
+
+}
+
+
+bool
+FrameGenerator::InBox(long frame, int x, int y) const
+{
+	const long picture = frame / _hold;
+	
+	const int box_w = _width / 4;
+	const int box_h = _height / 4;
+	
+	const int box_x = (picture * 8) % (_width - box_w);
+	const int box_y = _height / 3;
+	
+	return (x >= box_x && x < box_x + box_w && y >= box_y && y < box_y + box_h);
+}
+
+
+void
+FrameGenerator::Pixel(long frame, int x, int y, unsigned char &Y, unsigned char &U, unsigned char &V) const
+{
+	const long picture = frame / _hold;
+	
+	if( InBox(frame, x, y) )
+	{
+		Y = 235;
+		U = 128;
+		V = 128;
+	}
+	else
+	{
+		Y = 16 + ((x * 160 / _width) + (y * 40 / _height) + (picture * 3)) % 200;
+		U = 96 + (x * 64 / _width);
+		V = 96 + (y * 64 / _height);
+	}
+}
+
+
+void
+FrameGenerator::RGB(long frame, int x, int y, unsigned char &R, unsigned char &G, unsigned char &B) const
+{
+	const long picture = frame / _hold;
+	
+	if( InBox(frame, x, y) )
+	{
+		R = G = B = 255;
+	}
+	else
+	{
+		R = x * 255 / _width;
+		G = y * 255 / _height;
+		B = (picture * 8) % 256;
+	}
+}
+
+
+unsigned char
+FrameGenerator::Alpha(long frame, int x, int y) const
+{
+	if(!_alpha || InBox(frame, x, y))
+		return 255;
+	
+	const bool corner = ((x < _width / 8 || x >= _width - _width / 8) &&
+							(y < _height / 8 || y >= _height - _height / 8));
+	
+	return (corner ? 0 : 128);
+}
+
+
+void
+FrameGenerator::YUV420(long frame, unsigned char *Y, long Y_rowbytes,
+						unsigned char *U, long U_rowbytes,
+						unsigned char *V, long V_rowbytes) const
+{
+	for(int y=0; y < _height; y++)
+	{
+		for(int x=0; x < _width; x++)
+		{
+			unsigned char y_val, u_val, v_val;
+			
+			Pixel(frame, x, y, y_val, u_val, v_val);
+			
+			Y[(y * Y_rowbytes) + x] = y_val;
+			
+			if(x % 2 == 0 && y % 2 == 0)
+			{
+				U[((y / 2) * U_rowbytes) + (x / 2)] = u_val;
+				V[((y / 2) * V_rowbytes) + (x / 2)] = v_val;
+			}
+		}
+	}
+}
+
+
+void
+FrameGenerator::BGRA8(long frame, unsigned char *bgra, long rowbytes, bool flipped) const
+{
+	for(int y=0; y < _height; y++)
+	{
+		unsigned char *pix = bgra + ((flipped ? (_height - 1 - y) : y) * rowbytes);
+		
+		for(int x=0; x < _width; x++)
+		{
+			RGB(frame, x, y, pix[2], pix[1], pix[0]);
+			
+			pix[3] = Alpha(frame, x, y);
+			
+			pix += 4;
+		}
+	}
+}
+
+
+void
+FrameGenerator::BGRA16(long frame, unsigned short *bgra, long rowbytes, bool flipped) const
+{
+	for(int y=0; y < _height; y++)
+	{
+		unsigned short *pix = (unsigned short *)((char *)bgra + ((flipped ? (_height - 1 - y) : y) * rowbytes));
+		
+		for(int x=0; x < _width; x++)
+		{
+			unsigned char R, G, B;
+			
+			RGB(frame, x, y, R, G, B);
+			
+			// Premiere's 16-bit goes to 32768
+			pix[0] = ((B * 32768) + 127) / 255;
+			pix[1] = ((G * 32768) + 127) / 255;
+			pix[2] = ((R * 32768) + 127) / 255;
+			pix[3] = ((Alpha(frame, x, y) * 32768) + 127) / 255;
+			
+			pix += 4;
+		}
+	}
+}
+
+
+void
+FrameGenerator::Image(long frame, vpx_image_t *img) const
+{
+	YUV420(frame, img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y],
+					img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U],
+					img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V]);
+}
+
+
+ToneGenerator::ToneGenerator(int channels, int sample_rate) :
+	_channels(channels),
+	_sample_rate(sample_rate)
+{
+
+}
+
+
+float
+ToneGenerator::Sample(int channel, long long position) const
+{
+	// position can get big, so keep the phase small
+	const long long period = _sample_rate;
+	const double t = (double)(position % period) / (double)_sample_rate;
+	
+	return 0.5 * sin(2.0 * M_PI * Frequency(channel) * t);
+}
+
+
+void
+ToneGenerator::Fill(long long position, int samples, float **buffers) const
+{
+	for(int c=0; c < _channels; c++)
+	{
+		for(int i=0; i < samples; i++)
+			buffers[c][i] = Sample(c, position + i);
+	}
+}
+
+
+double
+WebM_TestToneLevel(const float *samples, int count, double frequency, int sample_rate)
+{
+	if(count <= 0)
+		return 0.0;
+	
+	const double coeff = 2.0 * cos(2.0 * M_PI * frequency / sample_rate);
+	
+	double s1 = 0.0, s2 = 0.0;
+	double energy = 0.0;
+	
+	for(int i=0; i < count; i++)
+	{
+		const double s = samples[i] + (coeff * s1) - s2;
+		
+		s2 = s1;
+		s1 = s;
+		
+		energy += samples[i] * samples[i];
+	}
+	
+	const double power = (s1 * s1) + (s2 * s2) - (coeff * s1 * s2);
+	
+	// a pure tone gets (A * N / 2)^2 here and A^2 * N / 2 in energy
+	if(energy <= 0.0)
+		return 0.0;
+	
+	const double level = power / (energy * count / 2.0);
+	
+	return (level > 1.0 ? 1.0 : level);
+}
+
+
+double
+WebM_TestPSNR(const unsigned char *a, long a_rowbytes,
+				const unsigned char *b, long b_rowbytes,
+				int width, int height)
+{
+	double sum = 0.0;
+	
+	for(int y=0; y < height; y++)
+	{
+		const unsigned char *a_row = a + (y * a_rowbytes);
+		const unsigned char *b_row = b + (y * b_rowbytes);
+		
+		for(int x=0; x < width; x++)
+		{
+			const double diff = (double)a_row[x] - (double)b_row[x];
+			
+			sum += diff * diff;
+		}
+	}
+	
+	const double mse = sum / ((double)width * (double)height);
+	
+	return (mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0);
+}
+
+
+// FileMkvWriter, except every write goes straight to disk, so a
+// reader on another handle sees it right away
+class FlushingMkvWriter : public WebM_MkvWriter
+{
+  public:
+	FlushingMkvWriter() : _file(NULL) {}
+	virtual ~FlushingMkvWriter() { Close(); }
+	
+	bool Open(const WebM_PathChar *path)
+	{
+		_file = WebM_OpenFile(path, "wb");
+		
+		return (_file != NULL);
+	}
+	
+	void Close()
+	{
+		if(_file != NULL)
+			fclose(_file);
+		
+		_file = NULL;
+	}
+	
+	virtual mkvmuxer::int32 Write(const void* buf, mkvmuxer::uint32 len)
+	{
+		if(fwrite(buf, 1, len, _file) != len || fflush(_file) != 0)
+			return -1;
+		
+		const long long pos = WebM_TellFile(_file);
+		
+		if(pos > _layout.size)
+			_layout.size = pos;
+		
+		return 0;
+	}
+	
+	virtual mkvmuxer::int64 Position() const { return WebM_TellFile(_file); }
+	virtual mkvmuxer::int32 Position(mkvmuxer::int64 position) { return WebM_SeekFile(_file, position); }
+	virtual bool Seekable() const { return true; }
+	
+  private:
+	FILE *_file;
+};
+
+
+TestMovieWriter::TestMovieWriter() :
+	_writer(NULL),
+	_segment(NULL),
+	_track(0),
+	_have_encoder(false),
+	_img(NULL),
+	_last_tstamp(0),
+	_frames(0)
+{
+
+}
+
+
+TestMovieWriter::~TestMovieWriter()
+{
+	Close();
+}
+
+
+bool
+TestMovieWriter::Open(const UTF16String &path, int width, int height, bool vp9, bool flush,
+						double frame_rate, int keyframe_interval)
+{
+	Close();
+	
+	if(flush)
+	{
+		FlushingMkvWriter *writer = new FlushingMkvWriter;
+		
+		_writer = writer;
+		
+		if( !writer->Open(path.c_str()) )
+			return false;
+	}
+	else
+	{
+		FileMkvWriter *writer = new FileMkvWriter;
+		
+		_writer = writer;
+		
+		if( !writer->Open(path.c_str()) )
+			return false;
+	}
+	
+	vpx_codec_iface_t *iface = (vp9 ? vpx_codec_vp9_cx() : vpx_codec_vp8_cx());
+	
+	vpx_codec_enc_cfg_t config;
+	
+	if(vpx_codec_enc_config_default(iface, &config, 0) != VPX_CODEC_OK)
+		return false;
+	
+	// timestamps in milliseconds, one packet out for every frame in
+	config.g_w = width;
+	config.g_h = height;
+	config.g_timebase.num = 1;
+	config.g_timebase.den = 1000;
+	config.g_lag_in_frames = 0;
+	config.g_threads = 1;
+	config.kf_mode = VPX_KF_AUTO;
+	config.kf_max_dist = keyframe_interval;
+	config.rc_target_bitrate = (width * height) / 200;
+	
+	if(vpx_codec_enc_init(&_encoder, iface, &config, 0) != VPX_CODEC_OK)
+		return false;
+	
+	_have_encoder = true;
+	
+	vpx_codec_control(&_encoder, VP8E_SET_CPUUSED, (vp9 ? 8 : 16));
+	
+	_img = vpx_img_alloc(NULL, VPX_IMG_FMT_I420, width, height, 32);
+	
+	if(_img == NULL)
+		return false;
+	
+	_segment = new mkvmuxer::Segment;
+	
+	_segment->Init(_writer);
+	_segment->set_mode(mkvmuxer::Segment::kFile);
+	
+	mkvmuxer::SegmentInfo* const info = _segment->GetSegmentInfo();
+	
+	info->set_writing_app("WebM tests");
+	info->set_timecode_scale(1000000);
+	
+	_track = _segment->AddVideoTrack(width, height, 1);
+	
+	mkvmuxer::VideoTrack* const video = static_cast<mkvmuxer::VideoTrack *>(_segment->GetTrackByNumber(_track));
+	
+	if(video == NULL)
+		return false;
+	
+	video->set_codec_id(vp9 ? "V_VP9" : mkvmuxer::Tracks::kVp8CodecId);
+	
+	if(frame_rate > 0.0)
+		video->set_frame_rate(frame_rate);
+	
+	_segment->CuesTrack(_track);
+	
+	return true;
+}
+
+
+bool
+TestMovieWriter::WritePackets(long long tstamp)
+{
+	vpx_codec_iter_t iter = NULL;
+	
+	const vpx_codec_cx_pkt_t *pkt = NULL;
+	
+	while( (pkt = vpx_codec_get_cx_data(&_encoder, &iter)) )
+	{
+		if(pkt->kind == VPX_CODEC_CX_FRAME_PKT)
+		{
+			const bool added = _segment->AddFrame((const mkvmuxer::uint8 *)pkt->data.frame.buf, pkt->data.frame.sz,
+													_track, tstamp, (pkt->data.frame.flags & VPX_FRAME_IS_KEY));
+			
+			if(!added)
+				return false;
+		}
+	}
+	
+	return true;
+}
+
+
+bool
+TestMovieWriter::AddFrame(const FrameGenerator &source, long frame, long long tstamp)
+{
+	if(_segment == NULL || _img == NULL)
+		return false;
+	
+	source.Image(frame, _img);
+	
+	const vpx_codec_pts_t pts = tstamp / 1000000;
+	
+	if(vpx_codec_encode(&_encoder, _img, pts, 1, 0, VPX_DL_REALTIME) != VPX_CODEC_OK)
+		return false;
+	
+	_last_tstamp = tstamp;
+	
+	_frames++;
+	
+	return WritePackets(tstamp);
+}
+
+
+void
+TestMovieWriter::NewCluster()
+{
+	if(_segment != NULL)
+		_segment->ForceNewClusterOnNextFrame();
+}
+
+
+bool
+TestMovieWriter::Close()
+{
+	bool ok = true;
+	
+	if(_segment != NULL)
+	{
+		// anything the encoder still has
+		if(_have_encoder && vpx_codec_encode(&_encoder, NULL, 0, 1, 0, VPX_DL_REALTIME) == VPX_CODEC_OK)
+			ok = WritePackets(_last_tstamp);
+		
+		ok = _segment->Finalize() && ok;
+		
+		delete _segment;
+		
+		_segment = NULL;
+	}
+	
+	if(_have_encoder)
+	{
+		vpx_codec_destroy(&_encoder);
+		
+		_have_encoder = false;
+	}
+	
+	if(_img != NULL)
+	{
+		vpx_img_free(_img);
+		
+		_img = NULL;
+	}
+	
+	delete _writer; // closes the file
+	
+	_writer = NULL;
+	
+	return ok;
+}
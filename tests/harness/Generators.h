@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_TEST_GENERATORS_H
+#define WEBM_TEST_GENERATORS_H
+
+// Synthetic pictures, sound and movies, the same every run, so a test
+// knows what it should get back.
+
+#include "WebM_File.h"
+
+extern "C" {
+#include "vpx/vpx_encoder.h"
+}
+
+#include "mkvmuxer.hpp"
+
+#include <string>
+
+
+// A gradient that drifts and a box that slides across it, so every frame is
+// different and motion search has something to find.  With hold > 1, each
+// picture is repeated that many frames (for skipping repeats).  With alpha,
+// the box is opaque, the rest half see-through and the corners clear.
+class FrameGenerator
+{
+  public:
+	FrameGenerator(int width, int height, bool alpha = false, int hold = 1);
+	
+	int Width() const { return _width; }
+	int Height() const { return _height; }
+	bool HasAlpha() const { return _alpha; }
+	
+	// planar 4:2:0
+	void YUV420(long frame, unsigned char *Y, long Y_rowbytes,
+					unsigned char *U, long U_rowbytes,
+					unsigned char *V, long V_rowbytes) const;
+	
+	// interleaved, optionally bottom row first like Premiere
+	void BGRA8(long frame, unsigned char *bgra, long rowbytes, bool flipped) const;
+	void BGRA16(long frame, unsigned short *bgra, long rowbytes, bool flipped) const;
+	
+	// into an I420 image of our size
+	void Image(long frame, vpx_image_t *img) const;
+	
+	unsigned char Alpha(long frame, int x, int y) const;
+	
+  private:
+	void Pixel(long frame, int x, int y, unsigned char &Y, unsigned char &U, unsigned char &V) const;
+	void RGB(long frame, int x, int y, unsigned char &R, unsigned char &G, unsigned char &B) const;
+	bool InBox(long frame, int x, int y) const;
+	
+	const int _width;
+	const int _height;
+	const bool _alpha;
+	const int _hold;
+};
+
+
+// A sine on each channel, 440 Hz times the channel's number (starting at 1),
+// at half volume
+class ToneGenerator
+{
+  public:
+	ToneGenerator(int channels, int sample_rate);
+	
+	int Channels() const { return _channels; }
+	int SampleRate() const { return _sample_rate; }
+	double Frequency(int channel) const { return 440.0 * (channel + 1); }
+	
+	float Sample(int channel, long long position) const;
+	
+	void Fill(long long position, int samples, float **buffers) const;
+	
+  private:
+	const int _channels;
+	const int _sample_rate;
+};
+
+
+// How much of frequency is in samples, from 0 (none) to 1 (all of it).
+// (Goertzel, normalized by the total power.)
+double WebM_TestToneLevel(const float *samples, int count, double frequency, int sample_rate);
+
+
+// PSNR of one 8-bit plane against another, 99 if they're the same
+double WebM_TestPSNR(const unsigned char *a, long a_rowbytes,
+						const unsigned char *b, long b_rowbytes,
+						int width, int height);
+
+
+// Writes VP8 or VP9 straight through mkvmuxer, for the files WebM_ExportMovie
+// won't make: timestamps of our choosing (variable frame rate), no frame rate
+// in the header, clusters where we say.  With flush, every write goes to disk
+// right away, so until Close() fills in the sizes and writes the Cues, the
+// file looks just like one that's still being captured.
+class TestMovieWriter
+{
+  public:
+	TestMovieWriter();
+	~TestMovieWriter();
+	
+	// frame_rate 0 leaves it out of the header
+	bool Open(const UTF16String &path, int width, int height, bool vp9, bool flush,
+				double frame_rate = 0.0, int keyframe_interval = 30);
+	
+	// encode frame of the generator, showing at tstamp (nanoseconds)
+	bool AddFrame(const FrameGenerator &source, long frame, long long tstamp);
+	
+	// start the next frame in a new Cluster
+	void NewCluster();
+	
+	// Cues and sizes, and close the file
+	bool Close();
+	
+	long FramesWritten() const { return _frames; }
+	
+  private:
+	bool WritePackets(long long tstamp);
+	
+	WebM_MkvWriter *_writer;
+	mkvmuxer::Segment *_segment;
+	mkvmuxer::uint64 _track;
+	
+	vpx_codec_ctx_t _encoder;
+	bool _have_encoder;
+	vpx_image_t *_img;
+	
+	long long _last_tstamp;
+	long _frames;
+};
+
+
+#endif // WEBM_TEST_GENERATORS_H
@@ -0,0 +1,1444 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "MockHost.h"
+
+#include "WebM_Color.h"
+#include "WebM_Speed.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+MockMemoryManagerSuite::MockMemoryManagerSuite() :
+	_outstanding(0),
+	_peak(0)
+{
+
+}
+
+
+MockMemoryManagerSuite::~MockMemoryManagerSuite()
+{
+	for(std::map<void *, size_t>::iterator i = _sizes.begin(); i != _sizes.end(); ++i)
+		free(i->first);
+}
+
+
+void *
+MockMemoryManagerSuite::NewPtr(size_t size)
+{
+	void *ptr = malloc(size > 0 ? size : 1);
+	
+	if(ptr != NULL)
+	{
+		_sizes[ptr] = size;
+		
+		_outstanding += size;
+		
+		if(_outstanding > _peak)
+			_peak = _outstanding;
+	}
+	
+	return ptr;
+}
+
+
+void *
+MockMemoryManagerSuite::NewPtrClear(size_t size)
+{
+	void *ptr = NewPtr(size);
+	
+	if(ptr != NULL)
+		memset(ptr, 0, size);
+	
+	return ptr;
+}
+
+
+void
+MockMemoryManagerSuite::PrDisposePtr(void *ptr)
+{
+	std::map<void *, size_t>::iterator i = _sizes.find(ptr);
+	
+	assert(i != _sizes.end()); // not one of ours, or disposed twice
+	
+	if(i != _sizes.end())
+	{
+		_outstanding -= i->second;
+		
+		_sizes.erase(i);
+		
+		free(ptr);
+	}
+}
+
+
+struct MockPPix
+{
+	MockPixelFormat		format;
+	int					width;
+	int					height;
+	int					refs;
+	
+	char				*pixels;
+	char				*planes[3];	// YUV, or just the first for BGRA
+	long				rowbytes[3];
+};
+
+
+// Premiere pads its rows, so we do too, to catch anybody assuming width * 4
+static long
+PaddedRowbytes(long bytes)
+{
+	return ((bytes + 63) / 64) * 64;
+}
+
+
+MockPPixSuite::MockPPixSuite(MockMemoryManagerSuite &memory) :
+	_memory(memory),
+	_live(0),
+	_created(0)
+{
+
+}
+
+
+MockPPixHand
+MockPPixSuite::CreatePPix(MockPixelFormat format, int width, int height)
+{
+	MockPPix *ppix = new MockPPix;
+	
+	memset(ppix, 0, sizeof(MockPPix));
+	
+	ppix->format = format;
+	ppix->width = width;
+	ppix->height = height;
+	ppix->refs = 1;
+	
+	size_t sizes[3] = { 0, 0, 0 };
+	
+	if(format == MOCK_PIXEL_YUV420)
+	{
+		const int chroma_width = (width + 1) / 2;
+		const int chroma_height = (height + 1) / 2;
+		
+		ppix->rowbytes[0] = PaddedRowbytes(width);
+		ppix->rowbytes[1] = ppix->rowbytes[2] = PaddedRowbytes(chroma_width);
+		
+		sizes[0] = ppix->rowbytes[0] * height;
+		sizes[1] = sizes[2] = ppix->rowbytes[1] * chroma_height;
+	}
+	else
+	{
+		ppix->rowbytes[0] = PaddedRowbytes((long)width * (format == MOCK_PIXEL_BGRA16 ? 8 : 4));
+		
+		sizes[0] = ppix->rowbytes[0] * height;
+	}
+	
+	ppix->pixels = (char *)_memory.NewPtrClear(sizes[0] + sizes[1] + sizes[2]);
+	
+	if(ppix->pixels == NULL)
+	{
+		delete ppix;
+		
+		return NULL;
+	}
+	
+	ppix->planes[0] = ppix->pixels;
+	ppix->planes[1] = ppix->planes[0] + sizes[0];
+	ppix->planes[2] = ppix->planes[1] + sizes[1];
+	
+	_live++;
+	_created++;
+	
+	return ppix;
+}
+
+
+void
+MockPPixSuite::Dispose(MockPPixHand ppix)
+{
+	assert(ppix != NULL && ppix->refs > 0);
+	
+	if(ppix != NULL && --ppix->refs == 0)
+	{
+		_memory.PrDisposePtr(ppix->pixels);
+		
+		delete ppix;
+		
+		_live--;
+	}
+}
+
+
+void
+MockPPixSuite::AddRef(MockPPixHand ppix)
+{
+	ppix->refs++;
+}
+
+
+char *
+MockPPixSuite::GetPixels(MockPPixHand ppix) const
+{
+	return ppix->planes[0];
+}
+
+
+long
+MockPPixSuite::GetRowBytes(MockPPixHand ppix) const
+{
+	return ppix->rowbytes[0];
+}
+
+
+void
+MockPPixSuite::GetBounds(MockPPixHand ppix, int &width, int &height) const
+{
+	width = ppix->width;
+	height = ppix->height;
+}
+
+
+MockPixelFormat
+MockPPixSuite::GetPixelFormat(MockPPixHand ppix) const
+{
+	return ppix->format;
+}
+
+
+void
+MockPPix2Suite::GetYUV420PlanarBuffers(MockPPixHand ppix,
+										char **Y, long *Y_rowbytes,
+										char **U, long *U_rowbytes,
+										char **V, long *V_rowbytes) const
+{
+	assert(ppix->format == MOCK_PIXEL_YUV420);
+	
+	*Y = ppix->planes[0];
+	*U = ppix->planes[1];
+	*V = ppix->planes[2];
+	
+	*Y_rowbytes = ppix->rowbytes[0];
+	*U_rowbytes = ppix->rowbytes[1];
+	*V_rowbytes = ppix->rowbytes[2];
+}
+
+
+bool
+MockPPixCacheSuite::Key::operator<(const struct Key &other) const
+{
+	if(importer != other.importer)
+		return (importer < other.importer);
+	else if(stream != other.stream)
+		return (stream < other.stream);
+	else
+		return (frame < other.frame);
+}
+
+
+MockPPixCacheSuite::MockPPixCacheSuite(MockPPixSuite &ppix) :
+	_ppix(ppix),
+	_adds(0),
+	_hits(0),
+	_misses(0)
+{
+
+}
+
+
+MockPPixCacheSuite::~MockPPixCacheSuite()
+{
+	Purge();
+}
+
+
+void
+MockPPixCacheSuite::AddFrameToCache(int importerID, int stream, MockPPixHand ppix, long frame)
+{
+	Key key;
+	
+	key.importer = importerID;
+	key.stream = stream;
+	key.frame = frame;
+	
+	_ppix.AddRef(ppix);
+	
+	std::map<Key, MockPPixHand>::iterator i = _frames.find(key);
+	
+	if(i != _frames.end())
+	{
+		_ppix.Dispose(i->second);
+		
+		i->second = ppix;
+	}
+	else
+		_frames[key] = ppix;
+	
+	_adds++;
+}
+
+
+bool
+MockPPixCacheSuite::GetFrameFromCache(int importerID, int stream, long frame,
+										MockPixelFormat format, int width, int height, MockPPixHand *ppix)
+{
+	Key key;
+	
+	key.importer = importerID;
+	key.stream = stream;
+	key.frame = frame;
+	
+	std::map<Key, MockPPixHand>::iterator i = _frames.find(key);
+	
+	if(i != _frames.end() &&
+		_ppix.GetPixelFormat(i->second) == format)
+	{
+		int cached_width = 0, cached_height = 0;
+		
+		_ppix.GetBounds(i->second, cached_width, cached_height);
+		
+		if(cached_width == width && cached_height == height)
+		{
+			_ppix.AddRef(i->second);
+			
+			*ppix = i->second;
+			
+			_hits++;
+			
+			return true;
+		}
+	}
+	
+	_misses++;
+	
+	return false;
+}
+
+
+void
+MockPPixCacheSuite::Purge()
+{
+	for(std::map<Key, MockPPixHand>::iterator i = _frames.begin(); i != _frames.end(); ++i)
+		_ppix.Dispose(i->second);
+	
+	_frames.clear();
+}
+
+
+MockImporterFileManagerSuite::MockImporterFileManagerSuite(const char *test_name) :
+	_open(0)
+{
+	const char *dir = getenv("WEBM_TEST_DIR");
+	
+	if(dir != NULL && *dir != '\0')
+	{
+		_dir = dir;
+	}
+	else
+	{
+		_dir = "/tmp/webm_test_";
+		_dir += test_name;
+	}
+	
+	mkdir(_dir.c_str(), 0755);
+	
+	// and keep the index cache out of the user's
+	const std::string cache_dir = _dir + "/index_cache";
+	
+	setenv("WEBM_CACHE_DIR", cache_dir.c_str(), 1);
+}
+
+
+std::string
+MockImporterFileManagerSuite::PathFor(const char *name) const
+{
+	return _dir + "/" + name;
+}
+
+
+MockFileRef
+MockImporterFileManagerSuite::OpenFile(const UTF16String &path)
+{
+	MockFileRef fileRef = WebM_OpenFile(path.c_str(), "rb");
+	
+	if(fileRef != NULL)
+		_open++;
+	
+	return fileRef;
+}
+
+
+void
+MockImporterFileManagerSuite::CloseFile(MockFileRef fileRef)
+{
+	if(fileRef != NULL)
+	{
+		fclose(fileRef);
+		
+		_open--;
+	}
+}
+
+
+// Premiere's param IDs, as in WebM_Premiere_Export_Params.h
+#define ADBEVideoMatchSource		"ADBEVideoMatchSource"
+#define ADBEVideoWidth				"ADBEVideoWidth"
+#define ADBEVideoHeight				"ADBEVideoHeight"
+#define ADBEVideoFPS				"ADBEVideoFPS"
+#define ADBEVideoAlpha				"ADBEVideoAlpha"
+#define ADBEAudioRatePerSecond		"ADBEAudioRatePerSecond"
+#define ADBEAudioNumChannels		"ADBEAudioNumChannels"
+
+
+MockExportParamSuite::MockExportParamSuite()
+{
+	// what a 320x240, 24 fps, stereo sequence gets
+	SetInt(ADBEVideoMatchSource, 0);
+	SetInt(ADBEVideoWidth, 320);
+	SetInt(ADBEVideoHeight, 240);
+	SetInt(ADBEVideoFPS, 254016000000LL / 24);
+	SetInt(ADBEVideoAlpha, 0);
+	
+	SetInt("WebMVideoCodec", WEBM_CODEC_VP8);
+	SetInt("WebMVideoMethod", WEBM_METHOD_QUALITY);
+	SetInt("WebMVideoQuality", 50);
+	SetInt("WebMVideoBitrate", 500);
+	SetInt("WebMVideoEncoding", WEBM_ENCODING_GOOD);
+	SetInt("WebMVideoBudgetMode", WEBM_BUDGET_MINUTES);
+	SetInt("WebMVideoBudgetMinutes", 30);
+	SetFloat("WebMVideoBudgetSpeed", 1.0);
+	SetInt("WebMVideoSceneCuts", 0);
+	SetInt("WebMVideoSkipRepeats", 0);
+	SetInt("WebMVideoSmartRender", 0);
+	SetInt("WebMVideoRenditions", 0);
+	SetInt("WebMVideoProxy", 0);
+	SetInt("WebMVideoDASH", 0);
+	SetInt("WebMVideoKeyframeInterval", 2);
+	SetString("WebMCustomArgs", "");
+	
+	SetFloat(ADBEAudioRatePerSecond, 48000.0);
+	SetInt(ADBEAudioNumChannels, 2);
+	
+	SetInt("WebMAudioCodec", WEBM_CODEC_VORBIS);
+	SetInt("WebMAudioMethod", OGG_QUALITY);
+	SetFloat("WebMAudioQuality", 0.5);
+	SetInt("WebMAudioBitrate", 128);
+}
+
+
+long long
+MockExportParamSuite::GetInt(const char *id) const
+{
+	std::map<std::string, Value>::const_iterator i = _params.find(id);
+	
+	assert(i != _params.end());
+	
+	return (i != _params.end() ? i->second.int_value : 0);
+}
+
+
+double
+MockExportParamSuite::GetFloat(const char *id) const
+{
+	std::map<std::string, Value>::const_iterator i = _params.find(id);
+	
+	assert(i != _params.end());
+	
+	return (i != _params.end() ? i->second.float_value : 0.0);
+}
+
+
+std::string
+MockExportParamSuite::GetString(const char *id) const
+{
+	std::map<std::string, Value>::const_iterator i = _params.find(id);
+	
+	return (i != _params.end() ? i->second.string_value : std::string());
+}
+
+
+void
+MockExportParamSuite::GetSettings(WebM_ExportSettings &settings, long long ticks_per_second) const
+{
+	WebM_InitExportSettings(settings);
+	
+	settings.ticks_per_second = ticks_per_second;
+	
+	settings.width = GetInt(ADBEVideoWidth);
+	settings.height = GetInt(ADBEVideoHeight);
+	settings.frame_ticks = GetInt(ADBEVideoFPS);
+	settings.alpha = GetInt(ADBEVideoAlpha);
+	
+	settings.codec = (WebM_Video_Codec)GetInt("WebMVideoCodec");
+	settings.method = (WebM_Video_Method)GetInt("WebMVideoMethod");
+	settings.quality = GetInt("WebMVideoQuality");
+	settings.bitrate = GetInt("WebMVideoBitrate");
+	settings.encoding = (WebM_Video_Encoding)GetInt("WebMVideoEncoding");
+	
+	strncpy(settings.custom_args, GetString("WebMCustomArgs").c_str(), 255);
+	settings.custom_args[255] = '\0';
+	
+	settings.budget_mode = (WebM_Budget_Mode)GetInt("WebMVideoBudgetMode");
+	settings.budget_minutes = GetInt("WebMVideoBudgetMinutes");
+	settings.budget_speed = GetFloat("WebMVideoBudgetSpeed");
+	
+	settings.renditions = GetInt("WebMVideoRenditions");
+	settings.proxy = GetInt("WebMVideoProxy");
+	settings.dash = GetInt("WebMVideoDASH");
+	settings.keyframe_interval = GetInt("WebMVideoKeyframeInterval");
+	settings.scene_cuts = GetInt("WebMVideoSceneCuts");
+	settings.skip_repeats = GetInt("WebMVideoSkipRepeats");
+	settings.smart_render = GetInt("WebMVideoSmartRender");
+	
+	settings.audio_codec = (WebM_Audio_Codec)GetInt("WebMAudioCodec");
+	settings.audio_method = (Ogg_Method)GetInt("WebMAudioMethod");
+	settings.audio_quality = GetFloat("WebMAudioQuality");
+	settings.audio_bitrate = GetInt("WebMAudioBitrate");
+	
+	// Opus only runs at 48k, and Premiere will resample for us
+	settings.sample_rate = (settings.audio_codec == WEBM_CODEC_OPUS ? 48000 : GetFloat(ADBEAudioRatePerSecond));
+	settings.channels = GetInt(ADBEAudioNumChannels);
+	
+	settings.writing_app = "fnord WebM for Premiere";
+}
+
+
+MockExportFileSuite::MockExportFileSuite() :
+	_open(0)
+{
+
+}
+
+
+MockExportFileSuite::~MockExportFileSuite()
+{
+	for(std::map<int, FileObject>::iterator i = _files.begin(); i != _files.end(); ++i)
+	{
+		if(i->second.file != NULL)
+			fclose(i->second.file);
+	}
+}
+
+
+int
+MockExportFileSuite::NewFileObject(const UTF16String &path)
+{
+	const int fileObject = _files.size() + 1;
+	
+	FileObject &object = _files[fileObject];
+	
+	object.path = path;
+	object.file = NULL;
+	
+	return fileObject;
+}
+
+
+bool
+MockExportFileSuite::Open(int fileObject)
+{
+	std::map<int, FileObject>::iterator i = _files.find(fileObject);
+	
+	if(i == _files.end() || i->second.file != NULL)
+		return false;
+	
+	i->second.file = WebM_OpenFile(i->second.path.c_str(), "wb");
+	
+	if(i->second.file != NULL)
+		_open++;
+	
+	return (i->second.file != NULL);
+}
+
+
+bool
+MockExportFileSuite::Close(int fileObject)
+{
+	std::map<int, FileObject>::iterator i = _files.find(fileObject);
+	
+	if(i == _files.end() || i->second.file == NULL)
+		return false;
+	
+	fclose(i->second.file);
+	
+	i->second.file = NULL;
+	
+	_open--;
+	
+	return true;
+}
+
+
+bool
+MockExportFileSuite::Write(int fileObject, const void *buf, size_t len)
+{
+	std::map<int, FileObject>::iterator i = _files.find(fileObject);
+	
+	if(i == _files.end() || i->second.file == NULL)
+		return false;
+	
+	return (fwrite(buf, 1, len, i->second.file) == len);
+}
+
+
+bool
+MockExportFileSuite::Seek(int fileObject, long long offset, long long &new_pos, MockSeekMode mode)
+{
+	std::map<int, FileObject>::iterator i = _files.find(fileObject);
+	
+	if(i == _files.end() || i->second.file == NULL)
+		return false;
+	
+	FILE *file = i->second.file;
+	
+	const int whence = (mode == MOCK_SEEK_END ? SEEK_END :
+						mode == MOCK_SEEK_CURRENT ? SEEK_CUR :
+						SEEK_SET);
+	
+	if(fseeko(file, offset, whence) != 0)
+		return false;
+	
+	new_pos = WebM_TellFile(file);
+	
+	return true;
+}
+
+
+UTF16String
+MockExportFileSuite::GetPlatformPath(int fileObject) const
+{
+	std::map<int, FileObject>::const_iterator i = _files.find(fileObject);
+	
+	return (i != _files.end() ? i->second.path : UTF16String());
+}
+
+
+MockSequenceRenderSuite::MockSequenceRenderSuite(MockPPixSuite &ppix, MockPPix2Suite &ppix2) :
+	_ppix(ppix),
+	_ppix2(ppix2),
+	_source(NULL),
+	_clip(NULL),
+	_next_id(1),
+	_rendered(0)
+{
+	_supported[MOCK_PIXEL_YUV420] = _supported[MOCK_PIXEL_BGRA8] = _supported[MOCK_PIXEL_BGRA16] = true;
+}
+
+
+int
+MockSequenceRenderSuite::MakeVideoRenderer(long long frame_ticks)
+{
+	const int renderID = _next_id++;
+	
+	_renderers[renderID] = frame_ticks;
+	
+	return renderID;
+}
+
+
+void
+MockSequenceRenderSuite::ReleaseVideoRenderer(int renderID)
+{
+	_renderers.erase(renderID);
+}
+
+
+bool
+MockSequenceRenderSuite::RenderVideoFrame(int renderID, long long time,
+											const MockPixelFormat *formats, int format_count,
+											MockPPixHand *outFrame)
+{
+	std::map<int, long long>::const_iterator renderer = _renderers.find(renderID);
+	
+	if(renderer == _renderers.end() || (_source == NULL && _clip == NULL))
+		return false;
+	
+	const long frame = time / renderer->second;
+	
+	if(_clip != NULL)
+	{
+		for(int f=0; f < format_count; f++)
+		{
+			if(formats[f] == MOCK_PIXEL_YUV420 && _supported[MOCK_PIXEL_YUV420])
+			{
+				*outFrame = _clip->GetSourceVideo(frame, MOCK_PIXEL_YUV420);
+				
+				if(*outFrame == NULL)
+					return false;
+				
+				_rendered++;
+				
+				return true;
+			}
+		}
+		
+		return false;
+	}
+	
+	for(int f=0; f < format_count; f++)
+	{
+		const MockPixelFormat format = formats[f];
+		
+		if(_supported[format])
+		{
+			MockPPixHand ppix = _ppix.CreatePPix(format, _source->Width(), _source->Height());
+			
+			if(ppix == NULL)
+				return false;
+			
+			if(format == MOCK_PIXEL_YUV420)
+			{
+				char *Y, *U, *V;
+				long Y_rowbytes, U_rowbytes, V_rowbytes;
+				
+				_ppix2.GetYUV420PlanarBuffers(ppix, &Y, &Y_rowbytes, &U, &U_rowbytes, &V, &V_rowbytes);
+				
+				_source->YUV420(frame, (unsigned char *)Y, Y_rowbytes,
+										(unsigned char *)U, U_rowbytes,
+										(unsigned char *)V, V_rowbytes);
+			}
+			else if(format == MOCK_PIXEL_BGRA16)
+			{
+				_source->BGRA16(frame, (unsigned short *)_ppix.GetPixels(ppix), _ppix.GetRowBytes(ppix), true);
+			}
+			else
+				_source->BGRA8(frame, (unsigned char *)_ppix.GetPixels(ppix), _ppix.GetRowBytes(ppix), true);
+			
+			*outFrame = ppix;
+			
+			_rendered++;
+			
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
+MockSequenceAudioSuite::MockSequenceAudioSuite() :
+	_source(NULL),
+	_next_id(1),
+	_rendered(0)
+{
+
+}
+
+
+int
+MockSequenceAudioSuite::MakeAudioRenderer(long long start_time, long long ticks_per_second, int sample_rate)
+{
+	const int renderID = _next_id++;
+	
+	Renderer &renderer = _renderers[renderID];
+	
+	renderer.position = start_time * sample_rate / ticks_per_second;
+	renderer.sample_rate = sample_rate;
+	renderer.ticks_per_second = ticks_per_second;
+	
+	return renderID;
+}
+
+
+void
+MockSequenceAudioSuite::ReleaseAudioRenderer(int renderID)
+{
+	_renderers.erase(renderID);
+}
+
+
+bool
+MockSequenceAudioSuite::GetAudio(int renderID, int samples, float **buffers)
+{
+	std::map<int, Renderer>::iterator renderer = _renderers.find(renderID);
+	
+	if(renderer == _renderers.end() || _source == NULL)
+		return false;
+	
+	_source->Fill(renderer->second.position, samples, buffers);
+	
+	renderer->second.position += samples;
+	
+	_rendered += samples;
+	
+	return true;
+}
+
+
+int
+MockSequenceAudioSuite::GetMaxBlip(int renderID, long long ticks) const
+{
+	std::map<int, Renderer>::const_iterator renderer = _renderers.find(renderID);
+	
+	if(renderer == _renderers.end())
+		return 100;
+	
+	const long long samples = ticks * renderer->second.sample_rate / renderer->second.ticks_per_second;
+	
+	return (samples > 0 ? samples : 1);
+}
+
+
+MockHost::MockHost(const char *test_name) :
+	ppix(memory),
+	cache(ppix),
+	files(test_name),
+	render(ppix, ppix2),
+	num_cpus(1)
+{
+
+}
+
+
+bool
+MockHost::Leaked()
+{
+	cache.Purge();
+	
+	return (ppix.Live() != 0 || memory.PtrsOutstanding() != 0 ||
+			files.OpenFiles() != 0 || exportFile.OpenFiles() != 0);
+}
+
+
+// PrMkvWriter, on the mock ExportFileSuite
+class MockMkvWriter : public WebM_MkvWriter
+{
+  public:
+	MockMkvWriter(MockExportFileSuite &fileSuite, int fileObject);
+	virtual ~MockMkvWriter();
+	
+	virtual mkvmuxer::int32 Write(const void* buf, mkvmuxer::uint32 len);
+	virtual mkvmuxer::int64 Position() const;
+	virtual mkvmuxer::int32 Position(mkvmuxer::int64 position); // seek
+	virtual bool Seekable() const { return true; }
+	
+  private:
+	MockExportFileSuite &_fileSuite;
+	const int _fileObject;
+	
+	mkvmuxer::int64 _pos;
+};
+
+
+MockMkvWriter::MockMkvWriter(MockExportFileSuite &fileSuite, int fileObject) :
+	_fileSuite(fileSuite),
+	_fileObject(fileObject),
+	_pos(0)
+{
+
+}
+
+
+MockMkvWriter::~MockMkvWriter()
+{
+	_fileSuite.Close(_fileObject);
+}
+
+
+mkvmuxer::int32
+MockMkvWriter::Write(const void* buf, mkvmuxer::uint32 len)
+{
+	if( !_fileSuite.Write(_fileObject, buf, len) )
+		return -1;
+	
+	_pos += len;
+	
+	if(_pos > _layout.size)
+		_layout.size = _pos;
+	
+	return 0;
+}
+
+
+mkvmuxer::int64
+MockMkvWriter::Position() const
+{
+	long long pos = 0;
+	
+	_fileSuite.Seek(_fileObject, 0, pos, MOCK_SEEK_CURRENT);
+	
+	return pos;
+}
+
+
+mkvmuxer::int32
+MockMkvWriter::Position(mkvmuxer::int64 position)
+{
+	long long pos = 0;
+	
+	if( !_fileSuite.Seek(_fileObject, position, pos, MOCK_SEEK_BEGIN) )
+		return -1;
+	
+	_pos = position;
+	
+	return 0;
+}
+
+
+MockExportHost::MockExportHost(MockHost &host, int fileObject, int videoRenderID, int audioRenderID, bool alpha) :
+	_host(host),
+	_fileObject(fileObject),
+	_videoRenderID(videoRenderID),
+	_audioRenderID(audioRenderID),
+	_alpha(alpha),
+	_cancel_at(-1.f),
+	_progress(0.f)
+{
+
+}
+
+
+WebM_MkvWriter *
+MockExportHost::OpenWriter()
+{
+	if( !_host.exportFile.Open(_fileObject) )
+		return NULL;
+	
+	return new MockMkvWriter(_host.exportFile, _fileObject);
+}
+
+
+void
+MockExportHost::CloseWriter(WebM_MkvWriter *writer)
+{
+	delete writer;
+}
+
+
+WebM_Result
+MockExportHost::RenderFrame(long long time, WebM_HostFrame &frame)
+{
+	// YUV has no alpha, so then we have to take BGRA
+	static const MockPixelFormat pixelFormats[] = { MOCK_PIXEL_YUV420,
+													MOCK_PIXEL_BGRA16,
+													MOCK_PIXEL_BGRA8 };
+	
+	const double start = WebM_Seconds();
+	
+	MockPPixHand ppix = NULL;
+	
+	const bool rendered = _host.render.RenderVideoFrame(_videoRenderID, time,
+														(_alpha ? &pixelFormats[1] : pixelFormats),
+														(_alpha ? 2 : 3),
+														&ppix);
+	
+	if(!rendered)
+		return WEBM_ERR_HOST;
+	
+	_latency.Add(WebM_Seconds() - start);
+	
+	const MockPixelFormat pixFormat = _host.ppix.GetPixelFormat(ppix);
+	
+	_host.ppix.GetBounds(ppix, frame.width, frame.height);
+	
+	frame.host_data = ppix;
+	
+	if(pixFormat == MOCK_PIXEL_YUV420)
+	{
+		char *Y_PixelAddress, *U_PixelAddress, *V_PixelAddress;
+		long Y_RowBytes, U_RowBytes, V_RowBytes;
+		
+		_host.ppix2.GetYUV420PlanarBuffers(ppix, &Y_PixelAddress, &Y_RowBytes,
+													&U_PixelAddress, &U_RowBytes,
+													&V_PixelAddress, &V_RowBytes);
+		
+		frame.format = WEBM_FRAME_YUV420;
+		frame.data[0] = (unsigned char *)Y_PixelAddress;
+		frame.data[1] = (unsigned char *)U_PixelAddress;
+		frame.data[2] = (unsigned char *)V_PixelAddress;
+		frame.rowbytes[0] = Y_RowBytes;
+		frame.rowbytes[1] = U_RowBytes;
+		frame.rowbytes[2] = V_RowBytes;
+	}
+	else
+	{
+		frame.format = (pixFormat == MOCK_PIXEL_BGRA16 ? WEBM_FRAME_BGRA16 : WEBM_FRAME_BGRA8);
+		frame.data[0] = (unsigned char *)_host.ppix.GetPixels(ppix);
+		frame.rowbytes[0] = _host.ppix.GetRowBytes(ppix);
+		frame.flipped = true;
+	}
+	
+	return WEBM_OK;
+}
+
+
+void
+MockExportHost::ReleaseFrame(WebM_HostFrame &frame)
+{
+	if(frame.host_data != NULL)
+		_host.ppix.Dispose((MockPPixHand)frame.host_data);
+	
+	frame.host_data = NULL;
+}
+
+
+WebM_Result
+MockExportHost::GetAudio(int samples, float **buffers)
+{
+	return (_host.audio.GetAudio(_audioRenderID, samples, buffers) ? WEBM_OK : WEBM_ERR_HOST);
+}
+
+
+int
+MockExportHost::MaxAudioBlip(long long ticks)
+{
+	return _host.audio.GetMaxBlip(_audioRenderID, ticks);
+}
+
+
+WebM_Result
+MockExportHost::Progress(float progress)
+{
+	assert(progress >= _progress - 0.0001f); // never backwards
+	
+	_progress = progress;
+	
+	return ((_cancel_at >= 0.f && progress >= _cancel_at) ? WEBM_ERR_HOST : WEBM_OK);
+}
+
+
+void
+MockExportHost::Message(const char *message)
+{
+	printf("  exporter says: %s\n", message);
+}
+
+
+WebM_Result
+MockExport(MockHost &host, const char *name, long long start_time, long long end_time,
+			WebM_ExportStats *stats, WebM_TestReport *report)
+{
+	const long long ticksPerSecond = host.time.GetTicksPerSecond();
+	
+	WebM_ExportSettings settings;
+	
+	host.params.GetSettings(settings, ticksPerSecond);
+	
+	settings.export_video = (host.render.Source() != NULL || host.render.Clip() != NULL);
+	settings.export_audio = (host.audio.Source() != NULL);
+	settings.start_time = start_time;
+	settings.end_time = end_time;
+	settings.num_cpus = host.num_cpus;
+	
+	const bool alpha = (settings.alpha && settings.export_video);
+	
+	const int videoRenderID = (settings.export_video ? host.render.MakeVideoRenderer(settings.frame_ticks) : 0);
+	
+	const int audioRenderID = (settings.export_audio ?
+								host.audio.MakeAudioRenderer(start_time, ticksPerSecond, settings.sample_rate) :
+								0);
+	
+	// where the movie is going, so we can put other files next to it
+	const int fileObject = host.exportFile.NewFileObject(host.files.PlatformPath(name));
+	
+	const UTF16String main_path = host.exportFile.GetPlatformPath(fileObject);
+	
+	MockExportHost exportHost(host, fileObject, videoRenderID, audioRenderID, alpha);
+	
+	if(report != NULL)
+		report->Start();
+	
+	const WebM_Result result = WebM_ExportMovie(settings, main_path.c_str(), exportHost, stats);
+	
+	if(report != NULL)
+	{
+		report->Stop(settings.export_video ? (end_time - start_time) / settings.frame_ticks : 0);
+		
+		report->Latency() = exportHost.RenderLatency();
+	}
+	
+	if(settings.export_video)
+		host.render.ReleaseVideoRenderer(videoRenderID);
+	
+	if(settings.export_audio)
+		host.audio.ReleaseAudioRenderer(audioRenderID);
+	
+	return result;
+}
+
+
+// PrMkvReader, on a stdio file
+class MockFileReader : public WebM_Reader
+{
+  public:
+	MockFileReader(MockFileRef fileRef);
+	virtual ~MockFileReader() {}
+	
+	virtual int Read(long long pos, long len, unsigned char* buf);
+	
+	MockFileRef FileRef() const { return _fileRef; }
+	
+	void Attach(MockFileRef fileRef);
+	void Detach();
+	
+  protected:
+	virtual long long FileSize() const;
+	
+  private:
+	MockFileRef _fileRef;
+};
+
+
+MockFileReader::MockFileReader(MockFileRef fileRef) :
+	_fileRef(NULL)
+{
+	Attach(fileRef);
+}
+
+
+void
+MockFileReader::Attach(MockFileRef fileRef)
+{
+	_fileRef = fileRef;
+	
+	UpdateSize();
+}
+
+
+void
+MockFileReader::Detach()
+{
+	_fileRef = NULL;
+	
+	ForgetSize();
+}
+
+
+int
+MockFileReader::Read(long long pos, long len, unsigned char* buf)
+{
+	if(_fileRef == NULL || WebM_SeekFile(_fileRef, pos) != 0)
+		return WebM_ReadError;
+	
+	return (fread(buf, 1, len, _fileRef) == (size_t)len ? WebM_ReadSuccess : WebM_ReadError);
+}
+
+
+long long
+MockFileReader::FileSize() const
+{
+	if(_fileRef == NULL)
+		return -1;
+	
+	struct stat file_stat;
+	
+	if(fstat(fileno(_fileRef), &file_stat) != 0)
+		return -1;
+	
+	return file_stat.st_size;
+}
+
+
+#define FAST_DECODE_STREAM	1
+
+
+// PremiereFrameSink, on the mock suites
+class MockFrameSink : public WebM_FrameSink
+{
+  public:
+	MockFrameSink(MockHost &host, int importerID, long theFrame, MockPixelFormat format,
+					int width, int height, bool keyframes_only, MockPPixHand *outFrame);
+	virtual ~MockFrameSink() {}
+	
+	virtual bool InCache(long frame);
+	
+	virtual WebM_Result Frame(long frame, const vpx_image_t *img, const vpx_image_t *alpha,
+								bool wanted, bool cache, bool fast);
+								
+  private:
+	MockHost &_host;
+	const int _importerID;
+	const long _theFrame;
+	const MockPixelFormat _format;
+	const int _width;
+	const int _height;
+	const bool _keyframes_only;
+	MockPPixHand * const _outFrame;
+};
+
+
+MockFrameSink::MockFrameSink(MockHost &host, int importerID, long theFrame, MockPixelFormat format,
+								int width, int height, bool keyframes_only, MockPPixHand *outFrame) :
+	_host(host),
+	_importerID(importerID),
+	_theFrame(theFrame),
+	_format(format),
+	_width(width),
+	_height(height),
+	_keyframes_only(keyframes_only),
+	_outFrame(outFrame)
+{
+
+}
+
+
+bool
+MockFrameSink::InCache(long frame)
+{
+	return _host.cache.GetFrameFromCache(_importerID, 0, frame, _format, _width, _height, _outFrame);
+}
+
+
+WebM_Result
+MockFrameSink::Frame(long frame, const vpx_image_t *img, const vpx_image_t *alpha,
+						bool wanted, bool cache, bool fast)
+{
+	assert(img->d_w == _width && img->d_h == _height);
+	
+	MockPPixHand ppix = _host.ppix.CreatePPix(_format, _width, _height);
+	
+	if(ppix == NULL)
+		return WEBM_ERR_MEMORY;
+	
+	if(_format == MOCK_PIXEL_YUV420)
+	{
+		char *Y_PixelAddress, *U_PixelAddress, *V_PixelAddress;
+		long Y_RowBytes, U_RowBytes, V_RowBytes;
+		
+		_host.ppix2.GetYUV420PlanarBuffers(ppix, &Y_PixelAddress, &Y_RowBytes,
+													&U_PixelAddress, &U_RowBytes,
+													&V_PixelAddress, &V_RowBytes);
+		
+		WebM_CopyImageToYUV420(img,
+								(unsigned char *)Y_PixelAddress, Y_RowBytes,
+								(unsigned char *)U_PixelAddress, U_RowBytes,
+								(unsigned char *)V_PixelAddress, V_RowBytes);
+	}
+	else if(_format == MOCK_PIXEL_BGRA8)
+	{
+		// upside down, like the BGRA the exporter gets
+		WebM_CopyImageToBGRA8(img, alpha, (unsigned char *)_host.ppix.GetPixels(ppix), _host.ppix.GetRowBytes(ppix), true);
+	}
+	else
+		assert(false); // the importer only offers those two
+	
+	const int cache_stream = (fast ? FAST_DECODE_STREAM : 0);
+	
+	if(cache)
+		_host.cache.AddFrameToCache(_importerID, cache_stream, ppix, frame);
+	
+	if(wanted)
+	{
+		*_outFrame = ppix;
+		
+		if(frame != _theFrame && !_keyframes_only)
+			_host.cache.AddFrameToCache(_importerID, cache_stream, ppix, _theFrame);
+	}
+	else
+		_host.ppix.Dispose(ppix);
+	
+	return WEBM_OK;
+}
+
+
+MockImporter::MockImporter(MockHost &host, int importerID) :
+	_host(host),
+	_importerID(importerID),
+	_fileRef(NULL),
+	_clip(NULL),
+	_reader(NULL),
+	_decode_mode(WEBM_DECODE_NORMAL),
+	_keyframes_only(false),
+	_decodes(0),
+	_last_result(WEBM_OK)
+{
+
+}
+
+
+MockImporter::~MockImporter()
+{
+	CloseFile();
+}
+
+
+WebM_Result
+MockImporter::OpenFile(const char *name)
+{
+	QuietFile();
+	
+	_path = _host.files.PlatformPath(name);
+	
+	_fileRef = _host.files.OpenFile(_path);
+	
+	if(_fileRef == NULL)
+		return WEBM_ERR_READ;
+	
+	// Coming back from being quiet.  If the file is the same as before,
+	// everything we parsed still holds, it just needs the new handle.
+	if(_clip != NULL)
+	{
+		_reader->Attach(_fileRef);
+		
+		if( !_clip->Reopen(_path.c_str()) )
+		{
+			delete _clip;
+			
+			_clip = NULL;
+			_reader = NULL;
+		}
+	}
+	
+	WebM_Result result = WEBM_OK;
+	
+	if(_clip == NULL)
+	{
+		_reader = new MockFileReader(_fileRef);
+		
+		_clip = new WebM_Clip(_importerID);
+		
+		result = _clip->Open(_reader, _path.c_str());
+	}
+	
+	if(result != WEBM_OK)
+		CloseFile();
+	
+	return result;
+}
+
+
+void
+MockImporter::QuietFile()
+{
+	if(_fileRef != NULL)
+	{
+		if(_reader != NULL)
+			_reader->Detach();
+		
+		if(_clip != NULL)
+			_clip->Quiet();
+		
+		_host.files.CloseFile(_fileRef);
+		
+		_fileRef = NULL;
+	}
+}
+
+
+void
+MockImporter::CloseFile()
+{
+	QuietFile();
+	
+	delete _clip; // and the reader
+	
+	_clip = NULL;
+	_reader = NULL;
+}
+
+
+MockPPixHand
+MockImporter::GetSourceVideo(long frame, MockPixelFormat format, MockRenderQuality quality,
+								int width, int height)
+{
+	_last_result = WEBM_OK;
+	
+	if(_clip == NULL || !_clip->IsOpen() || _fileRef == NULL)
+	{
+		_last_result = WEBM_ERR_INTERNAL;
+		
+		return NULL;
+	}
+	
+	_clip->Update();
+	
+	const long theFrame = (_clip->FpsDen() == 0 ? 0 : frame);
+	
+	if(width == 0 && height == 0)
+	{
+		width = _clip->Width();
+		height = _clip->Height();
+	}
+	
+	MockPPixHand outFrame = NULL;
+	
+	bool found = _host.cache.GetFrameFromCache(_importerID, 0, theFrame, format, width, height, &outFrame);
+	
+	// a fast frame is good enough for playback
+	if(!found && _decode_mode == WEBM_DECODE_FAST && quality != MOCK_QUALITY_HIGH)
+	{
+		found = _host.cache.GetFrameFromCache(_importerID, FAST_DECODE_STREAM, theFrame, format, width, height, &outFrame);
+	}
+	
+	if(!found && _clip->HasVideo())
+	{
+		WebM_DecodeRequest request;
+		
+		request.frame = theFrame;
+		request.width = width;
+		request.height = height;
+		request.alpha = (format == MOCK_PIXEL_BGRA8);
+		request.high_quality = (quality == MOCK_QUALITY_HIGH);
+		request.mode = _decode_mode;
+		request.num_cpus = _host.num_cpus;
+		
+		// Thumbnails, hover scrub and shuttling don't need the exact frame.
+		// Low is still playback, just at a lower resolution, so it does.
+		request.keyframes_only = (_keyframes_only ||
+									quality == MOCK_QUALITY_DRAFT);
+		
+		MockFrameSink sink(_host, _importerID, theFrame, format, width, height, request.keyframes_only, &outFrame);
+		
+		const double start = WebM_Seconds();
+		
+		_last_result = WebM_DecodeFrame(*_clip, request, sink);
+		
+		_latency.Add(WebM_Seconds() - start);
+		
+		_decodes++;
+	}
+	
+	return outFrame;
+}
+
+
+WebM_Result
+MockImporter::ImportAudio(long long position, int samples, float **buffers)
+{
+	if(_clip == NULL || !_clip->IsOpen() || _fileRef == NULL)
+		return WEBM_ERR_INTERNAL;
+	
+	return _clip->ReadAudio(position, samples, buffers);
+}
@@ -0,0 +1,502 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_TEST_MOCKHOST_H
+#define WEBM_TEST_MOCKHOST_H
+
+// A stand-in for Premiere, so the importer and exporter can run under a test.
+// The suites are cut down to the calls the plug-in makes, with the same names
+// and the same habits: BGRA comes bottom row first, PPixes are reference
+// counted, the frame cache hands back frames it was given.  MockImporter
+// and MockExportHost do what the adapters in src/premiere do, one call for
+// another, so what passes here is what Premiere would see.  Everything
+// keeps count of what was handed out and never given back.
+
+#include "WebM_Export.h"
+#include "WebM_Import.h"
+
+#include "Generators.h"
+#include "Stats.h"
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+
+
+// TimeSuite
+class MockTimeSuite
+{
+  public:
+	long long GetTicksPerSecond() const { return 254016000000LL; }
+	
+	long long GetTicksPerFrame(unsigned int fps_num, unsigned int fps_den) const
+		{ return GetTicksPerSecond() * fps_den / fps_num; }
+};
+
+
+// MemoryManagerSuite.  The PPixes get their pixels here too, so the peak
+// is the most frame memory the plug-in had Premiere hold at once.
+class MockMemoryManagerSuite
+{
+  public:
+	MockMemoryManagerSuite();
+	~MockMemoryManagerSuite();
+	
+	void * NewPtr(size_t size);
+	void * NewPtrClear(size_t size);
+	void PrDisposePtr(void *ptr);
+	
+	long PtrsOutstanding() const { return _sizes.size(); }
+	size_t BytesOutstanding() const { return _outstanding; }
+	size_t PeakBytes() const { return _peak; }
+	
+  private:
+	std::map<void *, size_t> _sizes;
+	size_t _outstanding;
+	size_t _peak;
+};
+
+
+// The pixel formats the plug-in deals in
+typedef enum {
+	MOCK_PIXEL_YUV420 = 0,	// PrPixelFormat_YUV_420_MPEG2_FRAME_PICTURE_PLANAR_8u_709
+	MOCK_PIXEL_BGRA8,		// PrPixelFormat_BGRA_4444_8u
+	MOCK_PIXEL_BGRA16		// PrPixelFormat_BGRA_4444_16u, 0 to 32768
+} MockPixelFormat;
+
+typedef struct MockPPix *MockPPixHand;
+
+
+// PPixCreatorSuite and PPixSuite
+class MockPPixSuite
+{
+  public:
+	MockPPixSuite(MockMemoryManagerSuite &memory);
+	
+	MockPPixHand CreatePPix(MockPixelFormat format, int width, int height);
+	
+	// one reference fewer, gone when there are none
+	void Dispose(MockPPixHand ppix);
+	
+	// Premiere does this behind the scenes when it keeps a frame
+	void AddRef(MockPPixHand ppix);
+	
+	char * GetPixels(MockPPixHand ppix) const;
+	long GetRowBytes(MockPPixHand ppix) const;
+	void GetBounds(MockPPixHand ppix, int &width, int &height) const;
+	MockPixelFormat GetPixelFormat(MockPPixHand ppix) const;
+	
+	long Live() const { return _live; }
+	long Created() const { return _created; }
+	
+  private:
+	MockMemoryManagerSuite &_memory;
+	
+	long _live;
+	long _created;
+};
+
+
+// PPix2Suite
+class MockPPix2Suite
+{
+  public:
+	void GetYUV420PlanarBuffers(MockPPixHand ppix,
+								char **Y, long *Y_rowbytes,
+								char **U, long *U_rowbytes,
+								char **V, long *V_rowbytes) const;
+};
+
+
+// PPixCacheSuite.  Frames by importer, stream and frame number.
+// Adding a frame takes a reference, getting one gives the caller its own.
+class MockPPixCacheSuite
+{
+  public:
+	MockPPixCacheSuite(MockPPixSuite &ppix);
+	~MockPPixCacheSuite();
+	
+	void AddFrameToCache(int importerID, int stream, MockPPixHand ppix, long frame);
+	// only a hit if it's the format and size asked for
+	bool GetFrameFromCache(int importerID, int stream, long frame,
+							MockPixelFormat format, int width, int height, MockPPixHand *ppix);
+	
+	// what Premiere does when it wants the memory back
+	void Purge();
+	
+	long Frames() const { return _frames.size(); }
+	long Adds() const { return _adds; }
+	long Hits() const { return _hits; }
+	long Misses() const { return _misses; }
+	
+  private:
+	typedef struct Key
+	{
+		int		importer;
+		int		stream;
+		long	frame;
+		
+		bool operator<(const struct Key &other) const;
+	} Key;
+	
+	MockPPixSuite &_ppix;
+	
+	std::map<Key, MockPPixHand> _frames;
+	
+	long _adds;
+	long _hits;
+	long _misses;
+};
+
+
+// ImporterFileManagerSuite, along with the file handles Premiere gives an
+// importer in imOpenFile8 and takes away in imQuietFile.  Test files go in
+// $WEBM_TEST_DIR, or a directory in /tmp.
+typedef FILE * MockFileRef;
+
+class MockImporterFileManagerSuite
+{
+  public:
+	MockImporterFileManagerSuite(const char *test_name);
+	
+	const std::string & Dir() const { return _dir; }
+	
+	std::string PathFor(const char *name) const;
+	UTF16String PlatformPath(const char *name) const { return WebM_PathFromUTF8(PathFor(name).c_str()); }
+	
+	// opened so a writer can keep going, like the importer does on Windows
+	MockFileRef OpenFile(const UTF16String &path);
+	void CloseFile(MockFileRef fileRef);
+	
+	long OpenFiles() const { return _open; }
+	
+  private:
+	std::string _dir;
+	
+	long _open;
+};
+
+
+// ExportParamSuite.  Starts out with what exSDKGenerateDefaultParams sets.
+class MockExportParamSuite
+{
+  public:
+	MockExportParamSuite();
+	
+	void SetInt(const char *id, long long value) { _params[id].int_value = value; }
+	void SetFloat(const char *id, double value) { _params[id].float_value = value; }
+	void SetString(const char *id, const char *value) { _params[id].string_value = value; }
+	
+	long long GetInt(const char *id) const;
+	double GetFloat(const char *id) const;
+	std::string GetString(const char *id) const;
+	
+	// what exSDKExport makes of them
+	void GetSettings(WebM_ExportSettings &settings, long long ticks_per_second) const;
+	
+  private:
+	typedef struct Value
+	{
+		long long		int_value;
+		double			float_value;
+		std::string		string_value;
+		
+		Value() : int_value(0), float_value(0.0) {}
+	} Value;
+	
+	std::map<std::string, Value> _params;
+};
+
+
+// ExportFileSuite
+typedef enum {
+	MOCK_SEEK_BEGIN = 0,
+	MOCK_SEEK_CURRENT,
+	MOCK_SEEK_END
+} MockSeekMode;
+
+class MockExportFileSuite
+{
+  public:
+	MockExportFileSuite();
+	~MockExportFileSuite();
+	
+	// Premiere makes these from the output settings
+	int NewFileObject(const UTF16String &path);
+	
+	bool Open(int fileObject);
+	bool Close(int fileObject);
+	bool Write(int fileObject, const void *buf, size_t len);
+	bool Seek(int fileObject, long long offset, long long &new_pos, MockSeekMode mode);
+	
+	UTF16String GetPlatformPath(int fileObject) const;
+	
+	long OpenFiles() const { return _open; }
+	
+  private:
+	typedef struct {
+		UTF16String		path;
+		FILE			*file;
+	} FileObject;
+	
+	std::map<int, FileObject> _files;
+	
+	long _open;
+};
+
+
+class MockImporter;
+
+// SequenceRenderSuite, rendering a FrameGenerator.  The exporter asks for the
+// formats it can take, best first, and gets the first one we have.  Or a
+// sequence with just one clip on it, which comes from the importer in
+// 4:2:0 untouched, the way Premiere hands over frames it doesn't have to
+// process, so smart rendering has something to find.
+class MockSequenceRenderSuite
+{
+  public:
+	MockSequenceRenderSuite(MockPPixSuite &ppix, MockPPix2Suite &ppix2);
+	
+	void SetSource(const FrameGenerator *source) { _source = source; _clip = NULL; }
+	const FrameGenerator * Source() const { return _source; }
+	
+	void SetClip(MockImporter *clip) { _clip = clip; _source = NULL; }
+	MockImporter * Clip() const { return _clip; }
+	
+	// all three are, to start with
+	void SetSupported(MockPixelFormat format, bool supported) { _supported[format] = supported; }
+	
+	int MakeVideoRenderer(long long frame_ticks);
+	void ReleaseVideoRenderer(int renderID);
+	
+	bool RenderVideoFrame(int renderID, long long time,
+							const MockPixelFormat *formats, int format_count,
+							MockPPixHand *outFrame);
+	
+	long FramesRendered() const { return _rendered; }
+	
+  private:
+	MockPPixSuite &_ppix;
+	MockPPix2Suite &_ppix2;
+	
+	const FrameGenerator *_source;
+	MockImporter *_clip;
+	
+	bool _supported[3];
+	
+	std::map<int, long long> _renderers;
+	int _next_id;
+	
+	long _rendered;
+};
+
+
+// SequenceAudioSuite, playing a ToneGenerator
+class MockSequenceAudioSuite
+{
+  public:
+	MockSequenceAudioSuite();
+	
+	void SetSource(const ToneGenerator *source) { _source = source; }
+	const ToneGenerator * Source() const { return _source; }
+	
+	int MakeAudioRenderer(long long start_time, long long ticks_per_second, int sample_rate);
+	void ReleaseAudioRenderer(int renderID);
+	
+	// the next samples, picking up where the last call left off
+	bool GetAudio(int renderID, int samples, float **buffers);
+	int GetMaxBlip(int renderID, long long ticks) const;
+	
+	long long SamplesRendered() const { return _rendered; }
+	
+  private:
+	typedef struct {
+		long long	position;
+		int			sample_rate;
+		long long	ticks_per_second;
+	} Renderer;
+	
+	const ToneGenerator *_source;
+	
+	std::map<int, Renderer> _renderers;
+	int _next_id;
+	
+	long long _rendered;
+};
+
+
+// Premiere, as far as the plug-in can tell
+class MockHost
+{
+  public:
+	MockHost(const char *test_name);
+	
+	MockTimeSuite					time;
+	MockMemoryManagerSuite			memory;
+	MockPPixSuite					ppix;
+	MockPPix2Suite					ppix2;
+	MockPPixCacheSuite				cache;
+	MockImporterFileManagerSuite	files;
+	MockExportParamSuite			params;
+	MockExportFileSuite				exportFile;
+	MockSequenceRenderSuite			render;
+	MockSequenceAudioSuite			audio;
+	
+	// g_num_cpus, which both plug-ins get from the system
+	int								num_cpus;
+	
+	// Purges the cache, then anything still around was leaked
+	bool Leaked();
+};
+
+
+// PremiereExportHost, on the mock suites
+class MockExportHost : public WebM_ExportHost
+{
+  public:
+	MockExportHost(MockHost &host, int fileObject, int videoRenderID, int audioRenderID, bool alpha);
+	virtual ~MockExportHost() {}
+	
+	virtual WebM_MkvWriter * OpenWriter();
+	virtual void CloseWriter(WebM_MkvWriter *writer);
+	
+	virtual WebM_Result RenderFrame(long long time, WebM_HostFrame &frame);
+	virtual void ReleaseFrame(WebM_HostFrame &frame);
+	
+	virtual WebM_Result GetAudio(int samples, float **buffers);
+	virtual int MaxAudioBlip(long long ticks);
+	
+	virtual WebM_Result Progress(float progress);
+	virtual void Message(const char *message);
+	
+	// render time per frame, as the exporter waited for it
+	const WebM_TestLatency & RenderLatency() const { return _latency; }
+	
+	// cancel as soon as progress gets this far
+	void CancelAt(float progress) { _cancel_at = progress; }
+	
+	float LastProgress() const { return _progress; }
+	
+  private:
+	MockHost &_host;
+	const int _fileObject;
+	const int _videoRenderID;
+	const int _audioRenderID;
+	const bool _alpha;
+	
+	WebM_TestLatency _latency;
+	
+	float _cancel_at;
+	float _progress;
+};
+
+
+// exSDKExport: settings from the params, renderers for whatever sources the
+// host has, and the movie goes to name in the test directory.
+// Frames per second and render latency go in report.
+WebM_Result MockExport(MockHost &host, const char *name, long long start_time, long long end_time,
+						WebM_ExportStats *stats = NULL, WebM_TestReport *report = NULL);
+
+
+// How Premiere wants a frame
+typedef enum {
+	MOCK_QUALITY_HIGH = 0,	// kPrRenderQuality_High
+	MOCK_QUALITY_MEDIUM,
+	MOCK_QUALITY_LOW,
+	MOCK_QUALITY_DRAFT
+} MockRenderQuality;
+
+
+// The importer's side: imOpenFile8, imQuietFile, imGetSourceVideo and
+// imImportAudio7, doing what WebM_Premiere_Import.cpp does with them.
+class MockImporter
+{
+  public:
+	MockImporter(MockHost &host, int importerID);
+	~MockImporter();
+	
+	// Opening again after QuietFile() is how Premiere wakes a clip up
+	WebM_Result OpenFile(const char *name);
+	void QuietFile();
+	void CloseFile();
+	
+	// A reference the caller has to Dispose(), NULL if there was no frame.
+	// frame is in the clip's frame rate (Premiere sends a time, which
+	// the importer turns into the same thing).  A width and height of 0
+	// mean the clip's own size.
+	MockPPixHand GetSourceVideo(long frame, MockPixelFormat format,
+								MockRenderQuality quality = MOCK_QUALITY_HIGH,
+								int width = 0, int height = 0);
+	
+	WebM_Result ImportAudio(long long position, int samples, float **buffers);
+	
+	WebM_Clip * Clip() const { return _clip; }
+	
+	// the importer's globals
+	void SetDecodeMode(WebM_Decode_Mode mode) { _decode_mode = mode; }
+	void SetKeyframesOnly(bool keyframes_only) { _keyframes_only = keyframes_only; }
+	
+	// time for each GetSourceVideo() that had to decode
+	const WebM_TestLatency & DecodeLatency() const { return _latency; }
+	long Decodes() const { return _decodes; }
+	
+	WebM_Result LastResult() const { return _last_result; }
+	
+  private:
+	MockHost &_host;
+	const int _importerID;
+	
+	UTF16String _path;
+	MockFileRef _fileRef;
+	
+	WebM_Clip *_clip;
+	class MockFileReader *_reader; // (the clip owns it)
+	
+	WebM_Decode_Mode _decode_mode;
+	bool _keyframes_only;
+	
+	WebM_TestLatency _latency;
+	long _decodes;
+	
+	WebM_Result _last_result;
+};
+
+
+#endif // WEBM_TEST_MOCKHOST_H
@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#include "Stats.h"
+
+#include "Check.h"
+
+#include "WebM_Speed.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+
+
+double
+WebM_TestLatency::Total() const
+{
+	double total = 0.0;
+	
+	for(size_t i=0; i < _samples.size(); i++)
+		total += _samples[i];
+	
+	return total;
+}
+
+
+double
+WebM_TestLatency::Percentile(double p) const
+{
+	if(_samples.empty())
+		return 0.0;
+	
+	std::vector<double> sorted = _samples;
+	
+	std::sort(sorted.begin(), sorted.end());
+	
+	size_t i = (p * (sorted.size() - 1)) + 0.5;
+	
+	return sorted[i < sorted.size() ? i : sorted.size() - 1];
+}
+
+
+double
+WebM_TestLatency::Max() const
+{
+	return (_samples.empty() ? 0.0 : *std::max_element(_samples.begin(), _samples.end()));
+}
+
+
+WebM_TestReport::WebM_TestReport(const char *what) :
+	_what(what),
+	_start(0.0),
+	_seconds(0.0),
+	_frames(0),
+	_useful(0),
+	_wasted(-1)
+{
+
+}
+
+
+void
+WebM_TestReport::Start()
+{
+	_start = WebM_Seconds();
+}
+
+
+void
+WebM_TestReport::Stop(long frames)
+{
+	_seconds = WebM_Seconds() - _start;
+	_frames = frames;
+}
+
+
+void
+WebM_TestReport::Print() const
+{
+	printf("%s: %ld frames in %.2f s (%.1f fps)", _what, _frames, _seconds, FPS());
+	
+	if(_latency.Count() > 0)
+	{
+		printf(", latency p50 %.1f ms, p95 %.1f ms, max %.1f ms",
+				_latency.Percentile(0.5) * 1000.0,
+				_latency.Percentile(0.95) * 1000.0,
+				_latency.Max() * 1000.0);
+	}
+	
+	if(_wasted >= 0)
+		printf(", read ahead %ld useful, %ld wasted", _useful, _wasted);
+	
+	printf(", peak RSS %.1f MB\n", WebM_TestPeakRSS() / 1024.0);
+}
+
+
+long
+WebM_TestPeakRSS()
+{
+	struct rusage usage;
+	
+	if(getrusage(RUSAGE_SELF, &usage) == 0)
+		return usage.ru_maxrss; // already KB on Linux
+	
+	return 0;
+}
+
+
+static int g_failures = 0;
+
+
+void
+WebM_TestFailed(const char *file, int line, const char *what)
+{
+	fprintf(stderr, "%s:%d: failed: %s\n", file, line, what);
+	
+	g_failures++;
+}
+
+
+int
+WebM_TestResult(const char *test_name)
+{
+	if(g_failures > 0)
+		printf("%s: %d check%s failed\n", test_name, g_failures, (g_failures > 1 ? "s" : ""));
+	else
+		printf("%s: passed\n", test_name);
+	
+	return (g_failures > 0 ? 1 : 0);
+}
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+#ifndef WEBM_TEST_STATS_H
+#define WEBM_TEST_STATS_H
+
+// Numbers for the test log: how fast, how long each frame took, how much
+// memory.  Nothing fails on these, they're for watching over time.
+
+#include <stddef.h>
+
+#include <vector>
+
+
+// seconds between Add()s, or however you like
+class WebM_TestLatency
+{
+  public:
+	void Add(double seconds) { _samples.push_back(seconds); }
+	
+	size_t Count() const { return _samples.size(); }
+	double Total() const;
+	
+	// p from 0 to 1
+	double Percentile(double p) const;
+	double Max() const;
+	
+  private:
+	std::vector<double> _samples;
+};
+
+
+// A line or two about one part of a test
+class WebM_TestReport
+{
+  public:
+	WebM_TestReport(const char *what);
+	
+	void Start();
+	void Stop(long frames);
+	
+	long Frames() const { return _frames; }
+	double Seconds() const { return _seconds; }
+	double FPS() const { return (_seconds > 0.0 ? _frames / _seconds : 0.0); }
+	
+	WebM_TestLatency & Latency() { return _latency; }
+	
+	// how the importer's read-ahead did, from WebM_ReadAhead
+	void ReadAhead(long useful, long wasted) { _useful = useful; _wasted = wasted; }
+	
+	// fps, latency percentiles, read-ahead, peak RSS
+	void Print() const;
+	
+  private:
+	const char *_what;
+	
+	double _start;
+	double _seconds;
+	long _frames;
+	
+	WebM_TestLatency _latency;
+	
+	long _useful;
+	long _wasted;		// -1 if nobody told us
+};
+
+
+// high water mark for the whole process, in KB
+long WebM_TestPeakRSS();
+
+
+#endif // WEBM_TEST_STATS_H
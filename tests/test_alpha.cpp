@@ -0,0 +1,180 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// Alpha, out and back: the exporter gets BGRA with alpha from the host and
+// writes the second stream in BlockAdditional, the importer decodes both and
+// puts them back together.  Export time with and without alpha goes in the
+// log, since the point of the parallel encoders is that it costs little.
+
+#include "MockHost.h"
+#include "Check.h"
+
+
+static const int kWidth = 320;
+static const int kHeight = 240;
+static const int kFrames = 48;
+
+
+static WebM_Result
+Export(MockHost &host, const char *name, bool alpha, WebM_TestReport &report)
+{
+	host.params.SetInt("ADBEVideoAlpha", alpha);
+	host.params.SetInt("ADBEVideoWidth", kWidth);
+	host.params.SetInt("ADBEVideoHeight", kHeight);
+	
+	return MockExport(host, name, 0, kFrames * host.time.GetTicksPerFrame(24, 1), NULL, &report);
+}
+
+
+static void
+CheckAlpha(MockHost &host, MockImporter &importer, const FrameGenerator &pictures, long frame)
+{
+	MockPPixHand ppix = importer.GetSourceVideo(frame, MOCK_PIXEL_BGRA8);
+	
+	REQUIRE(ppix != NULL);
+	
+	const unsigned char *bgra = (const unsigned char *)host.ppix.GetPixels(ppix);
+	const long rowbytes = host.ppix.GetRowBytes(ppix);
+	
+	std::vector<unsigned char> alpha_in(kWidth * kHeight), alpha_out(kWidth * kHeight);
+	
+	for(int y=0; y < kHeight; y++)
+	{
+		// bottom row first
+		const unsigned char *row = bgra + ((kHeight - 1 - y) * rowbytes);
+		
+		for(int x=0; x < kWidth; x++)
+		{
+			alpha_in[(y * kWidth) + x] = pictures.Alpha(frame, x, y);
+			alpha_out[(y * kWidth) + x] = row[(x * 4) + 3];
+		}
+	}
+	
+	const double psnr = WebM_TestPSNR(&alpha_in[0], kWidth, &alpha_out[0], kWidth, kWidth, kHeight);
+	
+	if(psnr < 30.0)
+		printf("  frame %ld: alpha PSNR %.1f\n", frame, psnr);
+	
+	CHECK(psnr >= 30.0);
+	
+	// the clear corners stay clear enough to key on, the box solid
+	CHECK(alpha_out[0] < 16);
+	CHECK(alpha_out[(kHeight - 1) * kWidth + (kWidth - 1)] < 16);
+	
+	host.ppix.Dispose(ppix);
+}
+
+
+static void
+TestAlpha()
+{
+	printf("alpha\n");
+	
+	MockHost host("alpha");
+	
+	host.num_cpus = 4;
+	
+	const FrameGenerator pictures(kWidth, kHeight, true);
+	
+	host.render.SetSource(&pictures);
+	
+	WebM_TestReport without("  export without alpha");
+	WebM_TestReport with("  export with alpha");
+	
+	REQUIRE(Export(host, "opaque.webm", false, without) == WEBM_OK);
+	REQUIRE(Export(host, "alpha.webm", true, with) == WEBM_OK);
+	
+	without.Print();
+	with.Print();
+	
+	printf("  alpha costs %.0f%% more time\n",
+			(without.Seconds() > 0.0 ? 100.0 * (with.Seconds() - without.Seconds()) / without.Seconds() : 0.0));
+	
+	CHECK(!host.Leaked());
+	
+	{
+		MockImporter importer(host, 1);
+		
+		REQUIRE(importer.OpenFile("opaque.webm") == WEBM_OK);
+		
+		CHECK(!importer.Clip()->HasAlpha());
+	}
+	
+	MockImporter importer(host, 2);
+	
+	REQUIRE(importer.OpenFile("alpha.webm") == WEBM_OK);
+	
+	CHECK(importer.Clip()->HasAlpha());
+	
+	// playing...
+	WebM_TestReport report("  import with alpha");
+	
+	report.Start();
+	
+	for(long f=0; f < kFrames; f++)
+		CheckAlpha(host, importer, pictures, f);
+	
+	report.Stop(kFrames);
+	report.Latency() = importer.DecodeLatency();
+	report.ReadAhead(importer.Clip()->ReadAhead()->UsefulFrames(), importer.Clip()->ReadAhead()->WastedFrames());
+	report.Print();
+	
+	// ...and jumping around
+	host.cache.Purge();
+	
+	CheckAlpha(host, importer, pictures, 37);
+	CheckAlpha(host, importer, pictures, 5);
+	
+	// YUV has nowhere to put alpha, but the color is still there
+	MockPPixHand ppix = importer.GetSourceVideo(20, MOCK_PIXEL_YUV420);
+	
+	CHECK(ppix != NULL);
+	
+	if(ppix != NULL)
+		host.ppix.Dispose(ppix);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestAlpha();
+	
+	return WebM_TestResult("alpha");
+}
@@ -0,0 +1,271 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// Audio blocks get the time of their own first sample, not whatever video
+// frame was going by when they came out of the encoder.  Checked against the
+// granule arithmetic directly, then in exported files, where every block's
+// time has to follow from the samples before it.  File size and parse time
+// go in the log.
+
+#include "MockHost.h"
+#include "Check.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+
+static void
+TestTimeStamps()
+{
+	printf("timestamps\n");
+	
+	// 1 ms timecodes
+	CHECK_EQ(WebM_AudioTimeStamp(0, 48000, 1000000), 0);
+	CHECK_EQ(WebM_AudioTimeStamp(48000, 48000, 1000000), 1000000000ULL);
+	CHECK_EQ(WebM_AudioTimeStamp(44100, 44100, 1000000), 1000000000ULL);
+	
+	// rounded to the nearest timecode: 1001 samples is 20.85 ms
+	CHECK_EQ(WebM_AudioTimeStamp(1001, 48000, 1000000), 21000000ULL);
+	CHECK_EQ(WebM_AudioTimeStamp(1000, 48000, 1000000), 21000000ULL);
+	CHECK_EQ(WebM_AudioTimeStamp(960, 48000, 1000000), 20000000ULL);
+	
+	// an hour in, at 44.1k, nothing overflows or drifts
+	CHECK_EQ(WebM_AudioTimeStamp(3600LL * 44100, 44100, 1000000), 3600000000000ULL);
+	
+	// other timecode scales
+	CHECK_EQ(WebM_AudioTimeStamp(48000, 48000, 1000), 1000000000ULL);
+	CHECK_EQ(WebM_AudioTimeStamp(1, 48000, 1000), 21000ULL);
+	
+	// never goes backwards
+	unsigned long long last = 0;
+	
+	for(long long granule = 0; granule < 200000; granule += 37)
+	{
+		const unsigned long long tstamp = WebM_AudioTimeStamp(granule, 44100, 1000000);
+		
+		CHECK(tstamp >= last);
+		
+		if(tstamp < last)
+			break;
+		
+		last = tstamp;
+	}
+}
+
+
+static void
+CheckBlocks(MockHost &host, const char *name, int sample_rate)
+{
+	const UTF16String path = host.files.PlatformPath(name);
+	
+	// a parser of our own, so we see the blocks as they are in the file
+	WebM_FileReader *reader = new WebM_FileReader;
+	
+	REQUIRE(reader->Open(path.c_str()));
+	
+	long long file_size = 0, available = 0;
+	
+	reader->Length(&file_size, &available);
+	
+	WebM_TestReport report("  parse");
+	
+	report.Start();
+	
+	long long pos = 0;
+	
+	mkvparser::EBMLHeader ebmlHeader;
+	
+	ebmlHeader.Parse(reader, pos);
+	
+	mkvparser::Segment *segment = NULL;
+	
+	long long ret = mkvparser::Segment::CreateInstance(reader, pos, segment);
+	
+	if(ret >= 0 && segment != NULL)
+		ret = segment->Load();
+	
+	long video_track = -1, audio_track = -1;
+	
+	if(ret >= 0 && segment != NULL)
+	{
+		const mkvparser::Tracks *tracks = segment->GetTracks();
+		
+		for(unsigned long t=0; t < tracks->GetTracksCount(); t++)
+		{
+			const mkvparser::Track *track = tracks->GetTrackByIndex(t);
+			
+			if(track != NULL && track->GetType() == mkvparser::Track::kVideo)
+				video_track = track->GetNumber();
+			else if(track != NULL && track->GetType() == mkvparser::Track::kAudio)
+				audio_track = track->GetNumber();
+		}
+	}
+	
+	WebM_Index index;
+	
+	if(ret >= 0 && segment != NULL)
+		WebM_BuildIndex(segment, reader, video_track, audio_track, index);
+	
+	report.Stop(index.video.size() + index.audio.size());
+	
+	printf("  %s: %lld bytes, %ld audio packets\n", name, file_size, (long)index.audio.size());
+	report.Print();
+	
+	CHECK(ret >= 0);
+	CHECK(audio_track > 0);
+	
+	if(ret >= 0 && segment != NULL && audio_track > 0)
+	{
+		const long long timeCodeScale = segment->GetInfo()->GetTimeCodeScale();
+		
+		// the time of each block, less the time of the samples before it,
+		// is the same for all of them (give or take a timecode of rounding)
+		long long offset = 0;
+		bool have_offset = false;
+		bool ok = true;
+		
+		size_t packet = 0;
+		long blocks = 0;
+		
+		for(const mkvparser::Cluster *cluster = segment->GetFirst();
+				cluster != NULL && !cluster->EOS() && ok;
+				cluster = segment->GetNext(cluster))
+		{
+			const mkvparser::BlockEntry *entry = NULL;
+			
+			cluster->GetFirst(entry);
+			
+			while(entry != NULL && !entry->EOS() && ok)
+			{
+				const mkvparser::Block *block = entry->GetBlock();
+				
+				if(block->GetTrackNumber() == audio_track)
+				{
+					if(packet >= index.audio.size())
+					{
+						ok = false;
+						break;
+					}
+					
+					const long long block_time = block->GetTime(cluster);
+					const long long sample_time = index.audio[packet].sample * 1000000000LL / sample_rate;
+					
+					if(!have_offset)
+					{
+						offset = block_time - sample_time;
+						have_offset = true;
+					}
+					else if(llabs((block_time - sample_time) - offset) > timeCodeScale)
+					{
+						printf("  block %ld is at %lld, should be %lld\n", blocks, block_time, sample_time + offset);
+						
+						ok = false;
+					}
+					
+					packet += block->GetFrameCount();
+					blocks++;
+				}
+				
+				cluster->GetNext(entry, entry);
+			}
+		}
+		
+		CHECK(ok);
+		CHECK(blocks > 0);
+		CHECK_EQ(packet, index.audio.size());
+		
+		// and they start at the start, not some video frame later
+		CHECK(have_offset && llabs(offset) <= 2 * timeCodeScale + (WEBM_OPUS_PREROLL * 1000000000LL / 48000));
+	}
+	
+	delete segment;
+	delete reader;
+}
+
+
+static void
+TestExport(WebM_Audio_Codec codec, int sample_rate, const char *name)
+{
+	printf("%s\n", name);
+	
+	MockHost host("audio_mux");
+	
+	host.params.SetInt("WebMAudioCodec", codec);
+	host.params.SetFloat("ADBEAudioRatePerSecond", sample_rate);
+	
+	// a frame rate that has nothing to do with the audio packets
+	host.params.SetInt("ADBEVideoFPS", host.time.GetTicksPerFrame(30000, 1001));
+	host.params.SetInt("ADBEVideoWidth", 64);
+	host.params.SetInt("ADBEVideoHeight", 48);
+	
+	const int rate = (codec == WEBM_CODEC_OPUS ? 48000 : sample_rate);
+	
+	const FrameGenerator pictures(64, 48);
+	const ToneGenerator tone(2, rate);
+	
+	host.render.SetSource(&pictures);
+	host.audio.SetSource(&tone);
+	
+	REQUIRE(MockExport(host, name, 0, 10 * host.time.GetTicksPerSecond()) == WEBM_OK);
+	
+	CheckBlocks(host, name, rate);
+	
+	// audio only, where there's no video to go by at all
+	const std::string audio_name = std::string("audio_") + name;
+	
+	host.render.SetSource(NULL);
+	
+	REQUIRE(MockExport(host, audio_name.c_str(), 0, 10 * host.time.GetTicksPerSecond()) == WEBM_OK);
+	
+	CheckBlocks(host, audio_name.c_str(), rate);
+	
+	CHECK(!host.Leaked());
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestTimeStamps();
+	TestExport(WEBM_CODEC_VORBIS, 48000, "vorbis48.webm");
+	TestExport(WEBM_CODEC_VORBIS, 44100, "vorbis44.webm");
+	TestExport(WEBM_CODEC_OPUS, 48000, "opus.webm");
+	
+	return WebM_TestResult("audio_mux");
+}
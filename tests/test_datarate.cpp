@@ -0,0 +1,292 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// The data rate graph: one sample per frame on the timeline, invisible frames
+// folded into the one that shows them, durations from the gaps, and fast
+// enough for a two hour file.  Then the same from a real file through the
+// mock host, which has to add up to what's in the file.
+
+#include "MockHost.h"
+#include "Check.h"
+
+
+static WebM_IndexVideoFrame
+Frame(long long tstamp, unsigned int size, unsigned int flags)
+{
+	WebM_IndexVideoFrame frame;
+	
+	frame.pos = 0;
+	frame.tstamp = tstamp;
+	frame.size = size;
+	frame.flags = flags;
+	frame.alpha_offset = 0;
+	frame.alpha_size = 0;
+	
+	return frame;
+}
+
+
+static void
+TestFolding()
+{
+	printf("folding\n");
+	
+	// 25 fps, with an alt-ref before the third frame and two before the sixth,
+	// and the fifth frame dropped
+	WebM_Index index;
+	
+	index.fps_num = 25;
+	index.fps_den = 1;
+	
+	index.video.push_back(Frame(0, 1000, WEBM_INDEX_KEYFRAME | WEBM_INDEX_CLUSTER_START));
+	index.video.push_back(Frame(40000000, 100, 0));
+	index.video.push_back(Frame(80000000, 300, WEBM_INDEX_INVISIBLE));
+	index.video.push_back(Frame(80000000, 50, 0));
+	index.video.push_back(Frame(120000000, 100, 0));
+	index.video.push_back(Frame(200000000, 200, WEBM_INDEX_INVISIBLE));
+	index.video.push_back(Frame(200000000, 10, WEBM_INDEX_INVISIBLE | WEBM_INDEX_KEYFRAME));
+	index.video.push_back(Frame(200000000, 60, 0));
+	
+	std::vector<WebM_DataSample> samples;
+	
+	REQUIRE(WebM_DataRate(index, 25, 1, samples));
+	REQUIRE(samples.size() == 5);
+	
+	CHECK_EQ(samples[0].size, 1000);
+	CHECK(samples[0].keyframe);
+	CHECK_EQ(samples[0].duration, 1);
+	
+	CHECK_EQ(samples[1].size, 100);
+	CHECK(!samples[1].keyframe);
+	
+	// the alt-ref goes with the frame it's shown in
+	CHECK_EQ(samples[2].size, 350);
+	
+	// two frames long, because the next one was dropped
+	CHECK_EQ(samples[3].size, 100);
+	CHECK_EQ(samples[3].duration, 2);
+	
+	// both invisibles, and the keyframe flag from one of them
+	CHECK_EQ(samples[4].size, 270);
+	CHECK(samples[4].keyframe);
+	
+	// the last one gets a frame's worth
+	CHECK_EQ(samples[4].duration, 1);
+	
+	// everything's accounted for
+	unsigned long long in = 0, out = 0;
+	
+	for(size_t i=0; i < index.video.size(); i++)
+		in += index.video[i].size;
+	
+	for(size_t i=0; i < samples.size(); i++)
+		out += samples[i].size;
+	
+	CHECK_EQ(in, out);
+	
+	// an alt-ref at the very end is never shown, so it's in no sample
+	index.video.push_back(Frame(240000000, 500, WEBM_INDEX_INVISIBLE));
+	
+	REQUIRE(WebM_DataRate(index, 25, 1, samples));
+	REQUIRE(samples.size() == 5);
+	
+	CHECK_EQ(samples[4].size, 270);
+	CHECK_EQ(samples[4].duration, 1);
+	
+	// in 1/30000 second units for NTSC
+	index.fps_num = 30000;
+	index.fps_den = 1001;
+	
+	index.video.clear();
+	
+	for(long f=0; f < 10; f++)
+		index.video.push_back(Frame((long long)f * 1001000000LL / 30000, 100, (f == 0 ? WEBM_INDEX_KEYFRAME : 0)));
+	
+	REQUIRE(WebM_DataRate(index, 30000, 1001, samples));
+	REQUIRE(samples.size() == 10);
+	
+	for(size_t i=0; i < samples.size(); i++)
+		CHECK_EQ(samples[i].duration, 1001);
+}
+
+
+static void
+TestNothing()
+{
+	printf("nothing\n");
+	
+	WebM_Index index;
+	
+	std::vector<WebM_DataSample> samples;
+	
+	CHECK(!WebM_DataRate(index, 24, 1, samples));
+	CHECK(!WebM_DataRate(index, 24, 0, samples));
+	
+	// only invisible frames, so nothing on the timeline
+	index.video.push_back(Frame(0, 100, WEBM_INDEX_INVISIBLE));
+	
+	CHECK(!WebM_DataRate(index, 24, 1, samples));
+	CHECK(samples.empty());
+}
+
+
+static void
+TestLong()
+{
+	printf("two hours\n");
+	
+	// 2 hours at 60 fps, an alt-ref every 8 frames, and a long run of
+	// invisible frames at the end for good measure
+	const long frames = 2 * 60 * 60 * 60;
+	
+	WebM_Index index;
+	
+	index.fps_num = 60;
+	index.fps_den = 1;
+	
+	for(long f=0; f < frames; f++)
+	{
+		const long long tstamp = (long long)f * 1000000000LL / 60;
+		
+		if(f % 8 == 7)
+			index.video.push_back(Frame(tstamp, 3000, WEBM_INDEX_INVISIBLE));
+		
+		index.video.push_back(Frame(tstamp, 1000, (f % 120 == 0 ? WEBM_INDEX_KEYFRAME : 0)));
+	}
+	
+	for(long f=0; f < 50000; f++)
+		index.video.push_back(Frame((long long)frames * 1000000000LL / 60, 10, WEBM_INDEX_INVISIBLE));
+	
+	std::vector<WebM_DataSample> samples;
+	
+	WebM_TestReport report("  data rate");
+	
+	report.Start();
+	
+	CHECK(WebM_DataRate(index, 60, 1, samples));
+	
+	report.Stop(index.video.size());
+	report.Print();
+	
+	CHECK_EQ(samples.size(), frames);
+	
+	// "well under a second", with plenty of room for a slow test machine
+	CHECK(report.Seconds() < 0.5);
+}
+
+
+static void
+TestHost()
+{
+	printf("host\n");
+	
+	MockHost host("datarate");
+	
+	const int width = 160, height = 120;
+	
+	const FrameGenerator pictures(width, height);
+	
+	{
+		TestMovieWriter writer;
+		
+		REQUIRE(writer.Open(host.files.PlatformPath("datarate.webm"), width, height, true, false, 24.0, 12));
+		
+		for(long f=0; f < 72; f++)
+			REQUIRE(writer.AddFrame(pictures, f, (long long)f * 1000000000LL / 24));
+		
+		REQUIRE(writer.Close());
+	}
+	
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile("datarate.webm") == WEBM_OK);
+	
+	const WebM_Clip *clip = importer.Clip();
+	
+	// what SDKAnalysis hands Premiere for imDataRateAnalysis
+	std::vector<WebM_DataSample> samples;
+	
+	REQUIRE(WebM_DataRate(clip->Index(), clip->FpsNum(), clip->FpsDen(), samples));
+	
+	CHECK_EQ(samples.size(), 72);
+	
+	unsigned long long total = 0;
+	int keyframes = 0;
+	
+	for(size_t i=0; i < samples.size(); i++)
+	{
+		total += samples[i].size;
+		
+		if(samples[i].keyframe)
+			keyframes++;
+		
+		CHECK_EQ(samples[i].duration, clip->FpsDen());
+	}
+	
+	CHECK(samples[0].keyframe);
+	
+	// every 12 frames, at least
+	CHECK(keyframes >= 6);
+	
+	// the frames are most of the file
+	long long file_size = 0;
+	
+	FILE *f = WebM_OpenFile(host.files.PlatformPath("datarate.webm").c_str(), "rb");
+	
+	REQUIRE(f != NULL);
+	
+	fseek(f, 0, SEEK_END);
+	file_size = ftell(f);
+	fclose(f);
+	
+	CHECK(total > 0 && (long long)total < file_size);
+	CHECK((long long)total > file_size / 2);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestFolding();
+	TestNothing();
+	TestLong();
+	TestHost();
+	
+	return WebM_TestResult("datarate");
+}
@@ -0,0 +1,214 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// The decoder speed/quality switch.  Every mode plays the same clip; frames
+// per second and PSNR for each go in the log.  Whatever the mode, a high
+// quality request (a paused frame or a render) has to get exactly what the
+// normal decoder makes, not a fast frame out of the cache.  A low quality
+// request still gets the exact frame, not a keyframe near it.
+
+#include "MockHost.h"
+#include "Check.h"
+
+#include <string.h>
+
+
+static const int kWidth = 640;
+static const int kHeight = 360;
+static const int kFrames = 72;
+
+
+static double
+FramePSNR(MockHost &host, MockPPixHand ppix, const FrameGenerator &pictures, long frame)
+{
+	char *Y, *U, *V;
+	long Y_rowbytes, U_rowbytes, V_rowbytes;
+	
+	host.ppix2.GetYUV420PlanarBuffers(ppix, &Y, &Y_rowbytes, &U, &U_rowbytes, &V, &V_rowbytes);
+	
+	std::vector<unsigned char> Y_in(kWidth * kHeight), U_in(kWidth * kHeight / 4), V_in(kWidth * kHeight / 4);
+	
+	pictures.YUV420(frame, &Y_in[0], kWidth, &U_in[0], kWidth / 2, &V_in[0], kWidth / 2);
+	
+	return WebM_TestPSNR(&Y_in[0], kWidth, (unsigned char *)Y, Y_rowbytes, kWidth, kHeight);
+}
+
+
+static std::vector<unsigned char>
+Pixels(MockHost &host, MockPPixHand ppix)
+{
+	char *Y, *U, *V;
+	long Y_rowbytes, U_rowbytes, V_rowbytes;
+	
+	host.ppix2.GetYUV420PlanarBuffers(ppix, &Y, &Y_rowbytes, &U, &U_rowbytes, &V, &V_rowbytes);
+	
+	std::vector<unsigned char> pixels(kWidth * kHeight);
+	
+	for(int y=0; y < kHeight; y++)
+		memcpy(&pixels[y * kWidth], Y + (y * Y_rowbytes), kWidth);
+	
+	return pixels;
+}
+
+
+static void
+TestModes(WebM_Video_Codec codec, const char *name)
+{
+	printf("%s\n", name);
+	
+	MockHost host("decode_modes");
+	
+	host.num_cpus = 4;
+	
+	// low enough quality that there's something for postprocessing to do
+	host.params.SetInt("WebMVideoCodec", codec);
+	host.params.SetInt("WebMVideoQuality", 15);
+	host.params.SetInt("ADBEVideoWidth", kWidth);
+	host.params.SetInt("ADBEVideoHeight", kHeight);
+	
+	const FrameGenerator pictures(kWidth, kHeight);
+	
+	host.render.SetSource(&pictures);
+	
+	REQUIRE(MockExport(host, name, 0, kFrames * host.time.GetTicksPerFrame(24, 1)) == WEBM_OK);
+	
+	static const WebM_Decode_Mode modes[] = { WEBM_DECODE_NORMAL, WEBM_DECODE_FAST,
+												WEBM_DECODE_POSTPROC, WEBM_DECODE_MFQE };
+	static const char * const mode_names[] = { "normal", "fast", "postproc", "mfqe" };
+	
+	std::vector<unsigned char> reference;
+	
+	const long still = 50;
+	
+	for(int m=0; m < 4; m++)
+	{
+		// a new importer each time, so nothing's in the cache
+		MockImporter importer(host, 10 + m);
+		
+		importer.SetDecodeMode(modes[m]);
+		
+		REQUIRE(importer.OpenFile(name) == WEBM_OK);
+		
+		char what[64];
+		snprintf(what, 64, "  %s", mode_names[m]);
+		
+		WebM_TestReport report(what);
+		
+		double psnr_total = 0.0, psnr_min = 99.0;
+		
+		report.Start();
+		
+		// playback
+		for(long f=0; f < kFrames; f++)
+		{
+			MockPPixHand ppix = importer.GetSourceVideo(f, MOCK_PIXEL_YUV420, MOCK_QUALITY_MEDIUM);
+			
+			CHECK(ppix != NULL);
+			
+			if(ppix != NULL)
+			{
+				const double psnr = FramePSNR(host, ppix, pictures, f);
+				
+				psnr_total += psnr;
+				
+				if(psnr < psnr_min)
+					psnr_min = psnr;
+				
+				host.ppix.Dispose(ppix);
+			}
+		}
+		
+		report.Stop(kFrames);
+		report.Latency() = importer.DecodeLatency();
+		report.ReadAhead(importer.Clip()->ReadAhead()->UsefulFrames(), importer.Clip()->ReadAhead()->WastedFrames());
+		report.Print();
+		
+		printf("  %s: PSNR average %.2f dB, worst %.2f dB\n", mode_names[m], psnr_total / kFrames, psnr_min);
+		
+		CHECK(psnr_min > 20.0);
+		
+		// stop on a frame, which Premiere asks for at high quality
+		if(modes[m] == WEBM_DECODE_NORMAL || modes[m] == WEBM_DECODE_FAST)
+		{
+			MockPPixHand ppix = importer.GetSourceVideo(still, MOCK_PIXEL_YUV420, MOCK_QUALITY_HIGH);
+			
+			CHECK(ppix != NULL);
+			
+			if(ppix != NULL)
+			{
+				if(modes[m] == WEBM_DECODE_NORMAL)
+					reference = Pixels(host, ppix);
+				else
+					CHECK(Pixels(host, ppix) == reference);
+				
+				host.ppix.Dispose(ppix);
+			}
+		}
+		
+		// Low quality is playback at a lower resolution, not a thumbnail,
+		// so it gets the real frame and not the keyframe near it
+		if(modes[m] == WEBM_DECODE_NORMAL)
+		{
+			host.cache.Purge();
+			
+			MockPPixHand ppix = importer.GetSourceVideo(still, MOCK_PIXEL_YUV420, MOCK_QUALITY_LOW);
+			
+			CHECK(ppix != NULL);
+			
+			if(ppix != NULL)
+			{
+				CHECK(Pixels(host, ppix) == reference);
+				
+				host.ppix.Dispose(ppix);
+			}
+		}
+	}
+	
+	CHECK(!host.Leaked());
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestModes(WEBM_CODEC_VP8, "vp8.webm");
+	TestModes(WEBM_CODEC_VP9, "vp9.webm");
+	
+	return WebM_TestResult("decode_modes");
+}
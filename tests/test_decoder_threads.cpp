@@ -0,0 +1,249 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// The decoder thread budget: one clip gets all the cores, clips playing
+// together split them by frame size, and a clip that stopped playing a while
+// ago doesn't count.  Then multicam through the mock host, with frames per
+// second and latency in the log.
+
+#include "MockHost.h"
+#include "Check.h"
+
+#include "WebM_DecoderThreads.h"
+#include "WebM_Speed.h"
+
+#include <unistd.h>
+
+
+static void
+TestAlone()
+{
+	printf("alone\n");
+	
+	WebM_DecoderThreads threads(100, 1920, 1080, 8);
+	
+	CHECK_EQ(threads.Threads(), 8);
+	
+	// one core, one thread, no matter what
+	WebM_DecoderThreads single(101, 1920, 1080, 1);
+	
+	CHECK_EQ(single.Threads(), 1);
+}
+
+
+static void
+TestMulticam()
+{
+	printf("multicam\n");
+	
+	// let the clips from before age out
+	usleep(1100000);
+	
+	const int angles = 9;
+	const int num_cpus = 8;
+	
+	// The first request of a round doesn't know about the others yet,
+	// so go around twice, like Premiere asking for each angle every frame.
+	int total = 0;
+	
+	for(int round=0; round < 2; round++)
+	{
+		total = 0;
+		
+		for(int a=0; a < angles; a++)
+		{
+			WebM_DecoderThreads threads(200 + a, 1920, 1080, num_cpus);
+			
+			CHECK(threads.Threads() >= 1);
+			
+			total += threads.Threads();
+		}
+	}
+	
+	printf("  %d angles on %d cores: %d threads\n", angles, num_cpus, total);
+	
+	// used to be angles * num_cpus
+	CHECK(total <= angles);
+	
+	// and the decoders all running at once
+	std::vector<WebM_DecoderThreads *> running;
+	
+	total = 0;
+	
+	for(int a=0; a < angles; a++)
+	{
+		running.push_back(new WebM_DecoderThreads(200 + a, 1920, 1080, num_cpus));
+		
+		total += running.back()->Threads();
+	}
+	
+	CHECK(total <= angles);
+	
+	for(int a=0; a < angles; a++)
+		delete running[a];
+}
+
+
+static void
+TestSizes()
+{
+	printf("sizes\n");
+	
+	usleep(1100000);
+	
+	// a 4K clip with an SD one over it
+	int big = 0, small = 0;
+	
+	for(int round=0; round < 2; round++)
+	{
+		WebM_DecoderThreads big_threads(300, 3840, 2160, 16);
+		WebM_DecoderThreads small_threads(301, 720, 480, 16);
+		
+		big = big_threads.Threads();
+		small = small_threads.Threads();
+	}
+	
+	printf("  4K gets %d, SD gets %d\n", big, small);
+	
+	CHECK(big > small);
+	CHECK(small >= 1);
+	CHECK(big + small <= 17);
+	
+	// after a second with nothing from them, they're forgotten
+	usleep(1100000);
+	
+	WebM_DecoderThreads alone(302, 720, 480, 16);
+	
+	CHECK_EQ(alone.Threads(), 16);
+}
+
+
+static void
+TestPlayback()
+{
+	printf("multicam playback\n");
+	
+	usleep(1100000);
+	
+	MockHost host("decoder_threads");
+	
+	host.num_cpus = 8;
+	
+	const int angles = 4;
+	const int frames = 48;
+	
+	const FrameGenerator pictures(640, 360);
+	
+	host.params.SetInt("ADBEVideoWidth", 640);
+	host.params.SetInt("ADBEVideoHeight", 360);
+	
+	host.render.SetSource(&pictures);
+	
+	char name[32];
+	
+	for(int a=0; a < angles; a++)
+	{
+		snprintf(name, 32, "angle%d.webm", a);
+		
+		REQUIRE(MockExport(host, name, 0, frames * host.time.GetTicksPerFrame(24, 1)) == WEBM_OK);
+	}
+	
+	std::vector<MockImporter *> importers;
+	
+	for(int a=0; a < angles; a++)
+	{
+		snprintf(name, 32, "angle%d.webm", a);
+		
+		importers.push_back(new MockImporter(host, 400 + a));
+		
+		CHECK_EQ(importers.back()->OpenFile(name), WEBM_OK);
+	}
+	
+	WebM_TestReport report("  4 angles");
+	
+	report.Start();
+	
+	// every angle, every frame, like the multicam monitor
+	for(long f=0; f < frames; f++)
+	{
+		for(int a=0; a < angles; a++)
+		{
+			const double start = WebM_Seconds();
+			
+			MockPPixHand ppix = importers[a]->GetSourceVideo(f, MOCK_PIXEL_YUV420, MOCK_QUALITY_MEDIUM);
+			
+			report.Latency().Add(WebM_Seconds() - start);
+			
+			CHECK(ppix != NULL);
+			
+			if(ppix != NULL)
+				host.ppix.Dispose(ppix);
+		}
+	}
+	
+	report.Stop(frames);
+	
+	long useful = 0, wasted = 0;
+	
+	for(int a=0; a < angles; a++)
+	{
+		useful += importers[a]->Clip()->ReadAhead()->UsefulFrames();
+		wasted += importers[a]->Clip()->ReadAhead()->WastedFrames();
+	}
+	
+	report.ReadAhead(useful, wasted);
+	report.Print();
+	
+	for(int a=0; a < angles; a++)
+		delete importers[a];
+	
+	CHECK(!host.Leaked());
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestAlone();
+	TestMulticam();
+	TestSizes();
+	TestPlayback();
+	
+	return WebM_TestResult("decoder_threads");
+}
@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// Encoder threads and tiles from the frame size and the core count, and what
+// that does for encode speed.  The fps at each core count go in the log, so
+// scaling can be compared across machines; only the configuration is checked.
+
+#include "MockHost.h"
+#include "Check.h"
+
+extern "C" {
+#include "vpx/vp8cx.h"
+}
+
+
+static int
+ThreadsFor(bool vp9, unsigned int width, unsigned int height, int num_cpus)
+{
+	vpx_codec_enc_cfg_t config;
+	
+	vpx_codec_enc_config_default((vp9 ? vpx_codec_vp9_cx() : vpx_codec_vp8_cx()), &config, 0);
+	
+	config.g_w = width;
+	config.g_h = height;
+	
+	ConfigureEncoderThreadsPre(config, vp9, num_cpus);
+	
+	return config.g_threads;
+}
+
+
+static void
+TestThreads()
+{
+	printf("threads\n");
+	
+	// VP8 goes by macroblock rows
+	CHECK_EQ(ThreadsFor(false, 1920, 1080, 8), 8);
+	CHECK_EQ(ThreadsFor(false, 1920, 1080, 32), 32);
+	CHECK_EQ(ThreadsFor(false, 64, 48, 32), 3);
+	CHECK_EQ(ThreadsFor(false, 1920, 1080, 1), 1);
+	
+	// somebody's 128 core machine
+	CHECK_EQ(ThreadsFor(false, 7680, 4320, 128), 64);
+	
+	// and somebody's broken one
+	CHECK_EQ(ThreadsFor(false, 1920, 1080, 0), 1);
+	
+	// VP9 goes by tile columns, at least 256 pixels each
+#ifdef VPX_CTRL_VP9E_SET_ROW_MT
+	// unless it can do rows too
+	CHECK_EQ(ThreadsFor(true, 1920, 1080, 8), 8);
+	CHECK_EQ(ThreadsFor(true, 320, 240, 8), 8);
+#else
+	CHECK_EQ(ThreadsFor(true, 1920, 1080, 8), 4);
+	CHECK_EQ(ThreadsFor(true, 3840, 2160, 8), 8);
+	CHECK_EQ(ThreadsFor(true, 3840, 2160, 32), 8);
+	CHECK_EQ(ThreadsFor(true, 320, 240, 8), 1);
+	CHECK_EQ(ThreadsFor(true, 1280, 720, 3), 3);
+#endif
+
+	CHECK_EQ(ThreadsFor(true, 1920, 1080, 1), 1);
+	
+	// the custom args still get the last word
+	vpx_codec_enc_cfg_t config;
+	
+	vpx_codec_enc_config_default(vpx_codec_vp8_cx(), &config, 0);
+	
+	config.g_w = 1920;
+	config.g_h = 1080;
+	
+	ConfigureEncoderThreadsPre(config, false, 16);
+	
+	CHECK(ConfigureEncoderPre(config, "--threads 3"));
+	CHECK_EQ(config.g_threads, 3);
+}
+
+
+// The encoder takes the controls we set after it's made
+static void
+TestControls(bool vp9)
+{
+	printf(vp9 ? "vp9 controls\n" : "vp8 controls\n");
+	
+	vpx_codec_iface_t *iface = (vp9 ? vpx_codec_vp9_cx() : vpx_codec_vp8_cx());
+	
+	vpx_codec_enc_cfg_t config;
+	
+	REQUIRE(vpx_codec_enc_config_default(iface, &config, 0) == VPX_CODEC_OK);
+	
+	config.g_w = 1280;
+	config.g_h = 720;
+	
+	ConfigureEncoderThreadsPre(config, vp9, 8);
+	
+	vpx_codec_ctx_t encoder;
+	
+	REQUIRE(vpx_codec_enc_init(&encoder, iface, &config, 0) == VPX_CODEC_OK);
+	
+	ConfigureEncoderThreadsPost(&encoder, config, vp9);
+	
+	CHECK(encoder.err == VPX_CODEC_OK);
+	
+	vpx_codec_destroy(&encoder);
+}
+
+
+static void
+Benchmark(WebM_Video_Codec codec, const char *name)
+{
+	printf("%s encode speed\n", name);
+	
+	const int cores[] = { 1, 2, 4, 8, 16, 32 };
+	
+	for(int i=0; i < 6; i++)
+	{
+		MockHost host("encoder_config");
+		
+		host.num_cpus = cores[i];
+		
+		host.params.SetInt("WebMVideoCodec", codec);
+		host.params.SetInt("WebMVideoEncoding", WEBM_ENCODING_REALTIME);
+		host.params.SetInt("ADBEVideoWidth", 1280);
+		host.params.SetInt("ADBEVideoHeight", 720);
+		
+		const FrameGenerator pictures(1280, 720);
+		
+		host.render.SetSource(&pictures);
+		
+		char what[64];
+		snprintf(what, 64, "  %2d cores", cores[i]);
+		
+		WebM_TestReport report(what);
+		
+		const WebM_Result result = MockExport(host, "speed.webm", 0, 24 * host.time.GetTicksPerFrame(24, 1),
+												NULL, &report);
+		
+		CHECK_EQ(result, WEBM_OK);
+		
+		report.Print();
+	}
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestThreads();
+	TestControls(false);
+	TestControls(true);
+	Benchmark(WEBM_CODEC_VP8, "VP8");
+	Benchmark(WEBM_CODEC_VP9, "VP9");
+	
+	return WebM_TestResult("encoder_config");
+}
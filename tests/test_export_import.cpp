@@ -0,0 +1,380 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// The whole round trip through the mock host: export a movie with picture and
+// sound from the generators, import it again and see that we got back what
+// went in.  Also the things Premiere would notice if we got them wrong, like
+// leaked frames, files left open, canceling and the proxy.
+
+#include "MockHost.h"
+#include "Check.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const int kWidth = 320;
+static const int kHeight = 240;
+static const int kFrames = 48;	// two seconds at 24
+
+
+static long long
+FrameTicks(MockHost &host)
+{
+	return host.time.GetTicksPerFrame(24, 1);
+}
+
+
+static void
+CheckPicture(MockHost &host, MockImporter &importer, const FrameGenerator &source, long frame)
+{
+	MockPPixHand ppix = importer.GetSourceVideo(frame, MOCK_PIXEL_YUV420);
+	
+	REQUIRE(ppix != NULL);
+	
+	char *Y, *U, *V;
+	long Y_rowbytes, U_rowbytes, V_rowbytes;
+	
+	host.ppix2.GetYUV420PlanarBuffers(ppix, &Y, &Y_rowbytes, &U, &U_rowbytes, &V, &V_rowbytes);
+	
+	// what went in
+	const int chroma_width = (kWidth + 1) / 2;
+	const int chroma_height = (kHeight + 1) / 2;
+	
+	std::vector<unsigned char> Y_in(kWidth * kHeight);
+	std::vector<unsigned char> U_in(chroma_width * chroma_height);
+	std::vector<unsigned char> V_in(chroma_width * chroma_height);
+	
+	source.YUV420(frame, &Y_in[0], kWidth, &U_in[0], chroma_width, &V_in[0], chroma_width);
+	
+	const double psnr = WebM_TestPSNR(&Y_in[0], kWidth, (unsigned char *)Y, Y_rowbytes, kWidth, kHeight);
+	
+	// quality 50 on a smooth gradient does a lot better than this
+	if(psnr < 30.0)
+		printf("  frame %ld: Y PSNR %.1f\n", frame, psnr);
+	
+	CHECK(psnr >= 30.0);
+	CHECK(WebM_TestPSNR(&U_in[0], chroma_width, (unsigned char *)U, U_rowbytes, chroma_width, chroma_height) >= 30.0);
+	CHECK(WebM_TestPSNR(&V_in[0], chroma_width, (unsigned char *)V, V_rowbytes, chroma_width, chroma_height) >= 30.0);
+	
+	host.ppix.Dispose(ppix);
+}
+
+
+static void
+TestRoundTrip(WebM_Video_Codec codec, WebM_Audio_Codec audio_codec, const char *name)
+{
+	printf("%s\n", name);
+	
+	MockHost host("export_import");
+	
+	host.num_cpus = 4;
+	
+	host.params.SetInt("WebMVideoCodec", codec);
+	host.params.SetInt("WebMAudioCodec", audio_codec);
+	
+	const FrameGenerator pictures(kWidth, kHeight);
+	const ToneGenerator tone(2, 48000);
+	
+	host.render.SetSource(&pictures);
+	host.audio.SetSource(&tone);
+	
+	WebM_ExportStats stats;
+	WebM_TestReport export_report("  export");
+	
+	const WebM_Result export_result = MockExport(host, name, 0, kFrames * FrameTicks(host), &stats, &export_report);
+	
+	CHECK_EQ(export_result, WEBM_OK);
+	CHECK_EQ(stats.encoded, kFrames);
+	CHECK_EQ(host.render.FramesRendered(), kFrames);
+	CHECK(host.audio.SamplesRendered() >= 2 * 48000);
+	
+	export_report.Print();
+	
+	// everything the exporter rendered went back, and the file got closed
+	CHECK(!host.Leaked());
+	
+	REQUIRE(export_result == WEBM_OK);
+	
+	{
+		MockImporter importer(host, 1);
+		
+		REQUIRE(importer.OpenFile(name) == WEBM_OK);
+		
+		WebM_Clip *clip = importer.Clip();
+		
+		CHECK(clip->HasVideo());
+		CHECK(clip->HasAudio());
+		CHECK_EQ(clip->Codec(), (codec == WEBM_CODEC_VP9 ? WEBM_CLIP_VP9 : WEBM_CLIP_VP8));
+		CHECK_EQ(clip->Width(), kWidth);
+		CHECK_EQ(clip->Height(), kHeight);
+		CHECK_EQ(clip->FpsNum(), 24);
+		CHECK_EQ(clip->FpsDen(), 1);
+		CHECK_EQ(clip->AudioChannels(), 2);
+		CHECK_EQ(clip->AudioSampleRate(), 48000);
+		
+		// in order, like playback...
+		WebM_TestReport play_report("  import, playing");
+		
+		play_report.Start();
+		
+		for(long f=0; f < kFrames; f++)
+			CheckPicture(host, importer, pictures, f);
+		
+		play_report.Stop(kFrames);
+		play_report.Latency() = importer.DecodeLatency();
+		play_report.Print();
+		
+		// ...then jumping around, with the cache out of the way
+		host.cache.Purge();
+		
+		const long jumps[] = { 40, 3, 25, 47, 0, 31 };
+		
+		for(int i=0; i < 6; i++)
+			CheckPicture(host, importer, pictures, jumps[i]);
+		
+		// the frame after the last one is the last one
+		MockPPixHand past_end = importer.GetSourceVideo(kFrames + 10, MOCK_PIXEL_YUV420);
+		
+		CHECK(past_end != NULL);
+		
+		if(past_end != NULL)
+			host.ppix.Dispose(past_end);
+		
+		// the sound, from the middle, where we'd be past any encoder delay
+		const int samples = 4800;
+		
+		std::vector<float> left(samples), right(samples);
+		float *buffers[2] = { &left[0], &right[0] };
+		
+		CHECK_EQ(importer.ImportAudio(48000, samples, buffers), WEBM_OK);
+		
+		CHECK(WebM_TestToneLevel(&left[0], samples, tone.Frequency(0), 48000) > 0.9);
+		CHECK(WebM_TestToneLevel(&right[0], samples, tone.Frequency(1), 48000) > 0.9);
+		
+		// and not the other channel's
+		CHECK(WebM_TestToneLevel(&left[0], samples, tone.Frequency(1), 48000) < 0.05);
+		
+		// the samples are where they should be, not just the right pitch
+		double error = 0.0, power = 0.0;
+		
+		for(int i=0; i < samples; i++)
+		{
+			const double expected = tone.Sample(0, 48000 + i);
+			
+			error += (left[i] - expected) * (left[i] - expected);
+			power += expected * expected;
+		}
+		
+		CHECK(error < power * 0.1);
+		
+		// Premiere closes the file when the project isn't looking at it
+		importer.QuietFile();
+		
+		CHECK_EQ(host.files.OpenFiles(), 0);
+		
+		REQUIRE(importer.OpenFile(name) == WEBM_OK);
+		
+		CheckPicture(host, importer, pictures, 12);
+	}
+	
+	CHECK(!host.Leaked());
+}
+
+
+static void
+TestBGRA(const char *name)
+{
+	printf("%s\n", name);
+	
+	MockHost host("export_import");
+	
+	// a host that only renders BGRA, so the exporter has to convert
+	host.render.SetSupported(MOCK_PIXEL_YUV420, false);
+	host.render.SetSupported(MOCK_PIXEL_BGRA16, false);
+	
+	const FrameGenerator pictures(kWidth, kHeight);
+	
+	host.render.SetSource(&pictures);
+	
+	REQUIRE(MockExport(host, name, 0, 12 * FrameTicks(host)) == WEBM_OK);
+	
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile(name) == WEBM_OK);
+	
+	CHECK(!importer.Clip()->HasAudio());
+	
+	MockPPixHand ppix = importer.GetSourceVideo(6, MOCK_PIXEL_BGRA8);
+	
+	REQUIRE(ppix != NULL);
+	
+	std::vector<unsigned char> bgra_in(kWidth * kHeight * 4);
+	
+	pictures.BGRA8(6, &bgra_in[0], kWidth * 4, true);
+	
+	// green is closest to Y, so it's the fairest comparison
+	std::vector<unsigned char> green_in(kWidth * kHeight), green_out(kWidth * kHeight);
+	
+	const unsigned char *bgra_out = (const unsigned char *)host.ppix.GetPixels(ppix);
+	const long rowbytes = host.ppix.GetRowBytes(ppix);
+	
+	for(int y=0; y < kHeight; y++)
+	{
+		for(int x=0; x < kWidth; x++)
+		{
+			green_in[(y * kWidth) + x] = bgra_in[(y * kWidth * 4) + (x * 4) + 1];
+			green_out[(y * kWidth) + x] = bgra_out[(y * rowbytes) + (x * 4) + 1];
+		}
+	}
+	
+	CHECK(WebM_TestPSNR(&green_in[0], kWidth, &green_out[0], kWidth, kWidth, kHeight) >= 28.0);
+	
+	host.ppix.Dispose(ppix);
+}
+
+
+static void
+TestCancel(const char *name)
+{
+	printf("%s\n", name);
+	
+	MockHost host("export_import");
+	
+	const FrameGenerator pictures(kWidth, kHeight);
+	const ToneGenerator tone(2, 48000);
+	
+	host.render.SetSource(&pictures);
+	host.audio.SetSource(&tone);
+	
+	// MockExport doesn't let us at the host, so this is it by hand
+	WebM_ExportSettings settings;
+	
+	host.params.GetSettings(settings, host.time.GetTicksPerSecond());
+	
+	settings.export_video = true;
+	settings.export_audio = true;
+	settings.start_time = 0;
+	settings.end_time = kFrames * FrameTicks(host);
+	settings.num_cpus = host.num_cpus;
+	
+	const int fileObject = host.exportFile.NewFileObject(host.files.PlatformPath(name));
+	const int videoRenderID = host.render.MakeVideoRenderer(settings.frame_ticks);
+	const int audioRenderID = host.audio.MakeAudioRenderer(0, settings.ticks_per_second, settings.sample_rate);
+	
+	MockExportHost exportHost(host, fileObject, videoRenderID, audioRenderID, false);
+	
+	exportHost.CancelAt(0.25f);
+	
+	const WebM_Result result = WebM_ExportMovie(settings, host.exportFile.GetPlatformPath(fileObject).c_str(), exportHost);
+	
+	CHECK_EQ(result, WEBM_ERR_HOST);
+	CHECK(exportHost.LastProgress() < 0.5f);
+	CHECK(host.render.FramesRendered() < kFrames);
+	
+	host.render.ReleaseVideoRenderer(videoRenderID);
+	host.audio.ReleaseAudioRenderer(audioRenderID);
+	
+	// a canceled export still cleans up after itself
+	CHECK(!host.Leaked());
+}
+
+
+static void
+TestProxy(const char *name)
+{
+	printf("%s\n", name);
+	
+	MockHost host("export_import");
+	
+	host.params.SetInt("WebMVideoProxy", 1);
+	
+	const FrameGenerator pictures(kWidth, kHeight);
+	
+	host.render.SetSource(&pictures);
+	
+	REQUIRE(MockExport(host, name, 0, kFrames * FrameTicks(host)) == WEBM_OK);
+	
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile(name) == WEBM_OK);
+	
+	const WebM_Clip *clip = importer.Clip();
+	
+	REQUIRE(clip->Proxy() != NULL);
+	
+	// what Premiere gets from imGetPreferredFrameSize
+	int width = 0, height = 0;
+	
+	CHECK(clip->FrameSize(0, width, height));
+	CHECK_EQ(width, kWidth);
+	CHECK_EQ(height, kHeight);
+	
+	CHECK(clip->FrameSize(1, width, height));
+	CHECK_EQ(width, kWidth / 2);
+	CHECK_EQ(height, kHeight / 2);
+	
+	CHECK(!clip->FrameSize(2, width, height));
+	
+	// and then it asks for that size
+	MockPPixHand ppix = importer.GetSourceVideo(10, MOCK_PIXEL_YUV420, MOCK_QUALITY_MEDIUM, kWidth / 2, kHeight / 2);
+	
+	REQUIRE(ppix != NULL);
+	
+	host.ppix.GetBounds(ppix, width, height);
+	
+	CHECK_EQ(width, kWidth / 2);
+	CHECK_EQ(height, kHeight / 2);
+	
+	host.ppix.Dispose(ppix);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestRoundTrip(WEBM_CODEC_VP8, WEBM_CODEC_VORBIS, "vp8_vorbis.webm");
+	TestRoundTrip(WEBM_CODEC_VP9, WEBM_CODEC_OPUS, "vp9_opus.webm");
+	TestBGRA("bgra.webm");
+	TestCancel("canceled.webm");
+	TestProxy("proxied.webm");
+	
+	return WebM_TestResult("export_import");
+}
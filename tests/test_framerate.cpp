@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// Frame rates, from the header when the file has one and from the timestamps
+// when it doesn't: NTSC rates, which never come out even in milliseconds,
+// the usual integer ones, an odd one, and a variable rate file with frames
+// dropped and doubled.
+
+#include "MockHost.h"
+#include "Check.h"
+
+#include <math.h>
+
+
+static const int kWidth = 64;
+static const int kHeight = 48;
+
+
+// frames at num/den fps, except where skip says to leave one out
+// and twice says to squeeze an extra one in
+static bool
+WriteMovie(MockHost &host, const char *name, unsigned int num, unsigned int den, double header_rate,
+			long frames, int skip_every = 0, int twice_every = 0)
+{
+	const FrameGenerator pictures(kWidth, kHeight);
+	
+	TestMovieWriter writer;
+	
+	if( !writer.Open(host.files.PlatformPath(name), kWidth, kHeight, false, false, header_rate) )
+		return false;
+	
+	for(long f=0; f < frames; f++)
+	{
+		const long long tstamp = (long long)f * 1000000000LL * den / num;
+		
+		if(skip_every > 0 && f % skip_every == skip_every - 1)
+			continue;
+		
+		if( !writer.AddFrame(pictures, f, tstamp) )
+			return false;
+		
+		if(twice_every > 0 && f % twice_every == twice_every - 1)
+		{
+			// a few ms later, like a capture that caught up
+			if( !writer.AddFrame(pictures, f, tstamp + 5000000LL) )
+				return false;
+		}
+	}
+	
+	return writer.Close();
+}
+
+
+static void
+CheckRate(const char *name, unsigned int num, unsigned int den, double header_rate,
+			unsigned int expect_num, unsigned int expect_den,
+			int skip_every = 0, int twice_every = 0)
+{
+	MockHost host("framerate");
+	
+	REQUIRE(WriteMovie(host, name, num, den, header_rate, 240, skip_every, twice_every));
+	
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile(name) == WEBM_OK);
+	
+	const WebM_Clip *clip = importer.Clip();
+	
+	printf("%s: %u/%u\n", name, clip->FpsNum(), clip->FpsDen());
+	
+	CHECK_EQ(clip->FpsNum(), expect_num);
+	CHECK_EQ(clip->FpsDen(), expect_den);
+	
+	// Every frame that's in there lands on its own frame number.
+	// (Only meaningful for constant rate.)
+	if(skip_every == 0 && twice_every == 0)
+	{
+		const WebM_Index &index = clip->Index();
+		
+		for(size_t i=0; i < index.video.size(); i++)
+		{
+			const long frame = WebM_FrameNumber(index.video[i].tstamp, clip->FpsNum(), clip->FpsDen());
+			
+			if(frame != (long)i)
+			{
+				printf("  frame %ld is at %ld\n", (long)i, frame);
+				
+				CHECK_EQ(frame, (long)i);
+				
+				break;
+			}
+		}
+	}
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	// the header says
+	CheckRate("ntsc_header.webm", 30000, 1001, 30000.0 / 1001.0, 30000, 1001);
+	CheckRate("film_header.webm", 24000, 1001, 24000.0 / 1001.0, 24000, 1001);
+	CheckRate("pal_header.webm", 25, 1, 25.0, 25, 1);
+	
+	// the timestamps say
+	CheckRate("ntsc.webm", 30000, 1001, 0.0, 30000, 1001);
+	CheckRate("ntsc60.webm", 60000, 1001, 0.0, 60000, 1001);
+	CheckRate("film.webm", 24000, 1001, 0.0, 24000, 1001);
+	CheckRate("24.webm", 24, 1, 0.0, 24, 1);
+	CheckRate("30.webm", 30, 1, 0.0, 30, 1);
+	CheckRate("50.webm", 50, 1, 0.0, 50, 1);
+	
+	// nothing we know, so it's in thousandths
+	CheckRate("odd.webm", 125, 10, 0.0, 12500, 1000);
+	
+	// Variable, but mostly 25 or 50.  (With whole milliseconds between
+	// frames, because leaving out the odd gap would throw off the
+	// rounding for a rate that doesn't come out even.)
+	CheckRate("vfr_dropped.webm", 25, 1, 0.0, 25, 1, 7, 0);
+	CheckRate("vfr_doubled.webm", 25, 1, 0.0, 25, 1, 0, 11);
+	CheckRate("vfr_both.webm", 50, 1, 0.0, 50, 1, 9, 13);
+	
+	return WebM_TestResult("framerate");
+}
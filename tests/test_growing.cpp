@@ -0,0 +1,312 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// Edit while capture: a writer appends to a file the importer already has
+// open.  The importer has to open it before it's done, see the new frames as
+// they arrive without starting over, and decode them.
+
+#include "MockHost.h"
+#include "Check.h"
+
+
+static const int kWidth = 160;
+static const int kHeight = 120;
+
+
+static long long
+TimeStamp(long frame)
+{
+	return (long long)frame * 1000000000LL / 30;
+}
+
+
+// a cluster a second, like a capture
+static bool
+Append(TestMovieWriter &writer, const FrameGenerator &pictures, long from, long to)
+{
+	for(long f=from; f < to; f++)
+	{
+		if(f > 0 && f % 30 == 0)
+			writer.NewCluster();
+		
+		if( !writer.AddFrame(pictures, f, TimeStamp(f)) )
+			return false;
+	}
+	
+	return true;
+}
+
+
+static bool
+CheckFrame(MockHost &host, MockImporter &importer, const FrameGenerator &pictures, long frame)
+{
+	MockPPixHand ppix = importer.GetSourceVideo(frame, MOCK_PIXEL_YUV420);
+	
+	if(ppix == NULL)
+		return false;
+	
+	char *Y, *U, *V;
+	long Y_rowbytes, U_rowbytes, V_rowbytes;
+	
+	host.ppix2.GetYUV420PlanarBuffers(ppix, &Y, &Y_rowbytes, &U, &U_rowbytes, &V, &V_rowbytes);
+	
+	std::vector<unsigned char> Y_in(kWidth * kHeight), U_in(kWidth * kHeight / 4), V_in(kWidth * kHeight / 4);
+	
+	pictures.YUV420(frame, &Y_in[0], kWidth, &U_in[0], kWidth / 2, &V_in[0], kWidth / 2);
+	
+	const double psnr = WebM_TestPSNR(&Y_in[0], kWidth, (unsigned char *)Y, Y_rowbytes, kWidth, kHeight);
+	
+	host.ppix.Dispose(ppix);
+	
+	return (psnr > 25.0);
+}
+
+
+static void
+TestGrowing()
+{
+	printf("growing\n");
+	
+	MockHost host("growing");
+	
+	const FrameGenerator pictures(kWidth, kHeight);
+	
+	TestMovieWriter writer;
+	
+	REQUIRE(writer.Open(host.files.PlatformPath("capture.webm"), kWidth, kHeight, false, true, 30.0));
+	
+	// two seconds in, and the second one's cluster is still open
+	REQUIRE(Append(writer, pictures, 0, 45));
+	
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile("capture.webm") == WEBM_OK);
+	
+	WebM_Clip *clip = importer.Clip();
+	
+	CHECK(clip->Reader()->IsGrowing());
+	CHECK_EQ(clip->FpsNum(), 30);
+	CHECK_EQ(clip->FpsDen(), 1);
+	
+	const size_t first_frames = clip->Index().video.size();
+	const long long first_duration = clip->Duration();
+	
+	printf("  opened with %ld frames\n", (long)first_frames);
+	
+	// at least the first cluster, no more than was written
+	CHECK(first_frames >= 30 && first_frames <= 45);
+	CHECK(first_duration > 0);
+	
+	CHECK(CheckFrame(host, importer, pictures, 10));
+	
+	// the index we have isn't going anywhere
+	const WebM_IndexVideoFrame tenth = clip->Index().video[10];
+	
+	// three more seconds
+	REQUIRE(Append(writer, pictures, 45, 135));
+	
+	// asking for a frame is what makes the importer look
+	CHECK(CheckFrame(host, importer, pictures, 100));
+	
+	const size_t more_frames = clip->Index().video.size();
+	
+	printf("  now %ld frames\n", (long)more_frames);
+	
+	CHECK(more_frames >= 120 && more_frames <= 135);
+	CHECK(clip->Duration() > first_duration);
+	
+	// picked up where it left off: what was there is the same
+	CHECK_EQ(clip->Index().video[10].pos, tenth.pos);
+	CHECK_EQ(clip->Index().video[10].tstamp, tenth.tstamp);
+	
+	for(size_t i=1; i < more_frames; i++)
+	{
+		if(clip->Index().video[i].tstamp <= clip->Index().video[i - 1].tstamp)
+		{
+			CHECK(clip->Index().video[i].tstamp > clip->Index().video[i - 1].tstamp);
+			
+			break;
+		}
+	}
+	
+	// Premiere closing and reopening the file doesn't lose anything either
+	importer.QuietFile();
+	
+	REQUIRE(Append(writer, pictures, 135, 150));
+	
+	REQUIRE(importer.OpenFile("capture.webm") == WEBM_OK);
+	
+	CHECK(importer.Clip() == clip);
+	CHECK(CheckFrame(host, importer, pictures, 130));
+	
+	// capture's done
+	REQUIRE(writer.Close());
+	
+	CHECK(CheckFrame(host, importer, pictures, 149));
+	
+	CHECK_EQ(clip->Index().video.size(), 150);
+	CHECK(clip->Duration() >= TimeStamp(149));
+	
+	// the next look finds it isn't getting any longer, and has Cues
+	CHECK(CheckFrame(host, importer, pictures, 75));
+	
+	CHECK(!clip->Reader()->IsGrowing());
+	
+	// an exporter that's smart rendering can copy from it now
+	WebM_PassthroughBegin();
+	
+	CHECK(clip->PassthroughSource() >= 0);
+	
+	WebM_PassthroughEnd();
+	
+	CHECK_EQ(clip->Index().video.size(), 150);
+	
+	// so now it's in the cache like any other file
+	const UTF16String path = host.files.PlatformPath("capture.webm");
+	
+	WebM_FileReader reader;
+	
+	REQUIRE(reader.Open(path.c_str()));
+	
+	WebM_FileIdentity identity;
+	WebM_Index cached;
+	
+	REQUIRE(WebM_GetFileIdentity(&reader, path.c_str(), identity));
+	
+	CHECK(WebM_LoadIndexCache(identity, cached));
+	CHECK_EQ(cached.video.size(), 150);
+}
+
+
+// A writer that hasn't finalized only stopped for a moment, so the file
+// stays a growing one no matter how many times we look.
+static void
+TestPaused()
+{
+	printf("paused\n");
+	
+	MockHost host("growing");
+	
+	const FrameGenerator pictures(kWidth, kHeight);
+	
+	TestMovieWriter writer;
+	
+	REQUIRE(writer.Open(host.files.PlatformPath("paused.webm"), kWidth, kHeight, false, true, 30.0));
+	
+	REQUIRE(Append(writer, pictures, 0, 60));
+	
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile("paused.webm") == WEBM_OK);
+	
+	WebM_Clip *clip = importer.Clip();
+	
+	for(int i=0; i < 3; i++)
+		CHECK(CheckFrame(host, importer, pictures, 20 + i));
+	
+	CHECK(clip->Reader()->IsGrowing());
+	
+	// not even for an exporter that's smart rendering
+	WebM_PassthroughBegin();
+	
+	CHECK(clip->PassthroughSource() < 0);
+	
+	WebM_PassthroughEnd();
+	
+	
+	// and picks up again
+	REQUIRE(Append(writer, pictures, 60, 90));
+	
+	CHECK(CheckFrame(host, importer, pictures, 80));
+	CHECK(clip->Reader()->IsGrowing());
+	
+	REQUIRE(writer.Close());
+	
+	CHECK(CheckFrame(host, importer, pictures, 89));
+	CHECK(CheckFrame(host, importer, pictures, 0));
+	
+	CHECK(!clip->Reader()->IsGrowing());
+	CHECK_EQ(clip->Index().video.size(), 90);
+}
+
+
+static void
+TestTooEarly()
+{
+	printf("too early\n");
+	
+	MockHost host("growing");
+	
+	const FrameGenerator pictures(kWidth, kHeight);
+	
+	TestMovieWriter writer;
+	
+	REQUIRE(writer.Open(host.files.PlatformPath("early.webm"), kWidth, kHeight, false, true, 30.0));
+	
+	// headers but no frames yet
+	MockImporter importer(host, 1);
+	
+	const WebM_Result result = importer.OpenFile("early.webm");
+	
+	// whatever it says, it can't be a crash or a clip with nothing in it
+	if(result == WEBM_OK)
+	{
+		REQUIRE(Append(writer, pictures, 0, 40));
+		
+		MockPPixHand ppix = importer.GetSourceVideo(5, MOCK_PIXEL_YUV420);
+		
+		CHECK(ppix != NULL);
+		
+		if(ppix != NULL)
+			host.ppix.Dispose(ppix);
+	}
+	
+	REQUIRE(writer.Close());
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestGrowing();
+	TestPaused();
+	TestTooEarly();
+	
+	return WebM_TestResult("growing");
+}
@@ -0,0 +1,359 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// The index cache: a clip opened a second time gets its index from the cache
+// instead of walking the clusters, and gets the same index.  A file that
+// changed, or a cache file that's been damaged, has to be caught and the
+// index built again from the file.
+
+#include "MockHost.h"
+#include "Check.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+static const int kWidth = 160;
+static const int kHeight = 120;
+
+
+static bool
+WriteMovie(MockHost &host, const char *name, long frames)
+{
+	const FrameGenerator pictures(kWidth, kHeight);
+	
+	TestMovieWriter writer;
+	
+	if( !writer.Open(host.files.PlatformPath(name), kWidth, kHeight, false, false, 30.0) )
+		return false;
+	
+	for(long f=0; f < frames; f++)
+	{
+		// a few clusters, so there's something to walk
+		if(f > 0 && f % 30 == 0)
+			writer.NewCluster();
+		
+		if( !writer.AddFrame(pictures, f, (long long)f * 1000000000LL / 30) )
+			return false;
+	}
+	
+	return writer.Close();
+}
+
+
+static bool
+SameIndex(const WebM_Index &one, const WebM_Index &two)
+{
+	if(one.fps_num != two.fps_num || one.fps_den != two.fps_den ||
+		one.duration != two.duration ||
+		one.video.size() != two.video.size() || one.audio.size() != two.audio.size())
+	{
+		return false;
+	}
+	
+	for(size_t i=0; i < one.video.size(); i++)
+	{
+		const WebM_IndexVideoFrame &a = one.video[i];
+		const WebM_IndexVideoFrame &b = two.video[i];
+		
+		if(a.pos != b.pos || a.tstamp != b.tstamp || a.size != b.size || a.flags != b.flags ||
+			a.alpha_offset != b.alpha_offset || a.alpha_size != b.alpha_size)
+		{
+			return false;
+		}
+	}
+	
+	for(size_t i=0; i < one.audio.size(); i++)
+	{
+		const WebM_IndexAudioPacket &a = one.audio[i];
+		const WebM_IndexAudioPacket &b = two.audio[i];
+		
+		if(a.pos != b.pos || a.sample != b.sample || a.size != b.size || a.samples != b.samples)
+			return false;
+	}
+	
+	return true;
+}
+
+
+// what the clip would look up, without opening a clip
+static bool
+Identity(MockHost &host, const char *name, WebM_FileIdentity &identity)
+{
+	const UTF16String path = host.files.PlatformPath(name);
+	
+	WebM_FileReader reader;
+	
+	if( !reader.Open(path.c_str()) )
+		return false;
+	
+	return WebM_GetFileIdentity(&reader, path.c_str(), identity);
+}
+
+
+// every file in the cache directory gets the same treatment
+static int
+DamageCache(const char *dir, bool truncate_it)
+{
+	int damaged = 0;
+	
+	DIR *d = opendir(dir);
+	
+	if(d == NULL)
+		return 0;
+	
+	struct dirent *entry = NULL;
+	
+	while( (entry = readdir(d)) )
+	{
+		const std::string file_name = entry->d_name;
+		
+		if(file_name.size() > 8 && file_name.substr(file_name.size() - 8) == ".webmidx")
+		{
+			const std::string path = std::string(dir) + "/" + file_name;
+			
+			if(truncate_it)
+			{
+				struct stat file_stat;
+				
+				if(stat(path.c_str(), &file_stat) == 0 && truncate(path.c_str(), file_stat.st_size / 2) == 0)
+					damaged++;
+			}
+			else
+			{
+				// scribble over the middle, leaving the header alone
+				FILE *f = fopen(path.c_str(), "r+b");
+				
+				if(f != NULL)
+				{
+					fseek(f, 0, SEEK_END);
+					
+					const long size = ftell(f);
+					
+					fseek(f, size / 2, SEEK_SET);
+					
+					for(int i=0; i < 64; i++)
+						fputc(0xa5, f);
+					
+					fclose(f);
+					
+					damaged++;
+				}
+			}
+		}
+	}
+	
+	closedir(d);
+	
+	return damaged;
+}
+
+
+static void
+TestRoundTrip()
+{
+	printf("round trip\n");
+	
+	MockHost host("index_cache");
+	
+	REQUIRE(WriteMovie(host, "cached.webm", 150));
+	
+	WebM_Index first;
+	
+	{
+		MockImporter importer(host, 1);
+		
+		WebM_TestReport report("  first open");
+		
+		report.Start();
+		
+		REQUIRE(importer.OpenFile("cached.webm") == WEBM_OK);
+		
+		report.Stop(importer.Clip()->Index().video.size());
+		report.Print();
+		
+		first = importer.Clip()->Index();
+		
+		CHECK_EQ(first.video.size(), 150);
+		CHECK_EQ(first.fps_num, 30);
+		CHECK_EQ(first.fps_den, 1);
+	}
+	
+	// the first open left it there for us
+	WebM_FileIdentity identity;
+	
+	REQUIRE(Identity(host, "cached.webm", identity));
+	
+	WebM_Index cached;
+	
+	CHECK(WebM_LoadIndexCache(identity, cached));
+	CHECK(SameIndex(first, cached));
+	
+	{
+		MockImporter importer(host, 1);
+		
+		WebM_TestReport report("  cached open");
+		
+		report.Start();
+		
+		REQUIRE(importer.OpenFile("cached.webm") == WEBM_OK);
+		
+		report.Stop(importer.Clip()->Index().video.size());
+		report.Print();
+		
+		CHECK(SameIndex(first, importer.Clip()->Index()));
+		
+		// and the frames are where it says
+		const FrameGenerator pictures(kWidth, kHeight);
+		
+		MockPPixHand ppix = importer.GetSourceVideo(100, MOCK_PIXEL_YUV420);
+		
+		CHECK(ppix != NULL);
+		CHECK_EQ(importer.LastResult(), WEBM_OK);
+		
+		if(ppix != NULL)
+			host.ppix.Dispose(ppix);
+	}
+	
+	CHECK(!host.Leaked());
+}
+
+
+static void
+TestStale()
+{
+	printf("stale\n");
+	
+	MockHost host("index_cache");
+	
+	REQUIRE(WriteMovie(host, "stale.webm", 90));
+	
+	WebM_FileIdentity before;
+	
+	{
+		MockImporter importer(host, 1);
+		
+		REQUIRE(importer.OpenFile("stale.webm") == WEBM_OK);
+		CHECK_EQ(importer.Clip()->Index().video.size(), 90);
+	}
+	
+	REQUIRE(Identity(host, "stale.webm", before));
+	
+	// same name, different movie, and make sure the clock has moved on
+	sleep(1);
+	
+	REQUIRE(WriteMovie(host, "stale.webm", 60));
+	
+	WebM_FileIdentity after;
+	
+	REQUIRE(Identity(host, "stale.webm", after));
+	
+	CHECK(!WebM_SameFileIdentity(before, after));
+	
+	WebM_Index cached;
+	
+	CHECK(!WebM_LoadIndexCache(after, cached));
+	
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile("stale.webm") == WEBM_OK);
+	
+	CHECK_EQ(importer.Clip()->Index().video.size(), 60);
+	
+	// and now the cache has the new one
+	CHECK(WebM_LoadIndexCache(after, cached));
+	CHECK_EQ(cached.video.size(), 60);
+}
+
+
+static void
+TestCorrupt(bool truncate_it)
+{
+	printf(truncate_it ? "truncated\n" : "scribbled\n");
+	
+	MockHost host("index_cache");
+	
+	REQUIRE(WriteMovie(host, "corrupt.webm", 90));
+	
+	WebM_Index first;
+	
+	{
+		MockImporter importer(host, 1);
+		
+		REQUIRE(importer.OpenFile("corrupt.webm") == WEBM_OK);
+		
+		first = importer.Clip()->Index();
+	}
+	
+	const std::string cache_dir = getenv("WEBM_CACHE_DIR");
+	
+	CHECK(DamageCache(cache_dir.c_str(), truncate_it) > 0);
+	
+	WebM_FileIdentity identity;
+	
+	REQUIRE(Identity(host, "corrupt.webm", identity));
+	
+	WebM_Index cached;
+	
+	CHECK(!WebM_LoadIndexCache(identity, cached));
+	
+	// the clip doesn't notice, except by taking longer
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile("corrupt.webm") == WEBM_OK);
+	
+	CHECK(SameIndex(first, importer.Clip()->Index()));
+	
+	CHECK(WebM_LoadIndexCache(identity, cached));
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestRoundTrip();
+	TestStale();
+	TestCorrupt(true);
+	TestCorrupt(false);
+	
+	return WebM_TestResult("index_cache");
+}
@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// Opus through the mock host: it always comes out at 48k, the pre-skip
+// doesn't shift the sound, and seeking anywhere (which has to start decoding
+// 80 ms early) gives the same samples as reading straight through.  Then
+// Opus and Vorbis at the same bitrate, with encode and decode speed in the
+// log.
+
+#include "MockHost.h"
+#include "Check.h"
+
+#include "WebM_Speed.h"
+
+#include <math.h>
+#include <sys/stat.h>
+
+
+static const int kSeconds = 6;
+
+
+// how far off samples are from the tone, relative to the tone
+static double
+ToneError(const ToneGenerator &tone, int channel, long long position, const float *samples, int count)
+{
+	double error = 0.0, power = 0.0;
+	
+	for(int i=0; i < count; i++)
+	{
+		const double expected = tone.Sample(channel, position + i);
+		
+		error += (samples[i] - expected) * (samples[i] - expected);
+		power += expected * expected;
+	}
+	
+	return (power > 0.0 ? error / power : 1.0);
+}
+
+
+static void
+TestOpus(int channels, int sample_rate, const char *name)
+{
+	printf("%s\n", name);
+	
+	MockHost host("opus");
+	
+	host.params.SetInt("WebMAudioCodec", WEBM_CODEC_OPUS);
+	host.params.SetInt("WebMAudioBitrate", 64 * channels);
+	host.params.SetInt("WebMAudioMethod", OGG_BITRATE);
+	host.params.SetInt("ADBEAudioNumChannels", channels);
+	host.params.SetFloat("ADBEAudioRatePerSecond", sample_rate);
+	
+	// Premiere resamples for us, so the tone is at 48k no matter what
+	const ToneGenerator tone(channels, 48000);
+	
+	host.audio.SetSource(&tone);
+	
+	REQUIRE(MockExport(host, name, 0, kSeconds * host.time.GetTicksPerSecond()) == WEBM_OK);
+	
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile(name) == WEBM_OK);
+	
+	const WebM_Clip *clip = importer.Clip();
+	
+	CHECK(!clip->HasVideo());
+	REQUIRE(clip->HasAudio());
+	
+	CHECK_EQ(clip->AudioChannels(), channels);
+	CHECK_EQ(clip->AudioSampleRate(), 48000);
+	
+	// the whole thing, start to finish
+	const long long total = (long long)kSeconds * 48000;
+	
+	std::vector< std::vector<float> > straight(channels, std::vector<float>(total));
+	std::vector<float *> buffers(channels);
+	
+	const int chunk = 4800;
+	
+	for(long long pos = 0; pos < total; pos += chunk)
+	{
+		for(int c=0; c < channels; c++)
+			buffers[c] = &straight[c][pos];
+		
+		CHECK_EQ(importer.ImportAudio(pos, chunk, &buffers[0]), WEBM_OK);
+	}
+	
+	// lined up from the very start (past the first 20 ms, where the codec is still waking up)
+	for(int c=0; c < channels; c++)
+		CHECK(ToneError(tone, c, 960, &straight[c][960], 48000 - 960) < 0.1);
+	
+	// seeks, including some not on a packet boundary and one right at the start
+	const long long seeks[] = { 123457, 3, 200000, 48000 * 3 + 17, 960, 48000 * 5 };
+	
+	std::vector< std::vector<float> > seeked(channels, std::vector<float>(chunk));
+	
+	for(int s=0; s < 6; s++)
+	{
+		const long long pos = seeks[s];
+		
+		for(int c=0; c < channels; c++)
+			buffers[c] = &seeked[c][0];
+		
+		CHECK_EQ(importer.ImportAudio(pos, chunk, &buffers[0]), WEBM_OK);
+		
+		// the same as straight through, give or take the decoder state
+		for(int c=0; c < channels; c++)
+		{
+			double diff = 0.0, power = 0.0;
+			
+			for(int i=0; i < chunk; i++)
+			{
+				diff += (seeked[c][i] - straight[c][pos + i]) * (seeked[c][i] - straight[c][pos + i]);
+				power += straight[c][pos + i] * straight[c][pos + i];
+			}
+			
+			if(diff > power * 0.01)
+				printf("  seek to %lld, channel %d: off by %.1f%%\n", pos, c, 100.0 * diff / power);
+			
+			CHECK(diff <= power * 0.01);
+		}
+	}
+	
+	CHECK(!host.Leaked());
+}
+
+
+static const int kBenchmarkSeconds = 60;
+
+
+static void
+Benchmark(WebM_Audio_Codec codec, const char *name)
+{
+	MockHost host("opus");
+	
+	host.params.SetInt("WebMAudioCodec", codec);
+	host.params.SetInt("WebMAudioBitrate", 128);
+	host.params.SetInt("WebMAudioMethod", OGG_BITRATE);
+	host.params.SetInt("ADBEAudioNumChannels", 2);
+	host.params.SetFloat("ADBEAudioRatePerSecond", 48000);
+	
+	const ToneGenerator tone(2, 48000);
+	
+	host.audio.SetSource(&tone);
+	
+	const double encode_start = WebM_Seconds();
+	
+	REQUIRE(MockExport(host, name, 0, kBenchmarkSeconds * host.time.GetTicksPerSecond()) == WEBM_OK);
+	
+	const double encode_seconds = WebM_Seconds() - encode_start;
+	
+	struct stat st;
+	
+	const long long size = (stat(host.files.PathFor(name).c_str(), &st) == 0 ? (long long)st.st_size : 0);
+	
+	MockImporter importer(host, 1);
+	
+	REQUIRE(importer.OpenFile(name) == WEBM_OK);
+	
+	const long long total = (long long)kBenchmarkSeconds * importer.Clip()->AudioSampleRate();
+	const int chunk = 4800;
+	
+	std::vector< std::vector<float> > samples(2, std::vector<float>(chunk));
+	float *buffers[2] = { &samples[0][0], &samples[1][0] };
+	
+	const double decode_start = WebM_Seconds();
+	
+	for(long long pos = 0; pos < total; pos += chunk)
+		CHECK_EQ(importer.ImportAudio(pos, chunk, buffers), WEBM_OK);
+	
+	const double decode_seconds = WebM_Seconds() - decode_start;
+	
+	// x realtime, so it doesn't matter how long the test clip is
+	printf("  %s: encode %.0fx, decode %.0fx realtime, %lld KB for %d seconds\n", name,
+			(encode_seconds > 0.0 ? kBenchmarkSeconds / encode_seconds : 0.0),
+			(decode_seconds > 0.0 ? kBenchmarkSeconds / decode_seconds : 0.0),
+			size / 1024, kBenchmarkSeconds);
+	
+	CHECK(size > 0);
+	CHECK(!host.Leaked());
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestOpus(2, 48000, "stereo.webm");
+	TestOpus(1, 48000, "mono.webm");
+	
+	// at 44.1k the exporter asks for 48k anyway
+	TestOpus(2, 44100, "from44.webm");
+	
+	printf("Opus vs Vorbis, stereo at 128 kbps\n");
+	
+	Benchmark(WEBM_CODEC_OPUS, "opus_speed.webm");
+	Benchmark(WEBM_CODEC_VORBIS, "vorbis_speed.webm");
+	
+	return WebM_TestResult("opus");
+}
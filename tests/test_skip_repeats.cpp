@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// Skipping repeated frames: a picture that's held for a few frames goes in
+// the file once, and every frame that does go in has to be stamped with
+// its own time, not the time of whatever the encoder was handed last.
+// Then finding the frame on screen, which has to back up over the gaps
+// and never land on an invisible frame.
+
+#include "MockHost.h"
+#include "Check.h"
+
+#include <vector>
+
+
+static const int kWidth = 160;
+static const int kHeight = 120;
+static const int kFrames = 48;	// two seconds at 24
+static const int kHold = 4;
+
+
+static WebM_IndexVideoFrame
+Frame(long long tstamp, unsigned int size, unsigned int flags)
+{
+	WebM_IndexVideoFrame frame;
+	
+	frame.pos = 0;
+	frame.tstamp = tstamp;
+	frame.size = size;
+	frame.flags = flags;
+	frame.alpha_offset = 0;
+	frame.alpha_size = 0;
+	
+	return frame;
+}
+
+
+static void
+TestHeldFrames(WebM_Video_Codec codec, const char *name)
+{
+	printf("%s\n", name);
+	
+	MockHost host("skip_repeats");
+	
+	host.params.SetInt("WebMVideoCodec", codec);
+	host.params.SetInt("WebMVideoSkipRepeats", 1);
+	host.params.SetInt("ADBEVideoWidth", kWidth);
+	host.params.SetInt("ADBEVideoHeight", kHeight);
+	
+	const FrameGenerator pictures(kWidth, kHeight, false, kHold);
+	
+	host.render.SetSource(&pictures);
+	
+	// every picture's first frame, and the last frame, which always goes in
+	std::vector<long> expected;
+	
+	for(long f=0; f < kFrames; f += kHold)
+		expected.push_back(f);
+	
+	if(expected.back() != kFrames - 1)
+		expected.push_back(kFrames - 1);
+	
+	WebM_ExportStats stats;
+	
+	const WebM_Result export_result = MockExport(host, name, 0, kFrames * host.time.GetTicksPerFrame(24, 1), &stats);
+	
+	CHECK_EQ(export_result, WEBM_OK);
+	CHECK_EQ(stats.encoded, (long)expected.size());
+	CHECK_EQ(stats.skipped, kFrames - (long)expected.size());
+	
+	REQUIRE(export_result == WEBM_OK);
+	
+	{
+		MockImporter importer(host, 1);
+		
+		REQUIRE(importer.OpenFile(name) == WEBM_OK);
+		
+		const WebM_Clip *clip = importer.Clip();
+		const WebM_Index &index = clip->Index();
+		
+		CHECK_EQ(index.video.size(), expected.size());
+		
+		for(size_t i=0; i < index.video.size() && i < expected.size(); i++)
+		{
+			// no alt-refs, the encoder isn't allowed to hold any frames back
+			CHECK(!(index.video[i].flags & WEBM_INDEX_INVISIBLE));
+			
+			const long frame = WebM_FrameNumber(index.video[i].tstamp, 24, 1);
+			
+			if(frame != expected[i])
+			{
+				printf("  block %ld is at frame %ld, should be %ld\n", (long)i, frame, expected[i]);
+				
+				CHECK_EQ(frame, expected[i]);
+				
+				break;
+			}
+		}
+		
+		// a held frame gets the block that's showing
+		CHECK_EQ(WebM_FindFrame(index, kHold + 1, 24, 1), 1);
+		CHECK_EQ(WebM_FindFrame(index, kFrames - 2, 24, 1), (long)expected.size() - 2);
+	}
+	
+	CHECK(!host.Leaked());
+}
+
+
+static void
+TestFindFrame()
+{
+	printf("find frame\n");
+	
+	// 25 fps, an alt-ref stamped before the frame that shows it, a
+	// dropped frame, and the file starting and ending on alt-refs
+	WebM_Index index;
+	
+	index.fps_num = 25;
+	index.fps_den = 1;
+	
+	index.video.push_back(Frame(0, 300, WEBM_INDEX_INVISIBLE | WEBM_INDEX_KEYFRAME | WEBM_INDEX_CLUSTER_START));
+	index.video.push_back(Frame(0, 100, 0));
+	index.video.push_back(Frame(40000000, 100, 0));
+	index.video.push_back(Frame(80000000, 300, WEBM_INDEX_INVISIBLE));
+	index.video.push_back(Frame(120000000, 100, 0));
+	index.video.push_back(Frame(200000000, 100, 0));
+	index.video.push_back(Frame(240000000, 300, WEBM_INDEX_INVISIBLE));
+	
+	CHECK_EQ(WebM_FindFrame(index, 0, 25, 1), 1);
+	CHECK_EQ(WebM_FindFrame(index, 1, 25, 1), 2);
+	
+	// the alt-ref has frame 2's time, but frame 1 is still showing
+	CHECK_EQ(WebM_FindFrame(index, 2, 25, 1), 2);
+	CHECK_EQ(WebM_FindFrame(index, 3, 25, 1), 4);
+	
+	// the dropped frame holds the one before
+	CHECK_EQ(WebM_FindFrame(index, 4, 25, 1), 4);
+	CHECK_EQ(WebM_FindFrame(index, 5, 25, 1), 5);
+	
+	// past the end, the last one showing
+	CHECK_EQ(WebM_FindFrame(index, 6, 25, 1), 5);
+	CHECK_EQ(WebM_FindFrame(index, 100, 25, 1), 5);
+	
+	// nothing but an alt-ref is still something to decode
+	WebM_Index alone;
+	
+	alone.video.push_back(Frame(0, 300, WEBM_INDEX_INVISIBLE | WEBM_INDEX_KEYFRAME));
+	
+	CHECK_EQ(WebM_FindFrame(alone, 0, 25, 1), 0);
+	
+	CHECK_EQ(WebM_FindFrame(WebM_Index(), 0, 25, 1), -1);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestHeldFrames(WEBM_CODEC_VP9, "held_vp9.webm");
+	TestHeldFrames(WEBM_CODEC_VP8, "held_vp8.webm");
+	TestFindFrame();
+	
+	return WebM_TestResult("skip_repeats");
+}
@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2013, Brendan Bolles
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// *	   Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// *	   Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ------------------------------------------------------------------------
+//
+// WebM plug-in for Premiere
+//
+// by Brendan Bolles <brendan@fnordware.com>
+//
+// ------------------------------------------------------------------------
+
+
+// Smart rendering: export a movie, put it on a sequence by itself, and export
+// that with smart render on.  Every frame should be copied, so the new movie
+// decodes to exactly the same pictures.  Odd sizes too, where the last
+// chroma column and row don't survive the trip through Premiere's buffers.
+// And nothing gets hashed unless an exporter is smart rendering.
+
+#include "MockHost.h"
+#include "Check.h"
+
+#include "WebM_Passthrough.h"
+
+#include <string>
+#include <vector>
+
+
+static const int kFrames = 48;	// two seconds at 24
+
+
+static bool
+SamePicture(MockHost &host, MockImporter &a, MockImporter &b, long frame, int width, int height)
+{
+	MockPPixHand a_ppix = a.GetSourceVideo(frame, MOCK_PIXEL_YUV420);
+	MockPPixHand b_ppix = b.GetSourceVideo(frame, MOCK_PIXEL_YUV420);
+	
+	bool same = false;
+	
+	if(a_ppix != NULL && b_ppix != NULL)
+	{
+		char *aY, *aU, *aV, *bY, *bU, *bV;
+		long aY_rowbytes, aU_rowbytes, aV_rowbytes, bY_rowbytes, bU_rowbytes, bV_rowbytes;
+		
+		host.ppix2.GetYUV420PlanarBuffers(a_ppix, &aY, &aY_rowbytes, &aU, &aU_rowbytes, &aV, &aV_rowbytes);
+		host.ppix2.GetYUV420PlanarBuffers(b_ppix, &bY, &bY_rowbytes, &bU, &bU_rowbytes, &bV, &bV_rowbytes);
+		
+		same = (WebM_TestPSNR((unsigned char *)aY, aY_rowbytes, (unsigned char *)bY, bY_rowbytes, width, height) == 99.0 &&
+				WebM_TestPSNR((unsigned char *)aU, aU_rowbytes, (unsigned char *)bU, bU_rowbytes, width / 2, height / 2) == 99.0 &&
+				WebM_TestPSNR((unsigned char *)aV, aV_rowbytes, (unsigned char *)bV, bV_rowbytes, width / 2, height / 2) == 99.0);
+	}
+	
+	if(a_ppix != NULL)
+		host.ppix.Dispose(a_ppix);
+	
+	if(b_ppix != NULL)
+		host.ppix.Dispose(b_ppix);
+	
+	return same;
+}
+
+
+static void
+TestSmartRender(WebM_Video_Codec codec, int width, int height, const char *name)
+{
+	printf("%s: %dx%d\n", name, width, height);
+	
+	const std::string source_name = std::string(name) + "_source.webm";
+	const std::string copy_name = std::string(name) + "_copy.webm";
+	
+	MockHost host("smart_render");
+	
+	host.params.SetInt("WebMVideoCodec", codec);
+	host.params.SetInt("ADBEVideoWidth", width);
+	host.params.SetInt("ADBEVideoHeight", height);
+	
+	const FrameGenerator pictures(width, height);
+	
+	host.render.SetSource(&pictures);
+	
+	const long long end_time = kFrames * host.time.GetTicksPerFrame(24, 1);
+	
+	// An alt-ref is never shown, so it never gets a hash and a run of
+	// copies stops there.  Keep the source to frames that show.
+	host.params.SetString("WebMCustomArgs", "--lag-in-frames 0");
+	
+	REQUIRE(MockExport(host, source_name.c_str(), 0, end_time) == WEBM_OK);
+	
+	host.params.SetString("WebMCustomArgs", "");
+	
+	{
+		MockImporter source(host, 1);
+		
+		REQUIRE(source.OpenFile(source_name.c_str()) == WEBM_OK);
+		
+		// just playing, so nobody wants the hashes
+		MockPPixHand ppix = source.GetSourceVideo(0, MOCK_PIXEL_YUV420);
+		
+		CHECK(ppix != NULL);
+		
+		if(ppix != NULL)
+			host.ppix.Dispose(ppix);
+		
+		CHECK(!WebM_PassthroughActive());
+		CHECK(source.Clip()->PassthroughSource() < 0);
+		
+		// and don't let the cache hide frames from the exporter
+		host.cache.Purge();
+		
+		host.params.SetInt("WebMVideoSmartRender", 1);
+		host.render.SetClip(&source);
+		
+		WebM_ExportStats stats;
+		
+		const WebM_Result result = MockExport(host, copy_name.c_str(), 0, end_time, &stats);
+		
+		CHECK_EQ(result, WEBM_OK);
+		CHECK_EQ(stats.copied, kFrames);
+		CHECK_EQ(stats.encoded, 0);
+		
+		// and off again once it's done
+		CHECK(!WebM_PassthroughActive());
+		
+		REQUIRE(result == WEBM_OK);
+		
+		MockImporter copy(host, 2);
+		
+		REQUIRE(copy.OpenFile(copy_name.c_str()) == WEBM_OK);
+		
+		CHECK_EQ(copy.Clip()->Width(), width);
+		CHECK_EQ(copy.Clip()->Height(), height);
+		CHECK_EQ(copy.Clip()->Index().video.size(), source.Clip()->Index().video.size());
+		
+		for(long f=0; f < kFrames; f++)
+		{
+			const bool same = SamePicture(host, source, copy, f, width, height);
+			
+			if(!same)
+			{
+				printf("  frame %ld is different\n", f);
+				
+				CHECK(same);
+				
+				break;
+			}
+		}
+	}
+	
+	CHECK(!host.Leaked());
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	TestSmartRender(WEBM_CODEC_VP8, 160, 120, "vp8");
+	TestSmartRender(WEBM_CODEC_VP9, 160, 120, "vp9");
+	TestSmartRender(WEBM_CODEC_VP8, 161, 121, "vp8_odd");
+	TestSmartRender(WEBM_CODEC_VP9, 161, 121, "vp9_odd");
+	
+	return WebM_TestResult("smart_render");
+}